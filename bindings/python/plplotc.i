@@ -58,6 +58,16 @@
 #define  NPY_PLFLT    NPY_FLOAT32
 #endif
 
+// plshades, plimagefr and plsurf3d take their matrix argument through
+// PLF2OPS in Python (see the MatrixOps typemaps) so that numpy arrays
+// can be used in place.
+#undef plshades
+#undef plimagefr
+#undef plsurf3d
+#define plshades     plfshades
+#define plimagefr    plfimagefr
+#define plsurf3d     plfsurf3d
+
 // python-1.5 compatibility mode?
 #if !defined ( PySequence_Fast_GET_ITEM )
   #define PySequence_Fast_GET_ITEM    PySequence_GetItem
@@ -620,6 +630,181 @@ typedef PLINT          PLBOOL;
     Py_CLEAR( tmp$argnum );
 }
 
+//--------------------------------------------------------------------------
+//                  2D arrays passed through PLF2OPS
+//--------------------------------------------------------------------------
+
+// Arrays that are already C or Fortran contiguous are handed to the
+// library in place through the plf2ops grid functions, so that no copy
+// and no table of row pointers is made.  Arrays of the other floating
+// point type (float32 for a double precision library and vice versa) are
+// read through the operators below instead of being converted.  Anything
+// else is converted to a contiguous PLFLT array as for Matrix.
+%wrapper
+%{
+#ifdef PL_DOUBLE
+#define  NPY_PLFLT_OTHER    NPY_FLOAT32
+    typedef float  PLFLT_OTHER;
+#else
+#define  NPY_PLFLT_OTHER    NPY_FLOAT64
+    typedef double PLFLT_OTHER;
+#endif
+
+    static PLFLT
+    grid_other_row_major_get( PLPointer p, PLINT ix, PLINT iy )
+    {
+        PLfGrid2 *g = (PLfGrid2 *) p;
+        return (PLFLT) ( (PLFLT_OTHER *) g->f )[ix * g->ny + iy];
+    }
+
+    static PLFLT
+    grid_other_row_major_f2eval( PLINT ix, PLINT iy, PLPointer p )
+    {
+        return grid_other_row_major_get( p, ix, iy );
+    }
+
+    static PLINT
+    grid_other_row_major_is_nan( PLPointer p, PLINT ix, PLINT iy )
+    {
+        return isnan( grid_other_row_major_get( p, ix, iy ) );
+    }
+
+    static PLFLT
+    grid_other_col_major_get( PLPointer p, PLINT ix, PLINT iy )
+    {
+        PLfGrid2 *g = (PLfGrid2 *) p;
+        return (PLFLT) ( (PLFLT_OTHER *) g->f )[ix + g->nx * iy];
+    }
+
+    static PLFLT
+    grid_other_col_major_f2eval( PLINT ix, PLINT iy, PLPointer p )
+    {
+        return grid_other_col_major_get( p, ix, iy );
+    }
+
+    static PLINT
+    grid_other_col_major_is_nan( PLPointer p, PLINT ix, PLINT iy )
+    {
+        return isnan( grid_other_col_major_get( p, ix, iy ) );
+    }
+
+    // The minimum and maximum do not depend on the storage order.  NaN and
+    // infinite values are skipped as in the library's own minmax operators.
+    static void
+    grid_other_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLFLT *zmax )
+    {
+        PLfGrid2    *g = (PLfGrid2 *) p;
+        PLFLT_OTHER *z = (PLFLT_OTHER *) g->f;
+        size_t      i, n = (size_t) nx * (size_t) ny;
+        PLFLT       min = HUGE_VAL, max = -HUGE_VAL;
+
+        for ( i = 0; i < n; i++ )
+        {
+            if ( isfinite( z[i] ) )
+            {
+                min = (PLFLT) z[i] < min ? (PLFLT) z[i] : min;
+                max = (PLFLT) z[i] > max ? (PLFLT) z[i] : max;
+            }
+        }
+        *zmin = min;
+        *zmax = max;
+    }
+
+    // The arrays are only read, so the operators that write are left out.
+    static plf2ops_t s_grid_other_row_major = {
+        grid_other_row_major_get,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        grid_other_row_major_is_nan,
+        grid_other_minmax,
+        grid_other_row_major_f2eval
+    };
+
+    static plf2ops_t s_grid_other_col_major = {
+        grid_other_col_major_get,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        grid_other_col_major_is_nan,
+        grid_other_minmax,
+        grid_other_col_major_f2eval
+    };
+
+    PyArrayObject* myArray_GridFromObject( PyObject* in, PLF2OPS *ops, PLfGrid2 *grid );
+
+    PyArrayObject* myArray_GridFromObject( PyObject* in, PLF2OPS *ops, PLfGrid2 *grid )
+    {
+        PyArrayObject *tmp = (PyArrayObject *) in;
+        int           type, col_major;
+
+        if ( PyArray_Check( in ) && PyArray_NDIM( tmp ) == 2 &&
+             ( PyArray_TYPE( tmp ) == NPY_PLFLT || PyArray_TYPE( tmp ) == NPY_PLFLT_OTHER ) &&
+             ( PyArray_ISCARRAY_RO( tmp ) || PyArray_ISFARRAY_RO( tmp ) ) &&
+             PyArray_ISNOTSWAPPED( tmp ) && PyArray_SIZE( tmp ) > 0 )
+        {
+            Py_INCREF( tmp );
+        }
+        else
+        {
+            tmp = (PyArrayObject *) myArray_ContiguousFromObject( in, NPY_PLFLT, 2, 2 );
+            if ( tmp == NULL )
+                return NULL;
+        }
+
+        // A single row or column is both, either order gives the same result.
+        type      = PyArray_TYPE( tmp );
+        col_major = !PyArray_IS_C_CONTIGUOUS( tmp );
+        grid->f   = (PLFLT **) PyArray_DATA( tmp );
+        grid->nx  = (PLINT) PyArray_DIMS( tmp )[0];
+        grid->ny  = (PLINT) PyArray_DIMS( tmp )[1];
+        if ( type == NPY_PLFLT )
+            *ops = col_major ? plf2ops_grid_col_major() : plf2ops_grid_row_major();
+        else
+            *ops = col_major ? &s_grid_other_col_major : &s_grid_other_row_major;
+        return tmp;
+    }
+%}
+
+// 2D array through PLF2OPS, set the X, Y size for later checking
+%typemap ( in ) ( PLF2OPS MatrixOps, PLPointer MatrixGrid, PLINT nx, PLINT ny ) ( PyArrayObject * tmp = NULL, PLfGrid2 grid )
+{
+    tmp = myArray_GridFromObject( $input, &$1, &grid );
+    if ( tmp == NULL )
+        return NULL;
+    Xlen = $3 = grid.nx;
+    Ylen = $4 = grid.ny;
+    $2   = &grid;
+}
+%typemap ( freearg ) ( PLF2OPS MatrixOps, PLPointer MatrixGrid, PLINT nx, PLINT ny )
+{
+    Py_CLEAR( tmp$argnum );
+}
+
+// 2D array through PLF2OPS, check consistency with previous
+%typemap ( in ) ( PLF2OPS MatrixCkOps, PLPointer MatrixCkGrid, PLINT nx, PLINT ny ) ( PyArrayObject * tmp = NULL, PLfGrid2 grid )
+{
+    tmp = myArray_GridFromObject( $input, &$1, &grid );
+    if ( tmp == NULL )
+        return NULL;
+    if ( Xlen != grid.nx || Ylen != grid.ny )
+    {
+        PyErr_SetString( PyExc_ValueError, "Vectors must match matrix." );
+        return NULL;
+    }
+    $3 = grid.nx;
+    $4 = grid.ny;
+    $2 = &grid;
+}
+%typemap ( freearg ) ( PLF2OPS MatrixCkOps, PLPointer MatrixCkGrid, PLINT nx, PLINT ny )
+{
+    Py_CLEAR( tmp$argnum );
+}
+
 // 2D array, check for consistency
 %typemap( in ) const PLFLT * *MatrixCk( PyArrayObject * tmp = NULL )
 {
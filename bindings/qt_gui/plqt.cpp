@@ -154,6 +154,49 @@ void QtPLDriver::drawPolygon( short * x, short * y, PLINT npts )
 }
 
 
+void QtPLDriver::drawImage()
+{
+    PLINT         nx = pls->dev_nptsX - 1;
+    PLINT         ny = pls->dev_nptsY - 1;
+    PLINT         ix, iy;
+    unsigned char *rgba;
+    double        ox, oy;
+
+    if ( !m_painterP->isActive() || nx < 1 || ny < 1 )
+        return;
+
+    // Image rows run along the image x axis, one per iy.
+    QImage image( nx, ny, QImage::Format_ARGB32 );
+    for ( iy = 0; iy < ny; ++iy )
+    {
+        QRgb *row = (QRgb *) image.scanLine( iy );
+        for ( ix = 0; ix < nx; ++ix )
+        {
+            rgba    = pls->dev_rgba + 4 * ( ix * ny + iy );
+            row[ix] = qRgba( rgba[0], rgba[1], rgba[2], rgba[3] );
+        }
+    }
+
+    // The cells form an affine grid, so the placement is given by the
+    // corners (0, 0), (nx, 0) and (0, ny).
+    ox = (PLFLT) pls->dev_ix[0];
+    oy = (PLFLT) pls->dev_iy[0];
+    QTransform transform(
+        ( pls->dev_ix[nx * ( ny + 1 )] - ox ) / nx * downscale,
+        -( pls->dev_iy[nx * ( ny + 1 )] - oy ) / nx * downscale,
+        ( pls->dev_ix[ny] - ox ) / ny * downscale,
+        -( pls->dev_iy[ny] - oy ) / ny * downscale,
+        ox * downscale, m_dHeight - oy * downscale );
+
+    m_painterP->save();
+    m_painterP->setClipRect( QRectF( pls->imclxmin * downscale, m_dHeight - pls->imclymax * downscale,
+            ( pls->imclxmax - pls->imclxmin ) * downscale, ( pls->imclymax - pls->imclymin ) * downscale ) );
+    m_painterP->setRenderHint( QPainter::SmoothPixmapTransform, false );
+    m_painterP->setTransform( transform, true );
+    m_painterP->drawImage( QPointF( 0., 0. ), image );
+    m_painterP->restore();
+}
+
 QFont QtPLDriver::getFont( PLUNICODE unicode )
 {
     // Get new font parameters
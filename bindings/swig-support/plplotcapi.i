@@ -539,9 +539,15 @@ plot3dcl( const PLFLT *ArrayX, const PLFLT *ArrayY, const PLFLT **MatrixCk,
           PLINT nx, PLINT ny, PLINT opt, const PLFLT *Array, PLINT n,
           PLINT ixstart, PLINT n, const PLINT *Array, const PLINT *ArrayCk );
 
+#ifdef SWIG_PYTHON
+void
+plsurf3d( const PLFLT *ArrayX, const PLFLT *ArrayY, PLF2OPS MatrixCkOps, PLPointer MatrixCkGrid,
+          PLINT nx, PLINT ny, PLINT opt, const PLFLT *Array, PLINT n );
+#else
 void
 plsurf3d( const PLFLT *ArrayX, const PLFLT *ArrayY, const PLFLT **MatrixCk,
           PLINT nx, PLINT ny, PLINT opt, const PLFLT *Array, PLINT n );
+#endif
 
 void
 plsurf3dl( const PLFLT *ArrayX, const PLFLT *ArrayY, const PLFLT **MatrixCk,
@@ -683,6 +689,16 @@ plsfnam( const char *fnam );
 void
 plsfont( PLINT family, PLINT style, PLINT weight );
 
+#ifdef SWIG_PYTHON
+void
+plshades( PLF2OPS MatrixOps, PLPointer MatrixGrid, PLINT nx, PLINT ny, defined_func df,
+          PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax,
+          const PLFLT *Array, PLINT n, PLFLT fill_width,
+          PLINT cont_color, PLFLT cont_width,
+          fill_func ff, PLBOOL rectangular,
+          pltr_func pltr,
+          PLPointer SWIG_OBJECT_DATA );
+#else
 void
 plshades( const PLFLT **Matrix, PLINT nx, PLINT ny, defined_func df,
           PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax,
@@ -691,6 +707,7 @@ plshades( const PLFLT **Matrix, PLINT nx, PLINT ny, defined_func df,
           fill_func ff, PLBOOL rectangular,
           pltr_func pltr,
           PLPointer SWIG_OBJECT_DATA );
+#endif
 
 void
 plshade( const PLFLT **Matrix, PLINT nx, PLINT ny, defined_func df,
@@ -958,11 +975,19 @@ plimage( const PLFLT **Matrix, PLINT nx, PLINT ny,
 
 // plots a 2d image (or a matrix too large for plshade() ).
 
+#ifdef SWIG_PYTHON
+void
+plimagefr( PLF2OPS MatrixOps, PLPointer MatrixGrid, PLINT nx, PLINT ny,
+           PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax, PLFLT zmin, PLFLT zmax,
+           PLFLT valuemin, PLFLT valuemax,
+           pltr_func pltr_img, PLPointer SWIG_OBJECT_DATA_img );
+#else
 void
 plimagefr( const PLFLT **Matrix, PLINT nx, PLINT ny,
            PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax, PLFLT zmin, PLFLT zmax,
            PLFLT valuemin, PLFLT valuemax,
            pltr_func pltr_img, PLPointer SWIG_OBJECT_DATA_img );
+#endif
 
 #ifdef 0
 // Returns a list of file-oriented device names and their menu strings
@@ -157,6 +157,7 @@ foreach(DRIVERS_DEVICE ${DRIVERS_DEVICE_LIST})
   endif(${DRIVER}_INFO)
 endforeach(DRIVERS_DEVICE)
 
+set(DRIVERS_DB_INFO)
 foreach(DRIVERS_DEVICE ${DRIVERS_DEVICE_LIST})
   string(REGEX REPLACE "^.*:(.*):.*:.*:.*$" "\\1" DRIVER ${DRIVERS_DEVICE})
   if(${DRIVER}_INFO)
@@ -164,5 +165,18 @@ foreach(DRIVERS_DEVICE ${DRIVERS_DEVICE_LIST})
     foreach(DEVICE_INFO ${${DRIVER}_INFO})
       file(APPEND ${CMAKE_BINARY_DIR}/drivers/${DRIVER}.driver_info "${DEVICE_INFO}\n")
     endforeach(DEVICE_INFO ${${DRIVER}_INFO})
+    list(APPEND DRIVERS_DB_INFO ${${DRIVER}_INFO})
   endif(${DRIVER}_INFO)
 endforeach(DRIVERS_DEVICE ${DRIVERS_DEVICE_LIST})
+
+# ${CMAKE_BINARY_DIR}/drivers/drivers.db caches the contents of all the
+# *.driver_info files so that plinit does not have to read them one by
+# one.  It is written after them since the library only uses it when none
+# of them is newer.
+if(DRIVERS_DB_INFO)
+  list(REMOVE_DUPLICATES DRIVERS_DB_INFO)
+endif(DRIVERS_DB_INFO)
+file(WRITE ${CMAKE_BINARY_DIR}/drivers/drivers.db "")
+foreach(DEVICE_INFO ${DRIVERS_DB_INFO})
+  file(APPEND ${CMAKE_BINARY_DIR}/drivers/drivers.db "${DEVICE_INFO}\n")
+endforeach(DEVICE_INFO ${DRIVERS_DB_INFO})
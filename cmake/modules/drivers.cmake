@@ -99,6 +99,7 @@ include(aqt)
 include(wxwidgets)
 include(pdf)
 include(wingdi)
+include(svg)
 
 # Finalize device options.
 include(drivers-finish)
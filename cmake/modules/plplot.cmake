@@ -267,6 +267,11 @@ set(NEED_SYS_TYPE_H ON)
 # Test signal handler return type (mimics AC_TYPE_SIGNAL)
 include(TestSignalType)
 
+# Byte order of the host, which the metafile I/O in pdfutils.c uses to
+# transfer arrays of little-endian values in one piece.
+include(TestBigEndian)
+test_big_endian(WORDS_BIGENDIAN)
+
 include(CheckFunctionExists)
 check_function_exists(popen HAVE_POPEN)
 check_function_exists(usleep PL_HAVE_USLEEP)
@@ -274,6 +279,7 @@ check_function_exists(nanosleep PL_HAVE_NANOSLEEP)
 check_function_exists(mkstemp PL_HAVE_MKSTEMP)
 check_function_exists(mkdtemp PL_HAVE_MKDTEMP)
 check_function_exists(mkfifo PL_HAVE_MKFIFO)
+check_function_exists(mmap PL_HAVE_MMAP)
 check_function_exists(unlink PL_HAVE_UNLINK)
 check_function_exists(_NSGetArgc HAVE_NSGETARGC)
 
@@ -541,6 +547,8 @@ include(freetype)
 # csiro must come after MATH_LIB is defined (or not).
 # csiro must come after c++ and fortran because of use of filter_rpath
 include(csiro)
+# Support for parallel computations in the core library
+include(threads)
 
 
 # =======================================================================
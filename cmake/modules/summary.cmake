@@ -109,6 +109,7 @@ Optional libraries:
 PL_HAVE_QHULL:		${PL_HAVE_QHULL}		WITH_CSA:	${WITH_CSA}
 PL_HAVE_FREETYPE:	${PL_HAVE_FREETYPE}		PL_HAVE_PTHREAD:	${PL_HAVE_PTHREAD}
 HAVE_AGG:		${HAVE_AGG}		HAVE_SHAPELIB:	${HAVE_SHAPELIB}
+PL_HAVE_THREADS:	${PL_HAVE_THREADS}
 
 Language Bindings:
 ENABLE_ada:		${ENABLE_ada}
@@ -0,0 +1,34 @@
+# cmake/modules/svg.cmake
+#
+# This file is part of PLplot.
+#
+# PLplot is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Library General Public License as published
+# by the Free Software Foundation; version 2 of the License.
+#
+# PLplot is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public License
+# along with the file PLplot; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+
+# Module for determining all configuration variables related to the svg
+# device driver.  The driver embeds images as PNG data, which is
+# compressed if zlib is found and stored uncompressed otherwise.
+# The following variables are set/modified:
+# svg_COMPILE_FLAGS	  - individual COMPILE_FLAGS required to compile svg
+# 			    device.
+# svg_LINK_FLAGS	  - individual LINK_FLAGS for dynamic svg device.
+# DRIVERS_LINK_FLAGS	  - list of LINK_FLAGS for all static devices.
+
+if(PLD_svg)
+  find_package(ZLIB)
+  if(ZLIB_FOUND)
+    set(svg_COMPILE_FLAGS "-DPL_HAVE_ZLIB -I${ZLIB_INCLUDE_DIRS}")
+    set(svg_LINK_FLAGS ${ZLIB_LIBRARIES})
+    set(DRIVERS_LINK_FLAGS ${DRIVERS_LINK_FLAGS} ${svg_LINK_FLAGS})
+  endif(ZLIB_FOUND)
+endif(PLD_svg)
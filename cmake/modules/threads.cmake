@@ -0,0 +1,38 @@
+# cmake/modules/threads.cmake
+#
+# This file is part of PLplot.
+#
+# PLplot is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Library General Public License as published
+# by the Free Software Foundation; version 2 of the License.
+#
+# PLplot is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public License
+# along with the file PLplot; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+#
+# Configuration for running compute-intensive parts of the core library
+# (e.g., plgriddata) on several threads.  The number of threads actually
+# used is set at run time with the -nthreads option.
+# The following variables are set/modified:
+# PL_HAVE_THREADS	  - ON means the core library can use pthreads.
+# THREADS_LIBRARIES	  - libraries needed to link the core library.
+
+option(PL_HAVE_THREADS "Use pthreads for parallel computations in the core library" ON)
+
+if(PL_HAVE_THREADS)
+  find_package(Threads)
+  if(CMAKE_USE_PTHREADS_INIT)
+    set(THREADS_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+  else(CMAKE_USE_PTHREADS_INIT)
+    message(STATUS "WARNING: pthreads not found.  Setting PL_HAVE_THREADS to OFF.")
+    set(PL_HAVE_THREADS OFF
+      CACHE BOOL "Use pthreads for parallel computations in the core library"
+      FORCE
+      )
+  endif(CMAKE_USE_PTHREADS_INIT)
+endif(PL_HAVE_THREADS)
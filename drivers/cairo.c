@@ -74,6 +74,7 @@
 
 #define MAX_STRING_LEN       500
 #define MAX_MARKUP_LEN       MAX_STRING_LEN * 10
+#define MAX_LAYOUTS          1000
 
 static int    text_clipping;
 static int    text_anti_aliasing;
@@ -93,6 +94,17 @@ static DrvOpt cairo_options[] = { { "text_clipping",          DRV_INT, &text_cli
                                   { "image_buffering",        DRV_INT, &image_buffering,        "Buffered offscreen rendering for the xcairo device (image_buffering=0|1)."                                                                                                                                                      },
                                   { NULL,                     DRV_INT, NULL,                    NULL                                                                                                                                                                                                                             } };
 
+// A prepared Pango layout in the layout cache, see get_layout().
+
+typedef struct
+{
+    char        *key;      // font options and markup
+    PangoLayout *layout;
+    int         width;     // pixel width and baseline of the layout
+    int         baseline;
+    GList       *link;     // position in the least recently used queue
+} PLCairoLayout;
+
 typedef struct
 {
     cairo_surface_t *cairoSurface;
@@ -120,6 +132,15 @@ typedef struct
     PLFLT           old_sscale, sscale, old_soffset, soffset;
     PLINT           level;
 
+    // Layouts of the strings drawn with cairoContext, the most recently
+    // used first in the queue, and the transformation and target of the
+    // context they were made for.
+    GHashTable      *layoutCache;
+    GQueue          *layoutQueue;
+    cairo_t         *layoutContext;
+    cairo_matrix_t  layoutMatrix;
+    cairo_surface_t *layoutTarget;
+
 #if defined ( PLD_xcairo )
     cairo_surface_t *cairoSurface_X;
     cairo_t         *cairoContext_X;
@@ -253,6 +274,9 @@ static void text_begin_cairo( PLStream *pls, EscText *args );
 static void text_char_cairo( PLStream *pls, EscText *args );
 static void text_esc_cairo( PLStream *pls, EscText *args );
 static void text_end_cairo( PLStream *pls, EscText *args );
+static PLCairoLayout *get_layout( PLStream *, const char * );
+static void free_layout( gpointer );
+static void clear_layout_cache( PLCairo * );
 static char *ucs4_to_pango_markup_format( PLUNICODE *, int, float );
 static void open_span_tag( char *, PLUNICODE, float, int );
 static void close_span_tag( char *, int );
@@ -264,6 +288,7 @@ static void set_current_context( PLStream * );
 static void poly_line( PLStream *, short *, short *, PLINT );
 static void filled_polygon( PLStream *pls, short *xa, short *ya, PLINT npts );
 static void gradient( PLStream *pls, short *xa, short *ya, PLINT npts );
+static void image( PLStream *pls );
 static void arc( PLStream *, arc_struct * );
 static void rotate_cairo_surface( PLStream *, float, float, float, float, float, float, PLBOOL );
 static void blit_to_x( PLStream *pls, double x, double y, double w, double h );
@@ -371,7 +396,10 @@ void end_raster( PLStream *pls )
     cairo_set_source_surface( aStream->cairoContext, aStream->cairoSurface_raster, 0.0, 0.0 );
     cairo_paint( aStream->cairoContext );
 
-    // Free the now extraneous surface and context
+    // Free the now extraneous surface and context, and the layouts made
+    // for it, if any
+    if ( aStream->layoutContext == aStream->cairoContext_raster )
+        clear_layout_cache( aStream );
     cairo_destroy( aStream->cairoContext_raster );
     cairo_surface_destroy( aStream->cairoSurface_raster );
 }
@@ -501,6 +529,9 @@ void plD_tidy_cairo( PLStream *pls )
 
     aStream = (PLCairo *) pls->dev;
 
+    // Free the layouts, which were made for this context.
+    clear_layout_cache( aStream );
+
     // Free the cairo context and surface.
     cairo_destroy( aStream->cairoContext );
     cairo_surface_destroy( aStream->cairoSurface );
@@ -541,6 +572,9 @@ void plD_esc_cairo( PLStream *pls, PLINT op, void *ptr )
     case PLESC_GRADIENT:     // render a gradient within a polygon.
         gradient( pls, pls->dev_x, pls->dev_y, pls->dev_npts );
         break;
+    case PLESC_IMAGE:        // draw an image
+        image( pls );
+        break;
     case PLESC_HAS_TEXT:
         if ( !pls->alt_unicode )
         {
@@ -772,12 +806,10 @@ void text_esc_cairo( PLStream *pls, EscText *args )
 
 void text_end_cairo( PLStream *pls, EscText *args )
 {
-    int   textXExtent, textYExtent, baseline;
+    int   textXExtent, baseline;
     PLFLT rotation, shear, stride, cos_rot, sin_rot, cos_shear, sin_shear;
     cairo_matrix_t       *cairoTransformMatrix;
-    cairo_font_options_t *cairoFontOptions;
-    PangoContext         *context;
-    PangoLayout          *layout;
+    PLCairoLayout        *cached;
     PLCairo              *aStream;
 
     aStream = (PLCairo *) pls->dev;
@@ -789,11 +821,10 @@ void text_end_cairo( PLStream *pls, EscText *args )
 
     // printf("%s\n", aStream->pangoMarkupString);
 
-    // Create the Pango text layout so we can figure out how big it is
-    layout = pango_cairo_create_layout( aStream->cairoContext );
-    pango_layout_set_markup( layout, aStream->pangoMarkupString, -1 );
-    pango_layout_get_pixel_size( layout, &textXExtent, &textYExtent );
-    baseline = pango_layout_get_baseline( layout );
+    // Get the Pango text layout and how big it is
+    cached      = get_layout( pls, aStream->pangoMarkupString );
+    textXExtent = cached->width;
+    baseline    = cached->baseline;
 
     // If asked, set the string length (in mm) and return
     if ( pls->get_string_length )
@@ -802,14 +833,6 @@ void text_end_cairo( PLStream *pls, EscText *args )
     }
     else
     {
-        // Set font aliasing
-        context          = pango_layout_get_context( layout );
-        cairoFontOptions = cairo_font_options_create();
-        cairo_font_options_set_antialias( cairoFontOptions, aStream->text_anti_aliasing );
-        pango_cairo_context_set_font_options( context, cairoFontOptions );
-        pango_layout_context_changed( layout );
-        cairo_font_options_destroy( cairoFontOptions );
-
         // Save current transform matrix & clipping region
         cairo_save( aStream->cairoContext );
 
@@ -853,14 +876,13 @@ void text_end_cairo( PLStream *pls, EscText *args )
             (double) 0.5 * aStream->fontSize - baseline / 1024.0 );
 
         // Render the text
-        pango_cairo_show_layout( aStream->cairoContext, layout );
+        pango_cairo_show_layout( aStream->cairoContext, cached->layout );
 
         // Restore the transform matrix to its state prior to the text transform.
         cairo_restore( aStream->cairoContext );
     }
 
-    // Free the layout object and the markup string
-    g_object_unref( layout );
+    // Free the markup string, the layout stays in the cache
     free( aStream->pangoMarkupString );
 }
 
@@ -873,13 +895,11 @@ void text_end_cairo( PLStream *pls, EscText *args )
 void proc_str( PLStream *pls, EscText *args )
 {
     float fontSize;
-    int   textXExtent, textYExtent, baseline;
+    int   textXExtent, baseline;
     char                 *textWithPangoMarkup;
     PLFLT rotation, shear, stride, cos_rot, sin_rot, cos_shear, sin_shear;
     cairo_matrix_t       *cairoTransformMatrix;
-    cairo_font_options_t *cairoFontOptions;
-    PangoContext         *context;
-    PangoLayout          *layout;
+    PLCairoLayout        *cached;
     PLCairo              *aStream;
 
     aStream = (PLCairo *) pls->dev;
@@ -906,11 +926,11 @@ void proc_str( PLStream *pls, EscText *args )
     // Convert the escape characters into the appropriate Pango markup
     textWithPangoMarkup = ucs4_to_pango_markup_format( args->unicode_array, args->unicode_array_len, fontSize );
 
-    // Create the Pango text layout so we can figure out how big it is
-    layout = pango_cairo_create_layout( aStream->cairoContext );
-    pango_layout_set_markup( layout, textWithPangoMarkup, -1 );
-    pango_layout_get_pixel_size( layout, &textXExtent, &textYExtent );
-    baseline = pango_layout_get_baseline( layout );
+    // Get the Pango text layout and how big it is
+    cached      = get_layout( pls, textWithPangoMarkup );
+    textXExtent = cached->width;
+    baseline    = cached->baseline;
+    free( textWithPangoMarkup );
 
     // If asked, set the string length (in mm) and return
     if ( pls->get_string_length )
@@ -919,14 +939,6 @@ void proc_str( PLStream *pls, EscText *args )
         return;
     }
 
-    // Set font aliasing
-    context          = pango_layout_get_context( layout );
-    cairoFontOptions = cairo_font_options_create();
-    cairo_font_options_set_antialias( cairoFontOptions, aStream->text_anti_aliasing );
-    pango_cairo_context_set_font_options( context, cairoFontOptions );
-    pango_layout_context_changed( layout );
-    cairo_font_options_destroy( cairoFontOptions );
-
     // Save current transform matrix & clipping region
     cairo_save( aStream->cairoContext );
 
@@ -970,14 +982,132 @@ void proc_str( PLStream *pls, EscText *args )
         (double) 0.5 * fontSize - baseline / 1024.0 );
 
     // Render the text
-    pango_cairo_show_layout( aStream->cairoContext, layout );
+    pango_cairo_show_layout( aStream->cairoContext, cached->layout );
 
     // Restore the transform matrix to its state prior to the text transform.
     cairo_restore( aStream->cairoContext );
+}
 
-    // Free the layout object and the markup string.
-    g_object_unref( layout );
-    free( textWithPangoMarkup );
+//--------------------------------------------------------------------------
+// get_layout()
+//
+// Returns the Pango layout of the markup string for the current context,
+// with its width and baseline.  Axis labels and the like are drawn over
+// and over again, so the layouts are kept in a cache of the stream and
+// only made the first time a string is drawn with a given font size and
+// font options.  The cache is emptied when the cairo context, or its
+// transformation or target surface, changes, as Pango would otherwise
+// have to update the layouts, and the least recently used layout is
+// dropped when it gets too big.
+//--------------------------------------------------------------------------
+
+PLCairoLayout *get_layout( PLStream *pls, const char *markup )
+{
+    cairo_font_options_t *cairoFontOptions;
+    cairo_matrix_t       matrix;
+    PangoContext         *context;
+    PLCairoLayout        *cached;
+    PLCairo              *aStream;
+    char                 *key;
+
+    aStream = (PLCairo *) pls->dev;
+
+    if ( aStream->layoutCache == NULL )
+    {
+        aStream->layoutCache = g_hash_table_new_full( g_str_hash, g_str_equal, NULL, free_layout );
+        aStream->layoutQueue = g_queue_new();
+    }
+
+    // The layouts depend on the context they were made for, which an
+    // external program (extcairo) may transform or redirect between pages
+    cairo_get_matrix( aStream->cairoContext, &matrix );
+    if ( aStream->layoutContext != aStream->cairoContext
+         || aStream->layoutTarget != cairo_get_target( aStream->cairoContext )
+         || matrix.xx != aStream->layoutMatrix.xx || matrix.yx != aStream->layoutMatrix.yx
+         || matrix.xy != aStream->layoutMatrix.xy || matrix.yy != aStream->layoutMatrix.yy
+         || matrix.x0 != aStream->layoutMatrix.x0 || matrix.y0 != aStream->layoutMatrix.y0 )
+    {
+        g_hash_table_remove_all( aStream->layoutCache );
+        g_queue_clear( aStream->layoutQueue );
+        aStream->layoutContext = aStream->cairoContext;
+        aStream->layoutTarget  = cairo_get_target( aStream->cairoContext );
+        aStream->layoutMatrix  = matrix;
+    }
+
+    key    = g_strdup_printf( "%d %s", aStream->text_anti_aliasing, markup );
+    cached = (PLCairoLayout *) g_hash_table_lookup( aStream->layoutCache, key );
+    if ( cached != NULL )
+    {
+        g_free( key );
+        g_queue_unlink( aStream->layoutQueue, cached->link );
+        g_queue_push_head_link( aStream->layoutQueue, cached->link );
+        return cached;
+    }
+
+    // Create the Pango text layout so we can figure out how big it is
+    if ( ( cached = (PLCairoLayout *) malloc( sizeof ( PLCairoLayout ) ) ) == NULL )
+        plexit( "get_layout: Insufficient memory" );
+    cached->key    = key;
+    cached->layout = pango_cairo_create_layout( aStream->cairoContext );
+    pango_layout_set_markup( cached->layout, markup, -1 );
+    pango_layout_get_pixel_size( cached->layout, &cached->width, NULL );
+    cached->baseline = pango_layout_get_baseline( cached->layout );
+
+    // Set font aliasing
+    context          = pango_layout_get_context( cached->layout );
+    cairoFontOptions = cairo_font_options_create();
+    cairo_font_options_set_antialias( cairoFontOptions, aStream->text_anti_aliasing );
+    pango_cairo_context_set_font_options( context, cairoFontOptions );
+    pango_layout_context_changed( cached->layout );
+    cairo_font_options_destroy( cairoFontOptions );
+
+    cached->link       = g_list_alloc();
+    cached->link->data = cached;
+    g_queue_push_head_link( aStream->layoutQueue, cached->link );
+    g_hash_table_insert( aStream->layoutCache, cached->key, cached );
+
+    if ( g_queue_get_length( aStream->layoutQueue ) > MAX_LAYOUTS )
+    {
+        PLCairoLayout *oldest = (PLCairoLayout *) g_queue_pop_tail( aStream->layoutQueue );
+        g_hash_table_remove( aStream->layoutCache, oldest->key );
+    }
+
+    return cached;
+}
+
+//--------------------------------------------------------------------------
+// free_layout()
+//
+// Frees a layout of the layout cache when it is removed from the hash
+// table.
+//--------------------------------------------------------------------------
+
+void free_layout( gpointer data )
+{
+    PLCairoLayout *cached = (PLCairoLayout *) data;
+
+    g_object_unref( cached->layout );
+    g_free( cached->key );
+    free( cached );
+}
+
+//--------------------------------------------------------------------------
+// clear_layout_cache()
+//
+// Frees the layout cache, before the context it was made for goes away.
+//--------------------------------------------------------------------------
+
+void clear_layout_cache( PLCairo *aStream )
+{
+    if ( aStream->layoutCache != NULL )
+    {
+        g_hash_table_destroy( aStream->layoutCache );
+        g_queue_free( aStream->layoutQueue );
+    }
+    aStream->layoutCache   = NULL;
+    aStream->layoutQueue   = NULL;
+    aStream->layoutContext = NULL;
+    aStream->layoutTarget  = NULL;
 }
 
 //--------------------------------------------------------------------------
@@ -1317,6 +1447,7 @@ PLCairo *stream_and_font_setup( PLStream *pls, int interactive )
     pls->page              = 0;
     pls->dev_fill0         = 1;           // Supports hardware solid fills
     pls->dev_gradient      = 1;           // driver renders gradient
+    pls->dev_fastimg       = 1;           // driver renders images
     pls->dev_arc           = 1;           // Supports driver-level arcs
     pls->plbuf_write       = interactive; // Activate plot buffer
     pls->has_string_length = 1;           // Driver supports string length calculations
@@ -1358,9 +1489,13 @@ PLCairo *stream_and_font_setup( PLStream *pls, int interactive )
     aStream->XDisplay = NULL;
     aStream->XWindow  = 0;
 #endif
-    aStream->cairoSurface = NULL;
-    aStream->cairoContext = NULL;
-    aStream->downscale    = downscale;
+    aStream->cairoSurface  = NULL;
+    aStream->cairoContext  = NULL;
+    aStream->layoutCache   = NULL;
+    aStream->layoutQueue   = NULL;
+    aStream->layoutContext = NULL;
+    aStream->layoutTarget  = NULL;
+    aStream->downscale     = downscale;
 
     // Set text clipping on by default since it makes little difference in
     // speed for a modern cairo stack.
@@ -1532,6 +1667,94 @@ void gradient( PLStream *pls, short *xa, short *ya, PLINT npts )
     cairo_pattern_destroy( linear_gradient );
 }
 
+//--------------------------------------------------------------------------
+// image()
+//
+// Render the image of pls->dev_nptsX x pls->dev_nptsY cell corners (see
+// plP_drawimage) as a single image surface with one pixel per cell.  The
+// core only sends images whose cells form an affine grid, so the placement
+// is given by the corners (0, 0), (nx, 0) and (0, ny).
+//--------------------------------------------------------------------------
+
+void image( PLStream *pls )
+{
+    PLCairo         *aStream;
+    cairo_surface_t *surface;
+    cairo_pattern_t *pattern;
+    cairo_matrix_t  matrix;
+    unsigned char   *data;
+    unsigned int    *row;
+    PLINT           nx = pls->dev_nptsX - 1;
+    PLINT           ny = pls->dev_nptsY - 1;
+    PLINT           ix, iy, stride;
+    unsigned char   *rgba;
+    unsigned int    a;
+    double          ox, oy;
+
+    aStream = (PLCairo *) pls->dev;
+
+    if ( nx < 1 || ny < 1 )
+        return;
+
+    // Image rows run along the image x axis, one per iy.  Cairo wants
+    // premultiplied alpha in native endian 32 bit words.
+    surface = cairo_image_surface_create( CAIRO_FORMAT_ARGB32, nx, ny );
+    if ( cairo_surface_status( surface ) != CAIRO_STATUS_SUCCESS )
+    {
+        cairo_surface_destroy( surface );
+        plwarn( "Cairo: image: Could not create image surface" );
+        return;
+    }
+    cairo_surface_flush( surface );
+    data   = cairo_image_surface_get_data( surface );
+    stride = cairo_image_surface_get_stride( surface );
+    for ( iy = 0; iy < ny; iy++ )
+    {
+        row = (unsigned int *) ( data + iy * stride );
+        for ( ix = 0; ix < nx; ix++ )
+        {
+            rgba    = pls->dev_rgba + 4 * ( ix * ny + iy );
+            a       = rgba[3];
+            row[ix] = a << 24 |
+                      ( rgba[0] * a + 127 ) / 255 << 16 |
+                      ( rgba[1] * a + 127 ) / 255 << 8 |
+                      ( rgba[2] * a + 127 ) / 255;
+        }
+    }
+    cairo_surface_mark_dirty( surface );
+
+    cairo_save( aStream->cairoContext );
+
+    cairo_rectangle( aStream->cairoContext,
+        aStream->downscale * (double) pls->imclxmin,
+        aStream->downscale * (double) pls->imclymin,
+        aStream->downscale * (double) ( pls->imclxmax - pls->imclxmin ),
+        aStream->downscale * (double) ( pls->imclymax - pls->imclymin ) );
+    cairo_clip( aStream->cairoContext );
+    cairo_new_path( aStream->cairoContext );
+
+    ox = (double) pls->dev_ix[0];
+    oy = (double) pls->dev_iy[0];
+    cairo_matrix_init( &matrix,
+        aStream->downscale * ( pls->dev_ix[nx * ( ny + 1 )] - ox ) / nx,
+        aStream->downscale * ( pls->dev_iy[nx * ( ny + 1 )] - oy ) / nx,
+        aStream->downscale * ( pls->dev_ix[ny] - ox ) / ny,
+        aStream->downscale * ( pls->dev_iy[ny] - oy ) / ny,
+        aStream->downscale * ox, aStream->downscale * oy );
+    cairo_transform( aStream->cairoContext, &matrix );
+
+    // One cell per pixel, so the cells must not be blurred together.
+    cairo_set_source_surface( aStream->cairoContext, surface, 0., 0. );
+    pattern = cairo_get_source( aStream->cairoContext );
+    cairo_pattern_set_filter( pattern, CAIRO_FILTER_NEAREST );
+    cairo_pattern_set_extend( pattern, CAIRO_EXTEND_PAD );
+    cairo_rectangle( aStream->cairoContext, 0., 0., (double) nx, (double) ny );
+    cairo_fill( aStream->cairoContext );
+
+    cairo_restore( aStream->cairoContext );
+    cairo_surface_destroy( surface );
+}
+
 //--------------------------------------------------------------------------
 // set_clip()
 //
@@ -3187,6 +3410,7 @@ void plD_esc_extcairo( PLStream *pls, PLINT op, void *ptr )
     switch ( op )
     {
     case PLESC_DEVINIT: // Set external context
+        clear_layout_cache( aStream );
         aStream->cairoContext = (cairo_t *) ptr;
         // Set graphics aliasing
         cairo_set_antialias( aStream->cairoContext, aStream->graphics_anti_aliasing );
@@ -3218,12 +3442,13 @@ void plD_esc_extcairo( PLStream *pls, PLINT op, void *ptr )
 //--------------------------------------------------------------------------
 // plD_tidy_extcairo()
 //
-// This is nop, it is up to the calling program to clean up the Cairo
-// context, etc...
+// It is up to the calling program to clean up the Cairo context, etc...
+// so only the layouts made for it are freed here.
 //--------------------------------------------------------------------------
 
-void plD_tidy_extcairo( PLStream * PL_UNUSED( pls ) )
+void plD_tidy_extcairo( PLStream *pls )
 {
+    clear_layout_cache( (PLCairo *) pls->dev );
 }
 
 #endif
@@ -31,11 +31,6 @@ void plD_tidy_mem( PLStream * );
 void plD_state_mem( PLStream *, PLINT );
 void plD_esc_mem( PLStream *, PLINT, void * );
 
-#undef MAX
-#undef ABS
-#define MAX( a, b )    ( ( a > b ) ? a : b )
-#define ABS( a )       ( ( a < 0 ) ? -a : a )
-
 #define MAX_INTENSITY    255
 
 void plD_dispatch_init_mem( PLDispatchTable *pdt )
@@ -84,57 +79,128 @@ plD_init_mem( PLStream *pls )
 
 
     pls->color     = 1;         // Is a color device
-    pls->dev_fill0 = 0;         // Handle solid fills
-    pls->dev_fill1 = 0;         // Use PLplot core fallback for pattern fills
-    pls->nopause   = 1;         // Don't pause between frames
+    pls->dev_fill0 = 1;         // Handle solid fills
+    pls->dev_fill1   = 0;       // Use PLplot core fallback for pattern fills
+    pls->dev_fastimg = 1;       // Draws images pixel by pixel
+    pls->nopause     = 1;       // Don't pause between frames
+}
+
+// Scratch storage of the polygon fill, grown as needed and kept between
+// fills so that filling does not allocate memory once it has warmed up.
+
+typedef struct
+{
+    PLFLT x;      // x at scanline ystart
+    PLFLT dxdy;   // change of x per scanline
+    PLINT ystart; // first scanline crossed
+    PLINT yend;   // first scanline no longer crossed
+    PLINT dir;    // +1 upwards, -1 downwards, for the nonzero rule
+} MemEdge;
+
+typedef struct
+{
+    PLFLT x;
+    PLINT dir;
+} MemCrossing;
+
+static MemEdge     *mem_edges;
+static MemCrossing *mem_crossings;
+static PLINT       *mem_active;
+static PLINT       mem_nalloc;
+
+static void mem_span( PLStream *pls, PLINT row, PLINT x1, PLINT x2 );
+static void mem_fill( PLStream *pls );
+static void mem_image( PLStream *pls );
+
+//--------------------------------------------------------------------------
+// mem_span()
+//
+// Sets the pixels x1 to x2 of image row row to the current color.  The
+// first pixel is stored and then copied over the span in doubling blocks,
+// so long spans cost little more than a memset.
+//--------------------------------------------------------------------------
+
+static void
+mem_span( PLStream *pls, PLINT row, PLINT x1, PLINT x2 )
+{
+    unsigned char *p;
+    size_t        len, n;
+
+    if ( row < 0 || row >= pls->phyyma )
+        return;
+    x1 = MAX( x1, 0 );
+    x2 = MIN( x2, pls->phyxma - 1 );
+    if ( x1 > x2 )
+        return;
+
+    p    = (unsigned char *) pls->dev + 3 * ( (size_t) row * (size_t) pls->phyxma + (size_t) x1 );
+    n    = 3 * (size_t) ( x2 - x1 + 1 );
+    p[0] = pls->curcolor.r;
+    p[1] = pls->curcolor.g;
+    p[2] = pls->curcolor.b;
+    for ( len = 3; len < n; len *= 2 )
+        memcpy( p + len, p, MIN( len, n - len ) );
 }
 
-#define sign( a )    ( ( a < 0 ) ? -1 : ( ( a == 0 ) ? 0 : 1 ) )
+//--------------------------------------------------------------------------
+// plD_line_mem()
+//
+// Draws a line with the integer Bresenham algorithm.  Horizontal lines,
+// such as the many grid and tick lines of a plot, are drawn as spans.
+// Pixels outside of the image are skipped.
+//--------------------------------------------------------------------------
 
 void
 plD_line_mem( PLStream *pls, short x1a, short y1a, short x2a, short y2a )
 {
-    int           i;
-    PLINT         idx;
-    int           x1 = x1a, y1 = y1a, x2 = x2a, y2 = y2a;
-    PLINT         x1b, y1b, x2b, y2b;
-    PLFLT         length, fx, fy, dx, dy;
     unsigned char *mem = (unsigned char *) pls->dev;
+    unsigned char r    = pls->curcolor.r;
+    unsigned char g    = pls->curcolor.g;
+    unsigned char b    = pls->curcolor.b;
     PLINT         xm   = pls->phyxma;
     PLINT         ym   = pls->phyyma;
+    PLINT         x1   = x1a, x2 = x2a;
+    PLINT         dx, dy, sx, sy, err, e2;
+    size_t        idx;
 
     // Take mirror image, since (0,0) must be at top left
 
-    y1 = ym - ( y1 - 0 );
-    y2 = ym - ( y2 - 0 );
-
-    x1b    = x1, x2b = x2, y1b = y1, y2b = y2;
-    length = (PLFLT) sqrt( (double)
-        ( ( x2b - x1b ) * ( x2b - x1b ) + ( y2b - y1b ) * ( y2b - y1b ) ) );
+    PLINT y1 = ym - y1a;
+    PLINT y2 = ym - y2a;
 
-    if ( length == 0. )
-        length = 1.;
-    dx = ( x2 - x1 ) / length;
-    dy = ( y2 - y1 ) / length;
-
-    fx = x1;
-    fy = y1;
-    mem[3 * xm * y1 + 3 * x1 + 0] = pls->curcolor.r;
-    mem[3 * xm * y1 + 3 * x1 + 1] = pls->curcolor.g;
-    mem[3 * xm * y1 + 3 * x1 + 2] = pls->curcolor.b;
-
-    mem[3 * xm * y2 + 3 * x2 + 0] = pls->curcolor.r;
-    mem[3 * xm * y2 + 3 * x2 + 1] = pls->curcolor.g;
-    mem[3 * xm * y2 + 3 * x2 + 2] = pls->curcolor.b;
+    if ( y1 == y2 )
+    {
+        mem_span( pls, y1, MIN( x1, x2 ), MAX( x1, x2 ) );
+        return;
+    }
 
-    for ( i = 1; i <= (int) length; i++ )
+    dx  = ABS( x2 - x1 );
+    dy  = -ABS( y2 - y1 );
+    sx  = x1 < x2 ? 1 : -1;
+    sy  = y1 < y2 ? 1 : -1;
+    err = dx + dy;
+    for (;; )
     {
-        fx          += dx;
-        fy          += dy;
-        idx          = 3 * xm * (PLINT) fy + 3 * (PLINT) fx;
-        mem[idx + 0] = pls->curcolor.r;
-        mem[idx + 1] = pls->curcolor.g;
-        mem[idx + 2] = pls->curcolor.b;
+        if ( x1 >= 0 && x1 < xm && y1 >= 0 && y1 < ym )
+        {
+            idx          = 3 * ( (size_t) y1 * (size_t) xm + (size_t) x1 );
+            mem[idx + 0] = r;
+            mem[idx + 1] = g;
+            mem[idx + 2] = b;
+        }
+        if ( x1 == x2 && y1 == y2 )
+            break;
+        e2 = 2 * err;
+        if ( e2 >= dy )
+        {
+            err += dy;
+            x1  += sx;
+        }
+        if ( e2 <= dx )
+        {
+            err += dx;
+            y1  += sy;
+        }
     }
 }
 
@@ -146,6 +212,195 @@ plD_polyline_mem( PLStream *pls, short *xa, short *ya, PLINT npts )
         plD_line_mem( pls, xa[i], ya[i], xa[i + 1], ya[i + 1] );
 }
 
+static int
+compare_edges( const void *a, const void *b )
+{
+    return ( (const MemEdge *) a )->ystart - ( (const MemEdge *) b )->ystart;
+}
+
+//--------------------------------------------------------------------------
+// mem_fill()
+//
+// Fills the polygon pls->dev_x[], pls->dev_y[] with the current color by
+// scanline conversion.  The edges are sorted by their first scanline and
+// kept in an active list, and on every scanline the pixels between the
+// edge crossings are set as spans, following the nonzero winding rule or,
+// with -eofill, the even-odd rule.  A scanline y crosses an edge if it
+// lies in the half open range of the y values of its ends, so polygons
+// sharing an edge leave no gap between them.
+//--------------------------------------------------------------------------
+
+static void
+mem_fill( PLStream *pls )
+{
+    PLINT   npts = pls->dev_npts;
+    PLINT   ym   = pls->phyyma;
+    PLINT   i, j, k, nedges, nactive, ncross, next, y, ylast, winding;
+    PLINT   x1, y1, x2, y2;
+    MemCrossing c;
+
+    if ( npts < 3 )
+        return;
+
+    if ( npts > mem_nalloc )
+    {
+        free( mem_edges );
+        free( mem_crossings );
+        free( mem_active );
+        mem_nalloc = MAX( npts, 2 * mem_nalloc );
+        if ( ( mem_edges = (MemEdge *) malloc( (size_t) mem_nalloc * sizeof ( MemEdge ) ) ) == NULL ||
+             ( mem_crossings = (MemCrossing *) malloc( (size_t) mem_nalloc * sizeof ( MemCrossing ) ) ) == NULL ||
+             ( mem_active = (PLINT *) malloc( (size_t) mem_nalloc * sizeof ( PLINT ) ) ) == NULL )
+        {
+            plexit( "mem_fill: Insufficient memory" );
+        }
+    }
+
+    // Build the edge table in image rows, skipping horizontal edges.
+
+    nedges = 0;
+    for ( i = 0; i < npts; i++ )
+    {
+        j  = ( i + 1 ) % npts;
+        x1 = pls->dev_x[i];
+        y1 = ym - pls->dev_y[i];
+        x2 = pls->dev_x[j];
+        y2 = ym - pls->dev_y[j];
+        if ( y1 == y2 )
+            continue;
+        if ( y1 < y2 )
+        {
+            mem_edges[nedges].x      = x1;
+            mem_edges[nedges].ystart = y1;
+            mem_edges[nedges].yend   = y2;
+            mem_edges[nedges].dir    = 1;
+        }
+        else
+        {
+            mem_edges[nedges].x      = x2;
+            mem_edges[nedges].ystart = y2;
+            mem_edges[nedges].yend   = y1;
+            mem_edges[nedges].dir    = -1;
+        }
+        mem_edges[nedges].dxdy = (PLFLT) ( x2 - x1 ) / (PLFLT) ( y2 - y1 );
+        nedges++;
+    }
+    if ( nedges == 0 )
+        return;
+    qsort( mem_edges, (size_t) nedges, sizeof ( MemEdge ), compare_edges );
+
+    ylast = 0;
+    for ( i = 0; i < nedges; i++ )
+        ylast = MAX( ylast, mem_edges[i].yend );
+    ylast = MIN( ylast, ym );
+
+    nactive = 0;
+    next    = 0;
+    for ( y = MAX( mem_edges[0].ystart, 0 ); y < ylast; y++ )
+    {
+        // Update the active edge list.
+
+        for ( i = k = 0; i < nactive; i++ )
+        {
+            if ( mem_edges[mem_active[i]].yend > y )
+                mem_active[k++] = mem_active[i];
+        }
+        nactive = k;
+        for (; next < nedges && mem_edges[next].ystart <= y; next++ )
+        {
+            if ( mem_edges[next].yend > y )
+                mem_active[nactive++] = next;
+        }
+
+        // Sort the crossings by x.  They change order only where edges
+        // cross, so insertion sort is close to linear.
+
+        for ( ncross = 0; ncross < nactive; ncross++ )
+        {
+            MemEdge *e = &mem_edges[mem_active[ncross]];
+            c.x   = e->x + e->dxdy * (PLFLT) ( y - e->ystart );
+            c.dir = e->dir;
+            for ( k = ncross; k > 0 && mem_crossings[k - 1].x > c.x; k-- )
+                mem_crossings[k] = mem_crossings[k - 1];
+            mem_crossings[k] = c;
+        }
+
+        winding = 0;
+        for ( i = 0; i < ncross - 1; i++ )
+        {
+            if ( pls->dev_eofill )
+                winding ^= 1;
+            else
+                winding += mem_crossings[i].dir;
+            if ( winding != 0 )
+                mem_span( pls, y, (PLINT) ceil( mem_crossings[i].x ),
+                    (PLINT) floor( mem_crossings[i + 1].x ) );
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+// mem_image()
+//
+// Draws the image of pls->dev_nptsX x pls->dev_nptsY cell corners (see
+// plP_drawimage) by setting the pixels of every cell to its cmap1 color.
+// A cell covers the pixels in the half open ranges of the physical
+// coordinates of its corners, within the image clip window.
+//--------------------------------------------------------------------------
+
+static void
+mem_image( PLStream *pls )
+{
+    unsigned char  *mem = (unsigned char *) pls->dev;
+    PLINT          nx   = pls->dev_nptsX;
+    PLINT          ny   = pls->dev_nptsY;
+    PLINT          ym   = pls->phyyma;
+    PLINT          ix, iy, k, x, y, x1, x2, y1, y2;
+    PLINT          c[4];
+    unsigned short icol1;
+    unsigned char  *p;
+
+    for ( ix = 0; ix < nx - 1; ix++ )
+    {
+        for ( iy = 0; iy < ny - 1; iy++ )
+        {
+            icol1 = pls->dev_z[ix * ( ny - 1 ) + iy];
+            if ( icol1 > pls->dev_zmax || icol1 >= pls->ncol1 )
+                continue;
+
+            c[0] = ix * ny + iy;
+            c[1] = c[0] + 1;
+            c[2] = c[0] + ny;
+            c[3] = c[2] + 1;
+            x1   = x2 = pls->dev_ix[c[0]];
+            y1   = y2 = pls->dev_iy[c[0]];
+            for ( k = 1; k < 4; k++ )
+            {
+                x1 = MIN( x1, pls->dev_ix[c[k]] );
+                x2 = MAX( x2, pls->dev_ix[c[k]] );
+                y1 = MIN( y1, pls->dev_iy[c[k]] );
+                y2 = MAX( y2, pls->dev_iy[c[k]] );
+            }
+            x1 = MAX( x1, MAX( pls->imclxmin, 0 ) );
+            x2 = MIN( x2, MIN( pls->imclxmax, pls->phyxma ) );
+            y1 = MAX( y1, MAX( pls->imclymin, 0 ) );
+            y2 = MIN( y2, MIN( pls->imclymax, ym ) );
+
+            // Image rows run downwards from the top
+            for ( y = ym - y2; y < ym - y1; y++ )
+            {
+                p = mem + 3 * ( (size_t) y * (size_t) pls->phyxma + (size_t) x1 );
+                for ( x = x1; x < x2; x++, p += 3 )
+                {
+                    p[0] = pls->cmap1[icol1].r;
+                    p[1] = pls->cmap1[icol1].g;
+                    p[2] = pls->cmap1[icol1].b;
+                }
+            }
+        }
+    }
+}
+
 void
 plD_eop_mem( PLStream *pls )
 {
@@ -165,7 +420,13 @@ plD_bop_mem( PLStream * PL_UNUSED( pls ) )
 void
 plD_tidy_mem( PLStream * PL_UNUSED( pls ) )
 {
-// Nothing to do here
+    free( mem_edges );
+    free( mem_crossings );
+    free( mem_active );
+    mem_edges     = NULL;
+    mem_crossings = NULL;
+    mem_active    = NULL;
+    mem_nalloc    = 0;
 }
 
 void
@@ -175,9 +436,17 @@ plD_state_mem( PLStream * PL_UNUSED( pls ), PLINT PL_UNUSED( op ) )
 }
 
 void
-plD_esc_mem( PLStream *PL_UNUSED( pls ), PLINT PL_UNUSED( op ), void * PL_UNUSED( ptr ) )
+plD_esc_mem( PLStream *pls, PLINT op, void * PL_UNUSED( ptr ) )
 {
-// Nothing to do here
+    switch ( op )
+    {
+    case PLESC_FILL:
+        mem_fill( pls );
+        break;
+    case PLESC_IMAGE:
+        mem_image( pls );
+        break;
+    }
 }
 
 #endif                          // PLD_mem
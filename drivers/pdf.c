@@ -104,6 +104,8 @@ static jmp_buf env;
 // General
 //static short desired_offset( short, double );
 static void poly_line( PLStream *pls, short *xa, short *ya, PLINT npts, short fill );
+static void draw_image( PLStream *pls );
+static void image_block( PLStream *pls, PLINT ix0, PLINT iy0, PLINT nx, PLINT ny );
 
 // String processing
 static void process_string( PLStream *, EscText * );
@@ -217,9 +219,10 @@ void plD_init_pdf( PLStream *pls )
             pls->dev_hrshsym = 1;
     }
 
-    pls->page      = 0;
-    pls->dev_fill0 = 1;         // supports hardware solid fills
-    pls->dev_fill1 = 0;         // Use PLplot core fallback for pattern fills
+    pls->page        = 0;
+    pls->dev_fill0   = 1;       // supports hardware solid fills
+    pls->dev_fill1   = 0;       // Use PLplot core fallback for pattern fills
+    pls->dev_fastimg = 1;       // draws images as image XObjects
 
     pls->graphx = GRAPHICS_MODE;
 
@@ -433,6 +436,9 @@ void plD_esc_pdf( PLStream *pls, PLINT op, void *ptr )
     case PLESC_FILL:    // fill polygon
         poly_line( pls, pls->dev_x, pls->dev_y, pls->dev_npts, 1 );
         break;
+    case PLESC_IMAGE:   // draw image
+        draw_image( pls );
+        break;
     case PLESC_HAS_TEXT: // render text
         process_string( pls, (EscText *) ptr );
         break;
@@ -476,6 +482,113 @@ void poly_line( PLStream *pls, short *xa, short *ya, PLINT npts, short fill )
 }
 
 
+//--------------------------------------------------------------------------
+// draw_image()
+//
+// Draws the image of pls->dev_nptsX x pls->dev_nptsY cell corners (see
+// plP_drawimage) clipped to the image clip limits.  The driver does not
+// handle transparency, so if cells are not to be plotted the image is
+// drawn as runs of plotted cells along each row.
+//--------------------------------------------------------------------------
+void draw_image( PLStream *pls )
+{
+    pdfdev* dev = (pdfdev *) pls->dev;
+    PLINT nx    = pls->dev_nptsX - 1;
+    PLINT ny    = pls->dev_nptsY - 1;
+    PLINT ix, iy, ix0, i;
+    int   all = 1;
+
+    if ( nx < 1 || ny < 1 )
+        return;
+
+    for ( i = 0; i < nx * ny && all; i++ )
+        all = pls->dev_z[i] <= pls->dev_zmax && pls->dev_z[i] < pls->ncol1;
+
+    HPDF_Page_GSave( dev->page );
+    HPDF_Page_Rectangle( dev->page, (HPDF_REAL) pls->imclxmin, (HPDF_REAL) pls->imclymin,
+        (HPDF_REAL) ( pls->imclxmax - pls->imclxmin ), (HPDF_REAL) ( pls->imclymax - pls->imclymin ) );
+    HPDF_Page_Clip( dev->page );
+    HPDF_Page_EndPath( dev->page );
+
+    if ( all )
+        image_block( pls, 0, 0, nx, ny );
+    else
+    {
+        for ( iy = 0; iy < ny; iy++ )
+        {
+            for ( ix = 0; ix < nx; ix++ )
+            {
+                for ( ix0 = ix; ix < nx; ix++ )
+                {
+                    i = pls->dev_z[ix * ny + iy];
+                    if ( i > pls->dev_zmax || i >= pls->ncol1 )
+                        break;
+                }
+                if ( ix > ix0 )
+                    image_block( pls, ix0, iy, ix - ix0, 1 );
+            }
+        }
+    }
+
+    HPDF_Page_GRestore( dev->page );
+}
+
+
+//--------------------------------------------------------------------------
+// image_block()
+//
+// Draws the nx x ny image cells starting at cell (ix0, iy0), which must all
+// be plotted, as one RGB image.
+//--------------------------------------------------------------------------
+void image_block( PLStream *pls, PLINT ix0, PLINT iy0, PLINT nx, PLINT ny )
+{
+    pdfdev        * dev = (pdfdev *) pls->dev;
+    PLINT         ncx   = pls->dev_nptsX - 1;
+    PLINT         ncy   = pls->dev_nptsY - 1;
+    PLINT         ix, iy;
+    PLColor       *col;
+    unsigned char *rgb, *p;
+    HPDF_Image    image;
+    HPDF_REAL     ox, oy, ex[2], ey[2];
+
+    // PDF images are drawn top row first into the unit square, so the rows
+    // are stored from the last iy down.
+    if ( ( rgb = (unsigned char *) malloc( (size_t) nx * (size_t) ny * 3 ) ) == NULL )
+        plexit( "pdf: image_block: Insufficient memory" );
+    p = rgb;
+    for ( iy = iy0 + ny - 1; iy >= iy0; iy-- )
+    {
+        for ( ix = ix0; ix < ix0 + nx; ix++ )
+        {
+            col  = &pls->cmap1[pls->dev_z[ix * ncy + iy]];
+            *p++ = col->r;
+            *p++ = col->g;
+            *p++ = col->b;
+        }
+    }
+    image = HPDF_LoadRawImageFromMem( dev->pdf, rgb, (HPDF_UINT) nx, (HPDF_UINT) ny,
+        HPDF_CS_DEVICE_RGB, 8 );
+    free( rgb );
+
+    // The grid is affine, so the cell edges follow from the corners
+    // (0, 0), (ncx, 0) and (0, ncy) of the whole image.
+    ox    = (HPDF_REAL) pls->dev_ix[0];
+    oy    = (HPDF_REAL) pls->dev_iy[0];
+    ex[0] = ( (HPDF_REAL) pls->dev_ix[ncx * ( ncy + 1 )] - ox ) / (HPDF_REAL) ncx;
+    ex[1] = ( (HPDF_REAL) pls->dev_iy[ncx * ( ncy + 1 )] - oy ) / (HPDF_REAL) ncx;
+    ey[0] = ( (HPDF_REAL) pls->dev_ix[ncy] - ox ) / (HPDF_REAL) ncy;
+    ey[1] = ( (HPDF_REAL) pls->dev_iy[ncy] - oy ) / (HPDF_REAL) ncy;
+
+    HPDF_Page_GSave( dev->page );
+    HPDF_Page_Concat( dev->page, ex[0] * (HPDF_REAL) nx, ex[1] * (HPDF_REAL) nx,
+        ey[0] * (HPDF_REAL) ny, ey[1] * (HPDF_REAL) ny,
+        ox + ex[0] * (HPDF_REAL) ix0 + ey[0] * (HPDF_REAL) iy0,
+        oy + ex[1] * (HPDF_REAL) ix0 + ey[1] * (HPDF_REAL) iy0 );
+    HPDF_Page_DrawImage( dev->page, image, 0, 0, 1, 1 );
+    HPDF_Page_GRestore( dev->page );
+}
+
+
 //--------------------------------------------------------------------------
 //  unsigned char plunicode2type1 (const PLUNICODE index,
 //   const Unicode_to_Type1_table lookup[], const int number_of_entries)
@@ -59,6 +59,7 @@ static void WriteFileHeader( PLStream *pls );
 static void UpdatePrevPagehdr( PLStream *pls );
 static void WritePageInfo( PLStream *pls, FPOS_T pp_offset );
 static void UpdateIndex( PLStream *pls, FPOS_T cp_offset );
+static void WritePageIndex( PLStream *pls );
 static void plm_fill( PLStream *pls );
 static void plm_swin( PLStream *pls );
 static void plm_text( PLStream *pls, EscText *args );
@@ -251,21 +252,32 @@ plD_line_plm( PLStream *pls, short x1, short y1, short x2, short y2 )
 // plD_polyline_plm()
 //
 // Draw a polyline in the current color.
+// The core passes polylines of any length, but readers such as plrender
+// take at most PL_MAXPOLY points per POLYLINE command, so longer ones are
+// written in pieces of (PL_MAXPOLY-1) segments that repeat the last point.
 //--------------------------------------------------------------------------
 
 void
 plD_polyline_plm( PLStream *pls, short *xa, short *ya, PLINT npts )
 {
     PLmDev *dev = (PLmDev *) pls->dev;
+    PLINT  ib = 0, ilim;
 
     dbug_enter( "plD_polyline_plm" );
 
-    plm_wr( pdf_wr_1byte( pls->pdfs, (U_CHAR) POLYLINE ) );
+    do
+    {
+        ilim = MIN( PL_MAXPOLY, npts - ib );
+
+        plm_wr( pdf_wr_1byte( pls->pdfs, (U_CHAR) POLYLINE ) );
+
+        plm_wr( pdf_wr_2bytes( pls->pdfs, (U_SHORT) ilim ) );
 
-    plm_wr( pdf_wr_2bytes( pls->pdfs, (U_SHORT) npts ) );
+        plm_wr( pdf_wr_2nbytes( pls->pdfs, (U_SHORT *) xa + ib, ilim ) );
+        plm_wr( pdf_wr_2nbytes( pls->pdfs, (U_SHORT *) ya + ib, ilim ) );
 
-    plm_wr( pdf_wr_2nbytes( pls->pdfs, (U_SHORT *) xa, npts ) );
-    plm_wr( pdf_wr_2nbytes( pls->pdfs, (U_SHORT *) ya, npts ) );
+        ib += PL_MAXPOLY - 1;
+    } while ( ib < npts - 1 );
 
     dev->xold = xa[npts - 1];
     dev->yold = ya[npts - 1];
@@ -339,10 +351,15 @@ plD_bop_plm( PLStream *pls )
 void
 plD_tidy_plm( PLStream *pls )
 {
+    PLmDev *dev = (PLmDev *) pls->dev;
+
     dbug_enter( "plD_tidy_plm" );
 
     plm_wr( pdf_wr_1byte( pls->pdfs, (U_CHAR) CLOSE ) );
+    if ( pls->output_type == 0 )
+        WritePageIndex( pls );
     pdf_close( pls->pdfs );
+    free_mem( dev->page_offsets );
     free_mem( pls->dev );
 }
 
@@ -705,6 +722,17 @@ WritePageInfo( PLStream *pls, FPOS_T pp_offset )
             plexit( "WritePageInfo (plmeta.c): fgetpos call failed" );
 
         UpdateIndex( pls, cp_offset );
+
+        // Remember where the page starts for the page index
+        if ( dev->n_pages >= dev->max_pages )
+        {
+            dev->max_pages = dev->max_pages > 0 ? 2 * dev->max_pages : 64;
+            dev->page_offsets = (U_LONG *) realloc( (void *) dev->page_offsets,
+                (size_t) dev->max_pages * sizeof ( U_LONG ) );
+            if ( dev->page_offsets == NULL )
+                plexit( "WritePageInfo (plmeta.c): Out of memory." );
+        }
+        dev->page_offsets[dev->n_pages++] = (U_LONG) cp_offset;
     }
 
     // Write new page header
@@ -852,6 +880,42 @@ UpdateIndex( PLStream *pls, FPOS_T cp_offset )
     }
 }
 
+//--------------------------------------------------------------------------
+// WritePageIndex()
+//
+// Write the page index after the CLOSE command.  Layout as follows:
+//
+// PAGE_INDEX		(U_CHAR)
+// number of pages	(U_LONG)
+// page offsets		(U_LONG each, of the BOP commands)
+// index offset		(U_LONG, of the PAGE_INDEX command)
+// PLMETA_INDEX_TAG	(4 bytes)
+//
+// Readers that do not know about the index stop at the CLOSE.
+//--------------------------------------------------------------------------
+
+static void
+WritePageIndex( PLStream *pls )
+{
+    PLmDev *dev = (PLmDev *) pls->dev;
+    FPOS_T ix_offset = 0;
+    PLINT  i;
+
+    if ( dev->n_pages == 0 )
+        return;
+
+    if ( pl_fgetpos( pls->OutFile, &ix_offset ) )
+        plexit( "WritePageIndex (plmeta.c): fgetpos call failed" );
+
+    plm_wr( pdf_wr_1byte( pls->pdfs, (U_CHAR) PAGE_INDEX ) );
+    plm_wr( pdf_wr_4bytes( pls->pdfs, (U_LONG) dev->n_pages ) );
+    for ( i = 0; i < dev->n_pages; i++ )
+        plm_wr( pdf_wr_4bytes( pls->pdfs, dev->page_offsets[i] ) );
+    plm_wr( pdf_wr_4bytes( pls->pdfs, (U_LONG) ix_offset ) );
+    for ( i = 0; i < 4; i++ )
+        plm_wr( pdf_wr_1byte( pls->pdfs, (U_CHAR) PLMETA_INDEX_TAG[i] ) );
+}
+
 #else
 int
 pldummy_plmeta()
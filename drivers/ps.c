@@ -60,6 +60,8 @@ void plD_dispatch_init_psc( PLDispatchTable *pdt );
 static char  *ps_getdate( void );
 static void  ps_init( PLStream * );
 static void  fill_polygon( PLStream *pls );
+static void  draw_image( PLStream *pls );
+static void  image_block( PLStream *pls, PLINT ix0, PLINT iy0, PLINT nx, PLINT ny );
 static void  proc_str( PLStream *, EscText * );
 static void  esc_purge( unsigned char *, unsigned char * );
 
@@ -187,7 +189,8 @@ ps_init( PLStream *pls )
             pls->dev_hrshsym = 1;            // want Hershey symbols
     }
 
-    pls->dev_fill0 = 1;         // Can do solid fills
+    pls->dev_fill0   = 1;       // Can do solid fills
+    pls->dev_fastimg = 1;       // Can draw images
 
 // Initialize family file info
 
@@ -647,6 +650,9 @@ plD_esc_ps( PLStream *pls, PLINT op, void *ptr )
     case PLESC_FILL:
         fill_polygon( pls );
         break;
+    case PLESC_IMAGE:
+        draw_image( pls );
+        break;
     case PLESC_HAS_TEXT:
         proc_str( pls, (EscText *) ptr );
         break;
@@ -717,6 +723,143 @@ fill_polygon( PLStream *pls )
     fprintf( OF, " F " );
 }
 
+//--------------------------------------------------------------------------
+// draw_image()
+//
+// Draw the image of pls->dev_nptsX x pls->dev_nptsY cell corners in
+// pls->dev_ix[], pls->dev_iy[] with the cmap1 colors in pls->dev_z[] (see
+// plP_drawimage), one image sample per cell.  The cells form an affine
+// grid, which is mapped onto the unit square of the image operator.  The
+// whole image is drawn at once unless it has cells that are not plotted,
+// in which case every row is drawn in runs of plotted cells.
+//--------------------------------------------------------------------------
+
+static void
+draw_image( PLStream *pls )
+{
+    PSDev *dev = (PSDev *) pls->dev;
+    PLINT nx   = pls->dev_nptsX - 1;
+    PLINT ny   = pls->dev_nptsY - 1;
+    PLINT ix, iy, ix0, i;
+    PLINT x[4], y[4];
+    int   all = 1;
+
+    if ( nx < 1 || ny < 1 )
+        return;
+
+    for ( i = 0; i < nx * ny && all; i++ )
+        all = pls->dev_z[i] <= pls->dev_zmax && pls->dev_z[i] < pls->ncol1;
+
+    // Clip to the image clip limits
+
+    x[0] = x[1] = pls->imclxmin;
+    x[2] = x[3] = pls->imclxmax;
+    y[0] = y[3] = pls->imclymin;
+    y[1] = y[2] = pls->imclymax;
+    for ( i = 0; i < 4; i++ )
+        plRotPhy( ORIENTATION, dev->xmin, dev->ymin, dev->xmax, dev->ymax, &x[i], &y[i] );
+    fprintf( OF, " S\ngsave %d %d %d %d %d %d %d %d CL\n",
+        x[0], y[0], x[1], y[1], x[2], y[2], x[3], y[3] );
+
+    if ( all )
+        image_block( pls, 0, 0, nx, ny );
+    else
+    {
+        for ( iy = 0; iy < ny; iy++ )
+        {
+            for ( ix = 0; ix < nx; ix++ )
+            {
+                for ( ix0 = ix; ix < nx; ix++ )
+                {
+                    i = pls->dev_z[ix * ny + iy];
+                    if ( i > pls->dev_zmax || i >= pls->ncol1 )
+                        break;
+                }
+                if ( ix > ix0 )
+                    image_block( pls, ix0, iy, ix - ix0, 1 );
+            }
+        }
+    }
+
+    fprintf( OF, "grestore\n" );
+    pls->linepos = 0;
+    dev->xold    = PL_UNDEFINED;
+    dev->yold    = PL_UNDEFINED;
+}
+
+//--------------------------------------------------------------------------
+// image_block()
+//
+// Draw the nx x ny image cells starting at cell (ix0, iy0), which must all
+// be plotted, as one image.
+//--------------------------------------------------------------------------
+
+static void
+image_block( PLStream *pls, PLINT ix0, PLINT iy0, PLINT nx, PLINT ny )
+{
+    PSDev   *dev = (PSDev *) pls->dev;
+    PLINT   ncy  = pls->dev_nptsY;
+    PLINT   ix, iy, i, n = 0;
+    PLINT   x[3], y[3];
+    PLFLT   cx[3], cy[3], ex[2], ey[2];
+    PLColor *col;
+
+    // The corners (0, 0), (nx, 0) and (0, ny) of the block, from those of
+    // the whole image, as the grid is affine.
+
+    for ( i = 0; i < 3; i++ )
+    {
+        x[i] = pls->dev_ix[i == 1 ? ( pls->dev_nptsX - 1 ) * ncy : i == 2 ? ncy - 1 : 0];
+        y[i] = pls->dev_iy[i == 1 ? ( pls->dev_nptsX - 1 ) * ncy : i == 2 ? ncy - 1 : 0];
+        plRotPhy( ORIENTATION, dev->xmin, dev->ymin, dev->xmax, dev->ymax, &x[i], &y[i] );
+    }
+    ex[0] = (PLFLT) ( x[1] - x[0] ) / ( pls->dev_nptsX - 1 );
+    ex[1] = (PLFLT) ( y[1] - y[0] ) / ( pls->dev_nptsX - 1 );
+    ey[0] = (PLFLT) ( x[2] - x[0] ) / ( ncy - 1 );
+    ey[1] = (PLFLT) ( y[2] - y[0] ) / ( ncy - 1 );
+    cx[0] = x[0] + ix0 * ex[0] + iy0 * ey[0];
+    cy[0] = y[0] + ix0 * ex[1] + iy0 * ey[1];
+    cx[1] = cx[0] + nx * ex[0];
+    cy[1] = cy[0] + nx * ex[1];
+    cx[2] = cx[0] + ny * ey[0];
+    cy[2] = cy[0] + ny * ey[1];
+    for ( i = 0; i < 3; i++ )
+    {
+        dev->llx = MIN( dev->llx, (int) cx[i] );
+        dev->lly = MIN( dev->lly, (int) cy[i] );
+        dev->urx = MAX( dev->urx, (int) cx[i] );
+        dev->ury = MAX( dev->ury, (int) cy[i] );
+    }
+    dev->llx = MIN( dev->llx, (int) ( cx[1] + cx[2] - cx[0] ) );
+    dev->lly = MIN( dev->lly, (int) ( cy[1] + cy[2] - cy[0] ) );
+    dev->urx = MAX( dev->urx, (int) ( cx[1] + cx[2] - cx[0] ) );
+    dev->ury = MAX( dev->ury, (int) ( cy[1] + cy[2] - cy[0] ) );
+
+    fprintf( OF, "gsave [%.4f %.4f %.4f %.4f %.4f %.4f] concat\n",
+        TRMFLT( cx[1] - cx[0] ), TRMFLT( cy[1] - cy[0] ),
+        TRMFLT( cx[2] - cx[0] ), TRMFLT( cy[2] - cy[0] ), cx[0], cy[0] );
+    fprintf( OF, "/picstr %d string def\n", ( pls->color ? 3 : 1 ) * nx );
+    fprintf( OF, "%d %d 8 [%d 0 0 %d 0 0] {currentfile picstr readhexstring pop}",
+        nx, ny, nx, ny );
+    fprintf( OF, pls->color ? " false 3 colorimage\n" : " image\n" );
+
+    for ( iy = iy0; iy < iy0 + ny; iy++ )
+    {
+        for ( ix = ix0; ix < ix0 + nx; ix++ )
+        {
+            col = &pls->cmap1[pls->dev_z[ix * ( ncy - 1 ) + iy]];
+            if ( pls->color )
+                fprintf( OF, "%02x%02x%02x", col->r, col->g, col->b );
+            else
+                fprintf( OF, "%02x", 255 - col->r );
+            if ( ++n % 12 == 0 )
+                putc( '\n', OF );
+        }
+    }
+    fprintf( OF, "\ngrestore\n" );
+    pls->bytecnt += ( pls->color ? 6 : 2 ) * nx * ny;
+}
+
 //--------------------------------------------------------------------------
 // ps_getdate()
 //
@@ -261,6 +261,7 @@ void plD_init_rasterqt( PLStream * pls )
     pls->dev_fill0    = 1;
     pls->dev_fill1    = 0;
     pls->dev_gradient = 1;      // driver renders gradient
+    pls->dev_fastimg  = 1;      // driver renders images
     // Let the PLplot core handle dashed lines since
     // the driver results for this capability have a number of issues.
     // pls->dev_dash=1;
@@ -427,6 +428,10 @@ void plD_esc_rasterqt( PLStream * pls, PLINT op, void* ptr )
         delete[] alpha;
         break;
 
+    case PLESC_IMAGE:
+        widget->drawImage();
+        break;
+
     case PLESC_HAS_TEXT:
         //  call the generic ProcessString function
         //  ProcessString( pls, (EscText *)ptr );
@@ -689,6 +694,7 @@ void plD_init_svgqt( PLStream * pls )
     pls->dev_fill0    = 1;
     pls->dev_fill1    = 0;
     pls->dev_gradient = 1;      // driver renders gradient
+    pls->dev_fastimg  = 1;      // driver renders images
     // Let the PLplot core handle dashed lines since
     // the driver results for this capability have a number of issues.
     // pls->dev_dash=1;
@@ -869,6 +875,10 @@ void plD_esc_svgqt( PLStream * pls, PLINT op, void* ptr )
         delete[] alpha;
         break;
 
+    case PLESC_IMAGE:
+        widget->drawImage();
+        break;
+
     case PLESC_HAS_TEXT:
         // call the generic ProcessString function
         //  ProcessString( pls, (EscText *)ptr );
@@ -978,6 +988,7 @@ void plD_init_epspdfqt( PLStream * pls )
     pls->dev_fill0    = 1;
     pls->dev_fill1    = 0;
     pls->dev_gradient = 1;      // driver renders gradient
+    pls->dev_fastimg  = 1;      // driver renders images
     pls->dev_arc      = 1;      // driver renders arcs
     // Let the PLplot core handle dashed lines since
     // the driver results for this capability have a number of issues.
@@ -1159,6 +1170,10 @@ void plD_esc_epspdfqt( PLStream * pls, PLINT op, void* ptr )
         delete[] alpha;
         break;
 
+    case PLESC_IMAGE:
+        widget->drawImage();
+        break;
+
     case PLESC_HAS_TEXT:
         // call the generic ProcessString function
         //  ProcessString( pls, (EscText *)ptr );
@@ -28,6 +28,9 @@
 
 #include <stdarg.h>
 #include <math.h>
+#ifdef PL_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 // PLplot header files
 
@@ -46,6 +49,9 @@
 // This has been generated empirically by looking carefully at results from
 // examples 1 and 2.
 
+// Size of the output buffer of a stream
+#define SVG_BUFFER_SIZE      65536
+
 #define FONT_SIZE_RATIO      1.34
 #define FONT_SHIFT_RATIO     0.705
 #define FONT_SHIFT_OFFSET    0.5
@@ -57,7 +63,12 @@ PLDLLIMPEXP_DRIVER const char* plD_DEVICE_INFO_svg = "svg:Scalable Vector Graphi
 static int    already_warned = 0;
 
 static int    text_clipping = 1;
-static DrvOpt svg_options[] = { { "text_clipping", DRV_INT, &text_clipping, "Use text clipping (text_clipping=0|1)" } };
+static int    precision     = 2;
+static int    path_data     = 0;
+static DrvOpt svg_options[] = { { "text_clipping", DRV_INT, &text_clipping, "Use text clipping (text_clipping=0|1)"                                   },
+                                { "precision",     DRV_INT, &precision,     "Number of decimals of the coordinates (precision=0..4)"                  },
+                                { "path",          DRV_INT, &path_data,     "Write lines and polygons as path data with relative moves (path=0|1)" },
+                                { NULL,            DRV_INT, NULL,           NULL                                                                      } };
 
 typedef struct
 {
@@ -69,7 +80,13 @@ typedef struct
     int   svgIndent;
     FILE  *svgFile;
     int   gradient_index;
+    int   image_index;
+    int   marker_index;
+    int   precision;
+    int   pathData;
     //  char curColor[7];
+    char   buffer[SVG_BUFFER_SIZE];
+    size_t bufferLength;
 } SVG;
 
 // font stuff
@@ -89,6 +106,12 @@ static void svg_attr_values( SVG *, const char *, const char *, ... );
 static void svg_close( SVG *, const char * );
 static void svg_general( SVG *, const char * );
 static void svg_indent( SVG * );
+static void svg_write( SVG *, const char *, size_t );
+static void svg_printf( SVG *, const char *, ... );
+static void svg_flush( SVG * );
+static char *svg_format_number( char *, double, int );
+static char *svg_format_fixed( char *, long, int );
+static void svg_points( SVG *, short *, short *, PLINT );
 static void svg_stroke_width( PLStream * );
 static void svg_stroke_color( PLStream * );
 static void svg_fill_color( PLStream * );
@@ -100,13 +123,19 @@ static int svg_family_check( PLStream * );
 
 static void poly_line( PLStream *, short *, short *, PLINT, short );
 static void gradient( PLStream *, short *, short *, PLINT );
-static void write_hex( FILE *, unsigned char );
-static void write_unicode( FILE *, PLUNICODE );
-static void specify_font( FILE *, PLUNICODE );
+static void image( PLStream * );
+static unsigned char *svg_png_encode( unsigned char *, int, int, size_t * );
+static void write_base64( SVG *, const unsigned char *, size_t );
+static void write_hex( SVG *, unsigned char );
+static void write_unicode( SVG *, PLUNICODE );
+static void specify_font( SVG *, PLUNICODE );
 
 // String processing
 
 static void proc_str( PLStream *, EscText * );
+static void text_clip( PLStream * );
+static void text_element( PLStream *, EscText *, int );
+static void markers( PLStream *, EscMarkers * );
 
 // PLplot interface functions
 
@@ -166,6 +195,8 @@ void plD_init_svg( PLStream *pls )
     pls->dev_fill0    = 1;      // driver generates solid fills
     pls->dev_fill1    = 0;      // Use PLplot core fallback for pattern fills
     pls->dev_gradient = 1;      // driver renders gradient
+    pls->dev_fastimg  = 1;      // driver embeds images as PNG data
+    pls->dev_markers  = 1;      // driver draws markers as references to one glyph
 
     pls->graphx = GRAPHICS_MODE;
 
@@ -221,9 +252,13 @@ void plD_init_svg( PLStream *pls )
         aStream->textClipping = 1;
     }
     aStream->textClipping = (short) text_clipping;
+    aStream->precision    = MAX( 0, MIN( precision, 4 ) );
+    aStream->pathData     = path_data;
 
     aStream->svgIndent      = 0;
     aStream->gradient_index = 0;
+    aStream->image_index    = 0;
+    aStream->marker_index   = 0;
     svg_general( aStream, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" );
     svg_general( aStream, "<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\"\n" );
     svg_general( aStream, "        \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n" );
@@ -301,13 +336,34 @@ void plD_line_svg( PLStream *pls, short x1a, short y1a, short x2a, short y2a )
     {
         return;
     }
-    svg_open( aStream, "polyline" );
+    svg_open( aStream, aStream->pathData ? "path" : "polyline" );
     svg_stroke_width( pls );
     svg_stroke_color( pls );
     svg_attr_value( aStream, "fill", "none" );
     // svg_attr_value(aStream, "shape-rendering", "crispEdges");
-    svg_attr_values( aStream, "points", "%r,%r %r,%r", (double) x1a / aStream->scale, (double) y1a / aStream->scale, (double) x2a / aStream->scale, (double) y2a / aStream->scale );
-    svg_open_end( aStream );
+    if ( aStream->pathData )
+    {
+        short xa[2] = { x1a, x2a }, ya[2] = { y1a, y2a };
+
+        svg_points( aStream, xa, ya, 2 );
+    }
+    else
+    {
+        char buffer[100], *p = buffer;
+
+        svg_indent( aStream );
+        p    = svg_format_number( p + 8, (double) x1a / aStream->scale, aStream->precision );
+        *p++ = ',';
+        p    = svg_format_number( p, (double) y1a / aStream->scale, aStream->precision );
+        *p++ = ' ';
+        p    = svg_format_number( p, (double) x2a / aStream->scale, aStream->precision );
+        *p++ = ',';
+        p    = svg_format_number( p, (double) y2a / aStream->scale, aStream->precision );
+        memcpy( buffer, "points=\"", 8 );
+        memcpy( p, "\"\n", 2 );
+        svg_write( aStream, buffer, (size_t) ( p + 2 - buffer ) );
+        svg_open_end( aStream );
+    }
 }
 
 //--------------------------------------------------------------------------
@@ -345,6 +401,7 @@ void plD_eop_svg( PLStream *pls )
 
     svg_close( aStream, "g" );
     svg_close( aStream, "svg" );
+    svg_flush( aStream );
 }
 
 //--------------------------------------------------------------------------
@@ -355,6 +412,7 @@ void plD_eop_svg( PLStream *pls )
 
 void plD_tidy_svg( PLStream *pls )
 {
+    svg_flush( pls->dev );
     if ( svg_family_check( pls ) )
     {
         return;
@@ -395,9 +453,15 @@ void plD_esc_svg( PLStream *pls, PLINT op, void *ptr )
     case PLESC_GRADIENT:      // render gradient inside polygon
         gradient( pls, pls->dev_x, pls->dev_y, pls->dev_npts );
         break;
+    case PLESC_IMAGE:     // draw image
+        image( pls );
+        break;
     case PLESC_HAS_TEXT:  // render text
         proc_str( pls, (EscText *) ptr );
         break;
+    case PLESC_MARKERS:   // render a batch of markers
+        markers( pls, (EscMarkers *) ptr );
+        break;
     }
 }
 
@@ -409,12 +473,11 @@ void plD_esc_svg( PLStream *pls, PLINT op, void *ptr )
 
 void poly_line( PLStream *pls, short *xa, short *ya, PLINT npts, short fill )
 {
-    int i;
     SVG *aStream;
 
     aStream = pls->dev;
 
-    svg_open( aStream, "polyline" );
+    svg_open( aStream, aStream->pathData ? "path" : "polyline" );
     if ( fill )
     {
         // Two adjacent regions will put non-zero width boundary strokes on top
@@ -449,19 +512,7 @@ void poly_line( PLStream *pls, short *xa, short *ya, PLINT npts, short fill )
         svg_attr_value( aStream, "fill", "none" );
     }
     //svg_attr_value(aStream, "shape-rendering", "crispEdges");
-    svg_indent( aStream );
-    fprintf( aStream->svgFile, "points=\"" );
-    for ( i = 0; i < npts; i++ )
-    {
-        fprintf( aStream->svgFile, "%.2f,%.2f ", (double) xa[i] / aStream->scale, (double) ya[i] / aStream->scale );
-        if ( ( ( i + 1 ) % 10 ) == 0 )
-        {
-            fprintf( aStream->svgFile, "\n" );
-            svg_indent( aStream );
-        }
-    }
-    fprintf( aStream->svgFile, "\"/>\n" );
-    aStream->svgIndent -= 2;
+    svg_points( aStream, xa, ya, npts );
 }
 
 //--------------------------------------------------------------------------
@@ -499,35 +550,98 @@ void gradient( PLStream *pls, short *xa, short *ya, PLINT npts )
     for ( i = 0; i < pls->ncol1; i++ )
     {
         svg_indent( aStream );
-        fprintf( aStream->svgFile, "<stop offset=\"%.3f\" ",
+        svg_printf( aStream, "<stop offset=\"%.3f\" ",
             (double) i / (double) ( pls->ncol1 - 1 ) );
-        fprintf( aStream->svgFile, "stop-color=\"#" );
-        write_hex( aStream->svgFile, pls->cmap1[i].r );
-        write_hex( aStream->svgFile, pls->cmap1[i].g );
-        write_hex( aStream->svgFile, pls->cmap1[i].b );
-        fprintf( aStream->svgFile, "\" " );
-        fprintf( aStream->svgFile, "stop-opacity=\"%.3f\"/>\n", pls->cmap1[i].a );
+        svg_printf( aStream, "stop-color=\"#" );
+        write_hex( aStream, pls->cmap1[i].r );
+        write_hex( aStream, pls->cmap1[i].g );
+        write_hex( aStream, pls->cmap1[i].b );
+        svg_printf( aStream, "\" " );
+        svg_printf( aStream, "stop-opacity=\"%.3f\"/>\n", pls->cmap1[i].a );
     }
 
     svg_close( aStream, "linearGradient" );
     svg_close( aStream, "defs" );
-    svg_open( aStream, "polyline" );
+    svg_open( aStream, aStream->pathData ? "path" : "polyline" );
     sprintf( buffer, "url(#MyGradient%010d)", aStream->gradient_index++ );
     svg_attr_value( aStream, "fill", buffer );
-    svg_indent( aStream );
-    fprintf( aStream->svgFile, "points=\"" );
-    for ( i = 0; i < npts; i++ )
+    svg_points( aStream, xa, ya, npts );
+    svg_close( aStream, "g" );
+}
+
+//--------------------------------------------------------------------------
+// image()
+//
+// Draws the image of pls->dev_nptsX x pls->dev_nptsY cell corners (see
+// plP_drawimage) as a single embedded PNG image with one pixel per cell.
+// The core only sends images whose cells form an affine grid, so the
+// placement is given by the corners (0, 0), (nx, 0) and (0, ny).
+//--------------------------------------------------------------------------
+
+void image( PLStream *pls )
+{
+    SVG           *aStream = pls->dev;
+    PLINT         nx       = pls->dev_nptsX - 1;
+    PLINT         ny       = pls->dev_nptsY - 1;
+    PLINT         ix, iy;
+    unsigned char *rgba, *p, *png;
+    size_t        png_size;
+    double        ox, oy;
+
+    if ( nx < 1 || ny < 1 )
+        return;
+
+    // PNG rows run along the image x axis, one per iy.
+    if ( ( rgba = (unsigned char *) malloc( (size_t) nx * (size_t) ny * 4 ) ) == NULL )
+        plexit( "svg: image: Insufficient memory" );
+    p = rgba;
+    for ( iy = 0; iy < ny; iy++ )
     {
-        fprintf( aStream->svgFile, "%.2f,%.2f ", (double) xa[i] / aStream->scale, (double) ya[i] / aStream->scale );
-        if ( ( ( i + 1 ) % 10 ) == 0 )
+        for ( ix = 0; ix < nx; ix++ )
         {
-            fprintf( aStream->svgFile, "\n" );
-            svg_indent( aStream );
+            memcpy( p, pls->dev_rgba + 4 * ( ix * ny + iy ), 4 );
+            p += 4;
         }
     }
-    fprintf( aStream->svgFile, "\"/>\n" );
+    png = svg_png_encode( rgba, nx, ny, &png_size );
+    free( rgba );
+
+    svg_open( aStream, "clipPath" );
+    svg_attr_values( aStream, "id", "image-clipping%d", aStream->image_index );
+    svg_general( aStream, ">\n" );
+    svg_open( aStream, "rect" );
+    svg_attr_values( aStream, "x", "%r", (double) pls->imclxmin / aStream->scale );
+    svg_attr_values( aStream, "y", "%r", (double) pls->imclymin / aStream->scale );
+    svg_attr_values( aStream, "width", "%r", (double) ( pls->imclxmax - pls->imclxmin ) / aStream->scale );
+    svg_attr_values( aStream, "height", "%r", (double) ( pls->imclymax - pls->imclymin ) / aStream->scale );
+    svg_open_end( aStream );
+    svg_close( aStream, "clipPath" );
+
+    ox = (double) pls->dev_ix[0];
+    oy = (double) pls->dev_iy[0];
+    // The clip path must not be subject to the transform of the image.
+    svg_open( aStream, "g" );
+    svg_attr_values( aStream, "clip-path", "url(#image-clipping%d)", aStream->image_index++ );
+    svg_general( aStream, ">\n" );
+    svg_open( aStream, "image" );
+    svg_attr_values( aStream, "width", "%d", nx );
+    svg_attr_values( aStream, "height", "%d", ny );
+    svg_attr_value( aStream, "preserveAspectRatio", "none" );
+    svg_attr_value( aStream, "style", "image-rendering:optimizeSpeed;image-rendering:pixelated" );
+    svg_attr_values( aStream, "transform", "matrix(%f %f %f %f %f %f)",
+        ( pls->dev_ix[nx * ( ny + 1 )] - ox ) / nx / aStream->scale,
+        ( pls->dev_iy[nx * ( ny + 1 )] - oy ) / nx / aStream->scale,
+        ( pls->dev_ix[ny] - ox ) / ny / aStream->scale,
+        ( pls->dev_iy[ny] - oy ) / ny / aStream->scale,
+        ox / aStream->scale, oy / aStream->scale );
+    svg_indent( aStream );
+    svg_printf( aStream, "xlink:href=\"data:image/png;base64," );
+    write_base64( aStream, png, png_size );
+    svg_printf( aStream, "\"/>\n" );
     aStream->svgIndent -= 2;
     svg_close( aStream, "g" );
+
+    free( png );
 }
 
 //--------------------------------------------------------------------------
@@ -561,94 +675,92 @@ void gradient( PLStream *pls, short *xa, short *ya, PLINT npts )
 
 void proc_str( PLStream *pls, EscText *args )
 {
-    char         plplot_esc;
-    short        i;
-    short        totalTags = 1;
-    short        ucs4Len   = (short) args->unicode_array_len;
-    double       ftHt, scaled_offset, scaled_ftHt;
-    PLUNICODE    fci;
-    PLINT        rcx[4], rcy[4];
-    static PLINT prev_rcx[4], prev_rcy[4];
-    PLFLT        rotation, shear, stride, cos_rot, sin_rot, sin_shear, cos_shear;
-    PLFLT        t[4];
-    int          glyph_size, sum_glyph_size;
-    short        if_write;
-    //   PLFLT *t = args->xform;
-    PLUNICODE    *ucs4 = args->unicode_array;
-    SVG          *aStream;
-    PLFLT        old_sscale, sscale, old_soffset, soffset, old_dup, ddup;
-    PLINT        level;
-    PLINT        same_clip;
+    SVG *aStream = (SVG *) pls->dev;
 
     // check that we got unicode
-    if ( ucs4Len == 0 )
+    if ( args->unicode_array_len == 0 )
     {
         printf( "Non unicode string passed to SVG driver, ignoring\n" );
         return;
     }
 
-    // get plplot escape character and the current font
-    plgesc( &plplot_esc );
-    plgfci( &fci );
+    // Setup & apply text clipping area if desired
+    if ( aStream->textClipping )
+        text_clip( pls );
 
-    // determine the font height in points.
-    ftHt = FONT_SIZE_RATIO * pls->chrht * POINTS_PER_INCH / 25.4;
+    text_element( pls, args, -1 );
 
-    // Setup & apply text clipping area if desired
-    aStream = (SVG *) pls->dev;
     if ( aStream->textClipping )
     {
-        // Use PLplot core routine difilt_clip to appropriately
-        // transform the coordinates of the clipping rectangle
-        difilt_clip( rcx, rcy );
-        same_clip = TRUE;
-        if ( aStream->which_clip == 0 )
-        {
-            same_clip = FALSE;
-        }
-        else
+        svg_close( aStream, "g" );
+    }
+}
+
+//--------------------------------------------------------------------------
+// text_clip()
+//
+// Opens a group clipped to the current clipping rectangle, defining the
+// clip path first unless it is the one of the previous text.
+//--------------------------------------------------------------------------
+
+void text_clip( PLStream *pls )
+{
+    short        i;
+    PLINT        rcx[4], rcy[4];
+    static PLINT prev_rcx[4], prev_rcy[4];
+    SVG          *aStream = (SVG *) pls->dev;
+    PLINT        same_clip;
+
+    // Use PLplot core routine difilt_clip to appropriately
+    // transform the coordinates of the clipping rectangle
+    difilt_clip( rcx, rcy );
+    same_clip = TRUE;
+    if ( aStream->which_clip == 0 )
+    {
+        same_clip = FALSE;
+    }
+    else
+    {
+        for ( i = 0; i < 4; i++ )
         {
-            for ( i = 0; i < 4; i++ )
-            {
-                if ( rcx[i] != prev_rcx[i] ||
-                     rcy[i] != prev_rcy[i] )
-                    same_clip = FALSE;
-            }
+            if ( rcx[i] != prev_rcx[i] ||
+                 rcy[i] != prev_rcy[i] )
+                same_clip = FALSE;
         }
-        if ( !same_clip )
+    }
+    if ( !same_clip )
+    {
+        svg_open( aStream, "clipPath" );
+        svg_attr_values( aStream, "id", "text-clipping%d", aStream->which_clip );
+        svg_general( aStream, ">\n" );
+
+        // Output a polygon to represent the clipping region.
+        svg_open( aStream, "polygon" );
+        svg_attr_values( aStream,
+            "points",
+            "%f,%f %f,%f %f,%f %f,%f",
+            ( (PLFLT) rcx[0] ) / aStream->scale,
+            ( (PLFLT) rcy[0] ) / aStream->scale,
+            ( (PLFLT) rcx[1] ) / aStream->scale,
+            ( (PLFLT) rcy[1] ) / aStream->scale,
+            ( (PLFLT) rcx[2] ) / aStream->scale,
+            ( (PLFLT) rcy[2] ) / aStream->scale,
+            ( (PLFLT) rcx[3] ) / aStream->scale,
+            ( (PLFLT) rcy[3] ) / aStream->scale );
+        svg_open_end( aStream );
+
+        svg_close( aStream, "clipPath" );
+        for ( i = 0; i < 4; i++ )
         {
-            svg_open( aStream, "clipPath" );
-            svg_attr_values( aStream, "id", "text-clipping%d", aStream->which_clip );
-            svg_general( aStream, ">\n" );
-
-            // Output a polygon to represent the clipping region.
-            svg_open( aStream, "polygon" );
-            svg_attr_values( aStream,
-                "points",
-                "%f,%f %f,%f %f,%f %f,%f",
-                ( (PLFLT) rcx[0] ) / aStream->scale,
-                ( (PLFLT) rcy[0] ) / aStream->scale,
-                ( (PLFLT) rcx[1] ) / aStream->scale,
-                ( (PLFLT) rcy[1] ) / aStream->scale,
-                ( (PLFLT) rcx[2] ) / aStream->scale,
-                ( (PLFLT) rcy[2] ) / aStream->scale,
-                ( (PLFLT) rcx[3] ) / aStream->scale,
-                ( (PLFLT) rcy[3] ) / aStream->scale );
-            svg_open_end( aStream );
-
-            svg_close( aStream, "clipPath" );
-            for ( i = 0; i < 4; i++ )
-            {
-                prev_rcx[i] = rcx[i];
-                prev_rcy[i] = rcy[i];
-            }
-            aStream->which_clip++;
+            prev_rcx[i] = rcx[i];
+            prev_rcy[i] = rcy[i];
         }
-        svg_open( aStream, "g" );
-        svg_attr_values( aStream, "clip-path",
-            "url(#text-clipping%d)", aStream->which_clip - 1 );
-        svg_general( aStream, ">\n" );
+        aStream->which_clip++;
     }
+    svg_open( aStream, "g" );
+    svg_attr_values( aStream, "clip-path",
+        "url(#text-clipping%d)", aStream->which_clip - 1 );
+    svg_general( aStream, ">\n" );
 
     // This draws the clipping region on the screen which can
     // be very helpful for debugging.
@@ -671,6 +783,40 @@ void proc_str( PLStream *pls, EscText *args )
     // svg_attr_value(aStream, "fill", "none");
     // svg_open_end(aStream);
     //
+}
+
+//--------------------------------------------------------------------------
+// text_element()
+//
+// Writes the text element of args, with the reference point of args as
+// its origin.  If id is not negative the element is given the identifier
+// "marker<id>" for later references by use elements.
+//--------------------------------------------------------------------------
+
+void text_element( PLStream *pls, EscText *args, int id )
+{
+    char      plplot_esc;
+    short     i;
+    short     totalTags = 1;
+    short     ucs4Len   = (short) args->unicode_array_len;
+    double    ftHt, scaled_offset, scaled_ftHt;
+    PLUNICODE fci;
+    PLFLT     rotation, shear, stride, cos_rot, sin_rot, sin_shear, cos_shear;
+    PLFLT     t[4];
+    int       glyph_size, sum_glyph_size;
+    short     if_write;
+    //   PLFLT *t = args->xform;
+    PLUNICODE *ucs4    = args->unicode_array;
+    SVG       *aStream = (SVG *) pls->dev;
+    PLFLT     old_sscale, sscale, old_soffset, soffset, old_dup, ddup;
+    PLINT     level;
+
+    // get plplot escape character and the current font
+    plgesc( &plplot_esc );
+    plgfci( &fci );
+
+    // determine the font height in points.
+    ftHt = FONT_SIZE_RATIO * pls->chrht * POINTS_PER_INCH / 25.4;
 
     // Calculate the tranformation matrix for SVG based on the
     // transformation matrix provided by PLplot.
@@ -693,6 +839,8 @@ void proc_str( PLStream *pls, EscText *args )
     // --------------
 
     svg_open( aStream, "text" );
+    if ( id >= 0 )
+        svg_attr_values( aStream, "id", "marker%d", id );
 
     svg_attr_value( aStream, "dominant-baseline", "no-change" );
 
@@ -763,10 +911,10 @@ void proc_str( PLStream *pls, EscText *args )
                 FONT_SHIFT_RATIO * 0.5 * ftHt +
                 FONT_SHIFT_OFFSET );
 
-            fprintf( aStream->svgFile, ">" );
+            svg_printf( aStream, ">" );
 
             // specify the initial font
-            specify_font( aStream->svgFile, fci );
+            specify_font( aStream, fci );
         }
         i           = 0;
         scaled_ftHt = ftHt;
@@ -780,7 +928,7 @@ void proc_str( PLStream *pls, EscText *args )
                 {
                     if ( if_write )
                     {
-                        write_unicode( aStream->svgFile, ucs4[i] );
+                        write_unicode( aStream, ucs4[i] );
                     }
                     else
                     {
@@ -794,7 +942,7 @@ void proc_str( PLStream *pls, EscText *args )
                 {
                     if ( if_write )
                     {
-                        write_unicode( aStream->svgFile, ucs4[i] );
+                        write_unicode( aStream, ucs4[i] );
                     }
                     else
                     {
@@ -830,7 +978,7 @@ void proc_str( PLStream *pls, EscText *args )
                         if ( if_write )
                         {
                             totalTags++;
-                            fprintf( aStream->svgFile, "<tspan dy=\"%f\" font-size=\"%d\">", scaled_offset, (int) scaled_ftHt );
+                            svg_printf( aStream, "<tspan dy=\"%f\" font-size=\"%d\">", scaled_offset, (int) scaled_ftHt );
                         }
                         else
                         {
@@ -859,7 +1007,7 @@ void proc_str( PLStream *pls, EscText *args )
                         if ( if_write )
                         {
                             totalTags++;
-                            fprintf( aStream->svgFile, "<tspan dy=\"%f\" font-size=\"%d\">", scaled_offset, (int) scaled_ftHt );
+                            svg_printf( aStream, "<tspan dy=\"%f\" font-size=\"%d\">", scaled_offset, (int) scaled_ftHt );
                         }
                         else
                         {
@@ -873,7 +1021,7 @@ void proc_str( PLStream *pls, EscText *args )
             {
                 if ( if_write )
                 {
-                    specify_font( aStream->svgFile, ucs4[i] );
+                    specify_font( aStream, ucs4[i] );
                     totalTags++;
                 }
                 i++;
@@ -888,7 +1036,7 @@ void proc_str( PLStream *pls, EscText *args )
 
     for ( i = 0; i < totalTags; i++ )
     {
-        fprintf( aStream->svgFile, "</tspan>" );
+        svg_printf( aStream, "</tspan>" );
     }
     // The following commented out (by AWI) because it is a bad idea to
     // put line ends in the middle of a text tag.  This was the key to
@@ -898,14 +1046,230 @@ void proc_str( PLStream *pls, EscText *args )
     // to close the text tag rather than svg_close("text"); since
     // we don't want indentation spaces entering the text.
     // svg_close("text");
-    fprintf( aStream->svgFile, "</text>\n" );
+    svg_printf( aStream, "</text>\n" );
     aStream->svgIndent -= 2;
+}
+
+//--------------------------------------------------------------------------
+// markers()
+//
+// Draws a batch of markers.  The glyph is written once as a text element
+// inside a defs element, and each marker is a use element that places it
+// at its position.
+//--------------------------------------------------------------------------
+
+void markers( PLStream *pls, EscMarkers *args )
+{
+    // Room for the reference, two numbers and the tag
+    char    text[100], *p;
+    EscText glyph;
+    PLINT   i;
+    SVG     *aStream = (SVG *) pls->dev;
+    int     id       = aStream->marker_index++;
+    int     digits   = aStream->precision;
+
+    // check that we got unicode
+    if ( args->text->unicode_array_len == 0 )
+    {
+        printf( "Non unicode string passed to SVG driver, ignoring\n" );
+        return;
+    }
+
+    // The glyph is placed at the origin, the use elements move it
+    glyph   = *args->text;
+    glyph.x = 0;
+    glyph.y = 0;
+    svg_open( aStream, "defs" );
+    svg_general( aStream, ">\n" );
+    text_element( pls, &glyph, id );
+    svg_close( aStream, "defs" );
+
+    if ( aStream->textClipping )
+        text_clip( pls );
+
+    for ( i = 0; i < args->n; i++ )
+    {
+        p    = text + sprintf( text, "<use xlink:href=\"#marker%d\" x=\"", id );
+        p    = svg_format_number( p, (double) args->x[i] / aStream->scale, digits );
+        p    = strcpy( p, "\" y=\"" ) + 5;
+        p    = svg_format_number( p, (double) args->y[i] / aStream->scale, digits );
+        p    = strcpy( p, "\"/>\n" ) + 4;
+        svg_indent( aStream );
+        svg_write( aStream, text, (size_t) ( p - text ) );
+    }
+
     if ( aStream->textClipping )
     {
         svg_close( aStream, "g" );
     }
 }
 
+//--------------------------------------------------------------------------
+// svg_png_encode ()
+//
+// Encodes width x height RGBA pixels as a PNG file in memory, which is
+// returned and must be freed by the caller.  The image data is deflated
+// with zlib if it is available and stored in uncompressed deflate blocks
+// otherwise.
+//--------------------------------------------------------------------------
+
+static unsigned long svg_png_crc_table[256];
+
+static unsigned long svg_png_crc( unsigned long crc, const unsigned char *buf, size_t len )
+{
+    size_t        i;
+    unsigned long c;
+    int           k;
+
+    if ( svg_png_crc_table[1] == 0 )
+    {
+        for ( i = 0; i < 256; i++ )
+        {
+            c = (unsigned long) i;
+            for ( k = 0; k < 8; k++ )
+                c = ( c & 1 ) ? 0xedb88320UL ^ ( c >> 1 ) : c >> 1;
+            svg_png_crc_table[i] = c;
+        }
+    }
+    crc ^= 0xffffffffUL;
+    for ( i = 0; i < len; i++ )
+        crc = svg_png_crc_table[( crc ^ buf[i] ) & 0xff] ^ ( crc >> 8 );
+    return crc ^ 0xffffffffUL;
+}
+
+static unsigned char *svg_png_put32( unsigned char *p, unsigned long v )
+{
+    p[0] = (unsigned char) ( v >> 24 );
+    p[1] = (unsigned char) ( v >> 16 );
+    p[2] = (unsigned char) ( v >> 8 );
+    p[3] = (unsigned char) v;
+    return p + 4;
+}
+
+// Writes a chunk of len data bytes, which must already be in place after
+// the 8 bytes for the length and the type, and returns the end of it.
+
+static unsigned char *svg_png_chunk( unsigned char *p, const char *type, size_t len )
+{
+    svg_png_put32( p, (unsigned long) len );
+    memcpy( p + 4, type, 4 );
+    return svg_png_put32( p + 8 + len, svg_png_crc( 0, p + 4, len + 4 ) );
+}
+
+static unsigned char *svg_png_encode( unsigned char *rgba, int width, int height, size_t *size )
+{
+    static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    size_t        row = 4 * (size_t) width + 1;
+    size_t        raw_size = row * (size_t) height;
+    size_t        data_size;
+    unsigned char *raw, *png, *p, *data;
+    int           y;
+
+    // Scanlines, each with filter type 0 (none)
+    if ( ( raw = (unsigned char *) malloc( raw_size ) ) == NULL )
+        plexit( "svg: svg_png_encode: Insufficient memory" );
+    for ( y = 0; y < height; y++ )
+    {
+        raw[y * row] = 0;
+        memcpy( raw + y * row + 1, rgba + 4 * (size_t) width * (size_t) y, row - 1 );
+    }
+
+#ifdef PL_HAVE_ZLIB
+    data_size = compressBound( (uLong) raw_size );
+#else
+    data_size = 2 + raw_size + 5 * ( raw_size / 65535 + 1 ) + 4;
+#endif
+    if ( ( png = (unsigned char *) malloc( 8 + 25 + 12 + data_size + 12 ) ) == NULL )
+        plexit( "svg: svg_png_encode: Insufficient memory" );
+
+    memcpy( png, signature, 8 );
+    p = png + 8;
+    svg_png_put32( p + 8, (unsigned long) width );
+    svg_png_put32( p + 12, (unsigned long) height );
+    p[16] = 8;       // bit depth
+    p[17] = 6;       // RGBA
+    p[18] = p[19] = p[20] = 0;
+    p = svg_png_chunk( p, "IHDR", 13 );
+
+    data = p + 8;
+#ifdef PL_HAVE_ZLIB
+    {
+        uLongf len = (uLongf) data_size;
+        if ( compress( data, &len, raw, (uLong) raw_size ) != Z_OK )
+            plexit( "svg: svg_png_encode: zlib compression failed" );
+        data_size = (size_t) len;
+    }
+#else
+    {
+        unsigned long a = 1, b = 0;
+        unsigned char *q = data;
+        size_t        i, n;
+
+        *q++ = 0x78;
+        *q++ = 0x01;
+        for ( i = 0; i < raw_size; i += n )
+        {
+            n    = MIN( raw_size - i, 65535 );
+            *q++ = (unsigned char) ( i + n == raw_size );
+            *q++ = (unsigned char) n;
+            *q++ = (unsigned char) ( n >> 8 );
+            *q++ = (unsigned char) ~n;
+            *q++ = (unsigned char) ( ~n >> 8 );
+            memcpy( q, raw + i, n );
+            q += n;
+        }
+        for ( i = 0; i < raw_size; i++ )
+        {
+            a = ( a + raw[i] ) % 65521;
+            b = ( b + a ) % 65521;
+        }
+        q         = svg_png_put32( q, ( b << 16 ) | a );
+        data_size = (size_t) ( q - data );
+    }
+#endif
+    free( raw );
+
+    p = svg_png_chunk( p, "IDAT", data_size );
+    p = svg_png_chunk( p, "IEND", 0 );
+
+    *size = (size_t) ( p - png );
+    return png;
+}
+
+//--------------------------------------------------------------------------
+// write_base64 ()
+//
+// Writes len bytes of buf to the file in base64 encoding.
+//--------------------------------------------------------------------------
+
+void write_base64( SVG *aStream, const unsigned char *buf, size_t len )
+{
+    static const char digits[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char          out[4 * 1024 + 4];
+    size_t        i, n = 0;
+    unsigned long v;
+
+    for ( i = 0; i < len; i += 3 )
+    {
+        v = (unsigned long) buf[i] << 16;
+        if ( i + 1 < len )
+            v |= (unsigned long) buf[i + 1] << 8;
+        if ( i + 2 < len )
+            v |= buf[i + 2];
+        out[n++] = digits[( v >> 18 ) & 63];
+        out[n++] = digits[( v >> 12 ) & 63];
+        out[n++] = i + 1 < len ? digits[( v >> 6 ) & 63] : '=';
+        out[n++] = i + 2 < len ? digits[v & 63] : '=';
+        if ( n >= 4 * 1024 )
+        {
+            svg_write( aStream, out, n );
+            n = 0;
+        }
+    }
+    svg_write( aStream, out, n );
+}
+
 //--------------------------------------------------------------------------
 // svg_open ()
 //
@@ -915,7 +1279,7 @@ void proc_str( PLStream *pls, EscText *args )
 void svg_open( SVG *aStream, const char *tag )
 {
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "<%s\n", tag );
+    svg_printf( aStream, "<%s\n", tag );
     aStream->svgIndent += 2;
 }
 
@@ -929,7 +1293,7 @@ void svg_open( SVG *aStream, const char *tag )
 void svg_open_end( SVG *aStream )
 {
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "/>\n" );
+    svg_printf( aStream, "/>\n" );
     aStream->svgIndent -= 2;
 }
 
@@ -943,7 +1307,7 @@ void svg_open_end( SVG *aStream )
 void svg_attr_value( SVG *aStream, const char *attribute, const char *value )
 {
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "%s=\"%s\"\n", attribute, value );
+    svg_printf( aStream, "%s=\"%s\"\n", attribute, value );
 }
 
 //--------------------------------------------------------------------------
@@ -963,42 +1327,43 @@ void svg_attr_values( SVG *aStream, const char *attribute, const char *format, .
     const char *p, *sval;
     int        ival;
     double     dval;
+    char       number[40];
 
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "%s=\"", attribute );
+    svg_printf( aStream, "%s=\"", attribute );
     va_start( ap, format );
     for ( p = format; *p; p++ )
     {
         if ( *p != '%' )
         {
-            fprintf( aStream->svgFile, "%c", *p );
+            svg_write( aStream, p, 1 );
             continue;
         }
         switch ( *++p )
         {
         case 'd':
             ival = va_arg( ap, int );
-            fprintf( aStream->svgFile, "%d", ival );
+            svg_write( aStream, number, (size_t) ( svg_format_fixed( number, ival, 0 ) - number ) );
             break;
         case 'f':
             dval = va_arg( ap, double );
-            fprintf( aStream->svgFile, "%f", dval );
+            svg_printf( aStream, "%f", dval );
             break;
         case 'r':
             // r is non-standard, but use it here to format rounded value
             dval = va_arg( ap, double );
-            fprintf( aStream->svgFile, "%.2f", dval );
+            svg_write( aStream, number, (size_t) ( svg_format_number( number, dval, 2 ) - number ) );
             break;
         case 's':
             sval = va_arg( ap, char * );
-            fprintf( aStream->svgFile, "%s", sval );
+            svg_printf( aStream, "%s", sval );
             break;
         default:
-            fprintf( aStream->svgFile, "%c", *p );
+            svg_printf( aStream, "%c", *p );
             break;
         }
     }
-    fprintf( aStream->svgFile, "\"\n" );
+    svg_printf( aStream, "\"\n" );
     va_end( ap );
 }
 
@@ -1014,11 +1379,11 @@ void svg_close( SVG *aStream, const char *tag )
     svg_indent( aStream );
     if ( strlen( tag ) > 0 )
     {
-        fprintf( aStream->svgFile, "</%s>\n", tag );
+        svg_printf( aStream, "</%s>\n", tag );
     }
     else
     {
-        fprintf( aStream->svgFile, "/>\n" );
+        svg_printf( aStream, "/>\n" );
     }
 }
 
@@ -1031,7 +1396,7 @@ void svg_close( SVG *aStream, const char *tag )
 void svg_general( SVG *aStream, const char *text )
 {
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "%s", text );
+    svg_printf( aStream, "%s", text );
 }
 
 //--------------------------------------------------------------------------
@@ -1042,11 +1407,190 @@ void svg_general( SVG *aStream, const char *text )
 
 void svg_indent( SVG *aStream )
 {
-    short i;
-    for ( i = 0; i < aStream->svgIndent; i++ )
+    static const char spaces[] = "                                ";
+    int               n;
+
+    for ( n = aStream->svgIndent; n > 0; n -= (int) sizeof ( spaces ) - 1 )
+        svg_write( aStream, spaces, (size_t) MIN( n, (int) sizeof ( spaces ) - 1 ) );
+}
+
+//--------------------------------------------------------------------------
+// svg_write ()
+//
+// Appends len bytes to the output buffer, which is written to the file
+// whenever it is full and at the end of each page.
+//--------------------------------------------------------------------------
+
+void svg_write( SVG *aStream, const char *text, size_t len )
+{
+    if ( aStream->bufferLength + len > SVG_BUFFER_SIZE )
+    {
+        svg_flush( aStream );
+        if ( len > SVG_BUFFER_SIZE )
+        {
+            fwrite( text, 1, len, aStream->svgFile );
+            return;
+        }
+    }
+    memcpy( aStream->buffer + aStream->bufferLength, text, len );
+    aStream->bufferLength += len;
+}
+
+//--------------------------------------------------------------------------
+// svg_printf ()
+//
+// Formats like fprintf into the output buffer.
+//--------------------------------------------------------------------------
+
+void svg_printf( SVG *aStream, const char *format, ... )
+{
+    va_list ap;
+    size_t  room = SVG_BUFFER_SIZE - aStream->bufferLength;
+    int     n;
+
+    va_start( ap, format );
+    n = vsnprintf( aStream->buffer + aStream->bufferLength, room, format, ap );
+    va_end( ap );
+    if ( n < 0 )
+        return;
+    if ( (size_t) n < room )
+    {
+        aStream->bufferLength += (size_t) n;
+        return;
+    }
+
+    // Did not fit, so try again in an empty buffer or else bypass it.
+    svg_flush( aStream );
+    va_start( ap, format );
+    if ( n < SVG_BUFFER_SIZE )
+        aStream->bufferLength = (size_t) vsnprintf( aStream->buffer, SVG_BUFFER_SIZE, format, ap );
+    else
+        vfprintf( aStream->svgFile, format, ap );
+    va_end( ap );
+}
+
+//--------------------------------------------------------------------------
+// svg_flush ()
+//
+// Writes the output buffer to the file.
+//--------------------------------------------------------------------------
+
+void svg_flush( SVG *aStream )
+{
+    if ( aStream == NULL || aStream->bufferLength == 0 )
+        return;
+    fwrite( aStream->buffer, 1, aStream->bufferLength, aStream->svgFile );
+    aStream->bufferLength = 0;
+}
+
+//--------------------------------------------------------------------------
+// svg_format_fixed ()
+//
+// Writes n / 10^digits in decimal notation with exactly digits decimals
+// to p and returns the end of the text (which is not terminated).
+//--------------------------------------------------------------------------
+
+char *svg_format_fixed( char *p, long n, int digits )
+{
+    char          text[24];
+    int           i = 0;
+    unsigned long u = n < 0 ? 0UL - (unsigned long) n : (unsigned long) n;
+
+    if ( n < 0 )
+        *p++ = '-';
+    do
+    {
+        if ( i == digits && digits > 0 )
+            text[i++] = '.';
+        text[i++] = (char) ( '0' + u % 10 );
+        u        /= 10;
+    } while ( u > 0 || i <= digits );
+    while ( i > 0 )
+        *p++ = text[--i];
+    return p;
+}
+
+//--------------------------------------------------------------------------
+// svg_format_number ()
+//
+// Writes value with digits decimals to p, exactly as printf's "%.*f"
+// would, and returns the end of the text (which is not terminated).
+// Values that are too large or too close to a rounding tie for the fast
+// conversion are left to snprintf.
+//--------------------------------------------------------------------------
+
+char *svg_format_number( char *p, double value, int digits )
+{
+    static const double scales[] = { 1., 10., 100., 1000., 10000. };
+    double              scaled   = fabs( value ) * scales[digits];
+    double              fraction = scaled - floor( scaled );
+
+    if ( scaled < 1e15 && fabs( fraction - 0.5 ) > 1e-6 && ( value > 0. || scaled >= 0.5 || ( value == 0. && !signbit( value ) ) ) )
     {
-        fprintf( aStream->svgFile, " " );
+        long n = (long) floor( scaled + 0.5 );
+        return svg_format_fixed( p, value < 0. ? -n : n, digits );
     }
+    return p + snprintf( p, 32, "%.*f", digits, value );
+}
+
+//--------------------------------------------------------------------------
+// svg_points ()
+//
+// Writes the vertices of a polyline or polygon, as the points attribute of
+// a polyline element or, with the path option, as the path data (an
+// absolute move followed by relative lines) of a path element, and closes
+// the element.
+//--------------------------------------------------------------------------
+
+void svg_points( SVG *aStream, short *xa, short *ya, PLINT npts )
+{
+    // Room for two numbers, the separators and a line break
+    char   text[100], *p;
+    PLINT  i;
+    int    digits = aStream->precision;
+    double scale  = pow( 10., digits ) / aStream->scale;
+    long   x, y, xold = 0, yold = 0;
+
+    svg_indent( aStream );
+    if ( aStream->pathData )
+        svg_write( aStream, "d=\"M", 4 );
+    else
+        svg_write( aStream, "points=\"", 8 );
+    for ( i = 0; i < npts; i++ )
+    {
+        p = text;
+        if ( aStream->pathData )
+        {
+            // Relative moves are taken between the rounded vertices so that
+            // the rounding errors do not add up.
+            x = (long) floor( xa[i] * scale + 0.5 );
+            y = (long) floor( ya[i] * scale + 0.5 );
+            if ( i == 1 )
+                *p++ = 'l';
+            else if ( i > 1 && x - xold >= 0 )
+                *p++ = ' ';
+            p = svg_format_fixed( p, i == 0 ? x : x - xold, digits );
+            if ( y - ( i == 0 ? 0 : yold ) >= 0 )
+                *p++ = ' ';
+            p    = svg_format_fixed( p, i == 0 ? y : y - yold, digits );
+            xold = x;
+            yold = y;
+        }
+        else
+        {
+            p    = svg_format_number( p, (double) xa[i] / aStream->scale, digits );
+            *p++ = ',';
+            p    = svg_format_number( p, (double) ya[i] / aStream->scale, digits );
+            *p++ = ' ';
+        }
+        if ( ( ( i + 1 ) % 10 ) == 0 )
+            *p++ = '\n';
+        svg_write( aStream, text, (size_t) ( p - text ) );
+        if ( ( ( i + 1 ) % 10 ) == 0 )
+            svg_indent( aStream );
+    }
+    svg_write( aStream, "\"/>\n", 4 );
+    aStream->svgIndent -= 2;
 }
 
 //--------------------------------------------------------------------------
@@ -1061,7 +1605,7 @@ void svg_stroke_width( PLStream *pls )
 
     aStream = pls->dev;
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "stroke-width=\"%e\"\n", pls->width );
+    svg_printf( aStream, "stroke-width=\"%e\"\n", pls->width );
 }
 
 //--------------------------------------------------------------------------
@@ -1076,13 +1620,13 @@ void svg_stroke_color( PLStream *pls )
 
     aStream = pls->dev;
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "stroke=\"#" );
-    write_hex( aStream->svgFile, pls->curcolor.r );
-    write_hex( aStream->svgFile, pls->curcolor.g );
-    write_hex( aStream->svgFile, pls->curcolor.b );
-    fprintf( aStream->svgFile, "\"\n" );
+    svg_printf( aStream, "stroke=\"#" );
+    write_hex( aStream, pls->curcolor.r );
+    write_hex( aStream, pls->curcolor.g );
+    write_hex( aStream, pls->curcolor.b );
+    svg_printf( aStream, "\"\n" );
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "stroke-opacity=\"%f\"\n", pls->curcolor.a );
+    svg_printf( aStream, "stroke-opacity=\"%f\"\n", pls->curcolor.a );
 }
 
 //--------------------------------------------------------------------------
@@ -1097,13 +1641,13 @@ void svg_fill_color( PLStream *pls )
 
     aStream = pls->dev;
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "fill=\"#" );
-    write_hex( aStream->svgFile, pls->curcolor.r );
-    write_hex( aStream->svgFile, pls->curcolor.g );
-    write_hex( aStream->svgFile, pls->curcolor.b );
-    fprintf( aStream->svgFile, "\"\n" );
+    svg_printf( aStream, "fill=\"#" );
+    write_hex( aStream, pls->curcolor.r );
+    write_hex( aStream, pls->curcolor.g );
+    write_hex( aStream, pls->curcolor.b );
+    svg_printf( aStream, "\"\n" );
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "fill-opacity=\"%f\"\n", pls->curcolor.a );
+    svg_printf( aStream, "fill-opacity=\"%f\"\n", pls->curcolor.a );
 }
 
 //--------------------------------------------------------------------------
@@ -1118,13 +1662,13 @@ void svg_fill_background_color( PLStream *pls )
 
     aStream = pls->dev;
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "fill=\"#" );
-    write_hex( aStream->svgFile, pls->cmap0[0].r );
-    write_hex( aStream->svgFile, pls->cmap0[0].g );
-    write_hex( aStream->svgFile, pls->cmap0[0].b );
-    fprintf( aStream->svgFile, "\"\n" );
+    svg_printf( aStream, "fill=\"#" );
+    write_hex( aStream, pls->cmap0[0].r );
+    write_hex( aStream, pls->cmap0[0].g );
+    write_hex( aStream, pls->cmap0[0].b );
+    svg_printf( aStream, "\"\n" );
     svg_indent( aStream );
-    fprintf( aStream->svgFile, "fill-opacity=\"%f\"\n", pls->cmap0[0].a );
+    svg_printf( aStream, "fill-opacity=\"%f\"\n", pls->cmap0[0].a );
 }
 
 //--------------------------------------------------------------------------
@@ -1157,16 +1701,14 @@ int svg_family_check( PLStream *pls )
 // writes a unsigned char as an appropriately formatted hex value
 //--------------------------------------------------------------------------
 
-void write_hex( FILE *svgFile, unsigned char val )
+void write_hex( SVG *aStream, unsigned char val )
 {
-    if ( val < 16 )
-    {
-        fprintf( svgFile, "0%X", val );
-    }
-    else
-    {
-        fprintf( svgFile, "%X", val );
-    }
+    static const char digits[] = "0123456789ABCDEF";
+    char              text[2];
+
+    text[0] = digits[val >> 4];
+    text[1] = digits[val & 15];
+    svg_write( aStream, text, 2 );
 }
 
 //--------------------------------------------------------------------------
@@ -1176,12 +1718,12 @@ void write_hex( FILE *svgFile, unsigned char val )
 // with invalid xml characters replaced by ' '.
 //--------------------------------------------------------------------------
 
-void write_unicode( FILE *svgFile, PLUNICODE ucs4_char )
+void write_unicode( SVG *aStream, PLUNICODE ucs4_char )
 {
     if ( ucs4_char >= ' ' || ucs4_char == '\t' || ucs4_char == '\n' || ucs4_char == '\r' )
-        fprintf( svgFile, "&#x%x;", ucs4_char );
+        svg_printf( aStream, "&#x%x;", ucs4_char );
     else
-        fprintf( svgFile, "&#x%x;", ' ' );
+        svg_printf( aStream, "&#x%x;", ' ' );
 }
 
 //--------------------------------------------------------------------------
@@ -1199,57 +1741,57 @@ void write_unicode( FILE *svgFile, PLUNICODE ucs4_char )
 //
 //--------------------------------------------------------------------------
 
-void specify_font( FILE *svgFile, PLUNICODE ucs4_char )
+void specify_font( SVG *aStream, PLUNICODE ucs4_char )
 {
-    fprintf( svgFile, "<tspan " );
+    svg_printf( aStream, "<tspan " );
 
     // sans, serif, mono, script, symbol
 
     if ( ( ucs4_char & 0x00F ) == 0x000 )
     {
-        fprintf( svgFile, "font-family=\"sans-serif\" " );
+        svg_printf( aStream, "font-family=\"sans-serif\" " );
     }
     else if ( ( ucs4_char & 0x00F ) == 0x001 )
     {
-        fprintf( svgFile, "font-family=\"serif\" " );
+        svg_printf( aStream, "font-family=\"serif\" " );
     }
     else if ( ( ucs4_char & 0x00F ) == 0x002 )
     {
-        fprintf( svgFile, "font-family=\"mono-space\" " );
+        svg_printf( aStream, "font-family=\"mono-space\" " );
     }
     else if ( ( ucs4_char & 0x00F ) == 0x003 )
     {
-        fprintf( svgFile, "font-family=\"cursive\" " );
+        svg_printf( aStream, "font-family=\"cursive\" " );
     }
     else if ( ( ucs4_char & 0x00F ) == 0x004 )
     {
         // this should be symbol, but that doesn't seem to be available
-        fprintf( svgFile, "font-family=\"sans-serif\" " );
+        svg_printf( aStream, "font-family=\"sans-serif\" " );
     }
 
     // normal, italic, oblique
 
     if ( ( ucs4_char & 0x0F0 ) == 0x000 )
     {
-        fprintf( svgFile, "font-style=\"normal\" " );
+        svg_printf( aStream, "font-style=\"normal\" " );
     }
     else if ( ( ucs4_char & 0x0F0 ) == 0x010 )
     {
-        fprintf( svgFile, "font-style=\"italic\" " );
+        svg_printf( aStream, "font-style=\"italic\" " );
     }
     else if ( ( ucs4_char & 0x0F0 ) == 0x020 )
     {
-        fprintf( svgFile, "font-style=\"oblique\" " );
+        svg_printf( aStream, "font-style=\"oblique\" " );
     }
 
     // normal, bold
 
     if ( ( ucs4_char & 0xF00 ) == 0x000 )
     {
-        fprintf( svgFile, "font-weight=\"normal\">" );
+        svg_printf( aStream, "font-weight=\"normal\">" );
     }
     else if ( ( ucs4_char & 0xF00 ) == 0x100 )
     {
-        fprintf( svgFile, "font-weight=\"bold\">" );
+        svg_printf( aStream, "font-weight=\"bold\">" );
     }
 }
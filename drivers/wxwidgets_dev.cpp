@@ -42,6 +42,7 @@
 // PLplot headers
 #include "plDevs.h"
 #include "wxwidgets.h" // includes wx/wx.h
+#include "drivers.h"   // plbuf_read_bytes
 
 // wxwidgets headers
 #include <wx/dir.h>
@@ -1470,7 +1471,10 @@ void wxPLDevice::TransmitBuffer( PLStream* pls, unsigned char transmissionType )
         {
             // N.B. the above condition implies pls is non-NULL.
             // Transmit m_header.plbufAmountToTransmit bytes of plbuf to the reader process.
-            m_outputMemoryMap.transmitBytes( false, (char *) pls->plbuf_buffer + m_localBufferPosition, m_header.plbufAmountToTransmit );
+            // The plot buffer is not contiguous, so stage the bytes first.
+            std::vector<char> bytes( m_header.plbufAmountToTransmit );
+            plbuf_read_bytes( pls, m_localBufferPosition, &bytes[0], m_header.plbufAmountToTransmit );
+            m_outputMemoryMap.transmitBytes( false, &bytes[0], m_header.plbufAmountToTransmit );
             m_localBufferPosition += m_header.plbufAmountToTransmit;
         }
     } // End of try block
@@ -1628,8 +1632,8 @@ void wxPLDevice::TransmitBuffer( PLStream* pls, unsigned char transmissionType )
                 {
                     memcpy( m_outputMemoryMap.getBuffer() + mapHeader.writeLocation + sizeof ( transmissionComplete ),
                         (char *) ( &copyAmount ), sizeof ( copyAmount ) );
-                    memcpy( m_outputMemoryMap.getBuffer() + mapHeader.writeLocation + headerSize,
-                        (char *) pls->plbuf_buffer + m_localBufferPosition, copyAmount );
+                    plbuf_read_bytes( pls, m_localBufferPosition,
+                        m_outputMemoryMap.getBuffer() + mapHeader.writeLocation + headerSize, copyAmount );
                     m_localBufferPosition   += copyAmount;
                     mapHeader.writeLocation += copyAmount + headerSize;
                     if ( mapHeader.writeLocation == m_outputMemoryMap.getSize() )
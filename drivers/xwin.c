@@ -3576,7 +3576,8 @@ DrawImage( PLStream *pls )
                 if ( icol1 < pls->dev_zmin || icol1 > pls->dev_zmax )
                     continue;
 
-                icol1 = (PLINT) ( (float) icol1 / (float) USHRT_MAX * (float) ( xwd->ncol1 - 1 ) );
+                // the Z array holds indices into the cmap1 of the stream
+                icol1 = icol1 * ( xwd->ncol1 - 1 ) / MAX( pls->ncol1 - 1, 1 );
                 if ( xwd->color )
                     curcolor = xwd->cmap1[icol1];
                 else
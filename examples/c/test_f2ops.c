@@ -0,0 +1,363 @@
+// PLF2OPS grid access test and benchmark.
+//
+// First checks, on a -nx by -ny grid with NaN and infinite values in some
+// cells, that plP_f2eval_row() and plP_f2eval_copy() give the same values as
+// the f2eval function they stand in for, for each f2eval the library reads
+// directly and for one it does not know, and that the minmax operators
+// return the minimum and maximum of the finite values found through
+// f2eval.  Exits with status 1 at the first mismatch.
+//
+// Then times the minimum/maximum search, plfimagefr, plfshades and plfcont on a
+// -nx by -ny grid stored in each of the layouts with built-in operators
+// (plf2ops_c, plf2ops_grid_row_major and plf2ops_grid_col_major), which
+// the library reads directly, and through an operator table of its own
+// that the library can only call value by value.  The plots are drawn into
+// memory with the mem device.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plplotP.h"
+#include "plcdemos.h"
+#include <time.h>
+
+#define NLEVEL    10
+#define WIDTH     640
+#define HEIGHT    480
+
+static PLINT nx = 2000;
+static PLINT ny = 2000;
+
+static PLOptionTable options[] = {
+    {
+        "nx",
+        NULL,
+        NULL,
+        &nx,
+        PL_OPT_INT,
+        "-nx points",
+        "Specify grid x dimension [2000]"
+    },
+    {
+        "ny",
+        NULL,
+        NULL,
+        &ny,
+        PL_OPT_INT,
+        "-ny points",
+        "Specify grid y dimension [2000]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Row-major operators that the library does not recognise
+
+static PLFLT
+generic_get( PLPointer p, PLINT ix, PLINT iy )
+{
+    PLfGrid2 *g = (PLfGrid2 *) p;
+    return ( (PLFLT *) g->f )[ix * g->ny + iy];
+}
+
+static PLFLT
+generic_f2eval( PLINT ix, PLINT iy, PLPointer p )
+{
+    return generic_get( p, ix, iy );
+}
+
+static void
+generic_minmax( PLPointer p, PLINT n_x, PLINT n_y, PLFLT *zmin, PLFLT *zmax )
+{
+    PLINT ix, iy;
+    PLFLT z;
+
+    *zmin = HUGE_VAL;
+    *zmax = -HUGE_VAL;
+    for ( ix = 0; ix < n_x; ix++ )
+    {
+        for ( iy = 0; iy < n_y; iy++ )
+        {
+            z     = generic_get( p, ix, iy );
+            *zmin = MIN( *zmin, z );
+            *zmax = MAX( *zmax, z );
+        }
+    }
+}
+
+// Grid values, without the non-finite cells added for the checks
+
+static PLFLT
+value( PLINT i, PLINT j )
+{
+    PLFLT x = -1. + 2. * i / ( nx - 1. );
+    PLFLT y = -1. + 2. * j / ( ny - 1. );
+
+    return sin( 7. * x ) * cos( 5. * y ) + 0.3 * x * y;
+}
+
+// Stores v at (i, j) in each of the layouts
+
+static void
+store( PLFLT **zc, PLFLT *zrow, PLFLT *zcol, PLINT i, PLINT j, PLFLT v )
+{
+    zc[i][j]         = v;
+    zrow[i * ny + j] = v;
+    zcol[i + nx * j] = v;
+}
+
+// Equality that also holds between two NaNs
+
+static int
+same( PLFLT a, PLFLT b )
+{
+    return a == b || ( isnan( a ) && isnan( b ) );
+}
+
+static void
+mismatch( const char *name, const char *what, PLINT ix, PLINT iy )
+{
+    fprintf( stderr, "test_f2ops: %s: %s differs from f2eval at (%d, %d)\n",
+        name, what, (int) ix, (int) iy );
+    exit( 1 );
+}
+
+// Compares plP_f2eval_row() and plP_f2eval_copy() with f2eval.  direct tells
+// whether plP_f2eval_row() should find the data behind f2eval.  The copies
+// cover the whole grid and ranges that end part way through a block.
+
+static void
+check_f2eval( const char *name, PLF2EVAL_callback f2eval, PLPointer data, int direct, PLFLT *a )
+{
+    PLINT       range[4][4] = {
+        { 0,      nx, 0,      ny     },
+        { 1,      nx - 1, 1,  ny - 1 },
+        { nx / 3, nx, ny / 2, ny     },
+        { nx - 1, nx, 0,      ny     }
+    };
+    const PLFLT *row;
+    PLINT       ix, iy, kx, lx, ky, ly, stride, k;
+
+    for ( ix = 0; ix < nx; ix++ )
+    {
+        row = plP_f2eval_row( f2eval, data, ix, &stride );
+        if ( ( row != NULL ) != direct )
+            mismatch( name, "plP_f2eval_row", ix, 0 );
+        for ( iy = 0; row != NULL && iy < ny; iy++ )
+        {
+            if ( !same( row[iy * stride], f2eval( ix, iy, data ) ) )
+                mismatch( name, "plP_f2eval_row", ix, iy );
+        }
+    }
+
+    for ( k = 0; k < 4; k++ )
+    {
+        kx = range[k][0];
+        lx = range[k][1];
+        ky = range[k][2];
+        ly = range[k][3];
+        plP_f2eval_copy( f2eval, data, kx, lx, ky, ly, a );
+        for ( ix = kx; ix < lx; ix++ )
+        {
+            for ( iy = ky; iy < ly; iy++ )
+            {
+                if ( !same( a[( ix - kx ) * ( ly - ky ) + iy - ky], f2eval( ix, iy, data ) ) )
+                    mismatch( name, "plP_f2eval_copy", ix, iy );
+            }
+        }
+    }
+}
+
+// Compares the minmax operator with the finite extremes found through
+// f2eval
+
+static void
+check_minmax( const char *name, PLF2OPS zops, PLPointer zp )
+{
+    PLFLT zmin, zmax, min = HUGE_VAL, max = -HUGE_VAL, z;
+    PLINT ix, iy;
+
+    for ( ix = 0; ix < nx; ix++ )
+    {
+        for ( iy = 0; iy < ny; iy++ )
+        {
+            z = zops->f2eval( ix, iy, zp );
+            if ( isfinite( z ) )
+            {
+                min = MIN( min, z );
+                max = MAX( max, z );
+            }
+        }
+    }
+
+    zops->minmax( zp, nx, ny, &zmin, &zmax );
+    if ( zmin != min || zmax != max )
+    {
+        fprintf( stderr, "test_f2ops: %s: minmax gives [%g, %g] instead of [%g, %g]\n",
+            name, zmin, zmax, min, max );
+        exit( 1 );
+    }
+}
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+// Runs the timed calls on one layout
+
+static void
+run( const char *name, PLF2OPS zops, PLPointer zp )
+{
+    PLFLT  zmin, zmax, clevel[NLEVEL + 1];
+    double t0, t_minmax, t_image, t_shades, t_cont;
+    int    i;
+
+    t0 = seconds();
+    zops->minmax( zp, nx, ny, &zmin, &zmax );
+    t_minmax = seconds() - t0;
+
+    for ( i = 0; i <= NLEVEL; i++ )
+        clevel[i] = zmin + ( zmax - zmin ) * i / NLEVEL;
+
+    t0 = seconds();
+    plfimagefr( zops, zp, nx, ny, 0., 1., 0., 1., zmin, zmax, zmin, zmax, NULL, NULL );
+    t_image = seconds() - t0;
+
+    t0 = seconds();
+    plfshades( zops, zp, nx, ny, NULL, 0., 1., 0., 1., clevel, NLEVEL + 1, 1., 0, 1.,
+        plfill, 1, NULL, NULL );
+    t_shades = seconds() - t0;
+
+    t0 = seconds();
+    plfcont( zops->f2eval, zp, nx, ny, 1, nx, 1, ny, clevel, NLEVEL + 1, pltr0, NULL );
+    t_cont = seconds() - t0;
+
+    printf( "%-10s %10.3f %10.3f %10.3f %10.3f\n", name, t_minmax, t_image, t_shades, t_cont );
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PLFLT         **zc, *zrow, *zcol, *a;
+    PLfGrid2      gc, grow, gcol;
+    PLfGrid       frow, fcol;
+    plf2ops_t     generic;
+    unsigned char *image;
+    int           i, j;
+
+    plMergeOpts( options, "test_f2ops options", NULL );
+    image = (unsigned char *) malloc( 3 * WIDTH * HEIGHT );
+    plsdev( "mem" );
+    plsmem( WIDTH, HEIGHT, image );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( nx < 2 || ny < 2 )
+    {
+        fprintf( stderr, "test_f2ops: bad arguments\n" );
+        exit( 1 );
+    }
+
+    plAlloc2dGrid( &zc, nx, ny );
+    zrow = (PLFLT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLFLT ) );
+    zcol = (PLFLT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLFLT ) );
+    a    = (PLFLT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLFLT ) );
+    if ( zrow == NULL || zcol == NULL || a == NULL )
+    {
+        fprintf( stderr, "test_f2ops: insufficient memory\n" );
+        exit( 1 );
+    }
+    for ( i = 0; i < nx; i++ )
+        for ( j = 0; j < ny; j++ )
+            store( zc, zrow, zcol, i, j, value( i, j ) );
+    gc.f    = zc;
+    grow.f  = (PLFLT **) zrow;
+    gcol.f  = (PLFLT **) zcol;
+    gc.nx   = grow.nx = gcol.nx = nx;
+    gc.ny   = grow.ny = gcol.ny = ny;
+    frow.f  = zrow;
+    fcol.f  = zcol;
+    frow.nx = fcol.nx = nx;
+    frow.ny = fcol.ny = ny;
+    frow.nz = fcol.nz = 1;
+
+    generic        = *plf2ops_grid_row_major();
+    generic.get    = generic_get;
+    generic.f2eval = generic_f2eval;
+    generic.minmax = generic_minmax;
+
+    // Non-finite values at the first and last cells, where a minimum and
+    // maximum search would start and end, and inside the grid
+    store( zc, zrow, zcol, 0, 0, NAN );
+    store( zc, zrow, zcol, nx - 1, ny - 1, NAN );
+    store( zc, zrow, zcol, nx / 2, 0, HUGE_VAL );
+    store( zc, zrow, zcol, 0, ny / 2, -HUGE_VAL );
+    store( zc, zrow, zcol, nx / 2, ny / 2, NAN );
+
+    check_f2eval( "c", plf2ops_c()->f2eval, (PLPointer) zc, 1, a );
+    check_f2eval( "grid c", plf2ops_grid_c()->f2eval, (PLPointer) &gc, 1, a );
+    check_f2eval( "row major", plf2ops_grid_row_major()->f2eval, (PLPointer) &grow, 1, a );
+    check_f2eval( "col major", plf2ops_grid_col_major()->f2eval, (PLPointer) &gcol, 1, a );
+    check_f2eval( "plf2eval1", plf2eval1, (PLPointer) zc, 1, a );
+    check_f2eval( "plf2eval2", plf2eval2, (PLPointer) &gc, 1, a );
+    check_f2eval( "plf2eval", plf2eval, (PLPointer) &frow, 1, a );
+    check_f2eval( "plf2evalr", plf2evalr, (PLPointer) &fcol, 1, a );
+    check_f2eval( "generic", generic_f2eval, (PLPointer) &grow, 0, a );
+
+    check_minmax( "c", plf2ops_c(), (PLPointer) zc );
+    check_minmax( "grid c", plf2ops_grid_c(), (PLPointer) &gc );
+    check_minmax( "row major", plf2ops_grid_row_major(), (PLPointer) &grow );
+    check_minmax( "col major", plf2ops_grid_col_major(), (PLPointer) &gcol );
+
+    store( zc, zrow, zcol, 0, 0, value( 0, 0 ) );
+    store( zc, zrow, zcol, nx - 1, ny - 1, value( nx - 1, ny - 1 ) );
+    store( zc, zrow, zcol, nx / 2, 0, value( nx / 2, 0 ) );
+    store( zc, zrow, zcol, 0, ny / 2, value( 0, ny / 2 ) );
+    store( zc, zrow, zcol, nx / 2, ny / 2, value( nx / 2, ny / 2 ) );
+
+    plinit();
+    plenv( 0., 1., 0., 1., 0, 0 );
+
+    printf( "%d x %d grid, times in s\n", nx, ny );
+    printf( "%-10s %10s %10s %10s %10s\n", "layout", "minmax", "plimagefr", "plshades", "plcont" );
+    run( "c", plf2ops_c(), (PLPointer) zc );
+    run( "row major", plf2ops_grid_row_major(), (PLPointer) &grow );
+    run( "col major", plf2ops_grid_col_major(), (PLPointer) &gcol );
+    run( "generic", &generic, (PLPointer) &grow );
+
+    plFree2dGrid( zc, nx, ny );
+    free( zrow );
+    free( zcol );
+    free( a );
+    plend();
+    free( image );
+    exit( 0 );
+}
@@ -0,0 +1,153 @@
+// Metafile I/O benchmark.
+//
+// Writes -n polyline records of -npts points, laid out the way the plmeta
+// driver writes them (a command byte, the point count and the x and y
+// arrays of U_SHORT's), each followed by a float, into a memory stream with
+// the pdf_* functions that the driver uses.  The records are then read back
+// with the functions used by plmetafile and checked.  The times taken to
+// write and to read the stream are reported.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include "pdf.h"
+#include <time.h>
+
+#define POLYLINE    13      // as in metadefs.h
+
+static PLINT n    = 20000;
+static PLINT npts = 500;
+
+static PLOptionTable options[] = {
+    {
+        "n",
+        NULL,
+        NULL,
+        &n,
+        PL_OPT_INT,
+        "-n number",
+        "Specify number of polyline records [20000]"
+    },
+    {
+        "npts",
+        NULL,
+        NULL,
+        &npts,
+        PL_OPT_INT,
+        "-npts points",
+        "Specify number of points per polyline [500]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PDFstrm *pdfs;
+    U_SHORT *xa, *ya, *xr, *yr, np;
+    U_CHAR  c;
+    float   f;
+    size_t  nbytes;
+    double  t0, t_write, t_read;
+    long    bad = 0;
+    int     i, j;
+
+    plMergeOpts( options, "test_pdfutils options", NULL );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( n < 1 || npts < 1 || npts > 65535 )
+    {
+        fprintf( stderr, "test_pdfutils: bad arguments\n" );
+        exit( 1 );
+    }
+
+    xa = (U_SHORT *) malloc( (size_t) npts * sizeof ( U_SHORT ) );
+    ya = (U_SHORT *) malloc( (size_t) npts * sizeof ( U_SHORT ) );
+    xr = (U_SHORT *) malloc( (size_t) npts * sizeof ( U_SHORT ) );
+    yr = (U_SHORT *) malloc( (size_t) npts * sizeof ( U_SHORT ) );
+    for ( j = 0; j < npts; j++ )
+    {
+        xa[j] = (U_SHORT) ( 32767. * ( 1. + cos( 0.01 * j ) ) );
+        ya[j] = (U_SHORT) ( 32767. * ( 1. + sin( 0.013 * j ) ) );
+    }
+
+    pdfs = pdf_bopen( NULL, 0 );
+
+    t0 = seconds();
+    for ( i = 0; i < n; i++ )
+    {
+        pdf_wr_1byte( pdfs, (U_CHAR) POLYLINE );
+        pdf_wr_2bytes( pdfs, (U_SHORT) npts );
+        pdf_wr_2nbytes( pdfs, xa, npts );
+        pdf_wr_2nbytes( pdfs, ya, npts );
+        pdf_wr_ieeef( pdfs, (float) ( 0.5 + i ) );
+    }
+    t_write = seconds() - t0;
+    nbytes  = pdfs->bp;
+
+    // Read back only what was written.
+    pdfs->bufmax = nbytes;
+    pdfs->bp     = 0;
+
+    t0 = seconds();
+    for ( i = 0; i < n; i++ )
+    {
+        if ( pdf_rd_1byte( pdfs, &c ) || pdf_rd_2bytes( pdfs, &np )
+             || pdf_rd_2nbytes( pdfs, xr, np ) || pdf_rd_2nbytes( pdfs, yr, np )
+             || pdf_rd_ieeef( pdfs, &f ) )
+        {
+            fprintf( stderr, "test_pdfutils: read error in record %d\n", i );
+            exit( 1 );
+        }
+        if ( c != POLYLINE || np != npts || f != (float) ( 0.5 + i )
+             || memcmp( xr, xa, (size_t) npts * sizeof ( U_SHORT ) )
+             || memcmp( yr, ya, (size_t) npts * sizeof ( U_SHORT ) ) )
+            bad++;
+    }
+    t_read = seconds() - t0;
+
+    printf( "%d records of %d points, %.1f MB: write %.3f s, read %.3f s, %ld bad records\n",
+        n, npts, nbytes / 1e6, t_write, t_read, bad );
+
+    pdf_close( pdfs );
+    free( xa );
+    free( ya );
+    free( xr );
+    free( yr );
+    exit( bad != 0 );
+}
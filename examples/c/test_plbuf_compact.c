@@ -0,0 +1,222 @@
+// Compact plot buffer test program.
+//
+// Draws the same page into a stream with a plain plot buffer and into
+// one with the compact encoding (the -compactbuf option), replays both
+// buffers to the svg device and checks that the two replays are
+// identical.  The page has color changes that repeat the last one of the
+// same kind with other color and color map changes in between, which the
+// compact encoding must not drop.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plplotP.h"
+#include "plcdemos.h"
+#include "plstrm.h"
+
+#define TEST_DEVICE    "svg"
+#define NPTS           100
+
+// Reach into the guts of PLPlot to get access to the current stream.
+// Not recommended behavior for user program.  Only needed for testing.
+extern PLDLLIMPEXP_DATA( PLStream * ) plsc;
+
+static PLCHAR_VECTOR out_names[2] = { "test_plbuf_compact_raw.svg", "test_plbuf_compact.svg" };
+
+// Draws a line offset by k.
+
+static void
+line( int k )
+{
+    PLFLT x[NPTS], y[NPTS];
+    int   i;
+
+    for ( i = 0; i < NPTS; i++ )
+    {
+        x[i] = (PLFLT) i / ( NPTS - 1 );
+        y[i] = 0.1 * k + 0.05 * sin( 2. * M_PI * x[i] );
+    }
+    plline( NPTS, x, y );
+}
+
+// Draws the test page.
+
+static void
+plot( void )
+{
+    PLINT r[2] = { 0, 255 }, g[2] = { 0, 255 }, b[2] = { 255, 0 };
+    PLFLT xs[6], ys[6];
+    int   i;
+
+    plssub( 2, 2 );
+
+    // Repeated color changes with other color changes in between
+    pladv( 0 );
+    plvpor( 0.1, 0.9, 0.1, 0.9 );
+    plwind( 0., 1., 0., 1. );
+    plcol0( 2 );
+    line( 1 );
+    plcol1( 0.5 );
+    line( 2 );
+    plcol0( 2 );
+    line( 3 );
+    plcol1( 0.5 );
+    line( 4 );
+    plcol0( 3 );
+    line( 5 );
+    plcol0( 3 );
+    line( 6 );
+
+    // Repeated color changes with color map changes in between
+    pladv( 0 );
+    plvpor( 0.1, 0.9, 0.1, 0.9 );
+    plwind( 0., 1., 0., 1. );
+    plcol1( 0.25 );
+    line( 1 );
+    plscmap1( r, g, b, 2 );
+    plcol1( 0.25 );
+    line( 2 );
+    plcol0( 4 );
+    line( 3 );
+    plscol0( 4, 255, 0, 255 );
+    plcol0( 4 );
+    line( 4 );
+    plscol0( 4, 0, 255, 0 );
+    plcol0( 4 );
+    line( 5 );
+
+    // Repeated widths, labels and symbols
+    plcol0( 1 );
+    plenv( 0., 1., 0., 1., 0, 0 );
+    pllab( "(x)", "(y)", "#frCompact plot buffer" );
+    plwidth( 2. );
+    line( 1 );
+    plwidth( 2. );
+    line( 2 );
+    plwidth( 1. );
+    for ( i = 0; i < 6; i++ )
+    {
+        xs[i] = 0.2 * i;
+        ys[i] = 0.7;
+    }
+    plssym( 0., 2. );
+    plpoin( 6, xs, ys, 9 );
+    plssym( 0., 2. );
+    plpoin( 6, xs, ys, 4 );
+
+    // Fills and boxes
+    plcol0( 2 );
+    plenv( 0., 1., 0., 1., 0, 1 );
+    for ( i = 0; i < 6; i++ )
+    {
+        xs[i] = 0.5 + 0.4 * cos( 2. * M_PI * i / 6 );
+        ys[i] = 0.5 + 0.4 * sin( 2. * M_PI * i / 6 );
+    }
+    plpsty( 1 );
+    plfill( 6, xs, ys );
+    plpsty( 1 );
+    plcol0( 3 );
+    plfill( 3, xs, ys );
+}
+
+// Draws the page into a stream with the plot buffer on and replays the
+// buffer into the file of out_names[compact].
+
+static void
+replay( int compact )
+{
+    PLINT cur_strm, new_strm;
+
+    plmkstrm( &cur_strm );
+    plsdev( TEST_DEVICE );
+    plsfnam( "test_plbuf_compact_0.svg" );
+    if ( compact )
+        plsetopt( "compactbuf", "" );
+    plsc->plbuf_write = 1;
+    plinit();
+
+    plot();
+
+    plmkstrm( &new_strm );
+    plsdev( TEST_DEVICE );
+    plsfnam( out_names[compact] );
+    plcpstrm( cur_strm, 0 );
+    plreplot();
+    plend1();
+
+    plsstrm( cur_strm );
+    plend1();
+}
+
+// Reads a file into memory, returning its size or -1.
+
+static long
+read_file( PLCHAR_VECTOR fname, char **buf )
+{
+    FILE *fp;
+    long size;
+
+    *buf = NULL;
+    if ( ( fp = fopen( fname, "rb" ) ) == NULL )
+        return -1;
+    fseek( fp, 0L, SEEK_END );
+    size = ftell( fp );
+    rewind( fp );
+    if ( size < 0 || ( *buf = (char *) malloc( (size_t) size + 1 ) ) == NULL
+         || fread( *buf, 1, (size_t) size, fp ) != (size_t) size )
+        size = -1;
+    fclose( fp );
+    return size;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    char *raw, *compact;
+    long raw_size, compact_size;
+    int  status = 0;
+
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    replay( 0 );
+    replay( 1 );
+
+    raw_size     = read_file( out_names[0], &raw );
+    compact_size = read_file( out_names[1], &compact );
+    if ( raw_size <= 0 || compact_size <= 0 )
+    {
+        fprintf( stderr, "test_plbuf_compact: could not read the replayed plots\n" );
+        status = 1;
+    }
+    else if ( raw_size != compact_size || memcmp( raw, compact, (size_t) raw_size ) != 0 )
+    {
+        fprintf( stderr, "test_plbuf_compact: %s and %s differ\n", out_names[0], out_names[1] );
+        status = 1;
+    }
+    else
+    {
+        remove( "test_plbuf_compact_0.svg" );
+        remove( out_names[0] );
+        remove( out_names[1] );
+    }
+
+    free( raw );
+    free( compact );
+    plend();
+    exit( status );
+}
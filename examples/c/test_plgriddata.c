@@ -0,0 +1,307 @@
+// plgriddata benchmark.
+//
+// Times the nearest neighbour algorithms of plgriddata on scattered
+// random data and, unless -nobrute is given, compares the results and
+// the timings with an exhaustive search over all data points for every
+// grid node (which is what plgriddata used to do).  The algorithms are
+// also run with -threads threads, whose results must be identical to the
+// single threaded ones.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include <float.h>
+#include <time.h>
+
+static PLINT pts       = 20000;
+static PLINT xp        = 200;
+static PLINT yp        = 200;
+static PLINT knn_order = 20;
+static PLINT threads   = 4;
+static int   nobrute   = 0;
+
+static PLOptionTable options[] = {
+    {
+        "npts",
+        NULL,
+        NULL,
+        &pts,
+        PL_OPT_INT,
+        "-npts points",
+        "Specify number of random points to generate [20000]"
+    },
+    {
+        "nx",
+        NULL,
+        NULL,
+        &xp,
+        PL_OPT_INT,
+        "-nx points",
+        "Specify grid x dimension [200]"
+    },
+    {
+        "ny",
+        NULL,
+        NULL,
+        &yp,
+        PL_OPT_INT,
+        "-ny points",
+        "Specify grid y dimension [200]"
+    },
+    {
+        "knn_order",
+        NULL,
+        NULL,
+        &knn_order,
+        PL_OPT_INT,
+        "-knn_order order",
+        "Specify the number of neighbors for GRID_NNIDW [20]"
+    },
+    {
+        "threads",
+        NULL,
+        NULL,
+        &threads,
+        PL_OPT_INT,
+        "-threads number",
+        "Specify number of threads for the parallel run [4]"
+    },
+    {
+        "nobrute",
+        NULL,
+        NULL,
+        &nobrute,
+        PL_OPT_BOOL,
+        "-nobrute",
+        "Do not run the exhaustive search reference"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Exhaustive search reference for GRID_NNIDW: inverse squared distance
+// weighted mean of the knn_order nearest points.
+
+static PLFLT
+brute_nnidw( PLFLT gx, PLFLT gy, PLFLT *x, PLFLT *y, PLFLT *z, int npts, int knn )
+{
+    PLFLT dist[100], d, max_dist, w, sw, swz;
+    int   item[100], max_slot, i, j;
+
+    for ( i = 0; i < knn; i++ )
+    {
+        dist[i] = PLFLT_MAX;
+        item[i] = -1;
+    }
+    max_dist = PLFLT_MAX;
+    max_slot = 0;
+    for ( i = 0; i < npts; i++ )
+    {
+        d = ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] );
+        if ( d < max_dist )
+        {
+            dist[max_slot] = d;
+            item[max_slot] = i;
+            max_dist       = dist[0];
+            max_slot       = 0;
+            for ( j = 1; j < knn; j++ )
+            {
+                if ( dist[j] > max_dist )
+                {
+                    max_dist = dist[j];
+                    max_slot = j;
+                }
+            }
+        }
+    }
+
+    sw = swz = 0.;
+    for ( i = 0; i < knn; i++ )
+    {
+        if ( item[i] == -1 )
+            continue;
+        w    = 1. / dist[i];
+        sw  += w;
+        swz += w * z[item[i]];
+    }
+    return swz / sw;
+}
+
+// Exhaustive search reference for GRID_NNAIDW: inverse squared distance
+// weighted mean of the nearest point in each quadrant.
+
+static PLFLT
+brute_nnaidw( PLFLT gx, PLFLT gy, PLFLT *x, PLFLT *y, PLFLT *z, int npts )
+{
+    PLFLT dist[4], d, w, sw, swz;
+    int   item[4], i, quad;
+
+    for ( i = 0; i < 4; i++ )
+    {
+        dist[i] = PLFLT_MAX;
+        item[i] = -1;
+    }
+    for ( i = 0; i < npts; i++ )
+    {
+        d    = ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] );
+        quad = 2 * ( x[i] > gx ) + ( y[i] < gy );
+        if ( d < dist[quad] )
+        {
+            dist[quad] = d;
+            item[quad] = i;
+        }
+    }
+
+    sw = swz = 0.;
+    for ( i = 0; i < 4; i++ )
+    {
+        if ( item[i] == -1 )
+            continue;
+        w    = 1. / dist[i];
+        sw  += w;
+        swz += w * z[item[i]];
+    }
+    return swz / sw;
+}
+
+// Wall clock time, as clock() adds up the time of all threads.
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PLFLT   *x, *y, *z, *xg, *yg, **zg, **zgt;
+    PLFLT   ref, err, max_err;
+    PLINT   alg[]  = { GRID_NNIDW, GRID_NNLI, GRID_NNAIDW };
+    PLCHAR_VECTOR name[] = { "GRID_NNIDW", "GRID_NNLI", "GRID_NNAIDW" };
+    PLFLT   data[] = { 0., 1.001, 0. };
+    char    nthreads[20];
+    double  t0, t_index, t_threads, t_brute;
+    int     i, j, k, differ, status = 0;
+
+    plMergeOpts( options, "test_plgriddata options", NULL );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( pts < 1 || xp < 2 || yp < 2 || knn_order < 1 || knn_order > 100 || threads < 1 )
+    {
+        fprintf( stderr, "test_plgriddata: bad arguments\n" );
+        exit( 1 );
+    }
+    data[0] = (PLFLT) knn_order;
+
+    plseed( 5489 );
+    x = (PLFLT *) malloc( (size_t) pts * sizeof ( PLFLT ) );
+    y = (PLFLT *) malloc( (size_t) pts * sizeof ( PLFLT ) );
+    z = (PLFLT *) malloc( (size_t) pts * sizeof ( PLFLT ) );
+    for ( i = 0; i < pts; i++ )
+    {
+        x[i] = plrandd();
+        y[i] = plrandd();
+        z[i] = sin( 6. * x[i] ) * cos( 4. * y[i] );
+    }
+
+    xg = (PLFLT *) malloc( (size_t) xp * sizeof ( PLFLT ) );
+    yg = (PLFLT *) malloc( (size_t) yp * sizeof ( PLFLT ) );
+    for ( i = 0; i < xp; i++ )
+        xg[i] = -0.1 + 1.2 * i / ( xp - 1. );
+    for ( j = 0; j < yp; j++ )
+        yg[j] = -0.1 + 1.2 * j / ( yp - 1. );
+    plAlloc2dGrid( &zg, xp, yp );
+    plAlloc2dGrid( &zgt, xp, yp );
+    snprintf( nthreads, sizeof ( nthreads ), "%d", threads );
+
+    printf( "%d points gridded onto %d x %d nodes\n", pts, xp, yp );
+
+    for ( k = 0; k < 3; k++ )
+    {
+        plsetopt( "nthreads", "1" );
+        t0 = seconds();
+        plgriddata( x, y, z, pts, xg, xp, yg, yp, zg, alg[k], data[k] );
+        t_index = seconds() - t0;
+
+        plsetopt( "nthreads", nthreads );
+        t0 = seconds();
+        plgriddata( x, y, z, pts, xg, xp, yg, yp, zgt, alg[k], data[k] );
+        t_threads = seconds() - t0;
+
+        differ = 0;
+        for ( i = 0; i < xp; i++ )
+        {
+            for ( j = 0; j < yp; j++ )
+            {
+                if ( zgt[i][j] != zg[i][j] && !( isnan( zgt[i][j] ) && isnan( zg[i][j] ) ) )
+                    differ = 1;
+            }
+        }
+        if ( differ )
+            status = 1;
+
+        printf( "%-12s %10.3f s (%d threads %10.3f s%s)\n", name[k], t_index,
+            threads, t_threads, differ ? ", results differ" : "" );
+
+        if ( nobrute || alg[k] == GRID_NNLI )
+            continue;
+
+        t0      = seconds();
+        max_err = 0.;
+        for ( i = 0; i < xp; i++ )
+        {
+            for ( j = 0; j < yp; j++ )
+            {
+                if ( alg[k] == GRID_NNIDW )
+                    ref = brute_nnidw( xg[i], yg[j], x, y, z, pts, knn_order );
+                else
+                    ref = brute_nnaidw( xg[i], yg[j], x, y, z, pts );
+                err     = fabs( zg[i][j] - ref );
+                max_err = MAX( max_err, err );
+            }
+        }
+        t_brute = seconds() - t0;
+
+        printf( "%-12s exhaustive search %10.3f s, max difference %g\n",
+            "", t_brute, max_err );
+        if ( max_err > 1e-10 )
+            status = 1;
+    }
+
+    plFree2dGrid( zg, xp, yp );
+    plFree2dGrid( zgt, xp, yp );
+    free( x );
+    free( y );
+    free( z );
+    free( xg );
+    free( yg );
+    plend();
+    exit( status );
+}
@@ -0,0 +1,100 @@
+// plinit startup benchmark.
+//
+// Initializes and ends PLplot -n times with the device given by -dev (the
+// null device by default) and reports the mean time taken by plinit and
+// plend, which includes setting up the table of available devices and
+// loading the driver of the selected one.  Comparing the times with and
+// without the drivers.db file of the drivers directory shows the gain of
+// the cached driver database.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include <time.h>
+
+static PLINT n = 1000;
+
+static PLOptionTable options[] = {
+    {
+        "n",
+        NULL,
+        NULL,
+        &n,
+        PL_OPT_INT,
+        "-n number",
+        "Specify number of plinit/plend cycles [1000]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    char   dev[80], fnam[256];
+    double t0, t;
+    int    i;
+
+    plMergeOpts( options, "test_plinit options", NULL );
+    plsdev( "null" );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( n < 1 )
+    {
+        fprintf( stderr, "test_plinit: bad arguments\n" );
+        exit( 1 );
+    }
+
+    // plend forgets the device and the output file, so keep them for the
+    // following cycles.
+    plgdev( dev );
+    plgfnam( fnam );
+
+    t0 = seconds();
+    for ( i = 0; i < n; i++ )
+    {
+        plsdev( dev );
+        if ( fnam[0] != '\0' )
+            plsfnam( fnam );
+        plinit();
+        plend();
+    }
+    t = seconds() - t0;
+
+    printf( "%d plinit/plend cycles with device %s: %.1f us each\n", n, dev, 1e6 * t / n );
+    exit( 0 );
+}
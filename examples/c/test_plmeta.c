@@ -0,0 +1,218 @@
+// Metafile page replay benchmark.
+//
+// Writes a PLplot metafile of -n pages with the plmeta driver and replays
+// it to the null device with plreadmetafile, once completely and once only
+// the page given by -page (the middle page by default) with the -mfpage
+// option.  The page is found through the page index that the driver writes
+// at the end of the file; it is then replayed again from a copy of the
+// file without the index, for which the index is rebuilt from the page
+// headers.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plplotP.h"
+#include "plcdemos.h"
+#include <time.h>
+
+#define NPTS         500
+#define MAXDEVS      100
+#define FILE_NAME    "test_plmeta.plm"
+#define COPY_NAME    "test_plmeta_noindex.plm"
+
+static PLINT n    = 1000;
+static PLINT page = 0;
+
+static PLOptionTable options[] = {
+    {
+        "n",
+        NULL,
+        NULL,
+        &n,
+        PL_OPT_INT,
+        "-n number",
+        "Specify number of pages [1000]"
+    },
+    {
+        "page",
+        NULL,
+        NULL,
+        &page,
+        PL_OPT_INT,
+        "-page number",
+        "Specify page to replay [n / 2]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+// Replays page p of the metafile (all pages for p = 0) to the null device,
+// returning the time taken.
+
+static double
+replay( const char *fname, PLINT p )
+{
+    char   opt[20];
+    double t;
+
+    plsdev( "null" );
+    sprintf( opt, "%d", (int) p );
+    plsetopt( "mfpage", opt );
+
+    t = seconds();
+    plreadmetafile( (char *) fname );
+    t = seconds() - t;
+
+    plend1();
+    return t;
+}
+
+// Copies the metafile without the page index that ends it.
+
+static int
+copy_without_index( const char *from, const char *to )
+{
+    FILE          *in, *out;
+    unsigned char *buf, *tail;
+    long          size, offset;
+
+    if ( ( in = fopen( from, "rb" ) ) == NULL )
+        return 1;
+    fseek( in, 0L, SEEK_END );
+    size = ftell( in );
+    rewind( in );
+    buf = (unsigned char *) malloc( (size_t) size );
+    if ( buf == NULL || fread( buf, 1, (size_t) size, in ) != (size_t) size )
+    {
+        fclose( in );
+        free( buf );
+        return 1;
+    }
+    fclose( in );
+
+    // The index ends with its offset, low byte first, and a tag
+    tail   = buf + size - 8;
+    offset = (long) tail[0] | (long) tail[1] << 8 | (long) tail[2] << 16 | (long) tail[3] << 24;
+    if ( memcmp( tail + 4, "PIDX", 4 ) != 0 || offset <= 0 || offset >= size )
+    {
+        free( buf );
+        return 1;
+    }
+
+    if ( ( out = fopen( to, "wb" ) ) == NULL )
+    {
+        free( buf );
+        return 1;
+    }
+    fwrite( buf, 1, (size_t) offset, out );
+    fclose( out );
+    free( buf );
+    return 0;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PLCHAR_VECTOR menu_list[MAXDEVS], dev_list[MAXDEVS];
+    PLCHAR_VECTOR *menus = menu_list, *devs = dev_list;
+    PLFLT         x[NPTS], y[NPTS];
+    double        t0, t_write, t_all, t_page, t_noindex;
+    int           ndev = MAXDEVS, have_plmeta = 0;
+    int           i, j;
+
+    plMergeOpts( options, "test_plmeta options", NULL );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( page == 0 )
+        page = ( n + 1 ) / 2;
+    if ( n < 1 || page < 1 || page > n )
+    {
+        fprintf( stderr, "test_plmeta: bad arguments\n" );
+        exit( 1 );
+    }
+
+    plgDevs( &menus, &devs, &ndev );
+    for ( i = 0; i < ndev; i++ )
+    {
+        if ( strcmp( devs[i], "plmeta" ) == 0 )
+            have_plmeta = 1;
+    }
+    if ( !have_plmeta )
+    {
+        printf( "test_plmeta: the plmeta device is not available\n" );
+        exit( 0 );
+    }
+
+    // Write the metafile
+    t0 = seconds();
+    plsdev( "plmeta" );
+    plsfnam( FILE_NAME );
+    plinit();
+    for ( i = 0; i < n; i++ )
+    {
+        for ( j = 0; j < NPTS; j++ )
+        {
+            x[j] = (PLFLT) j / ( NPTS - 1 );
+            y[j] = sin( 2. * M_PI * ( x[j] * ( 1 + i % 10 ) + 0.01 * i ) );
+        }
+        pladv( 0 );
+        plvsta();
+        plwind( 0., 1., -1., 1. );
+        plcol0( 1 + i % 14 );
+        plline( NPTS, x, y );
+    }
+    plend1();
+    t_write = seconds() - t0;
+
+    if ( copy_without_index( FILE_NAME, COPY_NAME ) )
+    {
+        fprintf( stderr, "test_plmeta: no page index in %s\n", FILE_NAME );
+        exit( 1 );
+    }
+
+    t_all     = replay( FILE_NAME, 0 );
+    t_page    = replay( FILE_NAME, page );
+    t_noindex = replay( COPY_NAME, page );
+
+    printf( "%d pages: write %.3f s, replay all %.3f s, "
+        "page %d %.6f s, page %d without index %.6f s\n",
+        n, t_write, t_all, page, t_page, page, t_noindex );
+
+    remove( FILE_NAME );
+    remove( COPY_NAME );
+    plend();
+    exit( 0 );
+}
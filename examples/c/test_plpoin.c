@@ -0,0 +1,138 @@
+// Marker drawing benchmark.
+//
+// Draws -n markers (one million by default) of the Hershey symbol -code
+// with plpoin on the device given by -dev (the svg device by default) and
+// reports the time taken by plpoin and the size of the output file.
+// Devices that set dev_markers get all the markers in a single
+// PLESC_MARKERS escape, the others draw them one at a time.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include <time.h>
+
+#define FILE_NAME    "test_plpoin.out"
+
+static PLINT n    = 1000000;
+static PLINT code = 9;
+
+static PLOptionTable options[] = {
+    {
+        "n",
+        NULL,
+        NULL,
+        &n,
+        PL_OPT_INT,
+        "-n number",
+        "Specify number of markers [1000000]"
+    },
+    {
+        "code",
+        NULL,
+        NULL,
+        &code,
+        PL_OPT_INT,
+        "-code number",
+        "Specify symbol code of the markers [9]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    char   dev[80], fnam[256];
+    PLFLT  *x, *y;
+    double t0, t;
+    long   size = 0;
+    FILE   *f;
+    int    i;
+
+    plMergeOpts( options, "test_plpoin options", NULL );
+    plsdev( "svg" );
+    plsfnam( FILE_NAME );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( n < 1 || code < -1 || code > 127 )
+    {
+        fprintf( stderr, "test_plpoin: bad arguments\n" );
+        exit( 1 );
+    }
+
+    x = (PLFLT *) malloc( (size_t) n * sizeof ( PLFLT ) );
+    y = (PLFLT *) malloc( (size_t) n * sizeof ( PLFLT ) );
+    if ( x == NULL || y == NULL )
+    {
+        fprintf( stderr, "test_plpoin: insufficient memory\n" );
+        exit( 1 );
+    }
+
+    plseed( 1 );
+    for ( i = 0; i < n; i++ )
+    {
+        x[i] = plrandd();
+        y[i] = plrandd();
+    }
+
+    plinit();
+    plgdev( dev );
+    plgfnam( fnam );
+    plenv( 0., 1., 0., 1., 0, 0 );
+
+    t0 = seconds();
+    plpoin( n, x, y, code );
+    t = seconds() - t0;
+
+    plend();
+
+    if ( ( f = fopen( fnam, "rb" ) ) != NULL )
+    {
+        fseek( f, 0L, SEEK_END );
+        size = ftell( f );
+        fclose( f );
+    }
+    if ( strcmp( fnam, FILE_NAME ) == 0 )
+        remove( FILE_NAME );
+
+    printf( "%d markers with device %s: %.3f s, %ld bytes of output\n",
+        n, dev, t, size );
+
+    free( x );
+    free( y );
+    exit( 0 );
+}
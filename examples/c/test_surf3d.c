@@ -0,0 +1,161 @@
+// plsurf3d z-buffer benchmark.
+//
+// Draws a shaded -nx by -nx surface with plsurf3d on the mem device, once
+// filling every triangle back to front and once with the -zbuffer option,
+// which renders the triangles into a z-buffer and draws it as one image.
+// The time taken by each and the number of pixels in which the two images
+// differ are reported.  Pass -mag to color the surface by height rather
+// than by the light source.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include <time.h>
+
+#define WIDTH     800
+#define HEIGHT    600
+
+static PLINT nx  = 1000;
+static int   mag = 0;
+
+static PLOptionTable options[] = {
+    {
+        "nx",
+        NULL,
+        NULL,
+        &nx,
+        PL_OPT_INT,
+        "-nx points",
+        "Specify number of grid points in x and in y [1000]"
+    },
+    {
+        "mag",
+        NULL,
+        NULL,
+        &mag,
+        PL_OPT_BOOL,
+        "-mag",
+        "Color the surface by height (MAG_COLOR)"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+// Draws the surface into image, returning the time plsurf3d takes.
+
+static double
+draw( unsigned char *image, int zbuffer, PLFLT *x, PLFLT *y, PLFLT **z )
+{
+    double t;
+
+    memset( image, 255, 3 * WIDTH * HEIGHT );
+    plsdev( "mem" );
+    plsmem( WIDTH, HEIGHT, image );
+    if ( zbuffer )
+        plsetopt( "zbuffer", "" );
+    plinit();
+    pladv( 0 );
+    plvpor( 0.0, 1.0, 0.0, 0.9 );
+    plwind( -1.0, 1.0, -0.9, 1.1 );
+    plw3d( 1.0, 1.0, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 1.0, 33.0, 24.0 );
+    pllightsource( 1., 1., 1. );
+
+    t = seconds();
+    plsurf3d( x, y, (PLFLT_MATRIX) z, nx, nx, mag ? MAG_COLOR : 0, NULL, 0 );
+    t = seconds() - t;
+
+    plend1();
+    return t;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PLFLT         *x, *y, **z, r;
+    unsigned char *image, *zimage;
+    double        t, tz;
+    long          differ = 0;
+    int           i, j;
+
+    plMergeOpts( options, "test_surf3d options", NULL );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( nx < 2 )
+    {
+        fprintf( stderr, "test_surf3d: bad arguments\n" );
+        exit( 1 );
+    }
+
+    x = (PLFLT *) malloc( (size_t) nx * sizeof ( PLFLT ) );
+    y = (PLFLT *) malloc( (size_t) nx * sizeof ( PLFLT ) );
+    plAlloc2dGrid( &z, nx, nx );
+    for ( i = 0; i < nx; i++ )
+    {
+        x[i] = y[i] = -1. + 2. * i / ( nx - 1. );
+    }
+    for ( i = 0; i < nx; i++ )
+    {
+        for ( j = 0; j < nx; j++ )
+        {
+            r       = sqrt( x[i] * x[i] + y[j] * y[j] );
+            z[i][j] = exp( -2. * r * r ) * cos( 12. * r );
+        }
+    }
+
+    image  = (unsigned char *) malloc( 3 * WIDTH * HEIGHT );
+    zimage = (unsigned char *) malloc( 3 * WIDTH * HEIGHT );
+
+    t  = draw( image, 0, x, y, z );
+    tz = draw( zimage, 1, x, y, z );
+
+    for ( i = 0; i < WIDTH * HEIGHT; i++ )
+    {
+        if ( memcmp( image + 3 * i, zimage + 3 * i, 3 ) != 0 )
+            differ++;
+    }
+
+    printf( "%d x %d surface: %.3f s, z-buffer %.3f s, %ld of %d pixels differ\n",
+        nx, nx, t, tz, differ, WIDTH * HEIGHT );
+
+    free( x );
+    free( y );
+    plFree2dGrid( z, nx, nx );
+    free( image );
+    free( zimage );
+    plend();
+    exit( 0 );
+}
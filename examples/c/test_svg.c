@@ -0,0 +1,153 @@
+// svg driver throughput benchmark.
+//
+// Draws -nlines polylines of -npts vertices each (a random walk across the
+// plot window) and -nfills filled polygons with the svg driver and reports
+// the time taken, the number of vertices written per second and the size
+// of the file.  Pass the svg driver options with -drvopt, e.g.
+// -drvopt path=1,precision=1, to compare the output formats.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plcdemos.h"
+#include <time.h>
+
+static PLINT npts   = 100000;
+static PLINT nlines = 20;
+static PLINT nfills = 20000;
+
+static PLOptionTable options[] = {
+    {
+        "npts",
+        NULL,
+        NULL,
+        &npts,
+        PL_OPT_INT,
+        "-npts points",
+        "Specify number of vertices per polyline [100000]"
+    },
+    {
+        "nlines",
+        NULL,
+        NULL,
+        &nlines,
+        PL_OPT_INT,
+        "-nlines number",
+        "Specify number of polylines [20]"
+    },
+    {
+        "nfills",
+        NULL,
+        NULL,
+        &nfills,
+        PL_OPT_INT,
+        "-nfills number",
+        "Specify number of filled quadrilaterals [20000]"
+    },
+    {
+        NULL,                   // option
+        NULL,                   // handler
+        NULL,                   // client data
+        NULL,                   // address of variable to set
+        0,                      // mode flag
+        NULL,                   // short syntax
+        NULL
+    }                           // long syntax
+};
+
+// Wall clock time, which includes the time spent writing the file.
+
+static double
+seconds( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    PLFLT  *x, *y, xf[4], yf[4];
+    double t0, t;
+    long   size = 0;
+    FILE   *file;
+    char   fnam[256];
+    int    i, k;
+
+    plMergeOpts( options, "test_svg options", NULL );
+    plsdev( "svg" );
+    plsfnam( "test_svg.svg" );
+    plparseopts( &argc, argv, PL_PARSE_FULL );
+
+    if ( npts < 2 || nlines < 0 || nfills < 0 )
+    {
+        fprintf( stderr, "test_svg: bad arguments\n" );
+        exit( 1 );
+    }
+
+    x = (PLFLT *) malloc( (size_t) npts * sizeof ( PLFLT ) );
+    y = (PLFLT *) malloc( (size_t) npts * sizeof ( PLFLT ) );
+
+    plseed( 5489 );
+    t0 = seconds();
+    plinit();
+    plgfnam( fnam );
+    plenv( 0., 1., 0., 1., 0, 0 );
+
+    for ( k = 0; k < nlines; k++ )
+    {
+        x[0] = plrandd();
+        y[0] = plrandd();
+        for ( i = 1; i < npts; i++ )
+        {
+            x[i] = x[i - 1] + 0.01 * ( plrandd() - 0.5 );
+            y[i] = y[i - 1] + 0.01 * ( plrandd() - 0.5 );
+        }
+        plcol0( 1 + k % 15 );
+        plline( npts, x, y );
+    }
+
+    for ( k = 0; k < nfills; k++ )
+    {
+        xf[0] = xf[1] = plrandd();
+        yf[0] = yf[3] = plrandd();
+        xf[2] = xf[3] = xf[0] + 0.02;
+        yf[1] = yf[2] = yf[0] + 0.02;
+        plcol1( plrandd() );
+        plfill( 4, xf, yf );
+    }
+
+    plend();
+    t = seconds() - t0;
+
+    if ( ( file = fopen( fnam, "rb" ) ) != NULL )
+    {
+        fseek( file, 0, SEEK_END );
+        size = ftell( file );
+        fclose( file );
+    }
+
+    printf( "%d polylines of %d vertices, %d fills: %.3f s, %.3g vertices/s, %ld bytes\n",
+        nlines, npts, nfills, t, ( (double) nlines * npts + 4. * nfills ) / t, size );
+
+    free( x );
+    free( y );
+    exit( 0 );
+}
@@ -101,6 +101,9 @@ void plbuf_clip( PLStream * );
 PLDLLIMPEXP void * plbuf_save( PLStream *, void * );
 PLDLLIMPEXP void * plbuf_switch( PLStream *, void * );
 PLDLLIMPEXP void plbuf_restore( PLStream *, void * );
+PLDLLIMPEXP void plbuf_read_bytes( PLStream *, size_t, void *, size_t );
+void plbuf_copy( PLStream *, PLStream * );
+void plbuf_free( PLStream * );
 
 PLDLLIMPEXP void plRemakePlot( PLStream * );
 void plFlushBuffer( PLStream *pls, PLBOOL restart, size_t amount );
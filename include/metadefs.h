@@ -32,6 +32,11 @@
 #define PIXEL_RES_X_OLD    42
 #define PIXEL_RES_Y_OLD    56
 
+// The page index ends with the offset of its PAGE_INDEX command and this
+// tag, so that a reader can find it from the end of the file.
+
+#define PLMETA_INDEX_TAG    "PIDX"
+
 // Macros to make it easier to abort on nonzero return code
 // Can't call plexit on a write failure since that would be circular
 
@@ -71,6 +76,7 @@
 #define SETSUB              18
 #define SSUB                19
 #define CLIP                20
+#define PAGE_INDEX          21  // Page header offsets, written after CLOSE
 #define END_OF_FIELD        255
 
 // Data structures
@@ -96,6 +102,11 @@ typedef struct
 
     int     notfirst;
 
+    // Offsets of the page headers, written as the page index on close
+    // or read from it
+    U_LONG  *page_offsets;
+    PLINT   n_pages, max_pages;
+
     PLINT   version;    // Metafile version number
     U_SHORT page;       // Current page
 
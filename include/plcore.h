@@ -67,7 +67,10 @@ static void     plLoadDriver( void );
 
 // Static variables
 
-static PLINT xscl[PL_MAXPOLY], yscl[PL_MAXPOLY];
+// Two point primitives are filtered in place here, longer polylines and
+// polygons use the growable arrays of the stream (see plP_growxy).
+
+static PLINT xscl[2], yscl[2];
 
 static PLINT initfont = 1;      // initial font: extended by default
 
@@ -55,6 +55,41 @@ typedef void ( *plD_pixel_fp )( PLStream *, PLINT, PLINT );
 typedef PLINT ( *plD_read_pixel_fp )( PLStream *, PLINT, PLINT );
 typedef PLINT ( *plD_set_pixel_fp )( PLStream *, PLINT, PLINT, PLINT );
 
+//--------------------------------------------------------------------------
+// Define the FT_CachedGlyph data structure.
+//
+// A glyph loaded by FT_Load_Char, kept in the glyph cache of the stream
+// together with everything that went into loading it: the face (fci),
+// the character size and resolution, the transformation and the load
+// flags other than FT_LOAD_RENDER.  The bitmap is only there once the
+// glyph has been rendered.
+//--------------------------------------------------------------------------
+
+typedef struct FT_CachedGlyph
+{
+    struct FT_CachedGlyph *next;        // next glyph in the same hash bucket
+    struct FT_CachedGlyph *newer;       // neighbours in the least recently
+    struct FT_CachedGlyph *older;       // used list
+
+    PLUNICODE             fci;
+    PLUNICODE             ch;
+    FT_F26Dot6            char_size;
+    FT_UInt               xdpi, ydpi;
+    FT_Matrix             matrix;
+    FT_Vector             pos;
+    FT_Int32              flags;        // without FT_LOAD_RENDER
+    unsigned long         hash;
+
+    FT_Vector             advance;      // as in the glyph slot
+    FT_Pos                width;        // glyph metrics
+    FT_Pos                height;
+    FT_Int                left;         // bitmap_left and bitmap_top
+    FT_Int                top;
+    FT_Bitmap             bitmap;       // with a buffer of our own
+    unsigned char         rendered;     // set once the bitmap is there
+    size_t                bytes;        // memory used by this glyph
+} FT_CachedGlyph;
+
 //--------------------------------------------------------------------------
 // Define the FT_Data data structure.
 //
@@ -173,6 +208,23 @@ typedef struct FT_Data
 //  with the background. Set to 1 if you have this.
 //
     unsigned char BLENDED_ANTIALIASING;
+
+//
+//  Glyph cache, see FT_GetGlyph().  The glyphs are kept in a hash table
+//  and in a list from the most to the least recently used one, which is
+//  dropped first when the glyphs take more than cache_max_bytes.  A glyph
+//  that does not fit at all goes to the scratch entry instead.
+//
+    FT_CachedGlyph **cache_table;
+    FT_CachedGlyph *cache_newest, *cache_oldest;
+    FT_CachedGlyph scratch;
+    unsigned char  *scratch_buffer;     // bitmap buffer of the scratch entry
+    size_t         scratch_size;
+    size_t         cache_bytes, cache_max_bytes;
+    unsigned long  cache_hits, cache_misses;
+    FT_F26Dot6     char_size;           // character size set by FT_SetFace
+    FT_Pos         glyph_width;         // metrics of the last glyph
+    FT_Pos         glyph_height;        // measured by FT_StrX_YW
 } FT_Data;
 
 
@@ -311,6 +311,7 @@ typedef PLINT ( *PLDEFINED_callback )( PLFLT x, PLFLT y );
 #define PLESC_IMPORT_BUFFER             39 // set the contents of the buffer to a specified byte string
 #define PLESC_APPEND_BUFFER             40 // append the given byte string to the buffer
 #define PLESC_FLUSH_REMAINING_BUFFER    41 // flush the remaining buffer e.g. after new data was appended
+#define PLESC_MARKERS                   42 // draw one glyph at many positions
 
 // Alternative unicode text handling control characters
 #define PLTEXT_FONTCHANGE               0 // font change in the text stream
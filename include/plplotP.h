@@ -624,6 +624,21 @@ plstrdup( PLCHAR_VECTOR src );
 PLDLLIMPEXP void
 plcmap1_calc( void );
 
+// Rebuild the RGBA lookup table of cmap 1.
+
+PLDLLIMPEXP void
+plcmap1_lut( PLStream *pls );
+
+// Map an array of cmap 1 positions to cmap 1 indices, as plcol1 does.
+
+PLDLLIMPEXP void
+plcmap1_index( PLFLT_VECTOR values, PLINT n, unsigned short *index );
+
+// Map an array of cmap 1 positions to RGBA bytes.
+
+PLDLLIMPEXP void
+plcmap1_rgba( PLFLT_VECTOR values, PLINT n, unsigned char *rgba );
+
 // Draws a slanting tick at position (mx,my) (measured in mm) of
 // vector length (dx,dy).
 
@@ -736,6 +751,18 @@ typedef struct
     PLINT          symbol;         // plot symbol to draw
 }EscText;
 
+// Arguments of PLESC_MARKERS.  The glyph of text is drawn centred on each
+// of the n points (x[i], y[i]), in physical coordinates; the reference
+// point of text itself is ignored.
+
+typedef struct
+{
+    EscText *text;                 // glyph to draw
+    PLINT   n;                     // number of markers
+    PLINT   *x;                    // positions of the markers
+    PLINT   *y;
+}EscMarkers;
+
 //
 // structure that contains driver specific information, to be used by
 // plargs.c and anydriver.c, related to plParseDrvOpts() and plHelpDrvOpts()
@@ -764,27 +791,24 @@ void
 plHelpDrvOpts( DrvOpt * );
 
 //
-// structures to store contour lines
+// structure to store contour lines
+//
+// The points of all lines of all levels are kept one after the other in x
+// and y.  Line j is made of the points line_pt[j] to line_pt[j + 1] - 1,
+// and the lines of level[i] are level_line[i] to level_line[i + 1] - 1.
 //
 
-#define LINE_ITEMS    20
-
-typedef struct cont_line
-{
-    PLFLT            *x;
-    PLFLT            *y;
-    PLINT            npts;
-    struct cont_line *next;
-} CONT_LINE;
-
-typedef struct cont_level
+typedef struct
 {
-    // INDENT-OFF (stop infinite recursion)
-    PLFLT level;             // contour level
-    struct cont_line  *line; // contour line struct
-    struct cont_level *next; // contour level struct
-    // INDENT-ON
-} CONT_LEVEL;
+    PLINT nlevel;                // number of contour levels
+    PLFLT *level;                // contour levels
+    PLINT *level_line;           // first line of each level, nlevel + 1 entries
+    PLINT nline;                 // number of contour lines
+    PLINT *line_pt;              // first point of each line, nline + 1 entries
+    PLINT npts;                  // number of points
+    PLFLT *x, *y;                // points of all lines
+    PLINT level_size, line_size, pts_size; // allocated sizes
+} CONT_STORE;
 
 void
 cont_store( PLFLT_MATRIX f, PLINT nx, PLINT ny,
@@ -792,10 +816,10 @@ cont_store( PLFLT_MATRIX f, PLINT nx, PLINT ny,
             PLFLT_VECTOR clevel, PLINT nlevel,
             void ( *pltr )( PLFLT, PLFLT, PLFLT *, PLFLT *, PLPointer ),
             PLPointer pltr_data,
-            CONT_LEVEL **contour );
+            CONT_STORE *contour );
 
 void
-cont_clean_store( CONT_LEVEL *ct );
+cont_clean_store( CONT_STORE *ct );
 
 // Get the viewport boundaries in world coordinates, expanded slightly
 
@@ -1087,12 +1111,23 @@ plP_fill( short *x, short *y, PLINT npts );
 void
 plP_gradient( short *x, short *y, PLINT npts );
 
+// Draw a glyph at many positions
+
+void
+plP_markers( EscMarkers *args );
+
 // draw image
 
 void
 plP_image( PLFLT *z, PLINT nx, PLINT ny, PLFLT xmin, PLFLT ymin, PLFLT dx, PLFLT dy,
            void ( *pltr )( PLFLT, PLFLT, PLFLT *, PLFLT *, PLPointer ), PLPointer pltr_data );
 
+// draw image cells given in physical coordinates
+
+void
+plP_drawimage( short *x, short *y, unsigned short *z, unsigned char *rgba,
+               PLINT nx, PLINT ny );
+
 // Structure for holding arc data
 typedef struct
 {
@@ -1187,6 +1222,9 @@ RestoreWrite2BufferPixmap( void );
 void
 grimage( short *x, short *y, unsigned short *z, PLINT nx, PLINT ny );
 
+void
+plimagefills( short *x, short *y, unsigned short *z, PLINT nx, PLINT ny );
+
 PLDLLIMPEXP int
 plInBuildTree( void );
 
@@ -1196,10 +1234,11 @@ plimageslow( PLFLT *idata, PLINT nx, PLINT ny,
              void ( *pltr )( PLFLT, PLFLT, PLFLT *, PLFLT *, PLPointer ),
              PLPointer pltr_data );
 
-typedef struct
-{
-    PLFLT xmin, ymin, dx, dy;
-} IMG_DT;
+int
+plimagefast( PLFLT *idata, PLINT nx, PLINT ny,
+             PLFLT xmin, PLFLT ymin, PLFLT dx, PLFLT dy,
+             void ( *pltr )( PLFLT, PLFLT, PLFLT *, PLFLT *, PLPointer ),
+             PLPointer pltr_data );
 
 //
 // void plfvect()
@@ -1291,6 +1330,40 @@ pl_set_extended_cmap0( PLStream *, int, int );
 
 #endif
 
+// Number of threads to use for parallel computations in the current stream
+
+PLINT
+plP_nthreads( void );
+
+// Calls body( i, thread, data ) for i = 0, ..., n - 1 using up to nthreads
+// threads
+
+void
+plP_parallel( PLINT n, PLINT nthreads, void ( *body )( PLINT, PLINT, PLPointer ), PLPointer data );
+
+// Pointer to the values at (ix, iy) of the data behind a built-in f2eval,
+// with a distance of *stride between consecutive iy
+
+PLDLLIMPEXP const PLFLT *
+plP_f2eval_row( PLF2EVAL_callback f2eval, PLPointer f2eval_data, PLINT ix, PLINT *stride );
+
+// Copies the values for kx <= ix < lx and ky <= iy < ly to a[ix][iy]
+
+PLDLLIMPEXP void
+plP_f2eval_copy( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
+                 PLINT kx, PLINT lx, PLINT ky, PLINT ly, PLFLT *a );
+
+// Grows the scratch coordinate arrays *px, *py of *size points so that
+// they can hold at least npts points
+
+void
+plP_growxy( PLINT **px, PLINT **py, PLINT *size, PLINT npts );
+
+// The same for arrays of device coordinates
+
+void
+plP_growxy_short( short **px, short **py, PLINT *size, PLINT npts );
+
 // Create a temporary file securely
 PLDLLIMPEXP FILE *
 pl_create_tempfile( char **fname );
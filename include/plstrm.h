@@ -169,6 +169,7 @@ typedef struct
 // dev_fastimg  PLINT   Set if driver has fast image drawing capabilities
 // dev_xor      PLINT   Set if driver supports xor mode.
 // dev_clear    PLINT   Set if driver support clear.
+// dev_markers  PLINT   Set if driver can draw a batch of markers (PLESC_MARKERS)
 // termin	PLINT	Set for interactive devices
 // graphx	PLINT	Set if currently in graphics mode
 // nopause	PLINT	Set if we are skipping the pause between frames
@@ -209,6 +210,7 @@ typedef struct
 // dev_z	ushort*	Pointer to array of z values for the color
 // dev_zmin,
 // dev_zmax     ushort  Min and max values of z to plot
+// dev_rgba     uchar*  RGBA bytes of the cells, 4 per z value (PLESC_IMAGE)
 //
 // The following pointer is for drivers that require device-specific
 // data.  At initialization the driver should malloc the necessary
@@ -291,11 +293,15 @@ typedef struct
 // Variables for use by the plot buffer
 //
 // For Memory Buffer (default)
-// plbuf_buffer_grow  size_t  Memory buffer growth step
+// plbuf_buffer_grow  size_t  Size of the memory buffer chunks
 // plbuf_buffer_size  size_t  Current size of memory buffer
-// plbuf_buffer	      void *  Pointer to memory buffer
+// plbuf_buffer	      void *  Pointer to the table of memory buffer chunks
 // plbuf_top	      size_t  Offset to the top of used area/start of free area
 // plbuf_readpos      size_t  Offset to current position being read
+// plbuf_scratch      void *  Copies of data straddling two chunks (two areas)
+// plbuf_compact      PLINT   Use the compact encoding (-compactbuf option)
+// plbuf_pack         void *  Work area for encoding/decoding coordinates
+// plbuf_state_pos    size_t  Offsets of the last state records written
 //
 // plbufOwner	int	Typically set; only zero if current stream is cloned.
 //
@@ -520,6 +526,10 @@ typedef struct
 
 #define PL_MAX_CMAP1CP    256
 
+// Number of slots for the PLSTATE_* codes (1 ... 8) in plbuf_state_pos
+
+#define PL_NSTATE         9
+
 typedef struct
 {
 // Misc control information
@@ -586,6 +596,7 @@ typedef struct
     short          *dev_ix, *dev_iy;
     unsigned short *dev_z;
     unsigned short dev_zmin, dev_zmax;
+    unsigned char  *dev_rgba;
     PLINT          imclxmin, imclxmax, imclymin, imclymax;
 
     // end of variables for plimage()
@@ -789,6 +800,9 @@ typedef struct
     // Drawing mode section
     PLINT       dev_modeset;
 
+    // Markers section, see plP_markers()
+    PLINT       dev_markers;
+
     // Calculate bounding-box limits rather than plot box?
     PLBOOL      if_boxbb;
     // Bounding box limits in mm for box including decorations
@@ -800,6 +814,54 @@ typedef struct
 //
     char *mf_infile;
     char *mf_outfile;
+    PLINT mf_page;              // Page of mf_infile to replay, 0 for all
+
+// Number of threads allowed for parallel computations (-nthreads option)
+    PLINT nthreads;
+
+// Scratch coordinate arrays for polylines and polygons of any length,
+// grown as needed by plP_growxy().  The dixbuf/diybuf pair holds the
+// copies filtered by difilt() in plcore.c and the linexbuf/lineybuf pair
+// the physical coordinates of the polylines of plline.c.  The
+// clpxbuf/clpybuf pairs, grown by plP_growxy_short(), hold the clipped
+// pieces of the polylines passed to plP_pllclp(), one pair for each of
+// the clpdepth calls that can be active at once.
+//
+    PLINT *dixbuf, *diybuf;
+    PLINT dibufsize;
+    PLINT *linexbuf, *lineybuf;
+    PLINT linebufsize;
+    short *clpxbuf[2], *clpybuf[2];
+    PLINT clpbufsize[2];
+    PLINT clpdepth;
+
+// Plot buffer data straddling two chunks, see rd_data_no_copy()
+    void   *plbuf_scratch[2];
+    size_t plbuf_scratch_size[2];
+    int    plbuf_scratch_next;
+
+// Compact plot buffer encoding, see plbuf_polyline() and plbuf_state()
+    PLINT  plbuf_compact;
+    void   *plbuf_pack;
+    size_t plbuf_pack_size;
+    size_t plbuf_state_pos[PL_NSTATE];
+    size_t plbuf_state_len[PL_NSTATE];
+
+// Width in physical units of the columns in which polyline vertices are
+// merged by plP_drawor_poly(), 0 to draw every vertex (-decimate option)
+    PLINT decimate;
+
+// Shade all levels of plshades in one pass over the grid (-shade_sweep
+// option)
+    PLINT shade_sweep;
+
+// Draw the shaded surfaces of plsurf3d as a single z-buffered image on
+// devices that draw images (-zbuffer option)
+    PLINT zbuffer;
+
+// RGBA bytes of the cmap1 entries, four per entry with the alpha scaled to
+// 0 - 255, rebuilt by plcmap1_lut() whenever cmap1 changes
+    unsigned char *cmap1_lut;
 } PLStream;
 
 //--------------------------------------------------------------------------
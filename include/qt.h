@@ -129,6 +129,8 @@ public:
     virtual void drawLine( short x1, short y1, short x2, short y2 );
     virtual void drawPolyline( short * x, short * y, PLINT npts );
     virtual void drawPolygon( short * x, short * y, PLINT npts );
+    // Draws the image sent with PLESC_IMAGE as a single QImage
+    virtual void drawImage();
     virtual void drawText( EscText* txt );
     virtual void setColor( int r, int g, int b, double alpha );
     virtual void setBackgroundColor( int /* r */, int /* g */, int /* b */, double /* alpha */ ){}
@@ -614,6 +614,43 @@ void delaunay_destroy( delaunay* d )
     free( d );
 }
 
+// Creates a copy of the Delaunay triangulation structure that shares the
+// triangulation with the original but has its own search work data.
+//
+// @param d Structure to be shared
+// @return Shared copy
+//
+delaunay* delaunay_share( delaunay* d )
+{
+    delaunay* s = malloc( sizeof ( delaunay ) );
+
+    *s          = *d;
+    s->flags    = calloc( (size_t) ( d->ntriangles ), sizeof ( int ) );
+    s->first_id = -1;
+    s->t_in     = NULL;
+    s->t_out    = NULL;
+
+    return s;
+}
+
+// Releases memory engaged in a copy made by delaunay_share().
+//
+// @param d Structure to be destroyed
+//
+void delaunay_destroy_shared( delaunay* d )
+{
+    if ( d == NULL )
+        return;
+
+    if ( d->flags != NULL )
+        free( d->flags );
+    if ( d->t_in != NULL )
+        istack_destroy( d->t_in );
+    if ( d->t_out != NULL )
+        istack_destroy( d->t_out );
+    free( d );
+}
+
 // Returns whether the point p is on the right side of the vector (p0, p1).
 //
 static int on_right_side( point* p, point* p0, point* p1 )
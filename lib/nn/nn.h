@@ -128,6 +128,23 @@ delaunay* delaunay_build( int np, point points[], int ns, int segments[], int nh
 //
 void delaunay_destroy( delaunay* d );
 
+//* Creates a copy of a Delaunay triangulation that shares the triangulation
+// with the original but has its own work data for point searches, so that
+// different threads can interpolate on the same triangulation at the same
+// time.
+//
+// @param d Delaunay triangulation
+// @return Shared copy, to be destroyed with delaunay_destroy_shared()
+// before `d' is destroyed
+//
+delaunay* delaunay_share( delaunay* d );
+
+//* Destroys a copy made by delaunay_share().
+//
+// @param d Structure to be destroyed
+//
+void delaunay_destroy_shared( delaunay* d );
+
 //* `lpi' -- "linear point interpolator" is a structure for
 // conducting linear interpolation on a given data on a "point-to-point" basis.
 // It interpolates linearly within each triangle resulted from the Delaunay
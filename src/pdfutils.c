@@ -37,8 +37,20 @@
 #define NEED_PLDEBUG
 #include "plplotP.h"
 
+#include <float.h>
+
+// Floats can be transferred by copying their bits when the host uses the
+// IEEE single precision format.
+#if FLT_RADIX == 2 && FLT_MANT_DIG == 24 && FLT_MAX_EXP == 128 && FLT_MIN_EXP == -125
+#define PDF_IEEE_FLOAT
+#endif
+
+// Number of U_SHORT's byte swapped at a time on big-endian hosts.
+#define PDF_SWAPBLOCK    256
+
 static void print_ieeef( float *, U_LONG * );
 static int  pdf_wrx( const U_CHAR *x, long nitems, PDFstrm *pdfs );
+static void pdf_growbuf( PDFstrm *pdfs, size_t nitems, const char *fname );
 
 static int debug = 0;
 
@@ -292,15 +304,7 @@ pdf_putc( int c, PDFstrm *pdfs )
     else if ( pdfs->buffer != NULL )
     {
         if ( pdfs->bp >= pdfs->bufmax )
-        {
-            pldebug( "pdf_putc",
-                "Increasing buffer to %d bytes\n", pdfs->bufmax );
-            pdfs->bufmax += 512;
-            if ( ( pdfs->buffer = (U_CHAR *) realloc( (void *) pdfs->buffer, pdfs->bufmax ) ) == NULL )
-            {
-                plexit( "pdf_putc: Insufficient memory" );
-            }
-        }
+            pdf_growbuf( pdfs, 1, "pdf_putc" );
         pdfs->buffer[pdfs->bp++] = (unsigned char) c;
         result = c;
     }
@@ -394,6 +398,37 @@ pdf_ungetc( int c, PDFstrm *pdfs )
     return result;
 }
 
+//--------------------------------------------------------------------------
+// pdf_growbuf()
+//
+//! Enlarges the buffer of a memory stream so that it can take nitems more
+//! bytes.  The size is at least doubled so that a stream written a little
+//! at a time is only reallocated a logarithmic number of times.
+//!
+//! @param pdfs The stream whose buffer is enlarged.
+//! @param nitems The number of bytes about to be written.
+//! @param fname The name of the calling function, for messages.
+//!
+//--------------------------------------------------------------------------
+
+static void
+pdf_growbuf( PDFstrm *pdfs, size_t nitems, const char *fname )
+{
+    size_t bufmax = pdfs->bufmax;
+
+    if ( bufmax < 512 )
+        bufmax = 512;
+    while ( bufmax < pdfs->bp + nitems )
+        bufmax *= 2;
+
+    pldebug( fname, "Increasing buffer to %d bytes\n", (int) bufmax );
+    if ( ( pdfs->buffer = (U_CHAR *) realloc( (void *) pdfs->buffer, bufmax ) ) == NULL )
+    {
+        plexit( "pdf_growbuf: Insufficient memory" );
+    }
+    pdfs->bufmax = bufmax;
+}
+
 //--------------------------------------------------------------------------
 // int pdf_wrx()
 //
@@ -410,7 +445,7 @@ pdf_ungetc( int c, PDFstrm *pdfs )
 static int
 pdf_wrx( const U_CHAR *x, long nitems, PDFstrm *pdfs )
 {
-    int i, result = 0;
+    int result = 0;
 
     if ( pdfs->file != NULL )
     {
@@ -424,24 +459,13 @@ pdf_wrx( const U_CHAR *x, long nitems, PDFstrm *pdfs )
         pdfs->bp += nitems;
 #endif
     }
-    else if ( pdfs->buffer != NULL )
+    else if ( pdfs->buffer != NULL && nitems > 0 )
     {
-        for ( i = 0; i < nitems; i++ )
-        {
-            if ( pdfs->bp >= pdfs->bufmax )
-            {
-                pldebug( "pdf_wrx",
-                    "Increasing buffer to %d bytes\n", pdfs->bufmax );
-                pdfs->bufmax += 512;
-                if ( ( pdfs->buffer = (U_CHAR *)
-                                      realloc( (void *) ( pdfs->buffer ), pdfs->bufmax ) ) == NULL )
-                {
-                    plexit( "pdf_wrx: Insufficient memory" );
-                }
-            }
-            pdfs->buffer[pdfs->bp++] = x[i];
-        }
-        result = i;
+        if ( pdfs->bp + (size_t) nitems > pdfs->bufmax )
+            pdf_growbuf( pdfs, (size_t) nitems, "pdf_wrx" );
+        memcpy( pdfs->buffer + pdfs->bp, x, (size_t) nitems );
+        pdfs->bp += (size_t) nitems;
+        result    = (int) nitems;
     }
 
     return result;
@@ -463,7 +487,7 @@ pdf_wrx( const U_CHAR *x, long nitems, PDFstrm *pdfs )
 int
 pdf_rdx( U_CHAR *x, long nitems, PDFstrm *pdfs )
 {
-    int i, result = 0;
+    int result = 0;
 
     if ( pdfs->file != NULL )
     {
@@ -477,15 +501,13 @@ pdf_rdx( U_CHAR *x, long nitems, PDFstrm *pdfs )
         pdfs->bp += nitems;
 #endif
     }
-    else if ( pdfs->buffer != NULL )
+    else if ( pdfs->buffer != NULL && nitems > 0 && pdfs->bp < pdfs->bufmax )
     {
-        for ( i = 0; i < nitems; i++ )
-        {
-            if ( pdfs->bp > pdfs->bufmax )
-                break;
-            x[i] = pdfs->buffer[pdfs->bp++];
-        }
-        result = i;
+        if ( (size_t) nitems > pdfs->bufmax - pdfs->bp )
+            nitems = (long) ( pdfs->bufmax - pdfs->bp );
+        memcpy( x, pdfs->buffer + pdfs->bp, (size_t) nitems );
+        pdfs->bp += (size_t) nitems;
+        result    = (int) nitems;
     }
 
     return result;
@@ -740,17 +762,24 @@ pdf_rd_2bytes( PDFstrm *pdfs, U_SHORT *ps )
 int
 pdf_wr_2nbytes( PDFstrm *pdfs, U_SHORT *s, PLINT n )
 {
-    PLINT  i;
-    U_CHAR x[2];
+#ifdef WORDS_BIGENDIAN
+    U_SHORT x[PDF_SWAPBLOCK];
+    PLINT   i, j, m;
 
-    for ( i = 0; i < n; i++ )
+    for ( i = 0; i < n; i += m )
     {
-        x[0] = (U_CHAR) ( (U_LONG) ( s[i] & (U_LONG) 0x00FF ) );
-        x[1] = (U_CHAR) ( (U_LONG) ( s[i] & (U_LONG) 0xFF00 ) >> 8 );
+        m = MIN( n - i, PDF_SWAPBLOCK );
+        for ( j = 0; j < m; j++ )
+            x[j] = (U_SHORT) ( ( s[i + j] << 8 ) | ( s[i + j] >> 8 ) );
 
-        if ( pdf_wrx( x, 2, pdfs ) != 2 )
+        if ( pdf_wrx( (U_CHAR *) x, 2 * m, pdfs ) != 2 * m )
             return PDF_WRERR;
     }
+#else
+    // The shorts are already stored low end first.
+    if ( n > 0 && pdf_wrx( (U_CHAR *) s, 2 * (long) n, pdfs ) != 2 * n )
+        return PDF_WRERR;
+#endif
     return 0;
 }
 
@@ -770,21 +799,20 @@ pdf_wr_2nbytes( PDFstrm *pdfs, U_SHORT *s, PLINT n )
 int
 pdf_rd_2nbytes( PDFstrm *pdfs, U_SHORT *s, PLINT n )
 {
-    PLINT   i;
-    U_CHAR  x[2];
-    U_SHORT xs;
+#ifdef WORDS_BIGENDIAN
+    PLINT i;
+#endif
 
-    for ( i = 0; i < n; i++ )
-    {
-        if ( !pdf_rdx( x, 2, pdfs ) )
-            return PDF_RDERR;
+    if ( n <= 0 )
+        return 0;
 
-        s[i]  = 0;
-        xs    = (U_SHORT) x[0];
-        s[i] |= xs;
-        xs    = (U_SHORT) ( (U_SHORT) x[1] << 8 );
-        s[i] |= xs;
-    }
+    if ( pdf_rdx( (U_CHAR *) s, 2 * (long) n, pdfs ) != 2 * n )
+        return PDF_RDERR;
+
+#ifdef WORDS_BIGENDIAN
+    for ( i = 0; i < n; i++ )
+        s[i] = (U_SHORT) ( ( s[i] << 8 ) | ( s[i] >> 8 ) );
+#endif
     return 0;
 }
 
@@ -915,6 +943,29 @@ pdf_rd_4bytes( PDFstrm *pdfs, U_LONG *ps )
 int
 pdf_wr_ieeef( PDFstrm *pdfs, float f )
 {
+#ifdef PDF_IEEE_FLOAT
+    PLUINT bits;
+    U_LONG value;
+    int    istat;
+
+    // Zero is always written without its sign.
+    if ( f == 0.0 )
+        return ( pdf_wr_4bytes( pdfs, 0 ) );
+
+    memcpy( &bits, &f, sizeof ( bits ) );
+    value = (U_LONG) bits;
+
+    if ( ( istat = pdf_wr_4bytes( pdfs, value ) ) )
+        return ( istat );
+
+    if ( debug )
+    {
+        fprintf( stderr, "Float value (written):      %g\n", f );
+        print_ieeef( &f, &value );
+    }
+
+    return 0;
+#else
     double    fdbl, fmant, f_new;
     float     fsgl, f_tmp;
     int       istat, ex, e_new, e_off;
@@ -974,6 +1025,7 @@ pdf_wr_ieeef( PDFstrm *pdfs, float f )
     }
 
     return 0;
+#endif
 }
 
 //--------------------------------------------------------------------------
@@ -991,6 +1043,25 @@ pdf_wr_ieeef( PDFstrm *pdfs, float f )
 int
 pdf_rd_ieeef( PDFstrm *pdfs, float *pf )
 {
+#ifdef PDF_IEEE_FLOAT
+    PLUINT bits;
+    U_LONG value;
+    int    istat;
+
+    if ( ( istat = pdf_rd_4bytes( pdfs, &value ) ) )
+        return ( istat );
+
+    bits = (PLUINT) ( value & (U_LONG) 0xFFFFFFFF );
+    memcpy( pf, &bits, sizeof ( bits ) );
+
+    if ( debug )
+    {
+        fprintf( stderr, "Float value (read):      %g\n", *pf );
+        print_ieeef( pf, &value );
+    }
+
+    return 0;
+#else
     double f_new, f_tmp;
     float  fsgl;
     int    istat, ex, bias = 127;
@@ -1029,6 +1100,7 @@ pdf_rd_ieeef( PDFstrm *pdfs, float *pf )
     }
 
     return 0;
+#endif
 }
 
 //--------------------------------------------------------------------------
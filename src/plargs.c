@@ -160,9 +160,15 @@ static int opt_cmap0( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 static int opt_cmap1( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 static int opt_locale( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 static int opt_eofill( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_compactbuf( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_nthreads( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_decimate( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_shade_sweep( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_zbuffer( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 
 static int opt_mfo( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 static int opt_mfi( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
+static int opt_mfpage( PLCHAR_VECTOR, PLCHAR_VECTOR, void * );
 
 // Global variables
 
@@ -640,6 +646,51 @@ static PLOptionTable ploption_table[] = {
         "-eofill",
         "For the case where the boundary of the filled region is self-intersecting, use the even-odd fill rule rather than the default nonzero fill rule."
     },
+    {
+        "compactbuf",           // Compact plot buffer encoding
+        opt_compactbuf,
+        NULL,
+        NULL,
+        PL_OPT_FUNC,
+        "-compactbuf",
+        "Delta encode coordinates and drop repeated state changes in the plot buffer"
+    },
+    {
+        "nthreads",             // Threads for parallel computations
+        opt_nthreads,
+        NULL,
+        NULL,
+        PL_OPT_FUNC | PL_OPT_ARG,
+        "-nthreads number",
+        "Number of threads used for parallel computations such as plgriddata (default 1)"
+    },
+    {
+        "decimate",             // Polyline decimation
+        opt_decimate,
+        NULL,
+        NULL,
+        PL_OPT_FUNC | PL_OPT_ARG,
+        "-decimate width",
+        "Merge solid polyline vertices within columns of width device units (0, the default, draws every vertex)"
+    },
+    {
+        "shade_sweep",          // Single pass plshades
+        opt_shade_sweep,
+        NULL,
+        NULL,
+        PL_OPT_FUNC,
+        "-shade_sweep",
+        "Compute all shades of plshades in one pass over the grid"
+    },
+    {
+        "zbuffer",              // Z-buffered plsurf3d
+        opt_zbuffer,
+        NULL,
+        NULL,
+        PL_OPT_FUNC,
+        "-zbuffer",
+        "Draw plsurf3d surfaces as one z-buffered image on devices that draw images"
+    },
     {
         "drvopt",               // Driver specific options
         opt_drvopt,
@@ -667,6 +718,15 @@ static PLOptionTable ploption_table[] = {
         "-mfi PLplot metafile name",
         "Read the specified PLplot metafile"
     },
+    {
+        "mfpage",               // Metafile page option
+        opt_mfpage,
+        NULL,
+        NULL,
+        PL_OPT_ARG | PL_OPT_FUNC,
+        "-mfpage page",
+        "Read only the given page of the PLplot metafile"
+    },
     {
         NULL,                   // option
         NULL,                   // handler
@@ -2844,6 +2904,120 @@ opt_eofill( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR PL_UNUSED( opt_arg ),
     return 0;
 }
 
+//--------------------------------------------------------------------------
+// opt_compactbuf()
+//
+//! Makes the plot buffer store polyline and polygon coordinates delta
+//! encoded and skip state changes which repeat the last one of the same
+//! kind on the page.  Replaying such a buffer needs no option.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param PL_UNUSED( opt_arg ) Not used.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_compactbuf( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR PL_UNUSED( opt_arg ), void * PL_UNUSED( client_data ) )
+{
+    plsc->plbuf_compact = 1;
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// opt_nthreads()
+//
+//! Sets the number of threads that may be used for parallel computations
+//! (e.g., in plgriddata, or in plshades with -shade_sweep).  Values less
+//! than 2 mean that everything is computed serially, which is the
+//! default.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param opt_arg The number of threads.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_nthreads( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR opt_arg, void * PL_UNUSED( client_data ) )
+{
+    plsc->nthreads = atoi( opt_arg );
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// opt_decimate()
+//
+//! Sets the width in physical (device) units of the columns within which
+//! consecutive vertices of solid polylines are reduced to the first, last,
+//! lowest and highest one before they reach the driver.  A width of 1 does
+//! not change what a raster device draws; larger widths trade accuracy for
+//! fewer vertices.  0, the default, keeps every vertex, which is what
+//! vector output that must be exact needs.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param opt_arg The column width.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_decimate( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR opt_arg, void * PL_UNUSED( client_data ) )
+{
+    plsc->decimate = MAX( atoi( opt_arg ), 0 );
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// opt_shade_sweep()
+//
+//! Makes plshades compute the polygons of all shades in a single pass over
+//! the grid, instead of a pass per shade, before filling them shade by
+//! shade.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param PL_UNUSED( opt_arg ) Not used.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_shade_sweep( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR PL_UNUSED( opt_arg ), void * PL_UNUSED( client_data ) )
+{
+    plsc->shade_sweep = 1;
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// opt_zbuffer()
+//
+//! Makes plsurf3d render the shaded surface into a z-buffer at the
+//! resolution of the device and draw it as one image, instead of filling
+//! every triangle back to front.  Only used by devices that draw images.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param PL_UNUSED( opt_arg ) Not used.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_zbuffer( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR PL_UNUSED( opt_arg ), void * PL_UNUSED( client_data ) )
+{
+    plsc->zbuffer = 1;
+    return 0;
+}
+
 //--------------------------------------------------------------------------
 // opt_mfo()
 //
@@ -2893,3 +3067,23 @@ opt_mfi( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR opt_arg, void * PL_UNUSED
     strcpy( plsc->mf_infile, opt_arg );
     return 0;
 }
+
+//--------------------------------------------------------------------------
+// opt_mfpage()
+//
+//! Sets the page of the PLplot metafile that will be read, 0 for all.
+//!
+//! @param PL_UNUSED( opt ) Not used.
+//! @param opt_arg The page number.
+//! @param PL_UNUSED( client_data ) Not used.
+//!
+//! returns 0.
+//!
+//--------------------------------------------------------------------------
+
+static int
+opt_mfpage( PLCHAR_VECTOR PL_UNUSED( opt ), PLCHAR_VECTOR opt_arg, void * PL_UNUSED( client_data ) )
+{
+    plsc->mf_page = atoi( opt_arg );
+    return 0;
+}
@@ -37,6 +37,16 @@ typedef unsigned char        uint8_t;
 typedef unsigned short int   uint16_t;
 #endif
 
+// The plot buffer is kept in chunks of PLBUF_CHUNK_SIZE bytes (stored in
+// pls->plbuf_buffer_grow), and pls->plbuf_buffer points to the table of
+// chunks.  Byte n of the buffer is byte n % PLBUF_CHUNK_SIZE of chunk
+// n / PLBUF_CHUNK_SIZE.  Growing the buffer only adds chunks, so the
+// data already written is never copied and a large buffer does not need
+// one contiguous block of memory.  The chunk size is even, so the two
+// byte command words never straddle two chunks.
+
+#define PLBUF_CHUNK_SIZE    ( 128 * 1024 )
+
 //
 // Function prototypes
 //
@@ -46,6 +56,14 @@ void * plbuf_save( PLStream *pls, void *state );
 
 // Private
 static void     check_buffer_size( PLStream *pls, size_t data_size );
+static uint8_t *buffer_at( PLStream *pls, size_t pos );
+static void     put_bytes( PLStream *pls, size_t pos, const void *buf, size_t buf_size );
+static void     get_bytes( PLStream *pls, size_t pos, void *buf, size_t buf_size );
+static int      cmp_bytes( PLStream *pls, size_t pos1, size_t pos2, size_t size );
+static void     reset_state_pos( PLStream *pls );
+
+static void     wr_points( PLStream *pls, short *xa, short *ya, PLINT npts );
+static void     rd_points( PLStream *pls, short **xa, short **ya, PLINT *npts );
 
 static int      rd_command( PLStream *pls, U_CHAR *p_c );
 static void     rd_data( PLStream *pls, void *buf, size_t buf_size );
@@ -57,6 +75,7 @@ static void     wr_data( PLStream *pls, void *buf, size_t buf_size );
 static void     plbuf_control( PLStream *pls, U_CHAR c );
 static void     plbuf_fill( PLStream *pls );
 static void     plbuf_swin( PLStream *pls, PLWindow *plwin );
+static void     plbuf_markers( PLStream *pls, EscMarkers *markers );
 
 static void     rdbuf_init( PLStream *pls );
 static void     rdbuf_line( PLStream *pls );
@@ -68,6 +87,7 @@ static void     rdbuf_esc( PLStream *pls );
 static void     rdbuf_image( PLStream *pls );
 static void     rdbuf_text( PLStream *pls );
 static void     rdbuf_text_unicode( PLINT op, PLStream *pls );
+static void     rdbuf_markers( PLStream *pls );
 static void     rdbuf_fill( PLStream *pls );
 static void     rdbuf_clip( PLStream *pls );
 static void     rdbuf_swin( PLStream *pls );
@@ -96,20 +116,19 @@ plbuf_init( PLStream *pls )
     if ( pls->plbuf_buffer == NULL )
     {
         // We have not allocated a buffer, so do it now
-        pls->plbuf_buffer_grow = 128 * 1024;
-
-        if ( ( pls->plbuf_buffer = malloc( pls->plbuf_buffer_grow ) ) == NULL )
-            plexit( "plbuf_init: Error allocating plot buffer." );
-
-        pls->plbuf_buffer_size = pls->plbuf_buffer_grow;
+        pls->plbuf_buffer_grow = PLBUF_CHUNK_SIZE;
+        pls->plbuf_buffer_size = 0;
         pls->plbuf_top         = 0;
         pls->plbuf_readpos     = 0;
+
+        check_buffer_size( pls, pls->plbuf_buffer_grow );
     }
     else
     {
         // Buffer is allocated, move the top to the beginning
         pls->plbuf_top = 0;
     }
+    reset_state_pos( pls );
 }
 
 //--------------------------------------------------------------------------
@@ -146,6 +165,7 @@ plbuf_bop( PLStream *pls )
 
     // Move the top to the beginning
     pls->plbuf_top = 0;
+    reset_state_pos( pls );
 
     wr_command( pls, (U_CHAR) BOP );
 
@@ -226,6 +246,84 @@ plbuf_tidy( PLStream * PL_UNUSED( pls ) )
     dbug_enter( "plbuf_tidy" );
 }
 
+//--------------------------------------------------------------------------
+// plbuf_free()
+//
+// Release the memory of the plot buffer.
+//--------------------------------------------------------------------------
+
+void
+plbuf_free( PLStream *pls )
+{
+    size_t i, nchunks;
+
+    dbug_enter( "plbuf_free" );
+
+    if ( pls->plbuf_buffer != NULL )
+    {
+        nchunks = pls->plbuf_buffer_size / pls->plbuf_buffer_grow;
+        for ( i = 0; i < nchunks; i++ )
+            free( ( (uint8_t **) pls->plbuf_buffer )[i] );
+        free( pls->plbuf_buffer );
+        pls->plbuf_buffer = NULL;
+    }
+    pls->plbuf_buffer_size = 0;
+    pls->plbuf_top         = 0;
+    pls->plbuf_readpos     = 0;
+
+    for ( i = 0; i < 2; i++ )
+    {
+        free( pls->plbuf_scratch[i] );
+        pls->plbuf_scratch[i]      = NULL;
+        pls->plbuf_scratch_size[i] = 0;
+    }
+    free( pls->plbuf_pack );
+    pls->plbuf_pack      = NULL;
+    pls->plbuf_pack_size = 0;
+}
+
+//--------------------------------------------------------------------------
+// plbuf_copy()
+//
+// Make the plot buffer of pls a copy of the plot buffer of src.
+//--------------------------------------------------------------------------
+
+void
+plbuf_copy( PLStream *pls, PLStream *src )
+{
+    size_t pos, n;
+
+    dbug_enter( "plbuf_copy" );
+
+    plbuf_free( pls );
+    if ( src->plbuf_buffer == NULL )
+        return;
+
+    pls->plbuf_buffer_grow = src->plbuf_buffer_grow;
+    check_buffer_size( pls, src->plbuf_top );
+    for ( pos = 0; pos < src->plbuf_top; pos += n )
+    {
+        n = MIN( src->plbuf_top - pos, src->plbuf_buffer_grow - pos % src->plbuf_buffer_grow );
+        put_bytes( pls, pos, buffer_at( src, pos ), n );
+    }
+    pls->plbuf_top     = src->plbuf_top;
+    pls->plbuf_readpos = src->plbuf_readpos;
+}
+
+//--------------------------------------------------------------------------
+// plbuf_read_bytes()
+//
+// Copy buf_size bytes of the plot buffer starting at pos into buf.  For
+// drivers that ship the raw buffer contents elsewhere (e.g. wxwidgets),
+// since the buffer is not one contiguous block of memory.
+//--------------------------------------------------------------------------
+
+void
+plbuf_read_bytes( PLStream *pls, size_t pos, void *buf, size_t buf_size )
+{
+    get_bytes( pls, pos, buf, buf_size );
+}
+
 //--------------------------------------------------------------------------
 // plbuf_line()
 //
@@ -276,12 +374,8 @@ plbuf_polyline( PLStream *pls, short *xa, short *ya, PLINT npts )
 //    wr_data( pls, &pls->clpymi, sizeof ( pls->clpymi ) );
 //    wr_data( pls, &pls->clpyma, sizeof ( pls->clpyma ) );
 
-    //then the number of points
-    wr_data( pls, &npts, sizeof ( PLINT ) );
-
-    //then the point data
-    wr_data( pls, xa, sizeof ( short ) * (size_t) npts );
-    wr_data( pls, ya, sizeof ( short ) * (size_t) npts );
+    //then the number of points and the point data
+    wr_points( pls, xa, ya, npts );
 }
 
 //--------------------------------------------------------------------------
@@ -293,6 +387,8 @@ plbuf_polyline( PLStream *pls, short *xa, short *ya, PLINT npts )
 void
 plbuf_state( PLStream *pls, PLINT op )
 {
+    size_t start = pls->plbuf_top, prev;
+
     dbug_enter( "plbuf_state" );
 
     wr_command( pls, (U_CHAR) CHANGE_STATE );
@@ -352,18 +448,56 @@ plbuf_state( PLStream *pls, PLINT op )
         wr_data( pls, &( pls->symht ), sizeof ( pls->symht ) );
         break;
     }
+
+    // With the compact encoding a record identical to the last one of the
+    // same kind on this page changes nothing on replay, so it is dropped.
+    // COLOR0 and COLOR1 both set the current color, and an index into a
+    // color map gives another color once the map changes, so a color or
+    // color map record makes the earlier color records useless for this.
+    if ( !pls->plbuf_compact || op <= 0 || op >= PL_NSTATE )
+        return;
+
+    switch ( op )
+    {
+    case PLSTATE_CMAP0:
+    case PLSTATE_CMAP1:
+        pls->plbuf_state_pos[PLSTATE_COLOR0] = (size_t) ( -1 );
+        pls->plbuf_state_pos[PLSTATE_COLOR1] = (size_t) ( -1 );
+        break;
+
+    case PLSTATE_COLOR0:
+    case PLSTATE_COLOR1:
+        pls->plbuf_state_pos[op == PLSTATE_COLOR0 ? PLSTATE_COLOR1 : PLSTATE_COLOR0] = (size_t) ( -1 );
+        // fall through
+
+    default:
+        prev = pls->plbuf_state_pos[op];
+        if ( prev != (size_t) ( -1 )
+             && pls->plbuf_top - start == pls->plbuf_state_len[op]
+             && cmp_bytes( pls, prev, start, pls->plbuf_top - start ) == 0 )
+        {
+            pls->plbuf_top = start;
+        }
+        else
+        {
+            pls->plbuf_state_pos[op] = start;
+            pls->plbuf_state_len[op] = pls->plbuf_top - start;
+        }
+        break;
+    }
 }
 
 
 //--------------------------------------------------------------------------
 // plbuf_image()
 //
-// write image described in points pls->dev_x[], pls->dev_y[], pls->dev_z[].
-//                      pls->nptsX, pls->nptsY.
+// write image described in points pls->dev_ix[], pls->dev_iy[] and
+// colors pls->dev_z[], of pls->dev_nptsX x pls->dev_nptsY cell corners
+// (see plP_drawimage()).
 //--------------------------------------------------------------------------
 
 static void
-plbuf_image( PLStream *pls, IMG_DT *img_dt )
+plbuf_image( PLStream *pls )
 {
     PLINT npts = pls->dev_nptsX * pls->dev_nptsY;
 
@@ -372,14 +506,6 @@ plbuf_image( PLStream *pls, IMG_DT *img_dt )
     wr_data( pls, &pls->dev_nptsX, sizeof ( PLINT ) );
     wr_data( pls, &pls->dev_nptsY, sizeof ( PLINT ) );
 
-    wr_data( pls, &img_dt->xmin, sizeof ( PLFLT ) );
-    wr_data( pls, &img_dt->ymin, sizeof ( PLFLT ) );
-    wr_data( pls, &img_dt->dx, sizeof ( PLFLT ) );
-    wr_data( pls, &img_dt->dy, sizeof ( PLFLT ) );
-
-    wr_data( pls, &pls->dev_zmin, sizeof ( short ) );
-    wr_data( pls, &pls->dev_zmax, sizeof ( short ) );
-
     wr_data( pls, pls->dev_ix, sizeof ( short ) * (size_t) npts );
     wr_data( pls, pls->dev_iy, sizeof ( short ) * (size_t) npts );
     wr_data( pls, pls->dev_z,
@@ -466,6 +592,41 @@ plbuf_text_unicode( PLStream *pls, EscText *text )
 }
 
 
+//--------------------------------------------------------------------------
+// plbuf_markers()
+//
+// Handle a batch of markers.  The glyph is stored like plbuf_text() stores
+// text, but it is never longer than two characters (a character and the
+// copy that unescapes the escape character), followed by the positions.
+//--------------------------------------------------------------------------
+
+static void
+plbuf_markers( PLStream *pls, EscMarkers *markers )
+{
+    EscText   *text = markers->text;
+    PLUNICODE fci;
+    U_SHORT   len   = MIN( text->unicode_array_len, 2 );
+
+    dbug_enter( "plbuf_markers" );
+
+    wr_data( pls, &pls->chrht, sizeof ( pls->chrht ) );
+    wr_data( pls, &pls->diorot, sizeof ( pls->diorot ) );
+
+    wr_data( pls, &text->base, sizeof ( text->base ) );
+    wr_data( pls, &text->just, sizeof ( text->just ) );
+    wr_data( pls, text->xform, sizeof ( text->xform[0] ) * 4 );
+    wr_data( pls, &text->font_face, sizeof ( text->font_face ) );
+
+    plgfci( &fci );
+    wr_data( pls, &fci, sizeof ( fci ) );
+    wr_data( pls, &len, sizeof ( len ) );
+    wr_data( pls, text->unicode_array, sizeof ( PLUNICODE ) * len );
+
+    wr_data( pls, &markers->n, sizeof ( markers->n ) );
+    wr_data( pls, markers->x, sizeof ( PLINT ) * (size_t) markers->n );
+    wr_data( pls, markers->y, sizeof ( PLINT ) * (size_t) markers->n );
+}
+
 //--------------------------------------------------------------------------
 // plbuf_esc()
 //
@@ -478,6 +639,7 @@ plbuf_text_unicode( PLStream *pls, EscText *text )
 //	PLESC_SWIN	    Set plot window parameters
 //      PLESC_IMAGE         Draw image
 //      PLESC_HAS_TEXT      Draw PostScript text
+//      PLESC_MARKERS       Draw a glyph at many positions
 //	PLESC_CLEAR	    Clear Background
 //	PLESC_START_RASTERIZE
 //	PLESC_END_RASTERIZE Start and stop rasterization
@@ -503,7 +665,7 @@ plbuf_esc( PLStream *pls, PLINT op, void *ptr )
         break;
 
     case PLESC_IMAGE:
-        plbuf_image( pls, (IMG_DT *) ptr );
+        plbuf_image( pls );
         break;
 
     // Unicode and non-Unicode text handling
@@ -511,6 +673,10 @@ plbuf_esc( PLStream *pls, PLINT op, void *ptr )
         plbuf_text( pls, (EscText *) ptr );
         break;
 
+    case PLESC_MARKERS:
+        plbuf_markers( pls, (EscMarkers *) ptr );
+        break;
+
     // Alternate Unicode text handling
     case PLESC_BEGIN_TEXT:
     case PLESC_TEXT_CHAR:
@@ -529,15 +695,16 @@ plbuf_esc( PLStream *pls, PLINT op, void *ptr )
         buffer    = (plbuffer *) ptr;
         extraSize = buffer->size > pls->plbuf_top ? buffer->size - pls->plbuf_top : 0;
         check_buffer_size( pls, extraSize );
-        memcpy( pls->plbuf_buffer, buffer->buffer, buffer->size );
+        put_bytes( pls, 0, buffer->buffer, buffer->size );
         pls->plbuf_top = buffer->size;
+        reset_state_pos( pls );
         break;
     }
 
     case PLESC_APPEND_BUFFER:
         buffer = (plbuffer *) ptr;
         check_buffer_size( pls, buffer->size );
-        memcpy( (char *) ( pls->plbuf_buffer ) + pls->plbuf_top, buffer->buffer, buffer->size );
+        put_bytes( pls, pls->plbuf_top, buffer->buffer, buffer->size );
         pls->plbuf_top += buffer->size;
         break;
 
@@ -594,9 +761,7 @@ plbuf_fill( PLStream *pls )
 {
     dbug_enter( "plbuf_fill" );
 
-    wr_data( pls, &pls->dev_npts, sizeof ( PLINT ) );
-    wr_data( pls, pls->dev_x, sizeof ( short ) * (size_t) pls->dev_npts );
-    wr_data( pls, pls->dev_y, sizeof ( short ) * (size_t) pls->dev_npts );
+    wr_points( pls, pls->dev_x, pls->dev_y, pls->dev_npts );
 }
 
 //--------------------------------------------------------------------------
@@ -853,14 +1018,8 @@ rdbuf_polyline( PLStream *pls )
 //    rd_data( pls, &pls->clpymi, sizeof ( pls->clpymi ) );
 //    rd_data( pls, &pls->clpyma, sizeof ( pls->clpyma ) );
 
-    //then the number of points
-    rd_data( pls, &npts, sizeof ( PLINT ) );
-
-    //then the line data
-    // Use the "no copy" version because the node data array does
-    // not need to persist outside of ths function
-    rd_data_no_copy( pls, (void **) &xpl, sizeof ( short ) * (size_t) npts );
-    rd_data_no_copy( pls, (void **) &ypl, sizeof ( short ) * (size_t) npts );
+    //then the number of points and the line data
+    rd_points( pls, &xpl, &ypl, &npts );
 
     plP_polyline( xpl, ypl, npts );
 }
@@ -1013,6 +1172,7 @@ rdbuf_state( PLStream *pls )
         // Now read the colormap from the buffer
         rd_data( pls, &( pls->cmap1[0] ), size );
         pls->ncol1 = ncol;
+        plcmap1_lut( pls );
 
         plP_state( PLSTATE_CMAP1 );
         break;
@@ -1050,6 +1210,7 @@ rdbuf_state( PLStream *pls )
 //	PLESC_SWIN	    Set plot window parameters
 //      PLESC_IMAGE         Draw image
 //      PLESC_HAS_TEXT      Draw PostScript text
+//      PLESC_MARKERS       Draw a glyph at many positions
 //      PLESC_BEGIN_TEXT    Commands for the alternative unicode text
 //      PLESC_TEXT_CHAR     handling path
 //      PLESC_CONTROL_CHAR
@@ -1080,6 +1241,9 @@ rdbuf_esc( PLStream *pls )
     case PLESC_HAS_TEXT:
         rdbuf_text( pls );
         break;
+    case PLESC_MARKERS:
+        rdbuf_markers( pls );
+        break;
     case PLESC_BEGIN_TEXT:
     case PLESC_TEXT_CHAR:
     case PLESC_CONTROL_CHAR:
@@ -1119,10 +1283,7 @@ rdbuf_fill( PLStream *pls )
 
     dbug_enter( "rdbuf_fill" );
 
-    rd_data( pls, &npts, sizeof ( PLINT ) );
-
-    rd_data_no_copy( pls, (void **) &xpl, sizeof ( short ) * (size_t) npts );
-    rd_data_no_copy( pls, (void **) &ypl, sizeof ( short ) * (size_t) npts );
+    rd_points( pls, &xpl, &ypl, &npts );
 
     plP_fill( xpl, ypl, npts );
 }
@@ -1145,22 +1306,15 @@ rdbuf_clip( PLStream *pls )
 //--------------------------------------------------------------------------
 // rdbuf_image()
 //
-// .
+// Draw an image stored by plbuf_image().
 //--------------------------------------------------------------------------
 
 static void
 rdbuf_image( PLStream *pls )
 {
-    // Unnecessarily initialize dev_iy and dev_z to quiet -O1
-    // -Wuninitialized warnings which are false alarms.  (If something
-    // goes wrong with the dev_ix malloc below any further use of
-    // dev_iy and dev_z does not occur.  Similarly, if something goes
-    // wrong with the dev_iy malloc below any further use of dev_z
-    // does not occur.)
     short          *dev_ix, *dev_iy = NULL;
-    unsigned short *dev_z = NULL, dev_zmin, dev_zmax;
+    unsigned short *dev_z = NULL;
     PLINT          nptsX, nptsY, npts;
-    PLFLT          xmin, ymin, dx, dy;
 
     dbug_enter( "rdbuf_image" );
 
@@ -1168,18 +1322,6 @@ rdbuf_image( PLStream *pls )
     rd_data( pls, &nptsY, sizeof ( PLINT ) );
     npts = nptsX * nptsY;
 
-    rd_data( pls, &xmin, sizeof ( PLFLT ) );
-    rd_data( pls, &ymin, sizeof ( PLFLT ) );
-    rd_data( pls, &dx, sizeof ( PLFLT ) );
-    rd_data( pls, &dy, sizeof ( PLFLT ) );
-
-    rd_data( pls, &dev_zmin, sizeof ( short ) );
-    rd_data( pls, &dev_zmax, sizeof ( short ) );
-
-    // NOTE:  Even though for memory buffered version all the data is in memory,
-    // we still allocate and copy the data because I think that method works
-    // better in a multithreaded environment.  I could be wrong.
-    //
     if ( ( ( dev_ix = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) ||
          ( ( dev_iy = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) ||
          ( ( dev_z = (unsigned short *) malloc( (size_t) ( ( nptsX - 1 ) * ( nptsY - 1 ) ) * sizeof ( unsigned short ) ) ) == NULL ) )
@@ -1191,14 +1333,7 @@ rdbuf_image( PLStream *pls )
         sizeof ( unsigned short )
         * (size_t) ( ( nptsX - 1 ) * ( nptsY - 1 ) ) );
 
-    //
-    // COMMENTED OUT by Hezekiah Carty
-    // Commented (hopefullly temporarily) until the dev_fastimg rendering
-    // path can be updated to support the new plimage internals. In the
-    // meantime this function is not actually used so the issue of how to
-    // update the code to support the new interface can be ignored.
-    //
-    //plP_image(dev_ix, dev_iy, dev_z, nptsX, nptsY, xmin, ymin, dx, dy, dev_zmin, dev_zmax);
+    plP_drawimage( dev_ix, dev_iy, dev_z, NULL, nptsX, nptsY );
 
     free( dev_ix );
     free( dev_iy );
@@ -1352,6 +1487,55 @@ rdbuf_text( PLStream *pls )
     plP_esc( PLESC_HAS_TEXT, &text );
 }
 
+//--------------------------------------------------------------------------
+// rdbuf_markers()
+//
+// Draw a batch of markers stored by plbuf_markers().
+//--------------------------------------------------------------------------
+
+static void
+rdbuf_markers( PLStream *pls )
+{
+    EscMarkers markers;
+    EscText    text;
+    PLFLT      xform[4];
+    PLUNICODE  fci, unicode[2];
+    U_SHORT    len;
+
+    dbug_enter( "rdbuf_markers" );
+
+    text.xform = xform;
+
+    rd_data( pls, &pls->chrht, sizeof ( pls->chrht ) );
+    rd_data( pls, &pls->diorot, sizeof ( pls->diorot ) );
+
+    rd_data( pls, &text.base, sizeof ( text.base ) );
+    rd_data( pls, &text.just, sizeof ( text.just ) );
+    rd_data( pls, text.xform, sizeof ( text.xform[0] ) * 4 );
+    rd_data( pls, &text.font_face, sizeof ( text.font_face ) );
+
+    rd_data( pls, &fci, sizeof ( fci ) );
+    plsfci( fci );
+    rd_data( pls, &len, sizeof ( len ) );
+    rd_data( pls, unicode, sizeof ( PLUNICODE ) * len );
+
+    text.text_type         = PL_STRING_SYMBOL;
+    text.unicode_char      = unicode[0];
+    text.unicode_array     = unicode;
+    text.unicode_array_len = len;
+    text.string            = NULL;
+
+    // The positions are read in place
+    rd_data( pls, &markers.n, sizeof ( markers.n ) );
+    rd_data_no_copy( pls, (void **) ( &markers.x ), sizeof ( PLINT ) * (size_t) markers.n );
+    rd_data_no_copy( pls, (void **) ( &markers.y ), sizeof ( PLINT ) * (size_t) markers.n );
+
+    text.x       = markers.x[0];
+    text.y       = markers.y[0];
+    markers.text = &text;
+    plP_markers( &markers );
+}
+
 //--------------------------------------------------------------------------
 // rdbuf_text_unicode()
 //
@@ -1501,7 +1685,7 @@ plbuf_control( PLStream *pls, U_CHAR c )
         break;
 
     case ESCAPE:
-        esc_old = *( (U_CHAR *) ( pls->plbuf_buffer ) + pls->plbuf_readpos );
+        esc_old = *buffer_at( pls, pls->plbuf_readpos );
         rdbuf_esc( pls );
         break;
 
@@ -1553,7 +1737,7 @@ rd_command( PLStream *pls, U_CHAR *p_c )
 
     if ( pls->plbuf_readpos < pls->plbuf_top )
     {
-        *p_c = *(U_CHAR *) ( (uint8_t *) pls->plbuf_buffer + pls->plbuf_readpos );
+        *p_c = *buffer_at( pls, pls->plbuf_readpos );
 
         // Advance the buffer position to maintain two-byte alignment
         pls->plbuf_readpos += sizeof ( uint16_t );
@@ -1577,7 +1761,7 @@ rd_command( PLStream *pls, U_CHAR *p_c )
 static void
 rd_data( PLStream *pls, void *buf, size_t buf_size )
 {
-    memcpy( buf, (uint8_t *) pls->plbuf_buffer + pls->plbuf_readpos, buf_size );
+    get_bytes( pls, pls->plbuf_readpos, buf, buf_size );
 
     // Advance position but maintain alignment
     pls->plbuf_readpos += ( buf_size + ( buf_size % sizeof ( uint16_t ) ) );
@@ -1591,12 +1775,36 @@ rd_data( PLStream *pls, void *buf, size_t buf_size )
 // and doing a memcpy.  Useful for commands that do not need the data
 // to persist (like LINE and POLYLINE).  Do not use for commands that
 // has data that needs to persist or are freed elsewhere (like COLORMAPS).
+//
+// Data straddling two chunks of the buffer is copied to one of two
+// scratch areas used in turn, so a command can read up to two items
+// this way.
 //--------------------------------------------------------------------------
 
 static void
 rd_data_no_copy( PLStream *pls, void **buf, size_t buf_size )
 {
-    ( *buf ) = (uint8_t *) pls->plbuf_buffer + pls->plbuf_readpos;
+    size_t offset = pls->plbuf_readpos % pls->plbuf_buffer_grow;
+    int    i;
+
+    if ( offset + buf_size <= pls->plbuf_buffer_grow )
+    {
+        ( *buf ) = buffer_at( pls, pls->plbuf_readpos );
+    }
+    else
+    {
+        i = pls->plbuf_scratch_next;
+        pls->plbuf_scratch_next = !i;
+        if ( pls->plbuf_scratch_size[i] < buf_size )
+        {
+            free( pls->plbuf_scratch[i] );
+            if ( ( pls->plbuf_scratch[i] = malloc( buf_size ) ) == NULL )
+                plexit( "rd_data_no_copy: Insufficient memory" );
+            pls->plbuf_scratch_size[i] = buf_size;
+        }
+        get_bytes( pls, pls->plbuf_readpos, pls->plbuf_scratch[i], buf_size );
+        ( *buf ) = pls->plbuf_scratch[i];
+    }
 
     // Advance position but maintain alignment
     pls->plbuf_readpos += ( buf_size + ( buf_size % sizeof ( uint16_t ) ) );
@@ -1606,39 +1814,267 @@ rd_data_no_copy( PLStream *pls, void **buf, size_t buf_size )
 // check_buffer_size()
 //
 // Checks that the buffer has space to store the desired amount of data.
-// If not, the buffer is resized to accomodate the request
+// If not, chunks are added to the buffer to accomodate the request
 //--------------------------------------------------------------------------
 static void
 check_buffer_size( PLStream *pls, size_t data_size )
 {
-    size_t required_size;
+    size_t  required_size, nchunks, newchunks, i;
+    uint8_t **chunks;
 
     required_size = pls->plbuf_top + data_size;
 
     if ( required_size >= pls->plbuf_buffer_size )
     {
         if ( pls->plbuf_buffer_grow == 0 )
-            pls->plbuf_buffer_grow = 128 * 1024;
-
-        // Not enough space, need to grow the buffer before memcpy
-        // Must make sure the increase is enough for this data, so
-        // Determine the amount of space required and grow in multiples
-        // of plbuf_buffer_grow
-        pls->plbuf_buffer_size += pls->plbuf_buffer_grow *
-                                  ( ( required_size
-                                      - pls->plbuf_buffer_size )
-                                    / pls->plbuf_buffer_grow
-                                    + 1 );
+            pls->plbuf_buffer_grow = PLBUF_CHUNK_SIZE;
+
+        // Not enough space, add as many chunks as needed for this data
+        nchunks   = pls->plbuf_buffer_size / pls->plbuf_buffer_grow;
+        newchunks = required_size / pls->plbuf_buffer_grow + 1;
 
         if ( pls->verbose )
             printf( "Growing buffer to %d KB\n",
-                (int) ( pls->plbuf_buffer_size / 1024 ) );
+                (int) ( newchunks * pls->plbuf_buffer_grow / 1024 ) );
 
-        if ( ( pls->plbuf_buffer
-                   = realloc( pls->plbuf_buffer, pls->plbuf_buffer_size )
-                   ) == NULL )
+        if ( ( chunks = (uint8_t **) realloc( pls->plbuf_buffer, newchunks * sizeof ( uint8_t * ) ) ) == NULL )
             plexit( "plbuf buffer grow:  Plot buffer grow failed" );
+        pls->plbuf_buffer = chunks;
+
+        for ( i = nchunks; i < newchunks; i++ )
+        {
+            if ( ( chunks[i] = (uint8_t *) malloc( pls->plbuf_buffer_grow ) ) == NULL )
+                plexit( "plbuf buffer grow:  Plot buffer grow failed" );
+            pls->plbuf_buffer_size += pls->plbuf_buffer_grow;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+// buffer_at()
+//
+// Address of byte pos of the buffer.
+//--------------------------------------------------------------------------
+
+static uint8_t *
+buffer_at( PLStream *pls, size_t pos )
+{
+    return ( (uint8_t **) pls->plbuf_buffer )[pos / pls->plbuf_buffer_grow]
+           + pos % pls->plbuf_buffer_grow;
+}
+
+//--------------------------------------------------------------------------
+// put_bytes()
+//
+// Copy buf_size bytes into the buffer starting at pos, which must already
+// have room for them.
+//--------------------------------------------------------------------------
+
+static void
+put_bytes( PLStream *pls, size_t pos, const void *buf, size_t buf_size )
+{
+    const uint8_t *src = (const uint8_t *) buf;
+    size_t        n;
+
+    while ( buf_size > 0 )
+    {
+        n = MIN( buf_size, pls->plbuf_buffer_grow - pos % pls->plbuf_buffer_grow );
+        memcpy( buffer_at( pls, pos ), src, n );
+        src      += n;
+        pos      += n;
+        buf_size -= n;
+    }
+}
+
+//--------------------------------------------------------------------------
+// get_bytes()
+//
+// Copy buf_size bytes out of the buffer starting at pos.
+//--------------------------------------------------------------------------
+
+static void
+get_bytes( PLStream *pls, size_t pos, void *buf, size_t buf_size )
+{
+    uint8_t *dest = (uint8_t *) buf;
+    size_t  n;
+
+    while ( buf_size > 0 )
+    {
+        n = MIN( buf_size, pls->plbuf_buffer_grow - pos % pls->plbuf_buffer_grow );
+        memcpy( dest, buffer_at( pls, pos ), n );
+        dest     += n;
+        pos      += n;
+        buf_size -= n;
+    }
+}
+
+//--------------------------------------------------------------------------
+// cmp_bytes()
+//
+// Compare size bytes of the buffer at pos1 and pos2, returns 0 if equal.
+//--------------------------------------------------------------------------
+
+static int
+cmp_bytes( PLStream *pls, size_t pos1, size_t pos2, size_t size )
+{
+    size_t n, grow = pls->plbuf_buffer_grow;
+
+    while ( size > 0 )
+    {
+        n = MIN( size, MIN( grow - pos1 % grow, grow - pos2 % grow ) );
+        if ( memcmp( buffer_at( pls, pos1 ), buffer_at( pls, pos2 ), n ) != 0 )
+            return 1;
+        pos1 += n;
+        pos2 += n;
+        size -= n;
+    }
+    return 0;
+}
+
+//--------------------------------------------------------------------------
+// reset_state_pos()
+//
+// Forget the state records written so far, e.g. when the buffer restarts.
+//--------------------------------------------------------------------------
+
+static void
+reset_state_pos( PLStream *pls )
+{
+    int i;
+
+    for ( i = 0; i < PL_NSTATE; i++ )
+        pls->plbuf_state_pos[i] = (size_t) ( -1 );
+}
+
+//--------------------------------------------------------------------------
+// Compact encoding of coordinates
+//
+// With pls->plbuf_compact set, the coordinates of polylines and polygons
+// are stored as the first point followed by the differences between
+// successive points, x and y interleaved.  Each value is a zigzag varint:
+// the sign goes into the lowest bit and the result is written 7 bits per
+// byte, least significant first, with the high bit set on all but the
+// last byte.  In place of the point count such a record holds minus the
+// number of encoded bytes, and the points are decoded until the bytes
+// are used up.  Records that would not get smaller are stored raw, and raw
+// records are read back unchanged, so the reader needs no option.
+//--------------------------------------------------------------------------
+
+static void *
+grow_pack( PLStream *pls, size_t size )
+{
+    if ( pls->plbuf_pack_size < size )
+    {
+        free( pls->plbuf_pack );
+        if ( ( pls->plbuf_pack = malloc( size ) ) == NULL )
+            plexit( "plbuf: Insufficient memory" );
+        pls->plbuf_pack_size = size;
+    }
+    return pls->plbuf_pack;
+}
+
+//--------------------------------------------------------------------------
+// wr_points()
+//
+// Write the number of points and the coordinates of a polyline or polygon
+//--------------------------------------------------------------------------
+
+static void
+wr_points( PLStream *pls, short *xa, short *ya, PLINT npts )
+{
+    U_CHAR       *p;
+    unsigned int z;
+    PLINT        i, d, dx, dy, nbytes;
+
+    if ( pls->plbuf_compact && npts > 2 )
+    {
+        p = (U_CHAR *) grow_pack( pls, 6 * (size_t) npts );
+        for ( i = 0; i < 2 * npts; i++ )
+        {
+            if ( i < 2 )
+                d = i == 0 ? xa[0] : ya[0];
+            else
+            {
+                dx = xa[i / 2] - xa[i / 2 - 1];
+                dy = ya[i / 2] - ya[i / 2 - 1];
+                d  = i % 2 == 0 ? dx : dy;
+            }
+            z = d >= 0 ? 2u * (unsigned int) d : 2u * (unsigned int) ( -d ) - 1u;
+            while ( z >= 0x80 )
+            {
+                *p++ = (U_CHAR) ( z | 0x80 );
+                z  >>= 7;
+            }
+            *p++ = (U_CHAR) z;
+        }
+        nbytes = (PLINT) ( p - (U_CHAR *) pls->plbuf_pack );
+
+        if ( (size_t) nbytes < 2 * sizeof ( short ) * (size_t) npts )
+        {
+            nbytes = -nbytes;
+            wr_data( pls, &nbytes, sizeof ( PLINT ) );
+            wr_data( pls, pls->plbuf_pack, (size_t) -nbytes );
+            return;
+        }
     }
+
+    wr_data( pls, &npts, sizeof ( PLINT ) );
+    wr_data( pls, xa, sizeof ( short ) * (size_t) npts );
+    wr_data( pls, ya, sizeof ( short ) * (size_t) npts );
+}
+
+//--------------------------------------------------------------------------
+// rd_points()
+//
+// Read the number of points and the coordinates of a polyline or polygon.
+// The coordinates are only valid until the next command is read.
+//--------------------------------------------------------------------------
+
+static void
+rd_points( PLStream *pls, short **xa, short **ya, PLINT *npts )
+{
+    U_CHAR       *p, *end;
+    short        *v;
+    unsigned int z;
+    int          shift;
+    PLINT        i, d, nbytes;
+
+    rd_data( pls, npts, sizeof ( PLINT ) );
+
+    if ( *npts >= 0 )
+    {
+        // Use the "no copy" version because the node data array does
+        // not need to persist outside of the caller
+        rd_data_no_copy( pls, (void **) xa, sizeof ( short ) * (size_t) *npts );
+        rd_data_no_copy( pls, (void **) ya, sizeof ( short ) * (size_t) *npts );
+        return;
+    }
+
+    nbytes = -*npts;
+    rd_data_no_copy( pls, (void **) &p, (size_t) nbytes );
+    end = p + nbytes;
+
+    // Every coordinate takes at least one byte
+    v   = (short *) grow_pack( pls, sizeof ( short ) * (size_t) nbytes );
+    *xa = v;
+    *ya = v + nbytes / 2;
+    for ( i = 0; p < end; i++ )
+    {
+        z     = 0;
+        shift = 0;
+        do
+        {
+            z     |= (unsigned int) ( *p & 0x7f ) << shift;
+            shift += 7;
+        } while ( *p++ & 0x80 );
+        d = z & 1u ? -(PLINT) ( ( z + 1u ) / 2u ) : (PLINT) ( z / 2u );
+
+        if ( i % 2 == 0 )
+            ( *xa )[i / 2] = (short) ( i < 2 ? d : ( *xa )[i / 2 - 1] + d );
+        else
+            ( *ya )[i / 2] = (short) ( i < 2 ? d : ( *ya )[i / 2 - 1] + d );
+    }
+    *npts = i / 2;
 }
 
 //--------------------------------------------------------------------------
@@ -1652,11 +2088,13 @@ wr_command( PLStream *pls, U_CHAR c )
 {
     check_buffer_size( pls, sizeof ( uint16_t ) );
 
-    *(U_CHAR *) ( (uint8_t *) pls->plbuf_buffer + pls->plbuf_top ) = c;
+    *buffer_at( pls, pls->plbuf_top ) = c;
 
     // Advance buffer position to maintain two-byte alignment.  This
     // will waste a little bit of space, but it prevents memory
-    // alignment problems
+    // alignment problems.  The padding is cleared so that equal records
+    // hold equal bytes.
+    *buffer_at( pls, pls->plbuf_top + 1 ) = 0;
     pls->plbuf_top += sizeof ( uint16_t );
 }
 
@@ -1670,7 +2108,9 @@ static void
 wr_data( PLStream *pls, void *buf, size_t buf_size )
 {
     check_buffer_size( pls, buf_size + ( buf_size % sizeof ( uint16_t ) ) );
-    memcpy( (uint8_t *) pls->plbuf_buffer + pls->plbuf_top, buf, buf_size );
+    put_bytes( pls, pls->plbuf_top, buf, buf_size );
+    if ( buf_size % sizeof ( uint16_t ) )
+        *buffer_at( pls, pls->plbuf_top + buf_size ) = 0;
 
     // Advance position but maintain alignment
     pls->plbuf_top += ( buf_size + ( buf_size % sizeof ( uint16_t ) ) );
@@ -1787,12 +2227,7 @@ void * plbuf_save( PLStream *pls, void *state )
     // Copy the plot buffer to our new buffer.  Again, I must stress, that
     // we only are copying the portion of the plot buffer that is being used
     //
-    if ( memcpy( plot_state->plbuf_buffer, pls->plbuf_buffer, pls->plbuf_top ) == NULL )
-    {
-        // This should never be NULL
-        plwarn( "plbuf: Got a NULL in memcpy!" );
-        return (void *) plot_state;
-    }
+    get_bytes( pls, 0, plot_state->plbuf_buffer, pls->plbuf_top );
 
     pls->plbuf_write = TRUE;
     pls->plbuf_read  = FALSE;
@@ -1811,10 +2246,13 @@ void plbuf_restore( PLStream *pls, void *state )
 
     dbug_enter( "plbuf_restore" );
 
-    pls->plbuf_buffer      = new_state->plbuf_buffer;
-    pls->plbuf_buffer_size = new_state->plbuf_buffer_size;
-    pls->plbuf_top         = new_state->plbuf_top;
-    pls->plbuf_readpos     = new_state->plbuf_readpos;
+    // The saved data is copied back into the chunks of the plot buffer
+    pls->plbuf_top = 0;
+    check_buffer_size( pls, new_state->plbuf_top );
+    put_bytes( pls, 0, new_state->plbuf_buffer, new_state->plbuf_top );
+    pls->plbuf_top     = new_state->plbuf_top;
+    pls->plbuf_readpos = new_state->plbuf_readpos;
+    reset_state_pos( pls );
 }
 
 // plbuf_switch(PLStream *, state)
@@ -1822,13 +2260,6 @@ void plbuf_restore( PLStream *pls, void *state )
 // Makes the passed state the current one.  Preserves the previous state
 // by returning a save buffer.
 //
-// NOTE:  The current implementation can cause a memory leak under the
-// following scenario:
-//    1) plbuf_save() is called
-//    2) plbuf_switch() is called
-//    3) Commands are called which cause the plot buffer to grow
-//    4) plbuf_swtich() is called
-//
 void * plbuf_switch( PLStream *pls, void *state )
 {
     struct _state *new_state = (struct _state *) state;
@@ -1849,7 +2280,7 @@ void * plbuf_switch( PLStream *pls, void *state )
         return NULL;
     }
 
-    save_size = sizeof ( struct _state );
+    save_size = sizeof ( struct _state ) + pls->plbuf_top;
 
     if ( ( prev_state = (struct _state *) malloc( save_size ) ) == NULL )
     {
@@ -1862,10 +2293,12 @@ void * plbuf_switch( PLStream *pls, void *state )
     prev_state->valid = 1;
 
     // Preserve the existing state
-    prev_state->plbuf_buffer      = pls->plbuf_buffer;
-    prev_state->plbuf_buffer_size = pls->plbuf_buffer_size;
+    prev_state->plbuf_buffer      = (void *) ( prev_state + 1 );
+    prev_state->plbuf_buffer_size = pls->plbuf_top;
     prev_state->plbuf_top         = pls->plbuf_top;
     prev_state->plbuf_readpos     = pls->plbuf_readpos;
+    if ( pls->plbuf_top > 0 )
+        get_bytes( pls, 0, prev_state->plbuf_buffer, pls->plbuf_top );
 
     plbuf_restore( pls, new_state );
 
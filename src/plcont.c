@@ -28,21 +28,58 @@
 #pragma optimize("",off)
 #endif
 
+// Number of grid points in a band of rows of the grid whose values and
+// transformed coordinates are kept by plfcont, which bounds the memory
+// used on large grids.  Smaller grids are held in one band.
+
+#define CONT_BAND_POINTS    65536
+
+// The contoured part of the grid, with the values and the transformed
+// points of the band of rows the contours are currently searched in.
+// Points outside the band are evaluated and transformed when needed.
+
+typedef struct
+{
+    PLINT                kx, lx, ky, ly; // cells kx..lx-1 by ky..ly-1
+    PLF2EVAL_callback    f2eval;
+    PLPointer            f2eval_data;
+    PLTRANSFORM_callback pltr;
+    PLPointer            pltr_data;
+    PLINT                by0, by1;       // band of cell rows by0..by1-1
+    PLINT                nrow;           // by1 - by0 + 1 points per column
+    PLFLT                *f;             // values of the band points
+    PLFLT                *tx, *ty;       // transformed band points ...
+    unsigned char        *have;          // ... where have is set
+    unsigned char        *ipts;          // bitmap of the cells visited
+    PLINT                *stack;         // cells left to finish, see pldrawcn
+    PLINT                nstack, stacksize;
+} CONT_GRID;
+
+#define CONT_CELL( grid, kcol, krow )    ( ( ( krow ) - ( grid )->ky ) * ( ( grid )->lx - ( grid )->kx ) + ( kcol ) - ( grid )->kx )
+#define CONT_VISITED( grid, k )          ( ( grid )->ipts[( k ) >> 3] & ( 1 << ( ( k ) & 7 ) ) )
+#define CONT_VISIT( grid, k )            ( ( grid )->ipts[( k ) >> 3] |= (unsigned char) ( 1 << ( ( k ) & 7 ) ) )
+
 // Static function prototypes.
 
 static void
-plcntr( PLF2EVAL_callback plf2eval, PLPointer plf2eval_data,
-        PLINT nx, PLINT ny, PLINT kx, PLINT lx,
-        PLINT ky, PLINT ly, PLFLT flev, PLINT **ipts,
-        PLTRANSFORM_callback pltr, PLPointer pltr_data );
+plcntr( CONT_GRID *grid, PLFLT flev, PLFLT *lim, PLINT nband );
+
+static void
+pldrawcn( CONT_GRID *grid, PLFLT flev, char *flabel, PLINT kcol, PLINT krow,
+          PLFLT *distance, PLINT *lastindex );
+
+static void
+cont_band( CONT_GRID *grid, PLINT by0, PLINT by1 );
+
+static PLFLT
+cont_value( CONT_GRID *grid, PLINT ix, PLINT iy );
 
 static void
-pldrawcn( PLF2EVAL_callback plf2eval, PLPointer plf2eval_data,
-          PLINT nx, PLINT ny, PLINT kx, PLINT lx,
-          PLINT ky, PLINT ly, PLFLT flev, char *flabel, PLINT kcol, PLINT krow,
-          PLFLT lastx, PLFLT lasty, PLINT startedge,
-          PLINT **ipts, PLFLT *distance, PLINT *lastindex,
-          PLTRANSFORM_callback pltr, PLPointer pltr_data );
+cont_corner( CONT_GRID *grid, PLINT ix, PLINT iy, PLFLT *px, PLFLT *py );
+
+static PLINT
+cont_cell( CONT_GRID *grid, PLFLT flev, PLINT kcol, PLINT krow,
+           PLFLT *f, PLINT *iedge, PLFLT *px, PLFLT *py );
 
 static void
 plfloatlabel( PLFLT value, char *string, PLINT len );
@@ -92,135 +129,105 @@ static PLINT
 
 //******* contour lines storage ***************************
 
-static CONT_LEVEL *startlev = NULL;
-static CONT_LEVEL *currlev;
-static CONT_LINE  *currline;
+static CONT_STORE *store = NULL;
 
 static int        cont3d = 0;
 
-static CONT_LINE *
-alloc_line( void )
-{
-    CONT_LINE *line;
-
-    if ( ( line = (CONT_LINE *) malloc( sizeof ( CONT_LINE ) ) ) == NULL )
-    {
-        plexit( "alloc_line: Insufficient memory" );
-    }
-
-    line->x = (PLFLT *) malloc( LINE_ITEMS * sizeof ( PLFLT ) );
-    line->y = (PLFLT *) malloc( LINE_ITEMS * sizeof ( PLFLT ) );
-
-    if ( ( line->x == NULL ) || ( line->y == NULL ) )
-    {
-        plexit( "alloc_line: Insufficient memory" );
-    }
-
-    line->npts = 0;
-    line->next = NULL;
-
-    return line;
-}
-
-static CONT_LEVEL *
-alloc_level( PLFLT level )
-{
-    CONT_LEVEL *node;
-
-    if ( ( node = (CONT_LEVEL *) malloc( sizeof ( CONT_LEVEL ) ) ) == NULL )
-    {
-        plexit( "alloc_level: Insufficient memory" );
-    }
-    node->level = level;
-    node->next  = NULL;
-    node->line  = alloc_line( );
+// Contour line being assembled for drawing in one piece
 
-    return node;
-}
+static PLFLT      *cont_x = NULL, *cont_y = NULL;
+static PLINT      cont_npts = 0, cont_size = 0;
 
-static void
-realloc_line( CONT_LINE *line )
+static void *
+cont_realloc( void *ptr, PLINT n, size_t size )
 {
-    if ( ( ( line->x = (PLFLT *) realloc( line->x,
-                 (size_t) ( line->npts + LINE_ITEMS ) * sizeof ( PLFLT ) ) ) == NULL ) ||
-         ( ( line->y = (PLFLT *) realloc( line->y,
-                 (size_t) ( line->npts + LINE_ITEMS ) * sizeof ( PLFLT ) ) ) == NULL ) )
-        plexit( "realloc_line: Insufficient memory" );
+    if ( ( ptr = realloc( ptr, (size_t) n * size ) ) == NULL )
+        plexit( "cont_store: Insufficient memory" );
+    return ptr;
 }
 
-
 // new contour level
 static void
 cont_new_store( PLFLT level )
 {
     if ( cont3d )
     {
-        if ( startlev == NULL )
-        {
-            startlev = alloc_level( level );
-            currlev  = startlev;
-        }
-        else
+        // room for the closing entry of level_line too
+        if ( store->nlevel + 1 >= store->level_size )
         {
-            currlev->next = alloc_level( level );
-            currlev       = currlev->next;
+            store->level_size = MAX( 2 * store->level_size, 16 );
+            store->level      = (PLFLT *) cont_realloc( store->level, store->level_size, sizeof ( PLFLT ) );
+            store->level_line = (PLINT *) cont_realloc( store->level_line, store->level_size, sizeof ( PLINT ) );
         }
-        currline = currlev->line;
+        store->level[store->nlevel]      = level;
+        store->level_line[store->nlevel] = store->nline;
+        store->nlevel++;
     }
 }
 
 void
-cont_clean_store( CONT_LEVEL *ct )
+cont_clean_store( CONT_STORE *ct )
 {
-    CONT_LINE  *tline, *cline;
-    CONT_LEVEL *tlev, *clevel;
-
     if ( ct != NULL )
     {
-        clevel = ct;
+#ifdef CONT_PLOT_DEBUG
+        PLINT j, k;
 
-        do
+        for ( j = 0; j < ct->nline; j++ )
         {
-            cline = clevel->line;
-            do
-            {
-#ifdef CONT_PLOT_DEBUG
-                plP_movwor( cline->x[0], cline->y[0] );
-                for ( j = 1; j < cline->npts; j++ )
-                    plP_drawor( cline->x[j], cline->y[j] );
-#endif
-                tline = cline->next;
-                free( cline->x );
-                free( cline->y );
-                free( cline );
-                cline = tline;
-            }
-            while ( cline != NULL );
-            tlev = clevel->next;
-            free( clevel );
-            clevel = tlev;
+            plP_movwor( ct->x[ct->line_pt[j]], ct->y[ct->line_pt[j]] );
+            for ( k = ct->line_pt[j] + 1; k < ct->line_pt[j + 1]; k++ )
+                plP_drawor( ct->x[k], ct->y[k] );
         }
-        while ( clevel != NULL );
-        startlev = NULL;
+#endif
+        free( (void *) ct->level );
+        free( (void *) ct->level_line );
+        free( (void *) ct->line_pt );
+        free( (void *) ct->x );
+        free( (void *) ct->y );
+        memset( ct, 0, sizeof ( CONT_STORE ) );
     }
 }
 
+// draw the contour line assembled so far
+static void
+cont_flush_line( void )
+{
+    if ( cont_npts > 1 )
+        plP_drawor_poly( cont_x, cont_y, cont_npts );
+    else if ( cont_npts == 1 )
+        plP_movwor( cont_x[0], cont_y[0] );
+    cont_npts = 0;
+}
+
 static void
 cont_xy_store( PLFLT xx, PLFLT yy )
 {
     if ( cont3d )
     {
-        PLINT pts = currline->npts;
-
-        if ( pts % LINE_ITEMS == 0 )
-            realloc_line( currline );
-
-        currline->x[pts] = xx;
-        currline->y[pts] = yy;
-        currline->npts++;
+        if ( store->npts == store->pts_size )
+        {
+            store->pts_size = MAX( 2 * store->pts_size, 1024 );
+            store->x        = (PLFLT *) cont_realloc( store->x, store->pts_size, sizeof ( PLFLT ) );
+            store->y        = (PLFLT *) cont_realloc( store->y, store->pts_size, sizeof ( PLFLT ) );
+        }
+        store->x[store->npts] = xx;
+        store->y[store->npts] = yy;
+        store->npts++;
     }
     else
-        plP_drawor( xx, yy );
+    {
+        if ( cont_npts == cont_size )
+        {
+            cont_size = cont_size == 0 ? 256 : 2 * cont_size;
+            if ( ( ( cont_x = (PLFLT *) realloc( cont_x, (size_t) cont_size * sizeof ( PLFLT ) ) ) == NULL ) ||
+                 ( ( cont_y = (PLFLT *) realloc( cont_y, (size_t) cont_size * sizeof ( PLFLT ) ) ) == NULL ) )
+                plexit( "cont_xy_store: Insufficient memory" );
+        }
+        cont_x[cont_npts] = xx;
+        cont_y[cont_npts] = yy;
+        cont_npts++;
+    }
 }
 
 static void
@@ -228,19 +235,23 @@ cont_mv_store( PLFLT xx, PLFLT yy )
 {
     if ( cont3d )
     {
-        if ( currline->npts != 0 ) // not an empty list, allocate new
+        // start a new line, leaving room for the closing entry of line_pt
+        if ( store->nline + 1 >= store->line_size )
         {
-            currline->next = alloc_line( );
-            currline       = currline->next;
+            store->line_size = MAX( 2 * store->line_size, 64 );
+            store->line_pt   = (PLINT *) cont_realloc( store->line_pt, store->line_size, sizeof ( PLINT ) );
         }
-
-        // and fill first element
-        currline->x[0] = xx;
-        currline->y[0] = yy;
-        currline->npts = 1;
+        store->line_pt[store->nline++] = store->npts;
+        cont_xy_store( xx, yy );
     }
-    else
+    else if ( contlabel_active )
         plP_movwor( xx, yy );
+    else
+    {
+        // start a new line, which is drawn when it is complete
+        cont_flush_line();
+        cont_xy_store( xx, yy );
+    }
 }
 
 // small routine to set offset and spacing of contour labels, see desciption above
@@ -477,7 +488,7 @@ plf2evalr( PLINT ix, PLINT iy, PLPointer plf2eval_data )
 //
 // cont_store:
 //
-// Draw contour lines in memory.
+// Draw contour lines in memory, into the arrays of contour.
 // cont_clean_store() must be called after use to release allocated memory.
 //
 //--------------------------------------------------------------------------
@@ -486,15 +497,23 @@ void
 cont_store( PLFLT_MATRIX f, PLINT nx, PLINT ny, PLINT kx, PLINT lx,
             PLINT ky, PLINT ly, PLFLT_VECTOR clevel, PLINT nlevel,
             PLTRANSFORM_callback pltr, PLPointer pltr_data,
-            CONT_LEVEL **contour )
+            CONT_STORE *contour )
 {
+    memset( contour, 0, sizeof ( CONT_STORE ) );
+    store  = contour;
     cont3d = 1;
 
     plcont( f, nx, ny, kx, lx, ky, ly, clevel, nlevel,
         pltr, pltr_data );
 
-    *contour = startlev;
-    cont3d   = 0;
+    // close the last level and the last line
+    if ( contour->level_line != NULL )
+        contour->level_line[contour->nlevel] = contour->nline;
+    if ( contour->line_pt != NULL )
+        contour->line_pt[contour->nline] = contour->npts;
+
+    store  = NULL;
+    cont3d = 0;
 }
 
 //--------------------------------------------------------------------------
@@ -529,6 +548,11 @@ c_plcont( PLFLT_MATRIX f, PLINT nx, PLINT ny, PLINT kx, PLINT lx,
 // Note that the fortran-like minimum and maximum indices (kx, lx, ky, ly)
 // are translated into more C-like ones.  I've only kept them as they are
 // for the plfcont() argument list because of backward compatibility.
+//
+// The scratch memory is a bitmap of the cells visited, one bit per cell,
+// the band of at most CONT_BAND_POINTS grid points described at CONT_GRID
+// and two PLINTs per cell left unfinished while a contour is followed
+// (see pldrawcn).
 //--------------------------------------------------------------------------
 
 void
@@ -537,7 +561,13 @@ plfcont( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
          PLINT ky, PLINT ly, PLFLT_VECTOR clevel, PLINT nlevel,
          PLTRANSFORM_callback pltr, PLPointer pltr_data )
 {
-    PLINT i, **ipts;
+    CONT_GRID grid;
+    PLINT     i, b, n, ncol, nband, nbands;
+    size_t    npoints, nbytes;
+    PLFLT     *lim, *fc;
+
+    (void) nx;
+    (void) ny;
 
     if ( pltr == NULL )
     {
@@ -556,55 +586,100 @@ plfcont( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
         plabort( "plfcont: indices must satisfy  1 <= ky <= ly <= ny" );
         return;
     }
+    if ( nlevel < 1 )
+        return;
 
-    if ( ( ipts = (PLINT **) malloc( (size_t) nx * sizeof ( PLINT * ) ) ) == NULL )
-    {
+    grid.kx          = kx - 1;
+    grid.lx          = lx - 1;
+    grid.ky          = ky - 1;
+    grid.ly          = ly - 1;
+    grid.f2eval      = f2eval;
+    grid.f2eval_data = f2eval_data;
+    grid.pltr        = pltr;
+    grid.pltr_data   = pltr_data;
+    grid.by0         = grid.by1 = -1;
+    grid.stack       = NULL;
+    grid.nstack      = grid.stacksize = 0;
+
+    // Bands of nband cell rows, i.e. nband + 1 rows of points
+    ncol    = lx - kx;
+    nband   = MIN( MAX( CONT_BAND_POINTS / ( ncol + 1 ) - 1, 1 ), ly - ky );
+    nbands  = ( ly - ky + nband - 1 ) / nband;
+    npoints = (size_t) ( ncol + 1 ) * (size_t) ( nband + 1 );
+    nbytes  = (size_t) ncol * (size_t) ( ly - ky ) / 8 + 1;
+
+    if ( ( grid.f = (PLFLT *) malloc( npoints * sizeof ( PLFLT ) ) ) == NULL )
+        plexit( "plfcont: Insufficient memory" );
+    if ( ( grid.tx = (PLFLT *) malloc( npoints * sizeof ( PLFLT ) ) ) == NULL )
+        plexit( "plfcont: Insufficient memory" );
+    if ( ( grid.ty = (PLFLT *) malloc( npoints * sizeof ( PLFLT ) ) ) == NULL )
+        plexit( "plfcont: Insufficient memory" );
+    if ( ( grid.have = (unsigned char *) malloc( npoints ) ) == NULL )
+        plexit( "plfcont: Insufficient memory" );
+    if ( ( grid.ipts = (unsigned char *) malloc( nbytes ) ) == NULL )
+        plexit( "plfcont: Insufficient memory" );
+    if ( ( lim = (PLFLT *) malloc( 2 * (size_t) nbands * sizeof ( PLFLT ) ) ) == NULL )
         plexit( "plfcont: Insufficient memory" );
-    }
 
-    for ( i = 0; i < nx; i++ )
+    // Range of the values of each band, leaving out NaN.  A level outside
+    // the range of a band cannot cross any of its cells.  The last band
+    // stays loaded, so a grid of a single band is only evaluated once.
+    for ( b = 0; b < nbands; b++ )
     {
-        if ( ( ipts[i] = (PLINT *) malloc( (size_t) ny * sizeof ( PLINT * ) ) ) == NULL )
+        cont_band( &grid, grid.ky + b * nband, MIN( grid.ky + ( b + 1 ) * nband, grid.ly ) );
+        lim[2 * b]     = PLFLT_MAX;
+        lim[2 * b + 1] = -PLFLT_MAX;
+        for ( n = 0, fc = grid.f; n < ( ncol + 1 ) * grid.nrow; n++, fc++ )
         {
-            plexit( "plfcont: Insufficient memory" );
+            if ( isnan( *fc ) )
+                continue;
+            lim[2 * b]     = MIN( lim[2 * b], *fc );
+            lim[2 * b + 1] = MAX( lim[2 * b + 1], *fc );
         }
     }
 
     for ( i = 0; i < nlevel; i++ )
     {
-        plcntr( f2eval, f2eval_data,
-            nx, ny, kx - 1, lx - 1, ky - 1, ly - 1, clevel[i], ipts,
-            pltr, pltr_data );
+        if ( isnan( clevel[i] ) )
+            continue;
+
+        memset( grid.ipts, 0, nbytes );
+        plcntr( &grid, clevel[i], lim, nband );
+        cont_flush_line();
 
         if ( error )
         {
             error = 0;
-            goto done;
+            break;
         }
     }
 
-done:
-    for ( i = 0; i < nx; i++ )
-    {
-        free( (void *) ipts[i] );
-    }
-    free( (void *) ipts );
+    free( (void *) grid.f );
+    free( (void *) grid.tx );
+    free( (void *) grid.ty );
+    free( (void *) grid.have );
+    free( (void *) grid.ipts );
+    free( (void *) grid.stack );
+    free( (void *) lim );
+    free( (void *) cont_x );
+    free( (void *) cont_y );
+    cont_x    = cont_y = NULL;
+    cont_size = 0;
 }
 
 //--------------------------------------------------------------------------
 // void plcntr()
 //
-// The contour for a given level is drawn here.  Note iscan has nx
-// elements. ixstor and iystor each have nstor elements.
+// The contour for a given level is drawn here.  The cells are searched
+// row by row for contours, in the bands of nband rows whose range of
+// values, given in lim, includes the level.
 //--------------------------------------------------------------------------
 
 static void
-plcntr( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
-        PLINT nx, PLINT ny, PLINT kx, PLINT lx,
-        PLINT ky, PLINT ly, PLFLT flev, PLINT **ipts,
-        PLTRANSFORM_callback pltr, PLPointer pltr_data )
+plcntr( CONT_GRID *grid, PLFLT flev, PLFLT *lim, PLINT nband )
 {
-    PLINT kcol, krow, lastindex;
+    PLINT b, j, kcol, krow, by0, lastindex;
+    PLFLT c, fmin, fmax, *fc;
     PLFLT distance;
     PLFLT save_def, save_scale;
 
@@ -618,27 +693,37 @@ plcntr( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
     plfloatlabel( flev, flabel, 30 );
     plschr( 0.0, contlabel_size );
 
-    // Clear array for traversed squares
-    for ( kcol = kx; kcol < lx; kcol++ )
+    for ( b = 0, by0 = grid->ky; by0 < grid->ly; b++, by0 += nband )
     {
-        for ( krow = ky; krow < ly; krow++ )
-        {
-            ipts[kcol][krow] = 0;
-        }
-    }
-
+        if ( !( lim[2 * b] <= flev && flev <= lim[2 * b + 1] ) )
+            continue;
 
-    for ( krow = ky; krow < ly; krow++ )
-    {
-        for ( kcol = kx; kcol < lx; kcol++ )
+        cont_band( grid, by0, MIN( by0 + nband, grid->ly ) );
+        for ( krow = grid->by0; krow < grid->by1; krow++ )
         {
-            if ( ipts[kcol][krow] == 0 )
+            for ( kcol = grid->kx; kcol < grid->lx; kcol++ )
             {
+                if ( CONT_VISITED( grid, CONT_CELL( grid, kcol, krow ) ) )
+                    continue;
+
+                // A contour can only pass through the cell if the level
+                // lies within the range of the values at the corners.
+                fc   = grid->f + ( kcol - grid->kx ) * grid->nrow + krow - grid->by0;
+                fmin = PLFLT_MAX;
+                fmax = -PLFLT_MAX;
+                for ( j = 0; j < 4; j++ )
+                {
+                    c = fc[( j / 2 ) * grid->nrow + j % 2];
+                    if ( isnan( c ) )
+                        continue;
+                    fmin = MIN( fmin, c );
+                    fmax = MAX( fmax, c );
+                }
+                if ( !( fmin <= flev && flev <= fmax ) )
+                    continue;
+
                 // Follow and draw a contour
-                pldrawcn( f2eval, f2eval_data,
-                    nx, ny, kx, lx, ky, ly, flev, flabel, kcol, krow,
-                    0.0, 0.0, -2, ipts, &distance, &lastindex,
-                    pltr, pltr_data );
+                pldrawcn( grid, flev, flabel, kcol, krow, &distance, &lastindex );
 
                 if ( error )
                     return;
@@ -649,34 +734,88 @@ plcntr( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
 }
 
 //--------------------------------------------------------------------------
-// void pldrawcn()
+// void cont_band()
 //
-// Follow and draw a contour.
+// Loads the values of the points of cell rows by0 to by1 - 1 into the
+// band held by grid, unless they are there already.  Their transformed
+// coordinates are computed on first use.
 //--------------------------------------------------------------------------
 
 static void
-pldrawcn( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
-          PLINT nx, PLINT ny, PLINT kx, PLINT lx,
-          PLINT ky, PLINT ly, PLFLT flev, char *flabel, PLINT kcol, PLINT krow,
-          PLFLT lastx, PLFLT lasty, PLINT startedge, PLINT **ipts,
-          PLFLT *distance, PLINT *lastindex,
-          PLTRANSFORM_callback pltr, PLPointer pltr_data )
+cont_band( CONT_GRID *grid, PLINT by0, PLINT by1 )
 {
-    PLFLT f[4];
-    PLFLT px[4], py[4], locx[4], locy[4];
-    PLINT iedge[4];
-    PLINT i, j, k, num, first, inext, kcolnext, krownext, sfi, sfj;
+    if ( by0 == grid->by0 && by1 == grid->by1 )
+        return;
 
+    grid->by0  = by0;
+    grid->by1  = by1;
+    grid->nrow = by1 - by0 + 1;
+    plP_f2eval_copy( grid->f2eval, grid->f2eval_data, grid->kx, grid->lx + 1,
+        by0, by1 + 1, grid->f );
+    memset( grid->have, 0, (size_t) ( grid->lx - grid->kx + 1 ) * (size_t) grid->nrow );
+}
 
-    ( *pltr )( kcol, krow + 1, &px[0], &py[0], pltr_data );
-    ( *pltr )( kcol, krow, &px[1], &py[1], pltr_data );
-    ( *pltr )( kcol + 1, krow, &px[2], &py[2], pltr_data );
-    ( *pltr )( kcol + 1, krow + 1, &px[3], &py[3], pltr_data );
+//--------------------------------------------------------------------------
+// PLFLT cont_value()
+//
+// Value of grid point (ix, iy), from the band if it lies in it.
+//--------------------------------------------------------------------------
 
-    f[0] = f2eval( kcol, krow + 1, f2eval_data ) - flev;
-    f[1] = f2eval( kcol, krow, f2eval_data ) - flev;
-    f[2] = f2eval( kcol + 1, krow, f2eval_data ) - flev;
-    f[3] = f2eval( kcol + 1, krow + 1, f2eval_data ) - flev;
+static PLFLT
+cont_value( CONT_GRID *grid, PLINT ix, PLINT iy )
+{
+    if ( iy >= grid->by0 && iy <= grid->by1 )
+        return grid->f[( ix - grid->kx ) * grid->nrow + iy - grid->by0];
+    return ( *grid->f2eval )( ix, iy, grid->f2eval_data );
+}
+
+//--------------------------------------------------------------------------
+// void cont_corner()
+//
+// Transformed coordinates of grid point (ix, iy), which are kept once
+// computed if the point lies in the band.
+//--------------------------------------------------------------------------
+
+static void
+cont_corner( CONT_GRID *grid, PLINT ix, PLINT iy, PLFLT *px, PLFLT *py )
+{
+    PLINT n;
+
+    if ( iy < grid->by0 || iy > grid->by1 )
+    {
+        ( *grid->pltr )( ix, iy, px, py, grid->pltr_data );
+        return;
+    }
+
+    n = ( ix - grid->kx ) * grid->nrow + iy - grid->by0;
+    if ( !grid->have[n] )
+    {
+        ( *grid->pltr )( ix, iy, &grid->tx[n], &grid->ty[n], grid->pltr_data );
+        grid->have[n] = 1;
+    }
+    *px = grid->tx[n];
+    *py = grid->ty[n];
+}
+
+//--------------------------------------------------------------------------
+// PLINT cont_cell()
+//
+// Sets up cell (kcol, krow) for tracing the contour at level flev: the
+// values at the corners relative to flev, whether each edge is crossed
+// and the transformed corners.  Returns 0 if no contour passes through
+// the cell.
+//--------------------------------------------------------------------------
+
+static PLINT
+cont_cell( CONT_GRID *grid, PLFLT flev, PLINT kcol, PLINT krow,
+           PLFLT *f, PLINT *iedge, PLFLT *px, PLFLT *py )
+{
+    PLINT i, j, sfi, sfj;
+
+    f[0] = cont_value( grid, kcol, krow + 1 ) - flev;
+    f[1] = cont_value( grid, kcol, krow ) - flev;
+    f[2] = cont_value( grid, kcol + 1, krow ) - flev;
+    f[3] = cont_value( grid, kcol + 1, krow + 1 ) - flev;
 
     for ( i = 0, j = 1; i < 4; i++, j = ( j + 1 ) % 4 )
     {
@@ -687,164 +826,209 @@ pldrawcn( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
         iedge[i] = ( sfi * sfj > 0 ) ? -1 : ( ( sfi * sfj < 0 ) ? 1 : 0 );
     }
 
-    // Mark this square as done
-    ipts[kcol][krow] = 1;
-
     // Check if no contour has been crossed i.e. iedge[i] = -1
     if ( ( iedge[0] == -1 ) && ( iedge[1] == -1 ) && ( iedge[2] == -1 )
          && ( iedge[3] == -1 ) )
-        return;
+        return 0;
 
     // Check if this is a completely flat square - in which case
     // ignore it
     if ( ( f[0] == 0.0 ) && ( f[1] == 0.0 ) && ( f[2] == 0.0 ) &&
          ( f[3] == 0.0 ) )
+        return 0;
+
+    cont_corner( grid, kcol, krow + 1, &px[0], &py[0] );
+    cont_corner( grid, kcol, krow, &px[1], &py[1] );
+    cont_corner( grid, kcol + 1, krow, &px[2], &py[2] );
+    cont_corner( grid, kcol + 1, krow + 1, &px[3], &py[3] );
+    return 1;
+}
+
+//--------------------------------------------------------------------------
+// void pldrawcn()
+//
+// Follow and draw the contours starting in cell (kcol, krow).
+//
+// A contour leaving a cell is followed into the neighbouring cell, where
+// the same line carries on.  Only a cell with more than two crossed edges
+// (a saddle, or a contour through a corner) can still have contours to
+// draw once the one that left it has been followed to its end.  Such
+// cells are kept on grid->stack with the edge to carry on from, which
+// replaces the recursion into the neighbouring cell the contour used to
+// be followed with: the C stack used no longer depends on the length of
+// the contour, and the order of the lines drawn is unchanged.
+//--------------------------------------------------------------------------
+
+static void
+pldrawcn( CONT_GRID *grid, PLFLT flev, char *flabel, PLINT kcol, PLINT krow,
+          PLFLT *distance, PLINT *lastindex )
+{
+    PLFLT f[4];
+    PLFLT px[4], py[4], locx, locy;
+    PLINT iedge[4];
+    PLINT i, j, k, n, first, follow, inext, kcolnext, krownext, startedge;
+    PLINT kx = grid->kx, lx = grid->lx, ky = grid->ky, ly = grid->ly;
+
+    // Start in cell (kcol, krow), looking at all of its edges
+    startedge = -2;
+    first     = 1;
+    k         = 0;
+    i         = 0;
+    CONT_VISIT( grid, CONT_CELL( grid, kcol, krow ) );
+    if ( !cont_cell( grid, flev, kcol, krow, f, iedge, px, py ) )
         return;
 
-    // Calculate intersection points
-    num = 0;
-    if ( startedge < 0 )
-    {
-        first = 1;
-    }
-    else
+    grid->nstack = 0;
+    for (;; )
     {
-        locx[num] = lastx;
-        locy[num] = lasty;
-        num++;
-        first = 0;
-    }
-    for ( k = 0, i = ( startedge < 0 ? 0 : startedge ); k < 4; k++, i = ( i + 1 ) % 4 )
-    {
-        if ( i == startedge )
-            continue;
-
-        // If the contour is an edge check it hasn't already been done
-        if ( f[i] == 0.0 && f[( i + 1 ) % 4] == 0.0 )
+        // Calculate intersection points, from edge i onwards
+        follow   = 0;
+        kcolnext = krownext = inext = 0;
+        for ( ; k < 4 && !follow; k++, i = ( i + 1 ) % 4 )
         {
-            kcolnext = kcol;
-            krownext = krow;
-            if ( i == 0 )
-                kcolnext--;
-            if ( i == 1 )
-                krownext--;
-            if ( i == 2 )
-                kcolnext++;
-            if ( i == 3 )
-                krownext++;
-            if ( ( kcolnext < kx ) || ( kcolnext >= lx ) ||
-                 ( krownext < ky ) || ( krownext >= ly ) ||
-                 ( ipts[kcolnext][krownext] == 1 ) )
+            if ( i == startedge )
                 continue;
-        }
-        if ( ( iedge[i] == 1 ) || ( f[i] == 0.0 ) )
-        {
-            j = ( i + 1 ) % 4;
-            if ( f[i] != 0.0 )
-            {
-                locx[num] = ( px[i] * fabs( f[j] ) + px[j] * fabs( f[i] ) ) / fabs( f[j] - f[i] );
-                locy[num] = ( py[i] * fabs( f[j] ) + py[j] * fabs( f[i] ) ) / fabs( f[j] - f[i] );
-            }
-            else
-            {
-                locx[num] = px[i];
-                locy[num] = py[i];
-            }
-            // If this is the start of the contour then move to the point
-            if ( first == 1 )
+
+            // If the contour is an edge check it hasn't already been done
+            if ( f[i] == 0.0 && f[( i + 1 ) % 4] == 0.0 )
             {
-                cont_mv_store( locx[num], locy[num] );
-                first      = 0;
-                *distance  = 0;
-                *lastindex = 0;
+                kcolnext = kcol;
+                krownext = krow;
+                if ( i == 0 )
+                    kcolnext--;
+                if ( i == 1 )
+                    krownext--;
+                if ( i == 2 )
+                    kcolnext++;
+                if ( i == 3 )
+                    krownext++;
+                if ( ( kcolnext < kx ) || ( kcolnext >= lx ) ||
+                     ( krownext < ky ) || ( krownext >= ly ) ||
+                     CONT_VISITED( grid, CONT_CELL( grid, kcolnext, krownext ) ) )
+                    continue;
             }
-            else
+            if ( ( iedge[i] == 1 ) || ( f[i] == 0.0 ) )
             {
-                // Link to the next point on the contour
-                if ( contlabel_active )
-                    pl_drawcontlabel( locx[num], locy[num], flabel, distance, lastindex );
-                else
-                    cont_xy_store( locx[num], locy[num] );
-                // Need to follow contour into next grid box
-                // Easy case where contour does not pass through corner
+                j = ( i + 1 ) % 4;
                 if ( f[i] != 0.0 )
                 {
-                    kcolnext = kcol;
-                    krownext = krow;
-                    inext    = ( i + 2 ) % 4;
-                    if ( i == 0 )
-                        kcolnext--;
-                    if ( i == 1 )
-                        krownext--;
-                    if ( i == 2 )
-                        kcolnext++;
-                    if ( i == 3 )
-                        krownext++;
-                    if ( ( kcolnext >= kx ) && ( kcolnext < lx ) &&
-                         ( krownext >= ky ) && ( krownext < ly ) &&
-                         ( ipts[kcolnext][krownext] == 0 ) )
-                    {
-                        pldrawcn( f2eval, f2eval_data,
-                            nx, ny, kx, lx, ky, ly, flev, flabel,
-                            kcolnext, krownext,
-                            locx[num], locy[num], inext, ipts,
-                            distance, lastindex,
-                            pltr, pltr_data );
-                    }
+                    locx = ( px[i] * fabs( f[j] ) + px[j] * fabs( f[i] ) ) / fabs( f[j] - f[i] );
+                    locy = ( py[i] * fabs( f[j] ) + py[j] * fabs( f[i] ) ) / fabs( f[j] - f[i] );
                 }
-                // Hard case where contour passes through corner
-                // This is still not perfect - it may lose the contour
-                // which won't upset the contour itself (we can find it
-                // again later) but might upset the labelling
                 else
                 {
-                    kcolnext = kcol;
-                    krownext = krow;
-                    inext    = ( i + 2 ) % 4;
-                    if ( i == 0 )
-                    {
-                        kcolnext--; krownext++;
-                    }
-                    if ( i == 1 )
-                    {
-                        krownext--; kcolnext--;
-                    }
-                    if ( i == 2 )
-                    {
-                        kcolnext++; krownext--;
-                    }
-                    if ( i == 3 )
-                    {
-                        krownext++; kcolnext++;
-                    }
-                    if ( ( kcolnext >= kx ) && ( kcolnext < lx ) &&
-                         ( krownext >= ky ) && ( krownext < ly ) &&
-                         ( ipts[kcolnext][krownext] == 0 ) )
-                    {
-                        pldrawcn( f2eval, f2eval_data,
-                            nx, ny, kx, lx, ky, ly, flev, flabel,
-                            kcolnext, krownext,
-                            locx[num], locy[num], inext, ipts,
-                            distance, lastindex,
-                            pltr, pltr_data );
-                    }
+                    locx = px[i];
+                    locy = py[i];
                 }
+                // If this is the start of the contour then move to the point
                 if ( first == 1 )
                 {
-                    // Move back to first point
-                    cont_mv_store( locx[num], locy[num] );
+                    cont_mv_store( locx, locy );
                     first      = 0;
                     *distance  = 0;
                     *lastindex = 0;
-                    first      = 0;
                 }
                 else
                 {
+                    // Link to the next point on the contour
+                    if ( contlabel_active )
+                        pl_drawcontlabel( locx, locy, flabel, distance, lastindex );
+                    else
+                        cont_xy_store( locx, locy );
+                    // Need to follow contour into next grid box
+                    kcolnext = kcol;
+                    krownext = krow;
+                    inext    = ( i + 2 ) % 4;
+                    // Easy case where contour does not pass through corner
+                    if ( f[i] != 0.0 )
+                    {
+                        if ( i == 0 )
+                            kcolnext--;
+                        if ( i == 1 )
+                            krownext--;
+                        if ( i == 2 )
+                            kcolnext++;
+                        if ( i == 3 )
+                            krownext++;
+                    }
+                    // Hard case where contour passes through corner
+                    // This is still not perfect - it may lose the contour
+                    // which won't upset the contour itself (we can find it
+                    // again later) but might upset the labelling
+                    else
+                    {
+                        if ( i == 0 )
+                        {
+                            kcolnext--; krownext++;
+                        }
+                        if ( i == 1 )
+                        {
+                            krownext--; kcolnext--;
+                        }
+                        if ( i == 2 )
+                        {
+                            kcolnext++; krownext--;
+                        }
+                        if ( i == 3 )
+                        {
+                            krownext++; kcolnext++;
+                        }
+                    }
+                    follow = ( kcolnext >= kx ) && ( kcolnext < lx ) &&
+                             ( krownext >= ky ) && ( krownext < ly ) &&
+                             !CONT_VISITED( grid, CONT_CELL( grid, kcolnext, krownext ) );
+                    // Any further contour in this cell starts a new line
                     first = 1;
                 }
-                num++;
             }
         }
+
+        if ( follow )
+        {
+            // Come back to the remaining edges of this cell once the
+            // contour has been followed, if any of them is crossed.
+            for ( n = k, j = i; n < 4; n++, j = ( j + 1 ) % 4 )
+            {
+                if ( ( iedge[j] == 1 ) || ( f[j] == 0.0 ) )
+                    break;
+            }
+            if ( n < 4 )
+            {
+                if ( grid->nstack + 2 > grid->stacksize )
+                {
+                    grid->stacksize = grid->stacksize == 0 ? 64 : 2 * grid->stacksize;
+                    if ( ( grid->stack = (PLINT *) realloc( grid->stack,
+                               (size_t) grid->stacksize * sizeof ( PLINT ) ) ) == NULL )
+                        plexit( "pldrawcn: Insufficient memory" );
+                }
+                grid->stack[grid->nstack++] = CONT_CELL( grid, kcol, krow );
+                grid->stack[grid->nstack++] = 4 * k + i;
+            }
+
+            // The contour enters the next cell across edge inext
+            kcol      = kcolnext;
+            krow      = krownext;
+            startedge = inext;
+            first     = 0;
+            k         = 0;
+            i         = inext;
+            CONT_VISIT( grid, CONT_CELL( grid, kcol, krow ) );
+            if ( cont_cell( grid, flev, kcol, krow, f, iedge, px, py ) )
+                continue;
+        }
+
+        // The contour has ended: carry on with the last cell left unfinished
+        if ( grid->nstack == 0 )
+            return;
+        i         = grid->stack[--grid->nstack];
+        k         = i / 4;
+        i         = i % 4;
+        n         = grid->stack[--grid->nstack];
+        kcol      = kx + n % ( lx - kx );
+        krow      = ky + n / ( lx - kx );
+        startedge = -2;
+        first     = 1;
+        cont_cell( grid, flev, kcol, krow, f, iedge, px, py );
     }
 }
 
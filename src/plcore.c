@@ -85,6 +85,13 @@
 #define BUFFER2_SIZE    300
 #define DRVSPEC_SIZE    400
 
+#ifdef ENABLE_DYNDRIVERS
+#include <sys/stat.h>
+
+// Cached driver database in the drivers directory, see plReadDriverDB()
+#define DRIVERS_DB    "drivers.db"
+#endif
+
 #include <errno.h>
 
 int
@@ -417,13 +424,14 @@ plP_polyline( short *x, short *y, PLINT npts )
 
     if ( plsc->difilt )
     {
+        plP_growxy( &plsc->dixbuf, &plsc->diybuf, &plsc->dibufsize, npts );
         for ( i = 0; i < npts; i++ )
         {
-            xscl[i] = x[i];
-            yscl[i] = y[i];
+            plsc->dixbuf[i] = x[i];
+            plsc->diybuf[i] = y[i];
         }
-        difilt( xscl, yscl, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
-        plP_pllclp( xscl, yscl, npts, clpxmi, clpxma, clpymi, clpyma,
+        difilt( plsc->dixbuf, plsc->diybuf, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
+        plP_pllclp( plsc->dixbuf, plsc->diybuf, npts, clpxmi, clpxma, clpymi, clpyma,
             grpolyline );
     }
     else
@@ -483,13 +491,14 @@ plP_fill( short *x, short *y, PLINT npts )
     {
         if ( plsc->difilt )
         {
+            plP_growxy( &plsc->dixbuf, &plsc->diybuf, &plsc->dibufsize, npts );
             for ( i = 0; i < npts; i++ )
             {
-                xscl[i] = x[i];
-                yscl[i] = y[i];
+                plsc->dixbuf[i] = x[i];
+                plsc->diybuf[i] = y[i];
             }
-            difilt( xscl, yscl, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
-            plP_plfclp( xscl, yscl, npts, clpxmi, clpxma, clpymi, clpyma,
+            difilt( plsc->dixbuf, plsc->diybuf, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
+            plP_plfclp( plsc->dixbuf, plsc->diybuf, npts, clpxmi, clpxma, clpymi, clpyma,
                 grfill );
         }
         else
@@ -499,6 +508,46 @@ plP_fill( short *x, short *y, PLINT npts )
     }
 }
 
+// Grow the scratch coordinate arrays *px, *py of *size points so that
+// they can hold at least npts points.  The arrays grow geometrically, so a
+// stream plotting long polylines reallocates them only a few times.
+
+void
+plP_growxy( PLINT **px, PLINT **py, PLINT *size, PLINT npts )
+{
+    PLINT newsize;
+
+    if ( npts <= *size )
+        return;
+
+    newsize = MAX( MAX( npts, 2 * *size ), PL_MAXPOLY );
+    if ( ( ( *px = (PLINT *) realloc( *px, (size_t) newsize * sizeof ( PLINT ) ) ) == NULL ) ||
+         ( ( *py = (PLINT *) realloc( *py, (size_t) newsize * sizeof ( PLINT ) ) ) == NULL ) )
+    {
+        plexit( "plP_growxy: Insufficient memory" );
+    }
+    *size = newsize;
+}
+
+// The same for arrays of device coordinates.
+
+void
+plP_growxy_short( short **px, short **py, PLINT *size, PLINT npts )
+{
+    PLINT newsize;
+
+    if ( npts <= *size )
+        return;
+
+    newsize = MAX( MAX( npts, 2 * *size ), PL_MAXPOLY );
+    if ( ( ( *px = (short *) realloc( *px, (size_t) newsize * sizeof ( short ) ) ) == NULL ) ||
+         ( ( *py = (short *) realloc( *py, (size_t) newsize * sizeof ( short ) ) ) == NULL ) )
+    {
+        plexit( "plP_growxy_short: Insufficient memory" );
+    }
+    *size = newsize;
+}
+
 // Render a gradient
 // The plot buffer must be called first
 // N.B. plP_gradient is never called (see plgradient) unless the
@@ -522,13 +571,14 @@ plP_gradient( short *x, short *y, PLINT npts )
     // Render gradient with driver.
     if ( plsc->difilt )
     {
+        plP_growxy( &plsc->dixbuf, &plsc->diybuf, &plsc->dibufsize, npts );
         for ( i = 0; i < npts; i++ )
         {
-            xscl[i] = x[i];
-            yscl[i] = y[i];
+            plsc->dixbuf[i] = x[i];
+            plsc->diybuf[i] = y[i];
         }
-        difilt( xscl, yscl, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
-        plP_plfclp( xscl, yscl, npts, clpxmi, clpxma, clpymi, clpyma,
+        difilt( plsc->dixbuf, plsc->diybuf, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
+        plP_plfclp( plsc->dixbuf, plsc->diybuf, npts, clpxmi, clpxma, clpymi, clpyma,
             grgradient );
     }
     else
@@ -537,6 +587,62 @@ plP_gradient( short *x, short *y, PLINT npts )
     }
 }
 
+// Draw the glyph of args->text centred on each of the args->n positions.
+// The plot buffer records the whole batch.  Drivers that have set
+// plsc->dev_markers get it in one PLESC_MARKERS escape, the others (which
+// only happens when the plot buffer is replayed on another stream) get one
+// PLESC_HAS_TEXT escape per marker.
+
+void
+plP_markers( EscMarkers *args )
+{
+    EscMarkers filtered;
+    EscText    *text = args->text;
+    PLINT      *x    = args->x, *y = args->y;
+    PLINT      i, clpxmi, clpxma, clpymi, clpyma;
+    char       *save_locale;
+
+    plsc->page_status = DRAWING;
+
+    if ( plsc->plbuf_write )
+        plbuf_esc( plsc, PLESC_MARKERS, args );
+
+    if ( plsc->difilt )
+    {
+        plP_growxy( &plsc->dixbuf, &plsc->diybuf, &plsc->dibufsize, args->n );
+        for ( i = 0; i < args->n; i++ )
+        {
+            plsc->dixbuf[i] = x[i];
+            plsc->diybuf[i] = y[i];
+        }
+        difilt( plsc->dixbuf, plsc->diybuf, args->n, &clpxmi, &clpxma, &clpymi, &clpyma );
+        x = plsc->dixbuf;
+        y = plsc->diybuf;
+    }
+
+    save_locale = plsave_set_locale();
+    if ( !plsc->stream_closed )
+    {
+        if ( plsc->dev_markers )
+        {
+            filtered   = *args;
+            filtered.x = x;
+            filtered.y = y;
+            ( *plsc->dispatch_table->pl_esc )( (struct PLStream_struct *) plsc, PLESC_MARKERS, &filtered );
+        }
+        else
+        {
+            for ( i = 0; i < args->n; i++ )
+            {
+                text->x = x[i];
+                text->y = y[i];
+                ( *plsc->dispatch_table->pl_esc )( (struct PLStream_struct *) plsc, PLESC_HAS_TEXT, text );
+            }
+        }
+    }
+    plrestore_locale( save_locale );
+}
+
 // Account for driver ability to draw text itself
 //
 // #define DEBUG_TEXT
@@ -2520,6 +2626,8 @@ c_plend( void )
 void
 c_plend1( void )
 {
+    int i;
+
     if ( plsc->level > 0 )
     {
         plP_eop();
@@ -2535,11 +2643,12 @@ c_plend1( void )
 
     free_mem( plsc->cmap0 );
     free_mem( plsc->cmap1 );
+    free_mem( plsc->cmap1_lut );
     free_mem( plsc->plwindow );
     free_mem( plsc->geometry );
     free_mem( plsc->dev );
     free_mem( plsc->BaseName );
-    free_mem( plsc->plbuf_buffer );
+    plbuf_free( plsc );
 
     if ( plsc->program )
         free_mem( plsc->program );
@@ -2564,6 +2673,22 @@ c_plend1( void )
     if ( plsc->timefmt )
         free_mem( plsc->timefmt );
 
+    if ( plsc->dixbuf )
+        free_mem( plsc->dixbuf );
+    if ( plsc->diybuf )
+        free_mem( plsc->diybuf );
+    if ( plsc->linexbuf )
+        free_mem( plsc->linexbuf );
+    if ( plsc->lineybuf )
+        free_mem( plsc->lineybuf );
+    for ( i = 0; i < 2; i++ )
+    {
+        if ( plsc->clpxbuf[i] )
+            free_mem( plsc->clpxbuf[i] );
+        if ( plsc->clpybuf[i] )
+            free_mem( plsc->clpybuf[i] );
+    }
+
     // Close qsastime library for this stream that was opened by
     // plconfigtime call in plinit.
 
@@ -2755,13 +2880,7 @@ c_plcpstrm( PLINT iplsr, PLINT flags )
 
 // Plot buffer -- need to copy buffer pointer so that plreplot() works
 // This also prevents inadvertent writes into the plot buffer
-    plsc->plbuf_buffer_grow = plsr->plbuf_buffer_grow;
-    plsc->plbuf_buffer_size = plsr->plbuf_buffer_size;
-    plsc->plbuf_top         = plsr->plbuf_top;
-    plsc->plbuf_readpos     = plsr->plbuf_readpos;
-    if ( ( plsc->plbuf_buffer = malloc( plsc->plbuf_buffer_size ) ) == NULL )
-        plexit( "plcpstrm: Error allocating plot buffer." );
-    memcpy( plsc->plbuf_buffer, plsr->plbuf_buffer, plsr->plbuf_top );
+    plbuf_copy( plsc, plsr );
 
 // Driver interface
 // Transformation must be recalculated in current driver coordinates
@@ -2821,6 +2940,7 @@ c_plcpstrm( PLINT iplsr, PLINT flags )
 
     for ( i = 0; i < plsc->ncol1; i++ )
         pl_cpcolor( &plsc->cmap1[i], &plsr->cmap1[i] );
+    plcmap1_lut( plsc );
 
 // Initialize if it hasn't been done yet.
 
@@ -2980,60 +3100,154 @@ plGetDrvDir()
 #endif
 
 
+#ifdef ENABLE_DYNDRIVERS
+
 //--------------------------------------------------------------------------
-// void plInitDispatchTable()
+// int plDriverListed()
 //
-// ...
+// Whether the driver name of length len is among the ndrivers drivers
+// (of lengths drvlen) collected by plReadDriverDB().
 //--------------------------------------------------------------------------
 
-static int plDispatchSequencer( const void *p1, const void *p2 )
+static int
+plDriverListed( char **drivers, size_t *drvlen, int ndrivers, PLCHAR_VECTOR name, size_t len )
 {
-    const PLDispatchTable* t1 = *(const PLDispatchTable * const *) p1;
-    const PLDispatchTable* t2 = *(const PLDispatchTable * const *) p2;
-
-//     printf( "sorting: t1.name=%s t1.seq=%d t2.name=%s t2.seq=%d\n",
-//             t1->pl_DevName, t1->pl_seq, t2->pl_DevName, t2->pl_seq );
+    int i;
 
-    return t1->pl_seq - t2->pl_seq;
+    for ( i = 0; i < ndrivers; i++ )
+    {
+        if ( drvlen[i] == len && strncmp( drivers[i], name, len ) == 0 )
+            return 1;
+    }
+    return 0;
 }
 
-static void
-plInitDispatchTable()
-{
-    int n;
+//--------------------------------------------------------------------------
+// char *plReadDriverDB()
+//
+// Returns the contents of the cached driver database DRIVERS_DB in the
+// drivers directory, which holds the lines of all the <driver>.driver_info
+// files and is generated when PLplot is configured and installed along
+// with the drivers.  It is only used if every <driver>.driver_info file in
+// the directory is listed in it and none of them is newer than it, so that
+// drivers added or updated afterwards are still found by scanning the
+// directory.  Returns NULL if there is no such database or it is out of
+// date.  The result must be freed.
+//--------------------------------------------------------------------------
 
-#ifdef ENABLE_DYNDRIVERS
-    char          buf[BUFFER2_SIZE];
-    PLCHAR_VECTOR drvdir;
-    char          *devnam, *devdesc, *devtype, *driver, *tag, *seqstr;
-    int           seq;
-    int           i, j, driver_found, done = 0;
-    FILE          *fp_drvdb   = NULL;
-    DIR           * dp_drvdir = NULL;
-    struct dirent * entry;
-    // lt_dlhandle dlhand;
+static char *
+plReadDriverDB( PLCHAR_VECTOR drvdir )
+{
+    char          path[PLPLOT_MAX_PATH];
+    char          *db, *line, *field, **drivers;
+    size_t        *drvlen, size, len, namlen;
+    int           i, nlines, ndrivers = 0, nfound = 0, valid = 1;
+    FILE          *fp;
+    struct stat   st;
+    time_t        db_mtime;
+    DIR           *dp_drvdir;
+    struct dirent *entry;
+
+    snprintf( path, PLPLOT_MAX_PATH, "%s/%s", drvdir, DRIVERS_DB );
+    if ( stat( path, &st ) != 0 || ( fp = fopen( path, "r" ) ) == NULL )
+        return NULL;
+    db_mtime = st.st_mtime;
+    if ( ( db = (char *) malloc( (size_t) st.st_size + 1 ) ) == NULL )
+        plexit( "plReadDriverDB: Insufficient memory" );
+    size     = fread( db, 1, (size_t) st.st_size, fp );
+    db[size] = '\0';
+    fclose( fp );
+
+// Collect the drivers, the fourth field of each line
+
+    nlines = 1;
+    for ( line = db; ( line = strchr( line, '\n' ) ) != NULL; line++ )
+        nlines++;
+    if ( ( ( drivers = (char **) malloc( (size_t) nlines * sizeof ( char * ) ) ) == NULL ) ||
+         ( ( drvlen = (size_t *) malloc( (size_t) nlines * sizeof ( size_t ) ) ) == NULL ) )
+        plexit( "plReadDriverDB: Insufficient memory" );
+
+    for ( line = db; *line != '\0'; line += len + ( line[len] == '\n' ) )
+    {
+        len   = strcspn( line, "\n" );
+        field = line;
+        for ( i = 0; i < 3 && field != NULL; i++ )
+        {
+            if ( ( field = memchr( field, ':', (size_t) ( line + len - field ) ) ) != NULL )
+                field++;
+        }
+        if ( field == NULL )
+            continue;
+        namlen = strcspn( field, ":\n" );
+        if ( !plDriverListed( drivers, drvlen, ndrivers, field, namlen ) )
+        {
+            drivers[ndrivers] = field;
+            drvlen[ndrivers]  = namlen;
+            ndrivers++;
+        }
+    }
 
-    // Make sure driver counts are zeroed
-    npldynamicdevices = 0;
-    nloadabledrivers  = 0;
+// Check them against the <driver>.driver_info files in the directory
 
-// Open a temporary file in which all the plD_DEVICE_INFO_<driver> strings
-// will be stored
-    fp_drvdb = pl_create_tempfile( NULL );
-    if ( fp_drvdb == NULL )
+    if ( ( dp_drvdir = opendir( drvdir ) ) == NULL )
+        valid = 0;
+    else
     {
-        plabort( "plInitDispatchTable: Could not open temporary file" );
-        return;
+        while ( valid && ( entry = readdir( dp_drvdir ) ) != NULL )
+        {
+            char * name = entry->d_name;
+
+            namlen = strlen( name );
+            if ( namlen <= 12 || strcmp( name + namlen - 12, ".driver_info" ) != 0 )
+                continue;
+            snprintf( path, PLPLOT_MAX_PATH, "%s/%s", drvdir, name );
+            valid = plDriverListed( drivers, drvlen, ndrivers, name, namlen - 12 ) &&
+                    stat( path, &st ) == 0 && st.st_mtime <= db_mtime;
+            nfound++;
+        }
+        closedir( dp_drvdir );
     }
+    free( drivers );
+    free( drvlen );
+
+    if ( !valid || nfound != ndrivers )
+    {
+        pldebug( "plReadDriverDB", "%s is out of date\n", DRIVERS_DB );
+        free( db );
+        return NULL;
+    }
+    pldebug( "plReadDriverDB", "Using %s/%s\n", drvdir, DRIVERS_DB );
+    return db;
+}
+
+//--------------------------------------------------------------------------
+// char *plScanDriverDir()
+//
+// Reads all the <driver>.driver_info files in the drivers directory and
+// returns their lines, each terminated by a newline, or NULL on failure.
+// The result must be freed.
+//--------------------------------------------------------------------------
+
+static char *
+plScanDriverDir( PLCHAR_VECTOR drvdir )
+{
+    char          buf[BUFFER2_SIZE];
+    char          *db, *newdb;
+    size_t        size = 0, maxsize = BUFFER2_SIZE, len;
+    DIR           * dp_drvdir;
+    struct dirent * entry;
+
+    if ( ( db = (char *) malloc( maxsize ) ) == NULL )
+        plexit( "plScanDriverDir: Insufficient memory" );
+    db[0] = '\0';
 
 // Open the drivers directory
-    drvdir    = plGetDrvDir();
     dp_drvdir = opendir( drvdir );
     if ( dp_drvdir == NULL )
     {
-        fclose( fp_drvdb );
+        free( db );
         plabort( "plInitDispatchTable: Could not open drivers directory" );
-        return;
+        return NULL;
     }
 
 // Loop over each entry in the drivers directory
@@ -3043,13 +3257,13 @@ plInitDispatchTable()
     {
         char   * name = entry->d_name;
         // Suffix .driver_info has a length of 12 letters.
-        size_t len = strlen( name ) - 12;
+        size_t namlen = strlen( name );
 
         pldebug( "plInitDispatchTable",
             "Consider file %s\n", name );
 
 // Only consider entries that have the ".driver_info" suffix
-        if ( ( len > 0 ) && ( strcmp( name + len, ".driver_info" ) == 0 ) )
+        if ( ( namlen > 12 ) && ( strcmp( name + namlen - 12, ".driver_info" ) == 0 ) )
         {
             char path[PLPLOT_MAX_PATH];
             FILE * fd;
@@ -3060,36 +3274,98 @@ plInitDispatchTable()
             if ( fd == NULL )
             {
                 closedir( dp_drvdir );
-                fclose( fp_drvdb );
+                free( db );
                 snprintf( buf, BUFFER2_SIZE,
                     "plInitDispatchTable: Could not open driver info file %s\n",
                     name );
                 plabort( buf );
-                return;
+                return NULL;
             }
 
 // Each line in the <driver>.driver_info file corresponds to a specific device.
-// Write it to the drivers db file and take care of leading newline
+// Append it to the drivers database and take care of the trailing newline
 // character
 
             pldebug( "plInitDispatchTable",
                 "Opened driver info file %s\n", name );
             while ( fgets( buf, BUFFER2_SIZE, fd ) != NULL )
             {
-                fprintf( fp_drvdb, "%s", buf );
-                if ( buf [strlen( buf ) - 1] != '\n' )
-                    fprintf( fp_drvdb, "\n" );
-                npldynamicdevices++;
+                len = strlen( buf );
+                if ( size + len + 2 > maxsize )
+                {
+                    maxsize = 2 * maxsize + len;
+                    if ( ( newdb = (char *) realloc( db, maxsize ) ) == NULL )
+                        plexit( "plScanDriverDir: Insufficient memory" );
+                    db = newdb;
+                }
+                memcpy( db + size, buf, len );
+                size += len;
+                if ( buf[len - 1] != '\n' )
+                    db[size++] = '\n';
+                db[size] = '\0';
             }
             fclose( fd );
         }
     }
-
-// Make sure that the temporary file containing the drivers database
-// is ready to read and close the directory handle
-    fflush( fp_drvdb );
     closedir( dp_drvdir );
 
+    return db;
+}
+
+#endif
+
+//--------------------------------------------------------------------------
+// void plInitDispatchTable()
+//
+// Sets up the dispatch table of all the static and dynamic devices.  The
+// dynamic devices are taken from the cached driver database if it is up to
+// date, otherwise from the <driver>.driver_info files in the drivers
+// directory.  The drivers themselves are only loaded by plLoadDriver()
+// once a device has been selected.
+//--------------------------------------------------------------------------
+
+static int plDispatchSequencer( const void *p1, const void *p2 )
+{
+    const PLDispatchTable* t1 = *(const PLDispatchTable * const *) p1;
+    const PLDispatchTable* t2 = *(const PLDispatchTable * const *) p2;
+
+//     printf( "sorting: t1.name=%s t1.seq=%d t2.name=%s t2.seq=%d\n",
+//             t1->pl_DevName, t1->pl_seq, t2->pl_DevName, t2->pl_seq );
+
+    return t1->pl_seq - t2->pl_seq;
+}
+
+static void
+plInitDispatchTable()
+{
+    int n;
+
+#ifdef ENABLE_DYNDRIVERS
+    char          buf[BUFFER2_SIZE];
+    PLCHAR_VECTOR drvdir;
+    char          *devnam, *devdesc, *devtype, *driver, *tag, *seqstr;
+    char          *drvdb, *line;
+    size_t        len;
+    int           seq;
+    int           i, j, driver_found;
+    // lt_dlhandle dlhand;
+
+    // Make sure driver counts are zeroed
+    npldynamicdevices = 0;
+    nloadabledrivers  = 0;
+
+// Get the lines of all the plD_DEVICE_INFO_<driver> strings
+    drvdir = plGetDrvDir();
+    if ( ( drvdb = plReadDriverDB( drvdir ) ) == NULL &&
+         ( drvdb = plScanDriverDir( drvdir ) ) == NULL )
+        return;
+
+    for ( line = drvdb; *line != '\0'; line += len + ( line[len] == '\n' ) )
+    {
+        len = strcspn( line, "\n" );
+        npldynamicdevices++;
+    }
+
 #endif
 
 // Allocate space for the dispatch table.
@@ -3097,7 +3373,7 @@ plInitDispatchTable()
                             malloc( (size_t) ( nplstaticdevices + npldynamicdevices ) * sizeof ( PLDispatchTable * ) ) ) == NULL )
     {
 #ifdef ENABLE_DYNDRIVERS
-        fclose( fp_drvdb );
+        free( drvdb );
 #endif
         plexit( "plInitDispatchTable: Insufficient memory" );
     }
@@ -3112,7 +3388,7 @@ plInitDispatchTable()
         if ( ( dispatch_table[n] = (PLDispatchTable *) malloc( sizeof ( PLDispatchTable ) ) ) == NULL )
         {
 #ifdef ENABLE_DYNDRIVERS
-            fclose( fp_drvdb );
+            free( drvdb );
 #endif
             plexit( "plInitDispatchTable: Insufficient memory" );
         }
@@ -3134,23 +3410,15 @@ plInitDispatchTable()
     if ( ( ( loadable_device_list = malloc( (size_t) npldynamicdevices * sizeof ( PLLoadableDevice ) ) ) == NULL ) ||
          ( ( loadable_driver_list = malloc( (size_t) npldynamicdevices * sizeof ( PLLoadableDriver ) ) ) == NULL ) )
     {
-        fclose( fp_drvdb );
+        free( drvdb );
         plexit( "plInitDispatchTable: Insufficient memory" );
     }
 
-    rewind( fp_drvdb );
-
-    i    = 0;
-    done = !( i < npldynamicdevices );
-    while ( !done )
+    i = 0;
+    for ( line = drvdb; *line != '\0'; line += len + ( line[len] == '\n' ) )
     {
-        char *p = fgets( buf, BUFFER2_SIZE, fp_drvdb );
-
-        if ( p == 0 )
-        {
-            done = 1;
-            continue;
-        }
+        len = strcspn( line, "\n" );
+        snprintf( buf, BUFFER2_SIZE, "%.*s", (int) len, line );
 
         devnam  = strtok( buf, ":" );
         devdesc = strtok( 0, ":" );
@@ -3171,7 +3439,7 @@ plInitDispatchTable()
 
         if ( ( dispatch_table[n] = malloc( sizeof ( PLDispatchTable ) ) ) == NULL )
         {
-            fclose( fp_drvdb );
+            free( drvdb );
             plexit( "plInitDispatchTable: Insufficient memory" );
         }
 
@@ -3215,8 +3483,7 @@ plInitDispatchTable()
         i++;
     }
 
-// RML: close fp_drvdb
-    fclose( fp_drvdb );
+    free( drvdb );
 
 #endif
 
@@ -4348,6 +4615,10 @@ PLINT plP_checkdriverinit( char *names )
 //   - Added support for pltr callback
 //   - Commented out the "dev_fastimg" rendering path
 //
+// Drivers that set dev_fastimg get the whole image in one PLESC_IMAGE
+// escape (see plimagefast and plP_drawimage) as long as the image cells
+// map to physical coordinates by an affine transformation.  All other
+// images are drawn cell by cell with plimageslow.
 //--------------------------------------------------------------------------
 
 void
@@ -4356,90 +4627,126 @@ plP_image( PLFLT *z, PLINT nx, PLINT ny, PLFLT xmin, PLFLT ymin, PLFLT dx, PLFLT
 {
     plsc->page_status = DRAWING;
 
-    plimageslow( z, nx, ny, xmin, ymin, dx, dy, pltr, pltr_data );
+    if ( !plsc->dev_fastimg ||
+         !plimagefast( z, nx, ny, xmin, ymin, dx, dy, pltr, pltr_data ) )
+        plimageslow( z, nx, ny, xmin, ymin, dx, dy, pltr, pltr_data );
+}
 
-    //
-    // COMMENTED OUT by Hezekiah Carty, March 2008
-    // The current dev_fastimg rendering method does not work as-is with
-    // the plimagefr coordinate transform support.
-    // This is hopefully temporary, until the dev_fastimg rendering
-    // path can be updated to work with the new plimage internals.
-    // Until then, all plimage* rendering is done by the plimageslow
-    // rendering path.
-    //
-#if 0   // BEGIN dev_fastimg COMMENT
-    PLINT i, npts;
-    short *xscl, *yscl;
+//--------------------------------------------------------------------------
+// plP_drawimage
+//
+// Draws an image of (nx - 1) x (ny - 1) cells.  x and y hold the physical
+// coordinates of the nx x ny cell corners, with corner [ix][iy] at index
+// ix * ny + iy, and z the cmap1 index of every cell, with cell [ix][iy] at
+// index ix * ( ny - 1 ) + iy.  Cells with an index of ncol1 or more are
+// not drawn.  The image is stored in the plot buffer as it is, and drivers
+// that do not set dev_fastimg (e.g., when the plot buffer is replayed on
+// another device) get every cell as a solid fill.
+//
+// Drivers get the RGBA bytes of the cells in dev_rgba as well, which are
+// transparent black for the cells not drawn.  rgba gives them if the
+// caller has them (see plimagefast), otherwise they are looked up from z.
+//--------------------------------------------------------------------------
+
+void
+plP_drawimage( short *x, short *y, unsigned short *z, unsigned char *rgba,
+               PLINT nx, PLINT ny )
+{
+    PLINT i, npts = nx * ny;
+    PLINT clpxmi, clpxma, clpymi, clpyma;
+    PLINT cx[2], cy[2];
     int   plbuf_write;
+    short *xscl, *yscl;
 
     plsc->page_status = DRAWING;
 
-    if ( plsc->dev_fastimg == 0 )
-    {
-        plimageslow( x, y, z, nx - 1, ny - 1,
-            xmin, ymin, dx, dy, zmin, zmax );
-        return;
-    }
+    plsc->dev_zmin = 0;
+    plsc->dev_zmax = (unsigned short) ( plsc->ncol1 - 1 );
 
     if ( plsc->plbuf_write )
     {
-        IMG_DT img_dt;
-
-        img_dt.xmin = xmin;
-        img_dt.ymin = ymin;
-        img_dt.dx   = dx;
-        img_dt.dy   = dy;
-
         plsc->dev_ix    = x;
         plsc->dev_iy    = y;
         plsc->dev_z     = z;
         plsc->dev_nptsX = nx;
         plsc->dev_nptsY = ny;
-        plsc->dev_zmin  = zmin;
-        plsc->dev_zmax  = zmax;
-
-        plbuf_esc( plsc, PLESC_IMAGE, &img_dt );
+        plbuf_esc( plsc, PLESC_IMAGE, NULL );
     }
 
-    // avoid re-saving plot buffer while in plP_esc()
+    // avoid re-saving plot buffer while in plP_esc() or plP_fill()
     plbuf_write       = plsc->plbuf_write;
     plsc->plbuf_write = 0;
 
-    npts = nx * ny;
-    if ( plsc->difilt ) // isn't this odd? when replaying the plot buffer, e.g., when resizing the window, difilt() is caled again! the plot buffer should already contain the transformed data--it would save a lot of time! (and allow for differently oriented plots when in multiplot mode)
+    if ( !plsc->dev_fastimg )
     {
-        PLINT clpxmi, clpxma, clpymi, clpyma;
+        plimagefills( x, y, z, nx, ny );
+        plsc->plbuf_write = plbuf_write;
+        return;
+    }
 
-        if ( ( ( xscl = (short *) malloc( nx * ny * sizeof ( short ) ) ) == NULL ) ||
-             ( ( yscl = (short *) malloc( nx * ny * sizeof ( short ) ) ) == NULL ) )
+    plsc->dev_rgba = rgba;
+    if ( rgba == NULL )
+    {
+        if ( ( plsc->dev_rgba = (unsigned char *) malloc( (size_t) ( ( nx - 1 ) * ( ny - 1 ) ) * 4 ) ) == NULL )
+            plexit( "plP_drawimage: Insufficient memory" );
+        for ( i = 0; i < ( nx - 1 ) * ( ny - 1 ); i++ )
         {
-            plexit( "plP_image: Insufficient memory" );
+            if ( z[i] < plsc->ncol1 )
+                memcpy( plsc->dev_rgba + 4 * i, plsc->cmap1_lut + 4 * z[i], 4 );
+            else
+                memset( plsc->dev_rgba + 4 * i, 0, 4 );
         }
+    }
 
+    if ( plsc->difilt )
+    {
+        if ( ( ( xscl = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) ||
+             ( ( yscl = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) )
+        {
+            plexit( "plP_drawimage: Insufficient memory" );
+        }
+
+        plP_growxy( &plsc->dixbuf, &plsc->diybuf, &plsc->dibufsize, npts );
         for ( i = 0; i < npts; i++ )
         {
-            xscl[i] = x[i];
-            yscl[i] = y[i];
+            plsc->dixbuf[i] = x[i];
+            plsc->diybuf[i] = y[i];
         }
-        sdifilt( xscl, yscl, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
-        plsc->imclxmin = clpxmi;
-        plsc->imclymin = clpymi;
-        plsc->imclxmax = clpxma;
-        plsc->imclymax = clpyma;
+        difilt( plsc->dixbuf, plsc->diybuf, npts, &clpxmi, &clpxma, &clpymi, &clpyma );
+        for ( i = 0; i < npts; i++ )
+        {
+            xscl[i] = (short) plsc->dixbuf[i];
+            yscl[i] = (short) plsc->diybuf[i];
+        }
+
+        // The clip window goes through the filter as well.
+        cx[0] = plsc->clpxmi;
+        cy[0] = plsc->clpymi;
+        cx[1] = plsc->clpxma;
+        cy[1] = plsc->clpyma;
+        difilt( cx, cy, 2, &clpxmi, &clpxma, &clpymi, &clpyma );
+        plsc->imclxmin = MAX( MIN( cx[0], cx[1] ), clpxmi );
+        plsc->imclxmax = MIN( MAX( cx[0], cx[1] ), clpxma );
+        plsc->imclymin = MAX( MIN( cy[0], cy[1] ), clpymi );
+        plsc->imclymax = MIN( MAX( cy[0], cy[1] ), clpyma );
+
         grimage( xscl, yscl, z, nx, ny );
         free( xscl );
         free( yscl );
     }
     else
     {
-        plsc->imclxmin = plsc->phyxmi;
-        plsc->imclymin = plsc->phyymi;
-        plsc->imclxmax = plsc->phyxma;
-        plsc->imclymax = plsc->phyyma;
+        plsc->imclxmin = plsc->clpxmi;
+        plsc->imclymin = plsc->clpymi;
+        plsc->imclxmax = plsc->clpxma;
+        plsc->imclymax = plsc->clpyma;
         grimage( x, y, z, nx, ny );
     }
     plsc->plbuf_write = plbuf_write;
-#endif  // END dev_fastimg COMMENT
+
+    if ( rgba == NULL )
+        free( plsc->dev_rgba );
+    plsc->dev_rgba = NULL;
 }
 
 //--------------------------------------------------------------------------
@@ -538,6 +538,7 @@ c_plscmap1( PLINT_VECTOR r, PLINT_VECTOR g, PLINT_VECTOR b, PLINT ncol1 )
         plsc->cmap1[i].b = (unsigned char) b[i];
         plsc->cmap1[i].a = 1.0;
     }
+    plcmap1_lut( plsc );
 
     if ( plsc->level > 0 )
         plP_state( PLSTATE_CMAP1 );
@@ -580,6 +581,7 @@ c_plscmap1a( PLINT_VECTOR r, PLINT_VECTOR g, PLINT_VECTOR b, PLFLT_VECTOR alpha,
         plsc->cmap1[i].b = (unsigned char) b[i];
         plsc->cmap1[i].a = alpha[i];
     }
+    plcmap1_lut( plsc );
 
     if ( plsc->level > 0 )
         plP_state( PLSTATE_CMAP1 );
@@ -863,10 +865,110 @@ plcmap1_calc( void )
         }
     }
 
+    plcmap1_lut( plsc );
+
     if ( plsc->level > 0 )
         plP_state( PLSTATE_CMAP1 );
 }
 
+//--------------------------------------------------------------------------
+// plcmap1_lut()
+//
+//! Rebuild pls->cmap1_lut, the RGBA bytes of the cmap 1 entries, from
+//! pls->cmap1.  This has to be done whenever the cmap 1 entries change, so
+//! that plcmap1_rgba() and plP_drawimage() can convert many colors at once.
+//!
+//! @param pls Stream whose table is rebuilt.
+
+void
+plcmap1_lut( PLStream *pls )
+{
+    PLINT         i;
+    unsigned char *p;
+
+    if ( pls->ncol1 <= 0 || pls->cmap1 == NULL )
+        return;
+
+    if ( ( pls->cmap1_lut = (unsigned char *) realloc( pls->cmap1_lut, (size_t) pls->ncol1 * 4 ) ) == NULL )
+    {
+        plexit( "plcmap1_lut: Insufficient memory" );
+    }
+
+    p = pls->cmap1_lut;
+    for ( i = 0; i < pls->ncol1; i++ )
+    {
+        *p++ = pls->cmap1[i].r;
+        *p++ = pls->cmap1[i].g;
+        *p++ = pls->cmap1[i].b;
+        *p++ = (unsigned char) MAX( 0, MIN( 255, (int) ( pls->cmap1[i].a * 255. + 0.5 ) ) );
+    }
+}
+
+//--------------------------------------------------------------------------
+// plcmap1_index()
+//
+//! Map n positions in cmap 1 space to the cmap 1 indices plcol1 would
+//! use for them.  Positions that plcol1 rejects (outside 0 - 1 or NaN) get
+//! the index USHRT_MAX, which is above any cmap 1 index.  Unlike plcol1
+//! this changes neither the current color nor the stream state.
+//!
+//! @param values Array of n positions in cmap 1 space.
+//! @param n Number of positions.
+//! @param index Array of n indices that are returned.
+
+void
+plcmap1_index( PLFLT_VECTOR values, PLINT n, unsigned short *index )
+{
+    PLINT i, icol1;
+    PLINT ncol1 = plsc->ncol1;
+    PLFLT v;
+
+    for ( i = 0; i < n; i++ )
+    {
+        v = values[i];
+        if ( v >= 0. && v <= 1. )
+        {
+            icol1    = (PLINT) ( v * ncol1 );
+            index[i] = (unsigned short) ( icol1 < ncol1 ? icol1 : ncol1 - 1 );
+        }
+        else
+            index[i] = USHRT_MAX;
+    }
+}
+
+//--------------------------------------------------------------------------
+// plcmap1_rgba()
+//
+//! Map n positions in cmap 1 space to the RGBA bytes of the cmap 1 entries
+//! plcol1 would use for them, with the alpha scaled to 0 - 255.  Positions
+//! that plcol1 rejects get four zero bytes, i.e. transparent black.
+//!
+//! @param values Array of n positions in cmap 1 space.
+//! @param n Number of positions.
+//! @param rgba Array of 4 * n bytes that are returned.
+
+void
+plcmap1_rgba( PLFLT_VECTOR values, PLINT n, unsigned char *rgba )
+{
+    PLINT         i, icol1;
+    PLINT         ncol1 = plsc->ncol1;
+    PLFLT         v;
+    unsigned char *lut  = plsc->cmap1_lut;
+
+    for ( i = 0; i < n; i++, rgba += 4 )
+    {
+        v = values[i];
+        if ( lut != NULL && v >= 0. && v <= 1. )
+        {
+            icol1 = (PLINT) ( v * ncol1 );
+            icol1 = 4 * ( icol1 < ncol1 ? icol1 : ncol1 - 1 );
+            memcpy( rgba, lut + icol1, 4 );
+        }
+        else
+            memset( rgba, 0, 4 );
+    }
+}
+
 //--------------------------------------------------------------------------
 //! Set the color map 1 value range to use in continuous color plots.
 //!
@@ -21,6 +21,35 @@
 
 #include "plplotP.h"
 
+// Number of x indices copied together by plP_f2eval_copy from data in which
+// consecutive x indices are adjacent
+
+#define F2EVAL_BLOCK    16
+
+//
+// Updates *min and *max with the finite values among the n values at z.  A
+// single pass without early exits, as used by all the minmax functions
+// below.
+//
+
+static void
+minmax_finite( const PLFLT *z, PLINT n, PLFLT *min, PLFLT *max )
+{
+    PLINT i;
+    PLFLT lo = *min, hi = *max;
+
+    for ( i = 0; i < n; i++ )
+    {
+        if ( isfinite( z[i] ) )
+        {
+            lo = z[i] < lo ? z[i] : lo;
+            hi = z[i] > hi ? z[i] : hi;
+        }
+    }
+    *min = lo;
+    *max = hi;
+}
+
 //
 // 2-D data access functions for data stored in (PLFLT **), such as the C
 // variable z declared as...
@@ -82,30 +111,12 @@ plf2ops_c_isnan( PLPointer p, PLINT ix, PLINT iy )
 static void
 plf2ops_c_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLFLT *zmax )
 {
-    int   i, j;
-    PLFLT min, max;
+    int   i;
+    PLFLT min = HUGE_VAL, max = -HUGE_VAL;
     PLFLT **z = (PLFLT **) p;
 
-    if ( !isfinite( z[0][0] ) )
-    {
-        max = -HUGE_VAL;
-        min = HUGE_VAL;
-    }
-    else
-        min = max = z[0][0];
-
     for ( i = 0; i < nx; i++ )
-    {
-        for ( j = 0; j < ny; j++ )
-        {
-            if ( !isfinite( z[i][j] ) )
-                continue;
-            if ( z[i][j] < min )
-                min = z[i][j];
-            if ( z[i][j] > max )
-                max = z[i][j];
-        }
-    }
+        minmax_finite( z[i], ny, &min, &max );
     *zmin = min;
     *zmax = max;
 }
@@ -184,8 +195,8 @@ plf2ops_grid_c_isnan( PLPointer p, PLINT ix, PLINT iy )
 static void
 plf2ops_grid_c_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLFLT *zmax )
 {
-    int      i, j;
-    PLFLT    min, max;
+    int      i;
+    PLFLT    min = HUGE_VAL, max = -HUGE_VAL;
     PLfGrid2 *g  = (PLfGrid2 *) p;
     PLFLT    **z = g->f;
 
@@ -193,26 +204,8 @@ plf2ops_grid_c_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLFLT *zmax
     nx = g->nx;
     ny = g->ny;
 
-    if ( !isfinite( z[0][0] ) )
-    {
-        max = -HUGE_VAL;
-        min = HUGE_VAL;
-    }
-    else
-        min = max = z[0][0];
-
     for ( i = 0; i < nx; i++ )
-    {
-        for ( j = 0; j < ny; j++ )
-        {
-            if ( !isfinite( z[i][j] ) )
-                continue;
-            if ( z[i][j] < min )
-                min = z[i][j];
-            if ( z[i][j] > max )
-                max = z[i][j];
-        }
-    }
+        minmax_finite( z[i], ny, &min, &max );
     *zmin = min;
     *zmax = max;
 }
@@ -302,8 +295,7 @@ plf2ops_grid_row_major_isnan( PLPointer p, PLINT ix, PLINT iy )
 static void
 plf2ops_grid_xxx_major_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLFLT *zmax )
 {
-    int      i;
-    PLFLT    min, max;
+    PLFLT    min = HUGE_VAL, max = -HUGE_VAL;
     PLfGrid2 *g = (PLfGrid2 *) p;
     PLFLT    *z = (PLFLT *) ( (PLFLT *) g->f );
 
@@ -311,23 +303,7 @@ plf2ops_grid_xxx_major_minmax( PLPointer p, PLINT nx, PLINT ny, PLFLT *zmin, PLF
     nx = g->nx;
     ny = g->ny;
 
-    if ( !isfinite( z[0] ) )
-    {
-        max = -HUGE_VAL;
-        min = HUGE_VAL;
-    }
-    else
-        min = max = z[0];
-
-    for ( i = 0; i < nx * ny; i++ )
-    {
-        if ( !isfinite( z[i] ) )
-            continue;
-        if ( z[i] < min )
-            min = z[i];
-        if ( z[i] > max )
-            max = z[i];
-    }
+    minmax_finite( z, nx * ny, &min, &max );
     *zmin = min;
     *zmax = max;
 }
@@ -431,3 +407,90 @@ plf2ops_grid_col_major()
 {
     return &s_plf2ops_grid_col_major;
 }
+
+//--------------------------------------------------------------------------
+// plP_f2eval_row()
+//
+// Direct access to the data behind the built-in evaluators, so that loops
+// over a whole grid need not make a function call per value.  If f2eval is
+// the f2eval function of plf2ops_c(), plf2ops_grid_c(),
+// plf2ops_grid_row_major() or plf2ops_grid_col_major(), or one of
+// plf2eval1(), plf2eval2(), plf2eval() and plf2evalr(), returns a pointer to
+// the value at (ix, 0) and sets *stride to the distance between the values
+// at (ix, iy) and (ix, iy + 1).  When *stride is not 1 the values at
+// (ix, iy) and (ix + 1, iy) are adjacent instead.  Returns NULL for any
+// other f2eval.
+//--------------------------------------------------------------------------
+
+const PLFLT *
+plP_f2eval_row( PLF2EVAL_callback f2eval, PLPointer f2eval_data, PLINT ix, PLINT *stride )
+{
+    PLfGrid2 *g2 = (PLfGrid2 *) f2eval_data;
+    PLfGrid  *g  = (PLfGrid *) f2eval_data;
+
+    *stride = 1;
+    if ( f2eval == plf2ops_c_f2eval || f2eval == plf2eval1 )
+        return ( (PLFLT **) f2eval_data )[ix];
+    if ( f2eval == plf2ops_grid_c_f2eval || f2eval == plf2eval2 )
+        return g2->f[ix];
+    if ( f2eval == plf2ops_grid_row_major_f2eval )
+        return (PLFLT *) g2->f + ix * g2->ny;
+    if ( f2eval == plf2eval )
+        return g->f + ix * g->ny;
+
+    if ( f2eval == plf2ops_grid_col_major_f2eval )
+    {
+        *stride = g2->nx;
+        return (PLFLT *) g2->f + ix;
+    }
+    if ( f2eval == plf2evalr )
+    {
+        *stride = g->nx;
+        return g->f + ix;
+    }
+    return NULL;
+}
+
+//--------------------------------------------------------------------------
+// plP_f2eval_copy()
+//
+// Copies the values at ix = kx, ..., lx - 1 and iy = ky, ..., ly - 1 to a,
+// with the value at (ix, iy) in a[( ix - kx ) * ( ly - ky ) + iy - ky].  The
+// data is read directly when plP_f2eval_row() allows it, a block of x
+// indices at a time for column-major data.
+//--------------------------------------------------------------------------
+
+void
+plP_f2eval_copy( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
+                 PLINT kx, PLINT lx, PLINT ky, PLINT ly, PLFLT *a )
+{
+    const PLFLT *row;
+    PLINT       ix, iy, ib, nb, stride, n = ly - ky;
+
+    for ( ix = kx; ix < lx; ix += nb )
+    {
+        nb  = MIN( F2EVAL_BLOCK, lx - ix );
+        row = plP_f2eval_row( f2eval, f2eval_data, ix, &stride );
+        if ( row == NULL )
+        {
+            for ( ib = 0; ib < nb; ib++ )
+                for ( iy = ky; iy < ly; iy++ )
+                    a[ib * n + iy - ky] = f2eval( ix + ib, iy, f2eval_data );
+        }
+        else if ( stride == 1 )
+        {
+            for ( ib = 0; ib < nb; ib++ )
+            {
+                row = plP_f2eval_row( f2eval, f2eval_data, ix + ib, &stride );
+                memcpy( a + ib * n, row + ky, (size_t) n * sizeof ( PLFLT ) );
+            }
+        }
+        else
+        {
+            for ( iy = ky; iy < ly; iy++ )
+                for ( ib = 0; ib < nb; ib++ )
+                    a[ib * n + iy - ky] = row[iy * stride + ib];
+        }
+        a += nb * n;
+    }
+}
@@ -115,6 +115,13 @@ PLDLLIMPEXP_DATA( FCI_to_FontName_Table ) FontLookup[N_TrueTypeLookup];
 
 #define NTEXT_ALLOC    1024
 
+// Number of hash buckets and default size in bytes of the glyph cache.
+// The size can be changed with the PLPLOT_FREETYPE_CACHE_SIZE environment
+// variable, 0 turns the cache off.
+
+#define FT_CACHE_BUCKETS    1024
+#define FT_CACHE_SIZE       1048576
+
 //--------------------------------------------------------------------------
 //  Some debugging macros
 //--------------------------------------------------------------------------
@@ -135,8 +142,11 @@ void plD_render_freetype_sym( PLStream *pls, EscText *args );
 
 //  Private prototypes for use in this file only
 
-static void FT_PlotChar( PLStream *pls, FT_Data *FT, FT_GlyphSlot slot, int x, int y );
+static void FT_PlotChar( PLStream *pls, FT_Data *FT, const FT_CachedGlyph *glyph, int x, int y );
 static void FT_SetFace( PLStream *pls, PLUNICODE fci );
+static const FT_CachedGlyph *FT_GetGlyph( PLStream *pls, PLUNICODE ch, FT_Int32 flags );
+static void FT_TrimGlyphs( FT_Data *FT );
+static void FT_FreeGlyphs( FT_Data *FT );
 static PLFLT CalculateIncrement( int bg, int fg, int levels );
 
 // These are never defined, maybe they will be used in the future?
@@ -155,18 +165,19 @@ static void FT_StrX_YW( PLStream *pls, const PLUNICODE *text, short len, int *xx
 // Returns the dimensions of the text box. It does this by fully parsing
 // the supplied text through the rendering engine. It does everything
 // but draw the text. This seems, to me, the easiest and most accurate
-// way of determining the text's dimensions. If/when caching is added,
-// the CPU hit for this "double processing" will be minimal.
+// way of determining the text's dimensions. The glyphs come from the
+// glyph cache, so the CPU hit for this "double processing" is minimal.
 //--------------------------------------------------------------------------
 
 void
 FT_StrX_YW( PLStream *pls, const PLUNICODE *text, short len, int *xx, int *yy, int *overyy, int *underyy )
 {
-    FT_Data   *FT = (FT_Data *) pls->FT;
-    short     i   = 0;
-    FT_Vector akerning, adjust;
-    int       x = 0, y = 0, startingy;
-    char      esc;
+    FT_Data              *FT = (FT_Data *) pls->FT;
+    short                i   = 0;
+    FT_Vector            akerning, adjust;
+    int                  x = 0, y = 0, startingy;
+    char                 esc;
+    const FT_CachedGlyph *glyph;
 
     plgesc( &esc );
 
@@ -240,16 +251,15 @@ FT_StrX_YW( PLStream *pls, const PLUNICODE *text, short len, int *xx, int *yy, i
             }
 
             //
-            // Next we load the char. This also draws the char, transforms it, and
-            // converts it to a bitmap. At present this is a bit wasteful, but
-            // if/when I add cache support, then this data won't go to waste.
-            // Since there is no sense in going to the trouble of doing anti-aliasing
-            // calculations since we aren't REALLY plotting anything, we will render
-            // this as monochrome since it is probably marginally quicker. If/when
-            // cache support is added, naturally this will have to change.
+            // Next we get the char. Since we aren't REALLY plotting anything
+            // we only need its metrics, so it is not rendered to a bitmap.
+            // It is loaded with the same hinting as in FT_WriteStrW, so the
+            // metrics cached here serve the rendering as well.
             //
 
-            FT_Load_Char( FT->face, text[i], FT_LOAD_MONOCHROME + FT_LOAD_RENDER );
+            glyph = FT_GetGlyph( pls, text[i], ( FT->smooth_text == 0 ) ? FT_LOAD_MONOCHROME : FT_LOAD_FORCE_AUTOHINT );
+            FT->glyph_width  = glyph->width;
+            FT->glyph_height = glyph->height;
 
             //
             // Add in the "advancement" needed to position the cursor for the next
@@ -257,8 +267,8 @@ FT_StrX_YW( PLStream *pls, const PLUNICODE *text, short len, int *xx, int *yy, i
             // Y is negative because freetype does things upside down
             //
 
-            x += (int) ( FT->face->glyph->advance.x );
-            y -= (int) ( FT->face->glyph->advance.y );
+            x += (int) ( glyph->advance.x );
+            y -= (int) ( glyph->advance.y );
         }
     }
 
@@ -287,10 +297,11 @@ FT_StrX_YW( PLStream *pls, const PLUNICODE *text, short len, int *xx, int *yy, i
 void
 FT_WriteStrW( PLStream *pls, const PLUNICODE *text, short len, int x, int y )
 {
-    FT_Data   *FT = (FT_Data *) pls->FT;
-    short     i   = 0, last_char = -1;
-    FT_Vector akerning, adjust;
-    char      esc;
+    FT_Data              *FT = (FT_Data *) pls->FT;
+    short                i   = 0, last_char = -1;
+    FT_Vector            akerning, adjust;
+    char                 esc;
+    const FT_CachedGlyph *glyph;
 
     plgesc( &esc );
 
@@ -404,12 +415,12 @@ FT_WriteStrW( PLStream *pls, const PLUNICODE *text, short len, int x, int y )
             }
 
 
-            FT_Load_Char( FT->face, text[i], ( FT->smooth_text == 0 ) ? FT_LOAD_MONOCHROME + FT_LOAD_RENDER : FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT );
-            FT_PlotChar( pls, FT, FT->face->glyph,
+            glyph = FT_GetGlyph( pls, text[i], ( FT->smooth_text == 0 ) ? FT_LOAD_MONOCHROME + FT_LOAD_RENDER : FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT );
+            FT_PlotChar( pls, FT, glyph,
                 ROUND( x / 64.0 ), ROUND( y / 64.0 ) );          // render the text
 
-            x += (int) FT->face->glyph->advance.x;
-            y -= (int) FT->face->glyph->advance.y;
+            x += (int) glyph->advance.x;
+            y -= (int) glyph->advance.y;
 
             last_char = i;
         }
@@ -424,12 +435,12 @@ FT_WriteStrW( PLStream *pls, const PLUNICODE *text, short len, int x, int y )
 //--------------------------------------------------------------------------
 
 void
-FT_PlotChar( PLStream *pls, FT_Data *FT, FT_GlyphSlot slot,
+FT_PlotChar( PLStream *pls, FT_Data *FT, const FT_CachedGlyph *glyph,
              int x, int y )
 {
     unsigned char bittest;
     short         i, k, j;
-    int           n = slot->bitmap.pitch;
+    int           n = glyph->bitmap.pitch;
     int           current_pixel_colour;
     int           R, G, B;
     PLFLT         alpha_a;
@@ -501,14 +512,14 @@ FT_PlotChar( PLStream *pls, FT_Data *FT, FT_GlyphSlot slot,
     // Comment this out as it fails for cases where we want to plot text
     // in the background font, i.e. example 24.
     //
-    //if ((slot->bitmap.pixel_mode==ft_pixel_mode_mono)||(pls->icol0==0)) {
-    if ( slot->bitmap.pixel_mode == ft_pixel_mode_mono )
+    //if ((glyph->bitmap.pixel_mode==ft_pixel_mode_mono)||(pls->icol0==0)) {
+    if ( glyph->bitmap.pixel_mode == ft_pixel_mode_mono )
     {
-        x += slot->bitmap_left;
-        y -= slot->bitmap_top;
+        x += glyph->left;
+        y -= glyph->top;
 
         imin = (short) MAX( 0, clipymin - y );
-        imax = (short) MIN( slot->bitmap.rows, clipymax - y );
+        imax = (short) MIN( glyph->bitmap.rows, clipymax - y );
         for ( i = imin; i < imax; i++ )
         {
             for ( k = 0; k < n; k++ )
@@ -516,7 +527,7 @@ FT_PlotChar( PLStream *pls, FT_Data *FT, FT_GlyphSlot slot,
                 bittest = 128;
                 for ( j = 0; j < 8; j++ )
                 {
-                    if ( ( bittest & (unsigned char) slot->bitmap.buffer[( i * n ) + k] ) == bittest )
+                    if ( ( bittest & (unsigned char) glyph->bitmap.buffer[( i * n ) + k] ) == bittest )
                     {
                         xx = x + ( k * 8 ) + j;
                         if ( ( xx >= clipxmin ) && ( xx <= clipxmax ) )
@@ -532,18 +543,18 @@ FT_PlotChar( PLStream *pls, FT_Data *FT, FT_GlyphSlot slot,
 
     else
     {
-        x += slot->bitmap_left;
-        y -= slot->bitmap_top;
+        x += glyph->left;
+        y -= glyph->top;
 
         imin = (short) MAX( 0, clipymin - y );
-        imax = (short) MIN( slot->bitmap.rows, clipymax - y );
+        imax = (short) MIN( glyph->bitmap.rows, clipymax - y );
         kmin = (short) MAX( 0, clipxmin - x );
-        kmax = (short) MIN( slot->bitmap.width, clipxmax - x );
+        kmax = (short) MIN( glyph->bitmap.width, clipxmax - x );
         for ( i = imin; i < imax; i++ )
         {
             for ( k = kmin; k < kmax; k++ )
             {
-                FT->shade = ( slot->bitmap.buffer[( i * slot->bitmap.width ) + k] );
+                FT->shade = ( glyph->bitmap.buffer[( i * glyph->bitmap.width ) + k] );
                 if ( FT->shade > 0 )
                 {
                     if ( ( FT->BLENDED_ANTIALIASING == 1 ) && ( FT->read_pixel != NULL ) )
@@ -680,6 +691,10 @@ void plD_FreeType_init( PLStream *pls )
     // set to an impossible value for an FCI
     FT->fci = PL_FCI_IMPOSSIBLE;
 
+    FT->cache_max_bytes = FT_CACHE_SIZE;
+    if ( ( a = getenv( "PLPLOT_FREETYPE_CACHE_SIZE" ) ) != NULL )
+        FT->cache_max_bytes = (size_t) MAX( atol( a ), 0 );
+
 #if defined ( MSDOS ) || defined ( WIN32 )
 
 // First check for a user customised location and if
@@ -855,11 +870,231 @@ void FT_SetFace( PLStream *pls, PLUNICODE fci )
                 FT_Select_Charmap( FT->face, FT->face->charmaps[0]->encoding );
         }
     }
-    FT_Set_Char_Size( FT->face, 0,
-        (FT_F26Dot6) ( font_size * 64 / TEXT_SCALING_FACTOR ), (FT_UInt) pls->xdpi,
+    FT->char_size = (FT_F26Dot6) ( font_size * 64 / TEXT_SCALING_FACTOR );
+    FT_Set_Char_Size( FT->face, 0, FT->char_size, (FT_UInt) pls->xdpi,
         (FT_UInt) pls->ydpi );
 }
 
+//--------------------------------------------------------------------------
+// FT_GetGlyph( PLStream *pls, PLUNICODE ch, FT_Int32 flags )
+//
+// Returns the glyph of ch in the current face, size and transformation,
+// loaded with the given FT_Load_Char flags.  The glyphs are taken from
+// the glyph cache if possible and kept there otherwise, dropping the
+// least recently used ones when the cache gets too big.  The cache keys
+// on the flags without FT_LOAD_RENDER, so the metrics of a glyph serve
+// both the measuring and the rendering of a string, and the bitmap is
+// only added to the glyph when it is first rendered.  The glyph is only
+// valid until the next call.
+//--------------------------------------------------------------------------
+
+static const FT_CachedGlyph *FT_GetGlyph( PLStream *pls, PLUNICODE ch, FT_Int32 flags )
+{
+    FT_Data        *FT = (FT_Data *) pls->FT;
+    FT_CachedGlyph key, *glyph = NULL;
+    FT_GlyphSlot   slot;
+    size_t         size;
+    unsigned long  h;
+
+    key.fci       = FT->fci;
+    key.ch        = ch;
+    key.char_size = FT->char_size;
+    key.xdpi      = (FT_UInt) FT->xdpi;
+    key.ydpi      = (FT_UInt) FT->ydpi;
+    key.matrix    = FT->matrix;
+    key.pos       = FT->pos;
+    key.flags     = flags & ~FT_LOAD_RENDER;
+
+    h = (unsigned long) ch;
+    h = h * 31 + (unsigned long) key.fci;
+    h = h * 31 + (unsigned long) key.char_size;
+    h = h * 31 + (unsigned long) key.xdpi;
+    h = h * 31 + (unsigned long) key.ydpi;
+    h = h * 31 + (unsigned long) key.matrix.xx;
+    h = h * 31 + (unsigned long) key.matrix.xy;
+    h = h * 31 + (unsigned long) key.matrix.yx;
+    h = h * 31 + (unsigned long) key.matrix.yy;
+    h = h * 31 + (unsigned long) key.flags;
+    key.hash = h;
+
+    if ( FT->cache_table != NULL )
+    {
+        for ( glyph = FT->cache_table[h % FT_CACHE_BUCKETS]; glyph != NULL; glyph = glyph->next )
+        {
+            if ( glyph->hash == h && glyph->ch == ch && glyph->fci == key.fci
+                 && glyph->char_size == key.char_size
+                 && glyph->xdpi == key.xdpi && glyph->ydpi == key.ydpi
+                 && glyph->matrix.xx == key.matrix.xx && glyph->matrix.xy == key.matrix.xy
+                 && glyph->matrix.yx == key.matrix.yx && glyph->matrix.yy == key.matrix.yy
+                 && glyph->pos.x == key.pos.x && glyph->pos.y == key.pos.y
+                 && glyph->flags == key.flags )
+            {
+                // move it to the front of the least recently used list
+                if ( glyph != FT->cache_newest )
+                {
+                    glyph->newer->older = glyph->older;
+                    if ( glyph->older != NULL )
+                        glyph->older->newer = glyph->newer;
+                    else
+                        FT->cache_oldest = glyph->newer;
+                    glyph->newer            = NULL;
+                    glyph->older            = FT->cache_newest;
+                    FT->cache_newest->newer = glyph;
+                    FT->cache_newest        = glyph;
+                }
+                break;
+            }
+        }
+        if ( glyph != NULL && ( glyph->rendered || !( flags & FT_LOAD_RENDER ) ) )
+        {
+            FT->cache_hits++;
+            return glyph;
+        }
+    }
+    FT->cache_misses++;
+
+    FT_Load_Char( FT->face, ch, flags );
+    slot = FT->face->glyph;
+
+    if ( glyph == NULL )
+    {
+        key.advance  = slot->advance;
+        key.width    = slot->metrics.width;
+        key.height   = slot->metrics.height;
+        key.left     = 0;
+        key.top      = 0;
+        key.rendered = 0;
+        memset( &key.bitmap, 0, sizeof ( FT_Bitmap ) );
+        key.bytes = sizeof ( FT_CachedGlyph );
+        key.next  = NULL;
+        key.newer = NULL;
+        key.older = NULL;
+
+        if ( key.bytes > FT->cache_max_bytes )
+        {
+            // Too big for the cache, so use the scratch glyph
+            glyph  = &FT->scratch;
+            *glyph = key;
+        }
+        else
+        {
+            if ( FT->cache_table == NULL )
+            {
+                if ( ( FT->cache_table = calloc( FT_CACHE_BUCKETS, sizeof ( FT_CachedGlyph * ) ) ) == NULL )
+                    plexit( "FT_GetGlyph: Insufficient memory" );
+            }
+            if ( ( glyph = malloc( sizeof ( FT_CachedGlyph ) ) ) == NULL )
+                plexit( "FT_GetGlyph: Insufficient memory" );
+            key.next  = FT->cache_table[h % FT_CACHE_BUCKETS];
+            key.older = FT->cache_newest;
+            *glyph    = key;
+
+            FT->cache_table[h % FT_CACHE_BUCKETS] = glyph;
+            if ( FT->cache_newest != NULL )
+                FT->cache_newest->newer = glyph;
+            else
+                FT->cache_oldest = glyph;
+            FT->cache_newest = glyph;
+            FT->cache_bytes += glyph->bytes;
+            FT_TrimGlyphs( FT );
+        }
+    }
+
+    if ( flags & FT_LOAD_RENDER )
+    {
+        // Add the bitmap to the glyph, which is the most recently used one
+        size = (size_t) abs( slot->bitmap.pitch ) * (size_t) slot->bitmap.rows;
+        if ( glyph == &FT->scratch || glyph->bytes + size > FT->cache_max_bytes )
+        {
+            // Too big for the cache, so use the scratch glyph and buffer
+            if ( size > FT->scratch_size )
+            {
+                if ( ( FT->scratch_buffer = realloc( FT->scratch_buffer, size ) ) == NULL )
+                    plexit( "FT_GetGlyph: Insufficient memory" );
+                FT->scratch_size = size;
+            }
+            if ( glyph != &FT->scratch )
+            {
+                FT->scratch       = *glyph;
+                FT->scratch.next  = NULL;
+                FT->scratch.newer = NULL;
+                FT->scratch.older = NULL;
+                glyph             = &FT->scratch;
+            }
+            glyph->bitmap        = slot->bitmap;
+            glyph->bitmap.buffer = FT->scratch_buffer;
+        }
+        else
+        {
+            glyph->bitmap        = slot->bitmap;
+            glyph->bitmap.buffer = NULL;
+            if ( size > 0 && ( glyph->bitmap.buffer = malloc( size ) ) == NULL )
+                plexit( "FT_GetGlyph: Insufficient memory" );
+            glyph->bytes    += size;
+            FT->cache_bytes += size;
+            FT_TrimGlyphs( FT );
+        }
+        glyph->left     = slot->bitmap_left;
+        glyph->top      = slot->bitmap_top;
+        glyph->rendered = 1;
+        if ( size > 0 )
+            memcpy( glyph->bitmap.buffer, slot->bitmap.buffer, size );
+    }
+    return glyph;
+}
+
+//--------------------------------------------------------------------------
+// FT_TrimGlyphs( FT_Data *FT )
+//
+// Drops the least recently used glyphs from the glyph cache until it
+// takes no more than cache_max_bytes.  The most recently used glyph is
+// never dropped, as it always fits by itself.
+//--------------------------------------------------------------------------
+
+static void FT_TrimGlyphs( FT_Data *FT )
+{
+    FT_CachedGlyph *old, **prev;
+
+    while ( FT->cache_bytes > FT->cache_max_bytes )
+    {
+        old = FT->cache_oldest;
+        for ( prev = &FT->cache_table[old->hash % FT_CACHE_BUCKETS]; *prev != old; prev = &( *prev )->next )
+            ;
+        *prev                   = old->next;
+        FT->cache_oldest        = old->newer;
+        FT->cache_oldest->older = NULL;
+        FT->cache_bytes        -= old->bytes;
+        free( old->bitmap.buffer );
+        free( old );
+    }
+}
+
+//--------------------------------------------------------------------------
+// FT_FreeGlyphs( FT_Data *FT )
+//
+// Empties the glyph cache.
+//--------------------------------------------------------------------------
+
+static void FT_FreeGlyphs( FT_Data *FT )
+{
+    FT_CachedGlyph *glyph, *older;
+
+    for ( glyph = FT->cache_newest; glyph != NULL; glyph = older )
+    {
+        older = glyph->older;
+        free( glyph->bitmap.buffer );
+        free( glyph );
+    }
+    free( FT->cache_table );
+    free( FT->scratch_buffer );
+    FT->cache_table    = NULL;
+    FT->cache_newest   = NULL;
+    FT->cache_oldest   = NULL;
+    FT->cache_bytes    = 0;
+    FT->scratch_buffer = NULL;
+    FT->scratch_size   = 0;
+}
+
 //--------------------------------------------------------------------------
 // plD_render_freetype_text()
 //
@@ -1109,8 +1344,8 @@ void plD_render_freetype_text( PLStream *pls, EscText *args )
             if ( ( args->unicode_array_len == 2 )
                  && ( args->unicode_array[0] == ( PL_FCI_MARK | 0x004 ) ) )
             {
-                adjust.x = (FT_Pos) ( args->just * ROUND( (PLFLT) FT->face->glyph->metrics.width / 64.0 ) );
-                adjust.y = (FT_Pos) ROUND( (PLFLT) FT->face->glyph->metrics.height / 128.0 );
+                adjust.x = (FT_Pos) ( args->just * ROUND( (PLFLT) FT->glyph_width / 64.0 ) );
+                adjust.y = (FT_Pos) ROUND( (PLFLT) FT->glyph_height / 128.0 );
             }
             else
             {
@@ -1167,6 +1402,10 @@ void plD_FreeType_Destroy( PLStream *pls )
             plscmap0n( FT->ncol0_org );
         if ( FT->textbuf )
             free( FT->textbuf );
+        if ( pls->debug )
+            fprintf( stderr, "FreeType glyph cache: %lu hits, %lu misses\n",
+                FT->cache_hits, FT->cache_misses );
+        FT_FreeGlyphs( FT );
         FT_Done_Library( FT->library );
         free( pls->FT );
         pls->FT = NULL;
@@ -1255,10 +1494,11 @@ void pl_set_extended_cmap0( PLStream *pls, int ncol0_width, int ncol0_org )
 
 void plD_render_freetype_sym( PLStream *pls, EscText *args )
 {
-    FT_Data   *FT = (FT_Data *) pls->FT;
-    int       x, y;
-    FT_Vector adjust;
-    PLUNICODE fci;
+    FT_Data              *FT = (FT_Data *) pls->FT;
+    int                  x, y;
+    FT_Vector            adjust;
+    PLUNICODE            fci;
+    const FT_CachedGlyph *glyph;
 
     if ( FT->scale != 0.0 )    // scale was set
     {
@@ -1313,7 +1553,7 @@ void plD_render_freetype_sym( PLStream *pls, EscText *args )
     FT = (FT_Data *) pls->FT;
     FT_Set_Transform( FT->face, &FT->matrix, &FT->pos );
 
-    FT_Load_Char( FT->face, args->unicode_char, ( FT->smooth_text == 0 ) ? FT_LOAD_MONOCHROME + FT_LOAD_RENDER : FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT );
+    glyph = FT_GetGlyph( pls, args->unicode_char, ( FT->smooth_text == 0 ) ? FT_LOAD_MONOCHROME + FT_LOAD_RENDER : FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT );
 
 //
 // Now we have to try and componsate for the fact that the freetype glyphs are left
@@ -1323,8 +1563,8 @@ void plD_render_freetype_sym( PLStream *pls, EscText *args )
 // but it is as good a way as I can think of.
 //
 
-    x -= (int) ( ( FT->face->glyph->advance.x >> 6 ) / 2 );
-    FT_PlotChar( pls, FT, FT->face->glyph, x, y ); // render the text
+    x -= (int) ( ( glyph->advance.x >> 6 ) / 2 );
+    FT_PlotChar( pls, FT, glyph, x, y ); // render the text
 }
 
 
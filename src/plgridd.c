@@ -72,11 +72,6 @@ grid_dtli( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
            PLF2OPS zops, PLPointer zgp );
 #endif
 
-static void
-dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts, int knn_order );
-static void
-dist2( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts );
-
 #define KNN_MAX_ORDER    100
 
 typedef struct pt
@@ -85,7 +80,33 @@ typedef struct pt
     int   item;
 }PT;
 
-static PT items[KNN_MAX_ORDER];
+// Uniform bucket grid over the data points, used to speed up the
+// nearest neighbour searches.  The indices of the points falling in
+// bucket b = cy * nx + cx are pts[start[b]] ... pts[start[b + 1] - 1].
+
+typedef struct grid_index
+{
+    PLFLT xmin, ymin; // bounding box of the data points
+    PLFLT xmax, ymax;
+    PLFLT dx, dy;     // bucket width and height
+    PLFLT xeps, yeps; // slack allowed for rounding in the bucket bounds
+    int   nx, ny;     // number of buckets in x and y
+    int   *start;
+    int   *pts;
+} GRID_INDEX;
+
+// Mean number of data points per bucket
+#define GRID_INDEX_BUCKET_SIZE    2
+
+static void
+grid_index_init( GRID_INDEX *gi, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts );
+static void
+grid_index_free( GRID_INDEX *gi );
+
+static void
+dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, const GRID_INDEX *gi, PT *items, int knn_order );
+static void
+dist2( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, const GRID_INDEX *gi, PT *items );
 
 //--------------------------------------------------------------------------
 //
@@ -278,7 +299,94 @@ grid_csa( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
 }
 #endif // WITH_CSA
 
-// Nearest Neighbors Inverse Distance Weighted, brute force approach.
+//
+// The nearest neighbors algorithms compute every grid node independently
+// of the others.  The columns of the grid (constant xg[i]) are handed out
+// to plP_nthreads() threads, each with its own KNN scratch items.  When
+// more than one thread is used the results are collected in a private
+// array and only stored through zops once all threads have finished.
+//
+
+typedef struct grid_nn
+{
+    PLFLT_VECTOR x, y, z;
+    PLFLT_VECTOR xg, yg;
+    int          nptsy;
+    GRID_INDEX   gi;
+    int          knn_order;
+    PLFLT        threshold;
+    PT           *items; // KNN_MAX_ORDER items per thread
+    PLFLT        *zt;    // results, if computed on several threads
+    PLF2OPS      zops;
+    PLPointer    zgp;
+    PLFLT ( *node )( const struct grid_nn *nn, PT *items, PLFLT gx, PLFLT gy );
+} GRID_NN;
+
+static void
+grid_nn_column( PLINT i, PLINT thread, PLPointer data )
+{
+    GRID_NN *nn    = (GRID_NN *) data;
+    PT      *items = nn->items + (size_t) thread * KNN_MAX_ORDER;
+    PLFLT   zv;
+    int     j;
+
+    for ( j = 0; j < nn->nptsy; j++ )
+    {
+        zv = ( *nn->node )( nn, items, nn->xg[i], nn->yg[j] );
+        if ( nn->zt != NULL )
+            nn->zt[(size_t) i * (size_t) nn->nptsy + (size_t) j] = zv;
+        else
+            nn->zops->set( nn->zgp, i, j, zv );
+    }
+}
+
+static void
+grid_nn_run( GRID_NN *nn, PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
+             PLFLT_VECTOR xg, int nptsx, PLFLT_VECTOR yg, int nptsy,
+             PLF2OPS zops, PLPointer zgp )
+{
+    PLINT nthreads;
+    int   i, j;
+
+    nn->x     = x;
+    nn->y     = y;
+    nn->z     = z;
+    nn->xg    = xg;
+    nn->yg    = yg;
+    nn->nptsy = nptsy;
+    nn->zops  = zops;
+    nn->zgp   = zgp;
+    nn->zt    = NULL;
+
+    nthreads = MIN( plP_nthreads(), nptsx );
+
+    if ( ( nn->items = (PT *) malloc( (size_t) nthreads * KNN_MAX_ORDER * sizeof ( PT ) ) ) == NULL )
+    {
+        plexit( "plgriddata: Insufficient memory" );
+    }
+    if ( nthreads > 1 &&
+         ( nn->zt = (PLFLT *) malloc( (size_t) nptsx * (size_t) nptsy * sizeof ( PLFLT ) ) ) == NULL )
+    {
+        plexit( "plgriddata: Insufficient memory" );
+    }
+
+    grid_index_init( &nn->gi, x, y, npts );
+
+    plP_parallel( nptsx, nthreads, grid_nn_column, nn );
+
+    if ( nn->zt != NULL )
+    {
+        for ( i = 0; i < nptsx; i++ )
+            for ( j = 0; j < nptsy; j++ )
+                zops->set( zgp, i, j, nn->zt[(size_t) i * (size_t) nptsy + (size_t) j] );
+        free( nn->zt );
+    }
+
+    grid_index_free( &nn->gi );
+    free( nn->items );
+}
+
+// Nearest Neighbors Inverse Distance Weighted.
 //
 // The z value at the grid position will be the weighted average
 // of the z values of the KNN points found. The weigth is the
@@ -286,13 +394,52 @@ grid_csa( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
 // neighbor.
 //
 
+static PLFLT
+nnidw_node( const GRID_NN *nn, PT *items, PLFLT gx, PLFLT gy )
+{
+    int   k;
+    PLFLT wi, nt, zv;
+#ifdef GMS
+    PLFLT md;
+#endif
+
+    dist1( gx, gy, nn->x, nn->y, &nn->gi, items, nn->knn_order );
+
+#ifdef GMS  // alternative weight coeficients. I Don't like the results
+    // find the maximum distance
+    md = items[0].dist;
+    for ( k = 1; k < nn->knn_order; k++ )
+        if ( items[k].dist > md )
+            md = items[k].dist;
+#endif
+    zv = 0.;
+    nt = 0.;
+
+    for ( k = 0; k < nn->knn_order; k++ )
+    {
+        if ( items[k].item == -1 ) // not enough neighbors found ?!
+            continue;
+#ifdef GMS
+        wi = ( md - items[k].dist ) / ( md * items[k].dist );
+        wi = wi * wi;
+#else
+        wi = 1. / ( items[k].dist * items[k].dist );
+#endif
+        zv += wi * nn->z[items[k].item];
+        nt += wi;
+    }
+    if ( nt != 0. )
+        return zv / nt;
+    else
+        return NaN;
+}
+
 static void
 grid_nnidw( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
             PLFLT_VECTOR xg, int nptsx, PLFLT_VECTOR yg, int nptsy,
             PLF2OPS zops, PLPointer zgp, int knn_order )
 {
-    int   i, j, k;
-    PLFLT wi, nt;
+    GRID_NN nn;
 
     if ( knn_order > KNN_MAX_ORDER )
     {
@@ -306,41 +453,9 @@ grid_nnidw( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
         knn_order = 15;;
     }
 
-    for ( i = 0; i < nptsx; i++ )
-    {
-        for ( j = 0; j < nptsy; j++ )
-        {
-            dist1( xg[i], yg[j], x, y, npts, knn_order );
-
-#ifdef GMS  // alternative weight coeficients. I Don't like the results
-            // find the maximum distance
-            md = items[0].dist;
-            for ( k = 1; k < knn_order; k++ )
-                if ( items[k].dist > md )
-                    md = items[k].dist;
-#endif
-            zops->set( zgp, i, j, 0.0 );
-            nt = 0.;
-
-            for ( k = 0; k < knn_order; k++ )
-            {
-                if ( items[k].item == -1 ) // not enough neighbors found ?!
-                    continue;
-#ifdef GMS
-                wi = ( md - items[k].dist ) / ( md * items[k].dist );
-                wi = wi * wi;
-#else
-                wi = 1. / ( items[k].dist * items[k].dist );
-#endif
-                zops->add( zgp, i, j, wi * z[items[k].item] );
-                nt += wi;
-            }
-            if ( nt != 0. )
-                zops->div( zgp, i, j, nt );
-            else
-                zops->set( zgp, i, j, NaN );
-        }
-    }
+    nn.knn_order = knn_order;
+    nn.node      = nnidw_node;
+    grid_nn_run( &nn, x, y, z, npts, xg, nptsx, yg, nptsy, zops, zgp );
 }
 
 // Nearest Neighbors Linear Interpolation
@@ -349,79 +464,65 @@ grid_nnidw( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
 // plane passing through the 3 nearest neighbors.
 //
 
-static void
-grid_nnli( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
-           PLFLT_VECTOR xg, int nptsx, PLFLT_VECTOR yg, int nptsy,
-           PLF2OPS zops, PLPointer zgp, PLFLT threshold )
+static PLFLT
+nnli_node( const GRID_NN *nn, PT *items, PLFLT gx, PLFLT gy )
 {
-    PLFLT xx[4], yy[4], zz[4], t, A, B, C, D, d1, d2, d3, max_thick;
-    int   i, j, ii, excl, cnt, excl_item;
+    PLFLT_VECTOR x = nn->x, y = nn->y, z = nn->z;
+    PLFLT        xx[4], yy[4], zz[4], t, A, B, C, D, d1, d2, d3, max_thick, zv;
+    int          ii, excl, cnt, excl_item;
 
-    if ( threshold == 0. )
+    dist1( gx, gy, x, y, &nn->gi, items, 3 );
+
+    // see if the triangle is a thin one
+    for ( ii = 0; ii < 3; ii++ )
     {
-        plwarn( "plgriddata(): GRID_NNLI: threshold must be specified with 'data' arg. Using 1.001" );
-        threshold = 1.001;
+        xx[ii] = x[items[ii].item];
+        yy[ii] = y[items[ii].item];
+        zz[ii] = z[items[ii].item];
     }
-    else if ( threshold > 2. || threshold < 1. )
+
+    d1 = sqrt( ( xx[1] - xx[0] ) * ( xx[1] - xx[0] ) + ( yy[1] - yy[0] ) * ( yy[1] - yy[0] ) );
+    d2 = sqrt( ( xx[2] - xx[1] ) * ( xx[2] - xx[1] ) + ( yy[2] - yy[1] ) * ( yy[2] - yy[1] ) );
+    d3 = sqrt( ( xx[0] - xx[2] ) * ( xx[0] - xx[2] ) + ( yy[0] - yy[2] ) * ( yy[0] - yy[2] ) );
+
+    if ( d1 == 0. || d2 == 0. || d3 == 0. ) // coincident points
     {
-        plabort( "plgriddata(): GRID_NNLI: 1. < threshold < 2." );
-        return;
+        zv = NaN;
     }
-
-    for ( i = 0; i < nptsx; i++ )
+    else
     {
-        for ( j = 0; j < nptsy; j++ )
+        // make d1 < d2
+        if ( d1 > d2 )
         {
-            dist1( xg[i], yg[j], x, y, npts, 3 );
-
-            // see if the triangle is a thin one
-            for ( ii = 0; ii < 3; ii++ )
-            {
-                xx[ii] = x[items[ii].item];
-                yy[ii] = y[items[ii].item];
-                zz[ii] = z[items[ii].item];
-            }
-
-            d1 = sqrt( ( xx[1] - xx[0] ) * ( xx[1] - xx[0] ) + ( yy[1] - yy[0] ) * ( yy[1] - yy[0] ) );
-            d2 = sqrt( ( xx[2] - xx[1] ) * ( xx[2] - xx[1] ) + ( yy[2] - yy[1] ) * ( yy[2] - yy[1] ) );
-            d3 = sqrt( ( xx[0] - xx[2] ) * ( xx[0] - xx[2] ) + ( yy[0] - yy[2] ) * ( yy[0] - yy[2] ) );
-
-            if ( d1 == 0. || d2 == 0. || d3 == 0. ) // coincident points
-            {
-                zops->set( zgp, i, j, NaN );
-                continue;
-            }
-
-            // make d1 < d2
-            if ( d1 > d2 )
-            {
-                t = d1; d1 = d2; d2 = t;
-            }
+            t = d1; d1 = d2; d2 = t;
+        }
 
-            // and d2 < d3
-            if ( d2 > d3 )
-            {
-                t = d2; d2 = d3; d3 = t;
-            }
+        // and d2 < d3
+        if ( d2 > d3 )
+        {
+            t = d2; d2 = d3; d3 = t;
+        }
 
-            if ( ( d1 + d2 ) / d3 < threshold ) // thin triangle!
-            {
-                zops->set( zgp, i, j, NaN );    // deal with it later
-            }
-            else                                // calculate the plane passing through the three points
+        if ( ( d1 + d2 ) / d3 < nn->threshold ) // thin triangle!
+        {
+            zv = NaN;                           // deal with it below
+        }
+        else                                    // calculate the plane passing through the three points
 
-            {
-                A = yy[0] * ( zz[1] - zz[2] ) + yy[1] * ( zz[2] - zz[0] ) + yy[2] * ( zz[0] - zz[1] );
-                B = zz[0] * ( xx[1] - xx[2] ) + zz[1] * ( xx[2] - xx[0] ) + zz[2] * ( xx[0] - xx[1] );
-                C = xx[0] * ( yy[1] - yy[2] ) + xx[1] * ( yy[2] - yy[0] ) + xx[2] * ( yy[0] - yy[1] );
-                D = -A * xx[0] - B * yy[0] - C * zz[0];
+        {
+            A = yy[0] * ( zz[1] - zz[2] ) + yy[1] * ( zz[2] - zz[0] ) + yy[2] * ( zz[0] - zz[1] );
+            B = zz[0] * ( xx[1] - xx[2] ) + zz[1] * ( xx[2] - xx[0] ) + zz[2] * ( xx[0] - xx[1] );
+            C = xx[0] * ( yy[1] - yy[2] ) + xx[1] * ( yy[2] - yy[0] ) + xx[2] * ( yy[0] - yy[1] );
+            D = -A * xx[0] - B * yy[0] - C * zz[0];
 
-                // and interpolate (or extrapolate...)
-                zops->set( zgp, i, j, -xg[i] * A / C - yg[j] * B / C - D / C );
-            }
+            // and interpolate (or extrapolate...)
+            zv = -gx * A / C - gy * B / C - D / C;
         }
     }
 
+    if ( !isnan( zv ) )
+        return zv;
+
     // now deal with NaNs resulting from thin triangles. The idea is
     // to use the 4 KNN points and exclude one at a time, creating
     // four triangles, evaluating their thickness and choosing the
@@ -431,135 +532,243 @@ grid_nnli( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
     // the candidate triangle... otherwise one is extrapolating
     //
 
+    dist1( gx, gy, x, y, &nn->gi, items, 4 );
+
+    // sort by distances. Not really needed!
+    // for (ii=3; ii>0; ii--) {
+    // for (jj=0; jj<ii; jj++) {
+    // if (items[jj].dist > items[jj+1].dist) {
+    // t = items[jj].dist;
+    // items[jj].dist = items[jj+1].dist;
+    // items[jj+1].dist = t;
+    // }
+    // }
+    // }
+    //
+
+    max_thick = 0.; excl_item = -1;
+    for ( excl = 0; excl < 4; excl++ ) // the excluded point
+
     {
-        for ( i = 0; i < nptsx; i++ )
+        cnt = 0;
+        for ( ii = 0; ii < 4; ii++ )
         {
-            for ( j = 0; j < nptsy; j++ )
+            if ( ii != excl )
             {
-                if ( zops->is_nan( zgp, i, j ) )
-                {
-                    dist1( xg[i], yg[j], x, y, npts, 4 );
-
-                    // sort by distances. Not really needed!
-                    // for (ii=3; ii>0; ii--) {
-                    // for (jj=0; jj<ii; jj++) {
-                    // if (items[jj].dist > items[jj+1].dist) {
-                    // t = items[jj].dist;
-                    // items[jj].dist = items[jj+1].dist;
-                    // items[jj+1].dist = t;
-                    // }
-                    // }
-                    // }
-                    //
+                xx[cnt] = x[items[ii].item];
+                yy[cnt] = y[items[ii].item];
+                cnt++;
+            }
+        }
 
-                    max_thick = 0.; excl_item = -1;
-                    for ( excl = 0; excl < 4; excl++ ) // the excluded point
+        d1 = sqrt( ( xx[1] - xx[0] ) * ( xx[1] - xx[0] ) + ( yy[1] - yy[0] ) * ( yy[1] - yy[0] ) );
+        d2 = sqrt( ( xx[2] - xx[1] ) * ( xx[2] - xx[1] ) + ( yy[2] - yy[1] ) * ( yy[2] - yy[1] ) );
+        d3 = sqrt( ( xx[0] - xx[2] ) * ( xx[0] - xx[2] ) + ( yy[0] - yy[2] ) * ( yy[0] - yy[2] ) );
+        if ( d1 == 0. || d2 == 0. || d3 == 0. ) // coincident points
+            continue;
 
-                    {
-                        cnt = 0;
-                        for ( ii = 0; ii < 4; ii++ )
-                        {
-                            if ( ii != excl )
-                            {
-                                xx[cnt] = x[items[ii].item];
-                                yy[cnt] = y[items[ii].item];
-                                cnt++;
-                            }
-                        }
+        // make d1 < d2
+        if ( d1 > d2 )
+        {
+            t = d1; d1 = d2; d2 = t;
+        }
+        // and d2 < d3
+        if ( d2 > d3 )
+        {
+            t = d2; d2 = d3; d3 = t;
+        }
 
-                        d1 = sqrt( ( xx[1] - xx[0] ) * ( xx[1] - xx[0] ) + ( yy[1] - yy[0] ) * ( yy[1] - yy[0] ) );
-                        d2 = sqrt( ( xx[2] - xx[1] ) * ( xx[2] - xx[1] ) + ( yy[2] - yy[1] ) * ( yy[2] - yy[1] ) );
-                        d3 = sqrt( ( xx[0] - xx[2] ) * ( xx[0] - xx[2] ) + ( yy[0] - yy[2] ) * ( yy[0] - yy[2] ) );
-                        if ( d1 == 0. || d2 == 0. || d3 == 0. ) // coincident points
-                            continue;
+        t = ( d1 + d2 ) / d3;
+        if ( t > max_thick )
+        {
+            max_thick = t;
+            excl_item = excl;
+        }
+    }
 
-                        // make d1 < d2
-                        if ( d1 > d2 )
-                        {
-                            t = d1; d1 = d2; d2 = t;
-                        }
-                        // and d2 < d3
-                        if ( d2 > d3 )
-                        {
-                            t = d2; d2 = d3; d3 = t;
-                        }
+    if ( excl_item == -1 ) // all points are coincident?
+        return zv;
 
-                        t = ( d1 + d2 ) / d3;
-                        if ( t > max_thick )
-                        {
-                            max_thick = t;
-                            excl_item = excl;
-                        }
-                    }
+    // one has the thicker triangle constructed from the 4 KNN
+    cnt = 0;
+    for ( ii = 0; ii < 4; ii++ )
+    {
+        if ( ii != excl_item )
+        {
+            xx[cnt] = x[items[ii].item];
+            yy[cnt] = y[items[ii].item];
+            zz[cnt] = z[items[ii].item];
+            cnt++;
+        }
+    }
 
-                    if ( excl_item == -1 ) // all points are coincident?
-                        continue;
+    A = yy[0] * ( zz[1] - zz[2] ) + yy[1] * ( zz[2] - zz[0] ) + yy[2] * ( zz[0] - zz[1] );
+    B = zz[0] * ( xx[1] - xx[2] ) + zz[1] * ( xx[2] - xx[0] ) + zz[2] * ( xx[0] - xx[1] );
+    C = xx[0] * ( yy[1] - yy[2] ) + xx[1] * ( yy[2] - yy[0] ) + xx[2] * ( yy[0] - yy[1] );
+    D = -A * xx[0] - B * yy[0] - C * zz[0];
 
-                    // one has the thicker triangle constructed from the 4 KNN
-                    cnt = 0;
-                    for ( ii = 0; ii < 4; ii++ )
-                    {
-                        if ( ii != excl_item )
-                        {
-                            xx[cnt] = x[items[ii].item];
-                            yy[cnt] = y[items[ii].item];
-                            zz[cnt] = z[items[ii].item];
-                            cnt++;
-                        }
-                    }
+    // and interpolate (or extrapolate...)
+    return -gx * A / C - gy * B / C - D / C;
+}
 
-                    A = yy[0] * ( zz[1] - zz[2] ) + yy[1] * ( zz[2] - zz[0] ) + yy[2] * ( zz[0] - zz[1] );
-                    B = zz[0] * ( xx[1] - xx[2] ) + zz[1] * ( xx[2] - xx[0] ) + zz[2] * ( xx[0] - xx[1] );
-                    C = xx[0] * ( yy[1] - yy[2] ) + xx[1] * ( yy[2] - yy[0] ) + xx[2] * ( yy[0] - yy[1] );
-                    D = -A * xx[0] - B * yy[0] - C * zz[0];
+static void
+grid_nnli( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
+           PLFLT_VECTOR xg, int nptsx, PLFLT_VECTOR yg, int nptsy,
+           PLF2OPS zops, PLPointer zgp, PLFLT threshold )
+{
+    GRID_NN nn;
 
-                    // and interpolate (or extrapolate...)
-                    zops->set( zgp, i, j, -xg[i] * A / C - yg[j] * B / C - D / C );
-                }
-            }
-        }
+    if ( threshold == 0. )
+    {
+        plwarn( "plgriddata(): GRID_NNLI: threshold must be specified with 'data' arg. Using 1.001" );
+        threshold = 1.001;
     }
+    else if ( threshold > 2. || threshold < 1. )
+    {
+        plabort( "plgriddata(): GRID_NNLI: 1. < threshold < 2." );
+        return;
+    }
+
+    nn.threshold = threshold;
+    nn.node      = nnli_node;
+    grid_nn_run( &nn, x, y, z, npts, xg, nptsx, yg, nptsy, zops, zgp );
 }
 
 //
-// Nearest Neighbors "Around" Inverse Distance Weighted, brute force approach.
+// Nearest Neighbors "Around" Inverse Distance Weighted.
 //
 // This uses the 1-KNN in each quadrant around the grid point, then
 // Inverse Distance Weighted is used as in GRID_NNIDW.
 //
 
+static PLFLT
+nnaidw_node( const GRID_NN *nn, PT *items, PLFLT gx, PLFLT gy )
+{
+    PLFLT d, nt, zv;
+    int   k;
+
+    dist2( gx, gy, nn->x, nn->y, &nn->gi, items );
+    zv = 0.;
+    nt = 0.;
+    for ( k = 0; k < 4; k++ )
+    {
+        if ( items[k].item != -1 )                              // was found
+        {
+            d   = 1. / ( items[k].dist * items[k].dist );       // 1/square distance
+            zv += d * nn->z[items[k].item];
+            nt += d;
+        }
+    }
+    if ( nt == 0. ) // no points found?!
+        return NaN;
+    else
+        return zv / nt;
+}
+
 static void
 grid_nnaidw( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
              PLFLT_VECTOR xg, int nptsx, PLFLT_VECTOR yg, int nptsy, PLF2OPS zops, PLPointer zgp )
 {
-    PLFLT d, nt;
-    int   i, j, k;
+    GRID_NN nn;
 
-    for ( i = 0; i < nptsx; i++ )
+    nn.node = nnaidw_node;
+    grid_nn_run( &nn, x, y, z, npts, xg, nptsx, yg, nptsy, zops, zgp );
+}
+
+#ifdef PL_HAVE_QHULL
+//
+// Threaded interpolation of the grid points for GRID_DTLI and GRID_NNI.
+// The triangulation is built once and every thread gets its own shallow
+// copy of it (the point location and circle searches keep their state in
+// the delaunay structure) together with its own interpolator.  The rows
+// of the grid are the units of work.
+//
+
+typedef struct grid_dt
+{
+    delaunay *d;
+    delaunay **ds;    // per-thread copies of d
+    void     **interp; // per-thread lpi or nnpi
+    int      nni;
+    double   wtmin;
+    point    *pgrid;
+    int      nptsx;
+} GRID_DT;
+
+static void
+grid_dt_row( PLINT j, PLINT thread, PLPointer data )
+{
+    GRID_DT *dt = (GRID_DT *) data;
+    point   *pt = dt->pgrid + (size_t) j * (size_t) dt->nptsx;
+    int     i;
+
+    if ( dt->ds[thread] == NULL )
     {
-        for ( j = 0; j < nptsy; j++ )
+        dt->ds[thread] = delaunay_share( dt->d );
+        if ( dt->nni )
         {
-            dist2( xg[i], yg[j], x, y, npts );
-            zops->set( zgp, i, j, 0. );
-            nt = 0.;
-            for ( k = 0; k < 4; k++ )
-            {
-                if ( items[k].item != -1 )                              // was found
-                {
-                    d = 1. / ( items[k].dist * items[k].dist );         // 1/square distance
-                    zops->add( zgp, i, j, d * z[items[k].item] );
-                    nt += d;
-                }
-            }
-            if ( nt == 0. ) // no points found?!
-                zops->set( zgp, i, j, NaN );
-            else
-                zops->div( zgp, i, j, nt );
+            dt->interp[thread] = nnpi_create( dt->ds[thread] );
+            nnpi_setwmin( (nnpi *) dt->interp[thread], dt->wtmin );
         }
+        else
+            dt->interp[thread] = lpi_build( dt->ds[thread] );
+    }
+
+    for ( i = 0; i < dt->nptsx; i++ )
+    {
+        if ( dt->nni )
+            nnpi_interpolate_point( (nnpi *) dt->interp[thread], &pt[i] );
+        else
+            lpi_interpolate_point( (lpi *) dt->interp[thread], &pt[i] );
     }
 }
 
-#ifdef PL_HAVE_QHULL
+static void
+grid_dt_interpolate( int npts, point *pin, int nptsx, int nptsy, point *pgrid,
+                     int nni, double wtmin )
+{
+    GRID_DT dt;
+    PLINT   nthreads = MIN( plP_nthreads(), nptsy );
+    int     k;
+
+    if ( nthreads <= 1 )
+    {
+        if ( nni )
+            nnpi_interpolate_points( npts, pin, wtmin, nptsx * nptsy, pgrid );
+        else
+            lpi_interpolate_points( npts, pin, nptsx * nptsy, pgrid );
+        return;
+    }
+
+    if ( ( dt.ds = (delaunay **) calloc( (size_t) nthreads, sizeof ( delaunay * ) ) ) == NULL ||
+         ( dt.interp = (void **) calloc( (size_t) nthreads, sizeof ( void * ) ) ) == NULL )
+    {
+        plexit( "plgriddata: Insufficient memory" );
+    }
+
+    dt.d     = delaunay_build( npts, pin, 0, NULL, 0, NULL );
+    dt.nni   = nni;
+    dt.wtmin = wtmin;
+    dt.pgrid = pgrid;
+    dt.nptsx = nptsx;
+
+    plP_parallel( nptsy, nthreads, grid_dt_row, &dt );
+
+    for ( k = 0; k < nthreads; k++ )
+    {
+        if ( dt.ds[k] == NULL )
+            continue;
+        if ( nni )
+            nnpi_destroy( (nnpi *) dt.interp[k] );
+        else
+            lpi_destroy( (lpi *) dt.interp[k] );
+        delaunay_destroy_shared( dt.ds[k] );
+    }
+    delaunay_destroy( dt.d );
+    free( dt.ds );
+    free( dt.interp );
+}
+
 //
 // Delaunay Triangulation Linear Interpolation using Pavel Sakov's nn package
 //
@@ -623,7 +832,7 @@ grid_dtli( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
         yt++;
     }
 
-    lpi_interpolate_points( npts, pin, nptsg, pgrid );
+    grid_dt_interpolate( npts, pin, nptsx, nptsy, pgrid, 0, 0. );
     for ( i = 0; i < nptsx; i++ )
     {
         for ( j = 0; j < nptsy; j++ )
@@ -704,7 +913,7 @@ grid_nni( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
         yt++;
     }
 
-    nnpi_interpolate_points( npts, pin, wtmin, nptsg, pgrid );
+    grid_dt_interpolate( npts, pin, nptsx, nptsy, pgrid, 1, wtmin );
     for ( i = 0; i < nptsx; i++ )
     {
         for ( j = 0; j < nptsy; j++ )
@@ -719,16 +928,156 @@ grid_nni( PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, int npts,
 }
 #endif // PL_HAVE_QHULL
 
+//
+// Build the bucket grid used by dist1() and dist2().  Points with
+// non-finite coordinates can never be a nearest neighbour, so they are
+// left out of the index.
+//
+
+static int
+grid_index_cell( PLFLT v, PLFLT vmin, PLFLT dv, int n )
+{
+    PLFLT t = ( v - vmin ) / dv;
+
+    if ( !( t >= 0. ) ) // also catches NaN
+        return 0;
+    if ( t >= (PLFLT) n )
+        return n - 1;
+    return (int) t;
+}
+
+static void
+grid_index_init( GRID_INDEX *gi, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts )
+{
+    PLFLT w, h;
+    int   i, b, nb, nfinite, *cell;
+
+    gi->xmin = gi->ymin = PLFLT_MAX;
+    gi->xmax = gi->ymax = -PLFLT_MAX;
+    nfinite  = 0;
+    for ( i = 0; i < npts; i++ )
+    {
+        if ( !isfinite( x[i] ) || !isfinite( y[i] ) )
+            continue;
+        gi->xmin = MIN( gi->xmin, x[i] );
+        gi->ymin = MIN( gi->ymin, y[i] );
+        gi->xmax = MAX( gi->xmax, x[i] );
+        gi->ymax = MAX( gi->ymax, y[i] );
+        nfinite++;
+    }
+
+    if ( nfinite == 0 )
+    {
+        gi->xmin = gi->ymin = 0.;
+        gi->xmax = gi->ymax = 0.;
+    }
+
+    // Choose the bucket layout so that the buckets are roughly square
+    w  = gi->xmax - gi->xmin;
+    h  = gi->ymax - gi->ymin;
+    nb = MAX( nfinite / GRID_INDEX_BUCKET_SIZE, 1 );
+    if ( w > 0. && h > 0. )
+    {
+        gi->nx = (int) sqrt( (PLFLT) nb * w / h );
+        gi->nx = MIN( MAX( gi->nx, 1 ), nb );
+        gi->ny = MAX( nb / gi->nx, 1 );
+    }
+    else if ( w > 0. )
+    {
+        gi->nx = nb;
+        gi->ny = 1;
+    }
+    else
+    {
+        gi->nx = 1;
+        gi->ny = h > 0. ? nb : 1;
+    }
+
+    gi->dx   = w > 0. ? w / gi->nx : 1.;
+    gi->dy   = h > 0. ? h / gi->ny : 1.;
+    gi->xeps = 1e-9 * gi->dx;
+    gi->yeps = 1e-9 * gi->dy;
+
+    nb = gi->nx * gi->ny;
+    if ( ( gi->start = (int *) calloc( (size_t) nb + 1, sizeof ( int ) ) ) == NULL ||
+         ( gi->pts = (int *) malloc( (size_t) MAX( nfinite, 1 ) * sizeof ( int ) ) ) == NULL ||
+         ( cell = (int *) malloc( (size_t) MAX( npts, 1 ) * sizeof ( int ) ) ) == NULL )
+    {
+        plexit( "plgriddata: Insufficient memory" );
+    }
+
+    // Counting sort of the point indices by bucket
+    for ( i = 0; i < npts; i++ )
+    {
+        if ( !isfinite( x[i] ) || !isfinite( y[i] ) )
+        {
+            cell[i] = -1;
+            continue;
+        }
+        cell[i] = grid_index_cell( y[i], gi->ymin, gi->dy, gi->ny ) * gi->nx +
+                  grid_index_cell( x[i], gi->xmin, gi->dx, gi->nx );
+        gi->start[cell[i] + 1]++;
+    }
+    for ( b = 0; b < nb; b++ )
+        gi->start[b + 1] += gi->start[b];
+
+    // Fill in increasing index order, so each bucket is sorted too
+    for ( i = 0; i < npts; i++ )
+    {
+        if ( cell[i] >= 0 )
+            gi->pts[gi->start[cell[i]]++] = i;
+    }
+    for ( b = nb; b > 0; b-- )
+        gi->start[b] = gi->start[b - 1];
+    gi->start[0] = 0;
+
+    free( cell );
+}
+
+static void
+grid_index_free( GRID_INDEX *gi )
+{
+    free( gi->start );
+    free( gi->pts );
+}
+
+//
+// Lower bound for the squared distance between [gx, gy] and any point
+// stored in bucket [cx, cy].
+//
+
+static PLFLT
+grid_index_bound( const GRID_INDEX *gi, PLFLT gx, PLFLT gy, int cx, int cy )
+{
+    PLFLT x0, x1, y0, y1, ddx, ddy;
+
+    x0 = gi->xmin + cx * gi->dx - gi->xeps;
+    x1 = gi->xmin + ( cx + 1 ) * gi->dx + gi->xeps;
+    y0 = gi->ymin + cy * gi->dy - gi->yeps;
+    y1 = gi->ymin + ( cy + 1 ) * gi->dy + gi->yeps;
+
+    ddx = gx < x0 ? x0 - gx : ( gx > x1 ? gx - x1 : 0. );
+    ddy = gy < y0 ? y0 - gy : ( gy > y1 ? gy - y1 : 0. );
+
+    return ddx * ddx + ddy * ddy;
+}
+
 //
 // this function just calculates the K Nearest Neighbors of grid point
 // [gx, gy].
 //
+// The buckets are visited in square rings of increasing size around the
+// bucket holding the grid point, until no bucket of a ring can hold a
+// point closer than the current K-th neighbor.  Ties in distance are
+// resolved in favour of the lower point index, so the neighbors found
+// are the same as those of an exhaustive search.
+//
 
 static void
-dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts, int knn_order )
+dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, const GRID_INDEX *gi, PT *items, int knn_order )
 {
-    PLFLT d, max_dist;
-    int   max_slot, i, j;
+    PLFLT d, max_dist, bound, ring_min;
+    int   max_slot, i, j, k, n, r, rmax, cx, cy, bx, by, step;
 
     max_dist = PLFLT_MAX;
     max_slot = 0;
@@ -739,32 +1088,65 @@ dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts, int knn_ord
         items[i].item = -1;
     }
 
-    for ( i = 0; i < npts; i++ )
-    {
-        d = ( ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] ) ); // save sqrt() time
+    cx   = grid_index_cell( gx, gi->xmin, gi->dx, gi->nx );
+    cy   = grid_index_cell( gy, gi->ymin, gi->dy, gi->ny );
+    rmax = MAX( MAX( cx, gi->nx - 1 - cx ), MAX( cy, gi->ny - 1 - cy ) );
 
-        if ( d < max_dist )
+    for ( r = 0; r <= rmax; r++ )
+    {
+        ring_min = PLFLT_MAX;
+        for ( by = MAX( cy - r, 0 ); by <= MIN( cy + r, gi->ny - 1 ); by++ )
         {
-            // found an item with a distance smaller than the
-            // maximum distance found so far. Replace.
-            //
+            // whole row on the top and bottom of the ring, the two
+            // end buckets otherwise
+            step = ( r == 0 || by == cy - r || by == cy + r ) ? 1 : 2 * r;
+            for ( bx = cx - r; bx <= cx + r; bx += step )
+            {
+                if ( bx < 0 || bx >= gi->nx )
+                    continue;
 
-            items[max_slot].dist = d;
-            items[max_slot].item = i;
+                bound    = grid_index_bound( gi, gx, gy, bx, by );
+                ring_min = MIN( ring_min, bound );
+                if ( bound > max_dist )
+                    continue;
 
-            // find new maximum distance
-            max_dist = items[0].dist;
-            max_slot = 0;
-            for ( j = 1; j < knn_order; j++ )
-            {
-                if ( items[j].dist > max_dist )
+                n = by * gi->nx + bx;
+                for ( k = gi->start[n]; k < gi->start[n + 1]; k++ )
                 {
-                    max_dist = items[j].dist;
-                    max_slot = j;
+                    i = gi->pts[k];
+                    d = ( ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] ) ); // save sqrt() time
+
+                    if ( d < max_dist || ( d == max_dist && i < items[max_slot].item ) )
+                    {
+                        // found an item closer than the farthest one
+                        // found so far. Replace.
+                        //
+
+                        items[max_slot].dist = d;
+                        items[max_slot].item = i;
+
+                        // find new farthest item
+                        max_dist = items[0].dist;
+                        max_slot = 0;
+                        for ( j = 1; j < knn_order; j++ )
+                        {
+                            if ( items[j].dist > max_dist ||
+                                 ( items[j].dist == max_dist && items[j].item > items[max_slot].item ) )
+                            {
+                                max_dist = items[j].dist;
+                                max_slot = j;
+                            }
+                        }
+                    }
                 }
             }
         }
+
+        // rings further out are at least as far away as this one
+        if ( ring_min > max_dist )
+            break;
     }
+
     for ( j = 0; j < knn_order; j++ )
         items[j].dist = sqrt( items[j].dist ); // now calculate the distance
 }
@@ -775,10 +1157,11 @@ dist1( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts, int knn_ord
 //
 
 static void
-dist2( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts )
+dist2( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, const GRID_INDEX *gi, PT *items )
 {
-    PLFLT d;
-    int   i, quad;
+    PLFLT d, bound, limit, ring_min;
+    int   i, k, n, r, rmax, quad, cx, cy, bx, by, step, done;
+    int   rquad[4];
 
     for ( i = 0; i < 4; i++ )
     {
@@ -786,25 +1169,78 @@ dist2( PLFLT gx, PLFLT gy, PLFLT_VECTOR x, PLFLT_VECTOR y, int npts )
         items[i].item = -1;
     }
 
-    for ( i = 0; i < npts; i++ )
+    cx = grid_index_cell( gx, gi->xmin, gi->dx, gi->nx );
+    cy = grid_index_cell( gy, gi->ymin, gi->dy, gi->ny );
+
+    // ring beyond which there are no more buckets in each quadrant, or
+    // -1 if the quadrant lies outside the bucket grid altogether
+    for ( quad = 0; quad < 4; quad++ )
     {
-        d = ( ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] ) ); // save sqrt() time
+        if ( ( ( quad & 2 ) ? gx >= gi->xmax : gx < gi->xmin ) ||
+             ( ( quad & 1 ) ? gy <= gi->ymin : gy > gi->ymax ) )
+            rquad[quad] = -1;
+        else
+            rquad[quad] = MAX( ( quad & 2 ) ? gi->nx - 1 - cx : cx,
+                ( quad & 1 ) ? cy : gi->ny - 1 - cy );
+    }
+    rmax = MAX( MAX( rquad[0], rquad[1] ), MAX( rquad[2], rquad[3] ) );
+
+    limit = PLFLT_MAX;
+    for ( r = 0; r <= rmax; r++ )
+    {
+        ring_min = PLFLT_MAX;
+        for ( by = MAX( cy - r, 0 ); by <= MIN( cy + r, gi->ny - 1 ); by++ )
+        {
+            step = ( r == 0 || by == cy - r || by == cy + r ) ? 1 : 2 * r;
+            for ( bx = cx - r; bx <= cx + r; bx += step )
+            {
+                if ( bx < 0 || bx >= gi->nx )
+                    continue;
+
+                bound    = grid_index_bound( gi, gx, gy, bx, by );
+                ring_min = MIN( ring_min, bound );
+                if ( bound > limit )
+                    continue;
+
+                n = by * gi->nx + bx;
+                for ( k = gi->start[n]; k < gi->start[n + 1]; k++ )
+                {
+                    i = gi->pts[k];
+                    d = ( ( gx - x[i] ) * ( gx - x[i] ) + ( gy - y[i] ) * ( gy - y[i] ) ); // save sqrt() time
 
-        // trick to quickly compute a quadrant. The determined quadrants will be
-        // miss-assigned, i.e., 1->2, 2->0, 3->1, 4->3, but that is not important,
-        // speed is.
+                    // trick to quickly compute a quadrant. The determined quadrants will be
+                    // miss-assigned, i.e., 1->2, 2->0, 3->1, 4->3, but that is not important,
+                    // speed is.
 
-        quad = 2 * ( x[i] > gx ) + ( y[i] < gy );
+                    quad = 2 * ( x[i] > gx ) + ( y[i] < gy );
 
-        // try to use the octants around the grid point, as it will give smoother
-        // (and slower) results.
-        // Hint: use the quadrant info plus x[i]/y[i] to determine the octant
+                    // try to use the octants around the grid point, as it will give smoother
+                    // (and slower) results.
+                    // Hint: use the quadrant info plus x[i]/y[i] to determine the octant
 
-        if ( d < items[quad].dist )
+                    if ( d < items[quad].dist || ( d == items[quad].dist && i < items[quad].item ) )
+                    {
+                        items[quad].dist = d;
+                        items[quad].item = i;
+                    }
+                }
+            }
+        }
+
+        // A quadrant is finished when it has no buckets left or when
+        // its nearest point is closer than anything in further rings.
+        done  = 1;
+        limit = 0.;
+        for ( quad = 0; quad < 4; quad++ )
         {
-            items[quad].dist = d;
-            items[quad].item = i;
+            if ( r < rquad[quad] && ring_min <= items[quad].dist )
+            {
+                done  = 0;
+                limit = MAX( limit, items[quad].dist );
+            }
         }
+        if ( done )
+            break;
     }
 
     for ( i = 0; i < 4; i++ )
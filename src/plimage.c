@@ -98,10 +98,18 @@ plimageslow( PLFLT *idata, PLINT nx, PLINT ny,
     PLFLT xf[4], yf[4];
     // Translated (by pltr) coordinates
     PLFLT tx, ty;
-    // The corners of a single filled region
-    // int corners[4]; - unreferenced
-    // The color to use in the fill
-    PLFLT color;
+    // The cmap1 indices of the cells and the one currently set
+    unsigned short *z;
+    PLINT          icol1 = -1;
+
+    // The color values are scaled to 0.0 -> 1.0 plcol1 color values, and
+    // all mapped at once.  Values that are not plotted, COLOR_NO_PLOT,
+    // get an index above any cmap1 index.
+    if ( ( z = (unsigned short *) malloc( (size_t) ( nx * ny ) * sizeof ( unsigned short ) ) ) == NULL )
+    {
+        plexit( "plimageslow: Insufficient memory" );
+    }
+    plcmap1_index( idata, nx * ny, z );
 
     plP_esc( PLESC_START_RASTERIZE, NULL );
     for ( ix = 0; ix < nx; ix++ )
@@ -109,12 +117,19 @@ plimageslow( PLFLT *idata, PLINT nx, PLINT ny,
         for ( iy = 0; iy < ny; iy++ )
         {
             // Only plot values within in appropriate range
-            color = idata[ix * ny + iy];
-            if ( color == COLOR_NO_PLOT )
+            if ( z[ix * ny + iy] >= plsc->ncol1 )
                 continue;
 
-            // The color value has to be scaled to 0.0 -> 1.0 plcol1 color values
-            plcol1( color / COLOR_MAX );
+            // Change the color, as plcol1 would, only when it differs from
+            // that of the last cell.
+            if ( z[ix * ny + iy] != icol1 )
+            {
+                icol1          = z[ix * ny + iy];
+                plsc->icol1    = icol1;
+                plsc->curcolor = plsc->cmap1[icol1];
+                plsc->curcmap  = 1;
+                plP_state( PLSTATE_COLOR1 );
+            }
 
             xf[0] = xf[1] = ix;
             xf[2] = xf[3] = ix + 1;
@@ -144,6 +159,181 @@ plimageslow( PLFLT *idata, PLINT nx, PLINT ny,
         }
     }
     plP_esc( PLESC_END_RASTERIZE, NULL );
+    free( z );
+}
+
+//
+// Draws the image with a single PLESC_IMAGE escape, which works if the
+// corners of the image cells map to physical coordinates by an affine
+// transformation (e.g., if pltr is NULL or linear).  The cell corners are
+// passed on in physical coordinates and the cell colors as cmap1 indices,
+// chosen as plcol1 would, and as RGBA bytes.  Returns 0 without drawing anything if the
+// mapping is not affine, so that the caller can use plimageslow instead.
+// This is an internal function, and should not be used directly.
+//
+int
+plimagefast( PLFLT *idata, PLINT nx, PLINT ny,
+             PLFLT xmin, PLFLT ymin, PLFLT dx, PLFLT dy,
+             PLTRANSFORM_callback pltr, PLPointer pltr_data )
+{
+    // Number of cell corners in x and y
+    PLINT          ncx = nx + 1, ncy = ny + 1;
+    PLINT          ix, iy, i;
+    PLFLT          tx, ty, ox, oy, exx, exy, eyx, eyy;
+    PLFLT          *px, *py;
+    short          *x, *y;
+    unsigned short *z;
+    unsigned char  *rgba;
+    int            affine = 1;
+
+    if ( ( px = (PLFLT *) malloc( (size_t) ( ncx * ncy ) * sizeof ( PLFLT ) ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+    if ( ( py = (PLFLT *) malloc( (size_t) ( ncx * ncy ) * sizeof ( PLFLT ) ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+
+    // Physical coordinates of the cell corners, as plimageslow computes them.
+    for ( ix = 0; ix < ncx && affine; ix++ )
+    {
+        for ( iy = 0; iy < ncy; iy++ )
+        {
+            if ( pltr )
+                ( *pltr )( (PLFLT) ix, (PLFLT) iy, &tx, &ty, pltr_data );
+            else
+            {
+                tx = xmin + ix * dx;
+                ty = ymin + iy * dy;
+            }
+            TRANSFORM( tx, ty, &tx, &ty );
+            i     = ix * ncy + iy;
+            px[i] = plsc->wpxoff + plsc->wpxscl * tx;
+            py[i] = plsc->wpyoff + plsc->wpyscl * ty;
+            if ( !isfinite( px[i] ) || !isfinite( py[i] ) ||
+                 fabs( px[i] ) > SHRT_MAX || fabs( py[i] ) > SHRT_MAX )
+            {
+                affine = 0;
+                break;
+            }
+        }
+    }
+
+    // Check that every corner is where the affine map through the corners
+    // (0, 0), (nx, 0) and (0, ny) puts it, give or take the rounding to
+    // physical coordinates.
+    if ( affine )
+    {
+        ox  = px[0];
+        oy  = py[0];
+        exx = ( px[nx * ncy] - ox ) / nx;
+        exy = ( py[nx * ncy] - oy ) / nx;
+        eyx = ( px[ny] - ox ) / ny;
+        eyy = ( py[ny] - oy ) / ny;
+        for ( ix = 0; ix < ncx && affine; ix++ )
+        {
+            for ( iy = 0; iy < ncy; iy++ )
+            {
+                i = ix * ncy + iy;
+                if ( fabs( px[i] - ( ox + ix * exx + iy * eyx ) ) > 0.5 ||
+                     fabs( py[i] - ( oy + ix * exy + iy * eyy ) ) > 0.5 )
+                {
+                    affine = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( !affine )
+    {
+        free( px );
+        free( py );
+        return 0;
+    }
+
+    if ( ( x = (short *) malloc( (size_t) ( ncx * ncy ) * sizeof ( short ) ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+    if ( ( y = (short *) malloc( (size_t) ( ncx * ncy ) * sizeof ( short ) ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+    if ( ( z = (unsigned short *) malloc( (size_t) ( nx * ny ) * sizeof ( unsigned short ) ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+
+    for ( i = 0; i < ncx * ncy; i++ )
+    {
+        x[i] = (short) ROUND( px[i] );
+        y[i] = (short) ROUND( py[i] );
+    }
+
+    // Cells that are not plotted (COLOR_NO_PLOT is outside the cmap1 range)
+    // get an index above any cmap1 index, and transparent black.
+    plcmap1_index( idata, nx * ny, z );
+    if ( ( rgba = (unsigned char *) malloc( (size_t) ( nx * ny ) * 4 ) ) == NULL )
+        plexit( "plimagefast: Insufficient memory" );
+    plcmap1_rgba( idata, nx * ny, rgba );
+
+    plP_drawimage( x, y, z, rgba, ncx, ncy );
+
+    free( px );
+    free( py );
+    free( x );
+    free( y );
+    free( z );
+    free( rgba );
+    return 1;
+}
+
+//
+// Draws an image, given as for plP_drawimage, with one solid fill per
+// cell.  This is how devices that cannot draw images themselves get an
+// image that was stored in one piece in the plot buffer.
+// This is an internal function, and should not be used directly.
+//
+void
+plimagefills( short *x, short *y, unsigned short *z, PLINT nx, PLINT ny )
+{
+    PLINT   ix, iy, i, icol1 = -1;
+    PLINT   corners[4], xf[5], yf[5];
+    PLINT   save_icol1   = plsc->icol1;
+    PLINT   save_curcmap = plsc->curcmap;
+    PLColor save_color   = plsc->curcolor;
+
+    for ( ix = 0; ix < nx - 1; ix++ )
+    {
+        for ( iy = 0; iy < ny - 1; iy++ )
+        {
+            if ( z[ix * ( ny - 1 ) + iy] >= plsc->ncol1 )
+                continue;
+
+            if ( z[ix * ( ny - 1 ) + iy] != icol1 )
+            {
+                icol1          = z[ix * ( ny - 1 ) + iy];
+                plsc->icol1    = icol1;
+                plsc->curcolor = plsc->cmap1[icol1];
+                plsc->curcmap  = 1;
+                plP_state( PLSTATE_COLOR1 );
+            }
+
+            corners[0] = ix * ny + iy;
+            corners[1] = ix * ny + iy + 1;
+            corners[2] = ( ix + 1 ) * ny + iy + 1;
+            corners[3] = ( ix + 1 ) * ny + iy;
+            for ( i = 0; i < 4; i++ )
+            {
+                xf[i] = x[corners[i]];
+                yf[i] = y[corners[i]];
+            }
+            xf[4] = xf[0];
+            yf[4] = yf[0];
+            plP_plfclp( xf, yf, 5, plsc->clpxmi, plsc->clpxma,
+                plsc->clpymi, plsc->clpyma, plP_fill );
+        }
+    }
+
+    if ( icol1 >= 0 )
+    {
+        plsc->icol1    = save_icol1;
+        plsc->curcmap  = save_curcmap;
+        plsc->curcolor = save_color;
+        plP_state( save_curcmap == 1 ? PLSTATE_COLOR1 : PLSTATE_COLOR0 );
+    }
 }
 
 void
@@ -251,7 +441,7 @@ plfimagefr( PLF2OPS idataops, PLPointer idatap, PLINT nx, PLINT ny,
             PLFLT valuemin, PLFLT valuemax,
             PLTRANSFORM_callback pltr, PLPointer pltr_data )
 {
-    PLINT ix, iy;
+    PLINT ix, iy, i;
     PLFLT dx, dy;
     // z holds scaled image pixel values
     PLFLT *z;
@@ -302,37 +492,41 @@ plfimagefr( PLF2OPS idataops, PLPointer idatap, PLINT nx, PLINT ny,
     // and values less than valuemin are set to valuemin.
     // Any values outside of zmin to zmax are flagged so they
     // are not plotted.
-    for ( ix = 0; ix < nx; ix++ )
+    if ( valuemin == valuemax )
     {
-        for ( iy = 0; iy < ny; iy++ )
+        // If valuemin == valuemax, avoid dividing by zero.
+        for ( i = 0; i < nx * ny; i++ )
+            z[i] = ( color_max + color_min ) / 2.0;
+    }
+    else
+    {
+        // Fetch the image in one pass, directly from the built-in layouts,
+        // then scale it in place.
+        if ( idataops->f2eval != NULL )
+            plP_f2eval_copy( idataops->f2eval, idatap, 0, nx, 0, ny, z );
+        else
+        {
+            for ( ix = 0; ix < nx; ix++ )
+                for ( iy = 0; iy < ny; iy++ )
+                    z[ix * ny + iy] = idataops->get( idatap, ix, iy );
+        }
+
+        for ( i = 0; i < nx * ny; i++ )
         {
-            if ( valuemin == valuemax )
+            datum = z[i];
+            if ( isnan( datum ) || datum < zmin || datum > zmax )
             {
-                // If valuemin == valuemax, avoid dividing by zero.
-                z[ix * ny + iy] = ( color_max + color_min ) / 2.0;
+                // Set to a guaranteed-not-to-plot value
+                z[i] = COLOR_NO_PLOT;
             }
             else
             {
-                datum = idataops->get( idatap, ix, iy );
-                if ( isnan( datum ) || datum < zmin || datum > zmax )
-                {
-                    // Set to a guaranteed-not-to-plot value
-                    z[ix * ny + iy] = COLOR_NO_PLOT;
-                }
-                else
-                {
-                    if ( datum < valuemin )
-                    {
-                        datum = valuemin;
-                    }
-                    else if ( datum > valuemax )
-                    {
-                        datum = valuemax;
-                    }
-                    // Set to a value scaled between color_min and color_max.
-                    z[ix * ny + iy] =
-                        color_min + ( datum - valuemin + COLOR_MIN ) / ( valuemax - valuemin ) * COLOR_MAX * color_range;
-                }
+                if ( datum < valuemin )
+                    datum = valuemin;
+                else if ( datum > valuemax )
+                    datum = valuemax;
+                // Set to a value scaled between color_min and color_max.
+                z[i] = color_min + ( datum - valuemin + COLOR_MIN ) / ( valuemax - valuemin ) * COLOR_MAX * color_range;
             }
         }
     }
@@ -24,7 +24,7 @@
 
 #define INSIDE( ix, iy )    ( BETW( ix, xmin, xmax ) && BETW( iy, ymin, ymax ) )
 
-static PLINT xline[PL_MAXPOLY], yline[PL_MAXPOLY];
+static PLINT xline[2], yline[2];
 
 static PLINT lastx = PL_UNDEFINED, lasty = PL_UNDEFINED;
 
@@ -35,6 +35,11 @@ static PLINT lastx = PL_UNDEFINED, lasty = PL_UNDEFINED;
 static void
 pllclp( PLINT *x, PLINT *y, PLINT npts );
 
+// Drops the polyline vertices that cannot be told apart on the device.
+
+static PLINT
+pldecimate( PLINT *x, PLINT *y, PLINT npts, PLINT width );
+
 // General line-drawing routine.  Takes line styles into account.
 
 static void
@@ -518,57 +523,108 @@ plP_drawor( PLFLT x, PLFLT y )
 //--------------------------------------------------------------------------
 // void plP_draphy_poly()
 //
-// Draw polyline in physical coordinates.
-// Need to draw buffers in increments of (PL_MAXPOLY-1) since the
-// last point must be repeated (for solid lines).
+// Draw polyline in physical coordinates.  The whole polyline is clipped
+// and passed on in one piece, whatever its length.
 //--------------------------------------------------------------------------
 
 void
 plP_draphy_poly( PLINT *x, PLINT *y, PLINT n )
 {
-    PLINT i, j, ib, ilim;
-
-    for ( ib = 0; ib < n; ib += PL_MAXPOLY - 1 )
-    {
-        ilim = MIN( PL_MAXPOLY, n - ib );
+    if ( n < 1 )
+        return;
 
-        for ( i = 0; i < ilim; i++ )
-        {
-            j        = ib + i;
-            xline[i] = x[j];
-            yline[i] = y[j];
-        }
-        pllclp( xline, yline, ilim );
-    }
+    pllclp( x, y, n );
 }
 
 //--------------------------------------------------------------------------
 // void plP_drawor_poly()
 //
-// Draw polyline in world coordinates.
-// Need to draw buffers in increments of (PL_MAXPOLY-1) since the
-// last point must be repeated (for solid lines).
+// Draw polyline in world coordinates.  The points are converted to
+// physical coordinates in the growable line arrays of the stream, so the
+// driver gets one path per curve whatever its length.  Solid lines are
+// decimated first if the stream asks for it (-decimate option).
 //--------------------------------------------------------------------------
 
 void
 plP_drawor_poly( PLFLT_VECTOR x, PLFLT_VECTOR y, PLINT n )
 {
-    PLINT i, j, ib, ilim;
+    PLINT i;
     PLFLT xt, yt;
 
-    for ( ib = 0; ib < n; ib += PL_MAXPOLY - 1 )
+    if ( n < 1 )
+        return;
+
+    plP_growxy( &plsc->linexbuf, &plsc->lineybuf, &plsc->linebufsize, n );
+    for ( i = 0; i < n; i++ )
     {
-        ilim = MIN( PL_MAXPOLY, n - ib );
+        TRANSFORM( x[i], y[i], &xt, &yt );
+        plsc->linexbuf[i] = plP_wcpcx( xt );
+        plsc->lineybuf[i] = plP_wcpcy( yt );
+    }
+    if ( plsc->decimate > 0 && plsc->nms == 0 )
+        n = pldecimate( plsc->linexbuf, plsc->lineybuf, n, plsc->decimate );
+    pllclp( plsc->linexbuf, plsc->lineybuf, n );
+}
+
+//--------------------------------------------------------------------------
+// PLINT pldecimate()
+//
+// Reduces a polyline in physical coordinates in place and returns the new
+// number of points.  The x axis is split into columns width physical units
+// wide, and of every run of consecutive vertices inside one column only the
+// first and last ones and those with the smallest and largest y are kept,
+// in their original order.  The dropped vertices lie on the vertical span
+// the kept ones still cover, so with a width of 1 (a device pixel on raster
+// devices) the line covers exactly the same pixels.  Dense data such as a
+// long time series sampled far beyond the device resolution are reduced to
+// at most four vertices per column.
+//--------------------------------------------------------------------------
+
+#define DECIMATE_COLUMN( ix )    ( ( ix ) >= 0 ? ( ix ) / width : -1 - ( -1 - ( ix ) ) / width )
 
-        for ( i = 0; i < ilim; i++ )
+static PLINT
+pldecimate( PLINT *x, PLINT *y, PLINT npts, PLINT width )
+{
+    PLINT i, j, k, col, imin, imax, nout = 0;
+    PLINT keep[4];
+
+    for ( i = 0; i < npts; i = j + 1 )
+    {
+        col  = DECIMATE_COLUMN( x[i] );
+        imin = imax = i;
+        for ( j = i; j + 1 < npts && DECIMATE_COLUMN( x[j + 1] ) == col; j++ )
         {
-            j = ib + i;
-            TRANSFORM( x[j], y[j], &xt, &yt );
-            xline[i] = plP_wcpcx( xt );
-            yline[i] = plP_wcpcy( yt );
+            if ( y[j + 1] < y[imin] )
+                imin = j + 1;
+            if ( y[j + 1] > y[imax] )
+                imax = j + 1;
+        }
+
+        if ( j - i < 4 )
+        {
+            for ( k = i; k <= j; k++ )
+            {
+                x[nout]   = x[k];
+                y[nout++] = y[k];
+            }
+            continue;
+        }
+
+        // First, extremes in the order they were met, last.
+        keep[0] = i;
+        keep[1] = MIN( imin, imax );
+        keep[2] = MAX( imin, imax );
+        keep[3] = j;
+        for ( k = 0; k < 4; k++ )
+        {
+            if ( k > 0 && keep[k] == keep[k - 1] )
+                continue;
+            x[nout]   = x[keep[k]];
+            y[nout++] = y[keep[k]];
         }
-        pllclp( xline, yline, ilim );
     }
+
+    return nout;
 }
 
 //--------------------------------------------------------------------------
@@ -601,25 +657,21 @@ plP_pllclp( PLINT *x, PLINT *y, PLINT npts,
             void ( *draw )( short *, short *, PLINT ) )
 {
     PLINT x1, x2, y1, y2;
-    PLINT i, iclp = 0;
-
-    short _xclp[PL_MAXPOLY], _yclp[PL_MAXPOLY];
-    short *xclp = NULL, *yclp = NULL;
+    PLINT i, iclp = 0, depth;
+    short *xclp, *yclp;
     int   drawable;
 
-    if ( npts < PL_MAXPOLY )
-    {
-        xclp = _xclp;
-        yclp = _yclp;
-    }
-    else
-    {
-        if ( ( ( xclp = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) ||
-             ( ( yclp = (short *) malloc( (size_t) npts * sizeof ( short ) ) ) == NULL ) )
-        {
-            plexit( "plP_pllclp: Insufficient memory" );
-        }
-    }
+// The draw function comes back here through plP_line() or plP_polyline()
+// when the driver interface filter is on, so each level clips into its
+// own arrays.
+
+    if ( plsc->clpdepth >= 2 )
+        plexit( "plP_pllclp: Too many nested calls" );
+    depth = plsc->clpdepth++;
+    plP_growxy_short( &plsc->clpxbuf[depth], &plsc->clpybuf[depth],
+        &plsc->clpbufsize[depth], npts );
+    xclp = plsc->clpxbuf[depth];
+    yclp = plsc->clpybuf[depth];
 
     for ( i = 0; i < npts - 1; i++ )
     {
@@ -680,11 +732,7 @@ plP_pllclp( PLINT *x, PLINT *y, PLINT npts,
     plsc->currx = x[npts - 1];
     plsc->curry = y[npts - 1];
 
-    if ( xclp != _xclp )
-    {
-        free( xclp );
-        free( yclp );
-    }
+    plsc->clpdepth--;
 }
 
 //--------------------------------------------------------------------------
@@ -30,6 +30,14 @@
 #include "metadefs.h"
 #include <stddef.h>       // For the offsetof() macro
 
+#ifdef PL_HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define MAX_BUFFER    256 // Character buffer size for reading records
 
 #if defined ( _MSC_VER ) && _MSC_VER <= 1500
@@ -57,6 +65,14 @@ enum _plm_status
     PLM_SUCCESS          = 0
 };
 
+// How much of the plot commands read_plot_commands() reads
+enum _plm_extent
+{
+    PLM_ALL = 0,  // Up to the end of the file
+    PLM_PROLOGUE, // Up to the first page header
+    PLM_PAGE      // Up to the end of the current page
+};
+
 // Portable data format types (perhaps should be defined elsewhere?)
 enum _pdf_types
 {
@@ -366,6 +382,213 @@ enum _plm_status read_string( PDFstrm *plm,
         return PLM_READ_ERROR;
 }
 
+//--------------------------------------------------------------------------
+// open_metafile()
+//
+// Opens a metafile for reading.  Where mmap() is available the file is
+// mapped into memory and read through a memory stream, so that a seek is
+// only a change of the buffer position and the file is never copied into
+// stdio buffers.  Otherwise the file is read with stdio.
+//--------------------------------------------------------------------------
+static
+PDFstrm *open_metafile( const char *infile )
+{
+#ifdef PL_HAVE_MMAP
+    PDFstrm     *plm = NULL;
+    struct stat st;
+    void        *map;
+    int         fd;
+
+    if ( ( fd = open( infile, O_RDONLY ) ) >= 0 )
+    {
+        if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+        {
+            map = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if ( map != MAP_FAILED )
+            {
+                plm = pdf_bopen( (U_CHAR *) map, (size_t) st.st_size );
+                if ( plm == NULL )
+                    munmap( map, (size_t) st.st_size );
+            }
+        }
+        close( fd );
+        if ( plm != NULL )
+            return plm;
+    }
+#endif
+
+    return pdf_fopen( infile, "rb" );
+}
+
+//--------------------------------------------------------------------------
+// close_metafile()
+//
+// Closes a metafile opened with open_metafile().
+//--------------------------------------------------------------------------
+static
+void close_metafile( PDFstrm *plm )
+{
+#ifdef PL_HAVE_MMAP
+    if ( plm->file == NULL && plm->buffer != NULL )
+    {
+        munmap( (void *) plm->buffer, plm->bufmax );
+        plm->buffer = NULL;
+    }
+#endif
+    pdf_close( plm );
+}
+
+//--------------------------------------------------------------------------
+// seek_metafile()
+//
+// Moves to the given byte offset of the metafile.
+//--------------------------------------------------------------------------
+static
+enum _plm_status seek_metafile( PDFstrm *plm, U_LONG offset )
+{
+    if ( plm->file != NULL )
+    {
+        if ( fseek( plm->file, (long) offset, SEEK_SET ) != 0 )
+            return PLM_READ_ERROR;
+    }
+    else if ( offset > plm->bufmax )
+    {
+        return PLM_READ_ERROR;
+    }
+    plm->bp = (size_t) offset;
+
+    return PLM_SUCCESS;
+}
+
+//--------------------------------------------------------------------------
+// metafile_size()
+//
+// Returns the size of the metafile in bytes, or 0 if it is not known.
+//--------------------------------------------------------------------------
+static
+U_LONG metafile_size( PDFstrm *plm )
+{
+    long size;
+
+    if ( plm->file == NULL )
+        return (U_LONG) plm->bufmax;
+
+    if ( fseek( plm->file, 0L, SEEK_END ) != 0 || ( size = ftell( plm->file ) ) < 0 )
+        size = 0;
+    fseek( plm->file, (long) plm->bp, SEEK_SET );
+
+    return (U_LONG) size;
+}
+
+//--------------------------------------------------------------------------
+// add_page()
+//
+// Appends the offset of a page header to the page index.
+//--------------------------------------------------------------------------
+static
+void add_page( PLmDev *dev, U_LONG offset )
+{
+    if ( dev->n_pages >= dev->max_pages )
+    {
+        dev->max_pages    = dev->max_pages > 0 ? 2 * dev->max_pages : 64;
+        dev->page_offsets = (U_LONG *) realloc( (void *) dev->page_offsets,
+            (size_t) dev->max_pages * sizeof ( U_LONG ) );
+        if ( dev->page_offsets == NULL )
+        {
+            plexit( "plmetafile: Insufficient memory for the page index" );
+        }
+    }
+    dev->page_offsets[dev->n_pages++] = offset;
+}
+
+//--------------------------------------------------------------------------
+// read_page_index()
+//
+// Reads the page index that the plmeta driver writes after the CLOSE
+// command.  Returns PLM_FORMAT_ERROR for files without a valid index.  The
+// position in the stream is not changed.
+//--------------------------------------------------------------------------
+static
+enum _plm_status read_page_index( PDFstrm *plm, PLmDev *dev )
+{
+    U_LONG           start = (U_LONG) plm->bp;
+    U_LONG           size, ix_offset, npages, offset, i;
+    U_CHAR           tag[4], cmd;
+    enum _plm_status rc = PLM_FORMAT_ERROR;
+
+    // The smallest index is the command, the page count, one page, the
+    // index offset and the tag
+    size = metafile_size( plm );
+    if ( size < 17 )
+        return PLM_FORMAT_ERROR;
+
+    if ( seek_metafile( plm, size - 8 ) != PLM_SUCCESS
+         || pdf_rd_4bytes( plm, &ix_offset ) != 0
+         || pdf_rdx( tag, 4, plm ) != 4
+         || memcmp( tag, PLMETA_INDEX_TAG, 4 ) != 0
+         || ix_offset > size - 17 )
+        goto done;
+
+    if ( seek_metafile( plm, ix_offset ) != PLM_SUCCESS
+         || pdf_rd_1byte( plm, &cmd ) != 0 || cmd != PAGE_INDEX
+         || pdf_rd_4bytes( plm, &npages ) != 0
+         || npages == 0 || npages != ( size - ix_offset - 13 ) / 4
+         || ( size - ix_offset - 13 ) % 4 != 0 )
+        goto done;
+
+    dev->n_pages = 0;
+    for ( i = 0; i < npages; i++ )
+    {
+        if ( pdf_rd_4bytes( plm, &offset ) != 0 || offset >= ix_offset )
+        {
+            dev->n_pages = 0;
+            goto done;
+        }
+        add_page( dev, offset );
+    }
+    rc = PLM_SUCCESS;
+
+done:
+    seek_metafile( plm, start );
+    return rc;
+}
+
+//--------------------------------------------------------------------------
+// build_page_index()
+//
+// Builds the page index of a metafile written without one by following
+// the links between the page headers, starting at the first page header
+// at which the stream must be positioned.  Only metafiles written to a
+// file have these links.  The position in the stream is not changed.
+//--------------------------------------------------------------------------
+static
+enum _plm_status build_page_index( PDFstrm *plm, PLmDev *dev )
+{
+    U_LONG  start = (U_LONG) plm->bp;
+    U_LONG  offset, prev_offset, next_offset;
+    U_SHORT page;
+    U_CHAR  cmd;
+
+    dev->n_pages = 0;
+    for ( offset = start; ; offset = next_offset )
+    {
+        if ( seek_metafile( plm, offset ) != PLM_SUCCESS
+             || pdf_rd_1byte( plm, &cmd ) != 0
+             || ( cmd != BOP && cmd != BOP0 )
+             || pdf_rd_2bytes( plm, &page ) != 0
+             || pdf_rd_4bytes( plm, &prev_offset ) != 0
+             || pdf_rd_4bytes( plm, &next_offset ) != 0 )
+            break;
+
+        add_page( dev, offset );
+        if ( next_offset <= offset )
+            break;
+    }
+
+    seek_metafile( plm, start );
+    return dev->n_pages > 0 ? PLM_SUCCESS : PLM_FORMAT_ERROR;
+}
+
 //--------------------------------------------------------------------------
 // read_metafile_header()
 //
@@ -464,6 +687,41 @@ enum _plm_status read_header( PDFstrm *plm,
     return PLM_SUCCESS;
 }
 
+//--------------------------------------------------------------------------
+// read_coords()
+//
+// Reads npts x values followed by npts y values into the temporary storage
+// and transforms them from the meta device to the current device
+// coordinate system.
+//--------------------------------------------------------------------------
+static
+enum _plm_status read_coords( PDFstrm *plm, PLmDev *dev, PLINT npts,
+                              short **xd, short **yd )
+{
+    U_SHORT *xy;
+    PLINT   i;
+
+    if ( npts <= 0 )
+        return PLM_FORMAT_ERROR;
+
+    // Setup temporary storage.  We need 2 * npts to store the X,Y pairs
+    check_buffer_size( dev, sizeof ( short ) * (size_t) npts * 2 );
+    xy = (U_SHORT *) ( dev->buffer );
+
+    // The x values, then the y values
+    if ( pdf_rd_2nbytes( plm, xy, 2 * npts ) != 0 )
+        return PLM_READ_ERROR;
+
+    *xd = (short *) xy;
+    *yd = ( (short *) xy ) + npts;
+    for ( i = 0; i < npts; i++ )
+        ( *xd )[i] = PLFLT2COORD( dev->mfpcxa * xy[i] + dev->mfpcxb );
+    for ( i = 0; i < npts; i++ )
+        ( *yd )[i] = PLFLT2COORD( dev->mfpcya * xy[npts + i] + dev->mfpcyb );
+
+    return PLM_SUCCESS;
+}
+
 //--------------------------------------------------------------------------
 // read_line()
 //
@@ -556,8 +814,7 @@ enum _plm_status read_lineto( PDFstrm *plm, PLmDev *dev, PLStream *pls )
 static
 enum _plm_status read_polyline( PDFstrm *plm, PLmDev *dev, PLStream *pls )
 {
-    PLINT            i, npts;
-    PLFLT            x, y;
+    PLINT            npts;
     short            *xd, *yd;
     enum _plm_status rc;
 
@@ -566,39 +823,12 @@ enum _plm_status read_polyline( PDFstrm *plm, PLmDev *dev, PLStream *pls )
     if ( rc != PLM_SUCCESS )
         return rc;
 
-    // Setup temporary storage.  We need 2 * npts to store the X,Y pairs
-    check_buffer_size( dev, sizeof ( short ) * npts * 2 );
-    // Setup storage for the x values and y values
-    xd = (short *) ( dev->buffer );
-    yd = ( (short *) ( dev->buffer ) ) + npts;
-
-    // Read the points and insert into the plot buffer
-    // The x values
-    for ( i = 0; i < npts; i++ )
-    {
-        rc = read_entry( plm, PDF_USHORT, PLP_PLFLT, &x );
-        if ( rc != PLM_SUCCESS )
-            return rc;
+    rc = read_coords( plm, dev, npts, &xd, &yd );
+    if ( rc != PLM_SUCCESS )
+        return rc;
 
-        // Transform the coordinates from the meta device to the current
-        // device coordinate system
-        xd[i] = PLFLT2COORD( dev->mfpcxa * x + dev->mfpcxb );
-    }
-    // Preserve the last X value for the LINETO command
+    // Preserve the last XY coords for the LINETO command
     dev->xold = xd[npts - 1];
-
-    // The y values
-    for ( i = 0; i < npts; i++ )
-    {
-        rc = read_entry( plm, PDF_USHORT, PLP_PLFLT, &y );
-        if ( rc != PLM_SUCCESS )
-            return rc;
-
-        // Transform the coordinates from the meta device to the current
-        // device coordinate system
-        yd[i] = PLFLT2COORD( dev->mfpcya * y + dev->mfpcyb );
-    }
-    // Preserve the last Y value for the LINETO command
     dev->yold = yd[npts - 1];
 
     // Draw the line
@@ -626,8 +856,7 @@ enum _plm_status read_escape( PDFstrm *plm, PLmDev *dev, PLStream *pls )
     {
     case PLESC_FILL:
     {
-        PLINT i, npts;
-        PLFLT x, y;
+        PLINT npts;
         short *xd, *yd;
 
         // Get the number of control points for the fill
@@ -635,27 +864,10 @@ enum _plm_status read_escape( PDFstrm *plm, PLmDev *dev, PLStream *pls )
         if ( rc != PLM_SUCCESS )
             return rc;
 
-        // Setup temporary storage.  We need 2 * npts to store the X,Y pairs
-        check_buffer_size( dev, sizeof ( short ) * npts * 2 );
-        // Setup storage for the x values and y values
-        xd = (short *) ( dev->buffer );
-        yd = ( (short *) ( dev->buffer ) ) + npts;
-
-        for ( i = 0; i < npts; i++ )
-        {
-            rc = read_entry( plm, PDF_USHORT, PLP_PLFLT, &x );
-            if ( rc != PLM_SUCCESS )
-                return rc;
-
-            rc = read_entry( plm, PDF_USHORT, PLP_PLFLT, &y );
-            if ( rc != PLM_SUCCESS )
-                return rc;
-
-            // Transform the coordinates from the meta device to the current
-            // device coordinate system
-            xd[i] = PLFLT2COORD( dev->mfpcxa * x + dev->mfpcxb );
-            yd[i] = PLFLT2COORD( dev->mfpcya * y + dev->mfpcyb );
-        }
+        // The plmeta driver writes all the x values, then all the y values
+        rc = read_coords( plm, dev, npts, &xd, &yd );
+        if ( rc != PLM_SUCCESS )
+            return rc;
 
         plP_fill( xd, yd, npts );
     }
@@ -811,6 +1023,11 @@ enum _plm_status read_state( PDFstrm *plm, PLmDev *dev, PLStream *pls )
                 return rc;
 
             // Was pen 0 set to an RGB value rather than color index?
+            // The color index is written as a short, so PL_RGB_COLOR
+            // comes back as an unsigned value
+            if ( icol == (U_SHORT) PL_RGB_COLOR )
+                icol = PL_RGB_COLOR;
+
             if ( op == PLSTATE_COLOR0 && icol != PL_RGB_COLOR )
             {
                 pls->icol0      = icol;
@@ -856,8 +1073,9 @@ enum _plm_status read_state( PDFstrm *plm, PLmDev *dev, PLStream *pls )
     case PLSTATE_FILL:
         pldebug( "state: FILL" );
 
-        // Read the pattern and put into the plot buffer
-        rc = read_entry( plm, PDF_USHORT, PLP_UCHAR, &( pls->patt ) );
+        // Read the pattern and put into the plot buffer.  The plmeta
+        // driver writes it as a single byte.
+        rc = read_entry( plm, PDF_UBYTE, PLP_PLINT, &( pls->patt ) );
         if ( rc != PLM_SUCCESS )
             return rc;
 
@@ -927,7 +1145,7 @@ enum _plm_status read_state( PDFstrm *plm, PLmDev *dev, PLStream *pls )
         pldebug( "state: CHR" );
 
         // The 2005 version and earlier do not support this operation
-        if ( 1 )
+        if ( strncmp( metafile_format[dev->version].identifier, "2005", 4 ) != 0 )
         {
             rc = read_entry( plm, PDF_IEEEF, PLP_PLFLT, &( pls->chrdef ) );
             if ( rc != PLM_SUCCESS )
@@ -943,7 +1161,7 @@ enum _plm_status read_state( PDFstrm *plm, PLmDev *dev, PLStream *pls )
         pldebug( "state: SYM" );
 
         // The 2005 version and earlier do not support this operation
-        if ( 1 )
+        if ( strncmp( metafile_format[dev->version].identifier, "2005", 4 ) != 0 )
         {
             rc = read_entry( plm, PDF_IEEEF, PLP_PLFLT, &( pls->symdef ) );
             if ( rc != PLM_SUCCESS )
@@ -969,10 +1187,12 @@ enum _plm_status read_state( PDFstrm *plm, PLmDev *dev, PLStream *pls )
 // read_plot_commands()
 //
 // Reads the plot commands from the metafile and places them into the
-// plot buffer
+// plot buffer.  With PLM_PROLOGUE the stream is left at the first page
+// header, with PLM_PAGE reading stops after the end of the page.
 //--------------------------------------------------------------------------
 static
-enum _plm_status read_plot_commands( PDFstrm *plm, PLmDev *dev, PLStream *pls )
+enum _plm_status read_plot_commands( PDFstrm *plm, PLmDev *dev, PLStream *pls,
+                                     enum _plm_extent extent )
 {
     uint8_t          cmd;
     enum _plm_status rc = PLM_SUCCESS;
@@ -999,12 +1219,17 @@ enum _plm_status read_plot_commands( PDFstrm *plm, PLmDev *dev, PLStream *pls )
             pldebug( "cmd: EOP" );
 
             plP_eop();
+            if ( extent == PLM_PAGE )
+                return PLM_SUCCESS;
             break;
 
         case BOP:
         case BOP0:                   // First BOP in a file
             pldebug( "cmd: BOP/BOP0" );
 
+            if ( extent == PLM_PROLOGUE )
+                return seek_metafile( plm, (U_LONG) ( plm->bp - 1 ) );
+
             // Read the metadata for this page
             rc = read_entry( plm,
                 page_2005_header[0].pdf_type,
@@ -1061,6 +1286,12 @@ enum _plm_status read_plot_commands( PDFstrm *plm, PLmDev *dev, PLStream *pls )
             rc = read_state( plm, dev, pls );
             break;
 
+        case PAGE_INDEX:
+            pldebug( "cmd: PAGE_INDEX" );
+
+            // The index follows the last of the plot commands
+            return PLM_SUCCESS;
+
         case END_OF_FIELD:
             pldebug( "cmd: EOF" );
 
@@ -1091,16 +1322,58 @@ enum _plm_status read_plot_commands( PDFstrm *plm, PLmDev *dev, PLStream *pls )
 }
 
 static
-void setup_page( PLmDev *mf_dev, PLStream *pls )
+void setup_page( PLmDev *mf_dev )
 {
-    PLmDev *dev = pls->dev;
+    PLINT xmin, xmax, ymin, ymax;
 
-    mf_dev->mfpcxa = (PLFLT) dev->xlen
+    // Use the physical limits of the device rather than its private data,
+    // which not every driver has (e.g. the null device)
+    plP_gphy( &xmin, &xmax, &ymin, &ymax );
+
+    mf_dev->mfpcxa = (PLFLT) ( xmax - xmin )
                      / (PLFLT) ( mf_dev->xmax - mf_dev->xmin );
-    mf_dev->mfpcxb = (PLFLT) dev->xmin;
-    mf_dev->mfpcya = (PLFLT) dev->ylen
+    mf_dev->mfpcxb = (PLFLT) xmin;
+    mf_dev->mfpcya = (PLFLT) ( ymax - ymin )
                      / (PLFLT) ( mf_dev->ymax - mf_dev->ymin );
-    mf_dev->mfpcyb = (PLFLT) dev->ymin;
+    mf_dev->mfpcyb = (PLFLT) ymin;
+}
+
+//--------------------------------------------------------------------------
+// read_metafile_page()
+//
+// Replays the state set before the first page and then only the given
+// page, found through the page index.  The index is rebuilt from the page
+// headers for metafiles written without one.
+//--------------------------------------------------------------------------
+static
+enum _plm_status read_metafile_page( PDFstrm *plm, PLmDev *dev, PLStream *pls,
+                                     PLINT page )
+{
+    enum _plm_status rc;
+
+    rc = read_plot_commands( plm, dev, pls, PLM_PROLOGUE );
+    if ( rc != PLM_SUCCESS )
+        return rc;
+
+    if ( read_page_index( plm, dev ) != PLM_SUCCESS )
+    {
+        pldebug( "read_metafile_page", "No page index, following the page headers\n" );
+        rc = build_page_index( plm, dev );
+        if ( rc != PLM_SUCCESS )
+            return rc;
+    }
+
+    if ( page > dev->n_pages )
+    {
+        plwarn( "plreadmetafile: Page not found in metafile." );
+        return PLM_SUCCESS;
+    }
+
+    rc = seek_metafile( plm, dev->page_offsets[page - 1] );
+    if ( rc != PLM_SUCCESS )
+        return rc;
+
+    return read_plot_commands( plm, dev, pls, PLM_PAGE );
 }
 
 //--------------------------------------------------------------------------
@@ -1115,7 +1388,8 @@ void setup_page( PLmDev *mf_dev, PLStream *pls )
 //! @param infile  Input PLplot metafile name.
 //!
 //! Pass NULL for infile to use the filename passed from the command line
-//! option -mfi.
+//! option -mfi.  If a page was given with the -mfpage option, only that
+//! page is read.
 //!
 //! Returns void
 //--------------------------------------------------------------------------
@@ -1133,11 +1407,11 @@ void plreadmetafile( char *infile )
     }
     else if ( infile != NULL )
     {
-        plm = pdf_fopen( infile, "rb" );
+        plm = open_metafile( infile );
     }
     else
     {
-        plm = pdf_fopen( plsc->mf_infile, "rb" );
+        plm = open_metafile( plsc->mf_infile );
     }
     if ( plm == NULL )
     {
@@ -1145,13 +1419,16 @@ void plreadmetafile( char *infile )
     }
 
     // Intialize the metafile device
-    mf_dev.buffer      = NULL;
-    mf_dev.buffer_size = 0;
+    mf_dev.buffer       = NULL;
+    mf_dev.buffer_size  = 0;
+    mf_dev.page_offsets = NULL;
+    mf_dev.n_pages      = 0;
+    mf_dev.max_pages    = 0;
 
     // Read the file header
     if ( ( rc = read_metafile_header( plm, &mf_dev ) ) != PLM_SUCCESS )
     {
-        pdf_close( plm );
+        close_metafile( plm );
         plwarn( "Failed to parse PLplot metafile, ignoring file." );
         return;
     }
@@ -1162,7 +1439,7 @@ void plreadmetafile( char *infile )
         (U_CHAR *) &index );
     if ( rc != PLM_SUCCESS )
     {
-        pdf_close( plm );
+        close_metafile( plm );
         plwarn( "Corrupted index in metafile, ignoring file." );
         return;
     }
@@ -1173,7 +1450,7 @@ void plreadmetafile( char *infile )
         (U_CHAR *) &mf_dev );
     if ( rc != PLM_SUCCESS )
     {
-        pdf_close( plm );
+        close_metafile( plm );
         plwarn( "Corrupted device information in metafile, ignoring file." );
         return;
     }
@@ -1188,7 +1465,7 @@ void plreadmetafile( char *infile )
         (U_CHAR *) &mf_pls );
     if ( rc != PLM_SUCCESS )
     {
-        pdf_close( plm );
+        close_metafile( plm );
         plwarn( "Corrupted device information in metafile, ignoring file." );
         return;
     }
@@ -1200,20 +1477,25 @@ void plreadmetafile( char *infile )
         // device configuation set
         plinit();
     }
-    setup_page( &mf_dev, plsc );
+    setup_page( &mf_dev );
 
     // At this point we should be in the plot commands
-    rc = read_plot_commands( plm, &mf_dev, plsc );
+    if ( plsc->mf_page > 0 )
+        rc = read_metafile_page( plm, &mf_dev, plsc, plsc->mf_page );
+    else
+        rc = read_plot_commands( plm, &mf_dev, plsc, PLM_ALL );
     if ( rc != PLM_SUCCESS )
     {
-        pdf_close( plm );
+        close_metafile( plm );
         plwarn( "Corrupted plot information in metafile, ignoring file." );
         return;
     }
 
-    pdf_close( plm );
+    close_metafile( plm );
 
     // Free the temporary storage
     if ( mf_dev.buffer != NULL )
         free( mf_dev.buffer );
+    if ( mf_dev.page_offsets != NULL )
+        free( mf_dev.page_offsets );
 }
@@ -43,14 +43,36 @@ static PLINT *utmp      = NULL;
 static PLINT *vtmp      = NULL;
 static PLFLT *ctmp      = NULL;
 
-static PLINT mhi, xxhi, newhisize;
-static PLINT mlo, xxlo, newlosize;
+// Physical coordinates (and color, for MAG_COLOR) of every grid point of
+// plot3dcl, point [ix][iy] at index ix * ny + iy, projected once per plot
+static PLINT *gridu = NULL;
+static PLINT *gridv = NULL;
+static PLFLT *gridc = NULL;
+
+// Number of points of the old views, next free entry of the new views,
+// and the sizes allocated for all four, in PLINTs
+static PLINT mhi, xxhi, oldhisize, newhisize;
+static PLINT mlo, xxlo, oldlosize, newlosize;
 
 // Light source for shading
 static PLFLT xlight, ylight, zlight;
 static PLINT falsecolor = 0;
 static PLFLT fc_minz, fc_maxz;
 
+// Z-buffer of plsurf3d (-zbuffer option): the depth and cmap1 index of
+// every pixel of the clip window, pixel [ix][iy] at index ix * ny + iy
+
+typedef struct
+{
+    PLINT          nx, ny;
+    PLFLT          x0, y0, step; // physical coordinates of the corner of
+                                 // pixel [0][0], and size of the pixels
+    PLFLT          *depth;
+    unsigned short *icol1;
+} SURF_ZBUFFER;
+
+static SURF_ZBUFFER *zbuffer = NULL;
+
 // Prototypes for static functions
 
 static void plgrid3( PLFLT );
@@ -59,12 +81,12 @@ static void
 plside3( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny, PLINT opt );
 static void
 plt3zz( PLINT x0, PLINT y0, PLINT dx, PLINT dy, PLINT flag, PLINT *init,
-        PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
-        PLINT *u, PLINT *v, PLFLT* c );
+        PLINT nx, PLINT ny, PLINT *u, PLINT *v, PLFLT* c );
 static void plnxtvhi( PLINT *, PLINT *, PLFLT*, PLINT, PLINT );
 static void plnxtvlo( PLINT *, PLINT *, PLFLT*, PLINT, PLINT );
 static void plnxtvhi_draw( PLINT *u, PLINT *v, PLFLT* c, PLINT n );
 
+static void growview( PLINT **view, PLINT *size, PLINT need );
 static void savehipoint( PLINT, PLINT );
 static void savelopoint( PLINT, PLINT );
 static void swaphiview( void );
@@ -77,6 +99,9 @@ static void pl3cut( PLINT, PLINT, PLINT, PLINT, PLINT,
                     PLINT, PLINT, PLINT, PLINT *, PLINT * );
 static PLFLT plGetAngleToLight( PLFLT* x, PLFLT* y, PLFLT* z );
 static void plP_draw3d( PLINT x, PLINT y, PLFLT *c, PLINT j, PLINT move );
+static void zbuffer_begin( void );
+static void zbuffer_end( void );
+static void zbuffer_polygon( PLFLT *x, PLFLT *y, PLFLT *z, PLINT n, PLFLT col1 );
 //static void plxyindexlimits( PLINT instart, PLINT inn,
 //                             PLINT *inarray_min, PLINT *inarray_max,
 //                             PLINT *outstart, PLINT *outn, PLINT outnmax,
@@ -290,6 +315,15 @@ shade_triangle( PLFLT x0, PLFLT y0, PLFLT z0,
 
     if ( n > 0 )
     {
+        if ( zbuffer != NULL )
+        {
+            if ( falsecolor )
+                zbuffer_polygon( x, y, z, n, ( ( z[0] + z[1] + z[2] ) / 3. - fc_minz ) / ( fc_maxz - fc_minz ) );
+            else
+                zbuffer_polygon( x, y, z, n, plGetAngleToLight( x, y, z ) );
+            return;
+        }
+
         if ( falsecolor )
             plcol1( ( ( z[0] + z[1] + z[2] ) / 3. - fc_minz ) / ( fc_maxz - fc_minz ) );
         else
@@ -383,6 +417,12 @@ plfsurf3d( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
 //
 // There are multitude of ways this code could be optimized. Given the
 // problems with the old code, I tried to focus on clarity here.
+//
+// With the -zbuffer option, on devices that draw images, the triangles of
+// the surface are instead rendered into a z-buffer with the resolution of
+// the device and drawn as one image (see zbuffer_begin()).  This is not
+// done when contours are drawn on the surface, as these are interleaved
+// with the triangles.
 //--------------------------------------------------------------------------
 
 void
@@ -409,8 +449,7 @@ plfsurf3dl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx
     PLINT      ixmin = 0, ixmax = nx, iymin = 0, iymax = ny;
     PLFLT      xx[3], yy[3], zz[3];
     PLFLT      px[4], py[4], pz[4];
-    CONT_LEVEL *cont, *clev;
-    CONT_LINE  *cline;
+    CONT_STORE cont;
     int        ct, ix, iy, iftriangle;
     PLINT      color = plsc->icol0;
     PLFLT      width = plsc->width;
@@ -580,7 +619,7 @@ plfsurf3dl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx
     if ( clevel != NULL && opt & BASE_CONT )
     {
 #define NPTS    100
-        int      np = NPTS;
+        int      np = NPTS, l;
         PLFLT    **zstore;
         PLcGrid2 cgrid2;
         PLFLT    *zzloc = (PLFLT *) malloc( (size_t) NPTS * sizeof ( PLFLT ) );
@@ -627,38 +666,35 @@ plfsurf3dl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx
         plFree2dGrid( cgrid2.yg, nx, ny );
 
         // follow the contour levels and lines
-        clev = cont;
-        do  // for each contour level
+        for ( k = 0; k < cont.nlevel; k++ )
         {
-            cline = clev->line;
-            do  // there are several lines that make up the contour
+            // there are several lines that make up the contour
+            for ( l = cont.level_line[k]; l < cont.level_line[k + 1]; l++ )
             {
-                if ( cline->npts > np )
+                PLINT first = cont.line_pt[l], npts = cont.line_pt[l + 1] - first;
+
+                if ( npts > np )
                 {
-                    np = cline->npts;
+                    np = npts;
                     if ( ( zzloc = (PLFLT *) realloc( zzloc, (size_t) np * sizeof ( PLFLT ) ) ) == NULL )
                     {
                         plexit( "plsurf3dl: Insufficient memory" );
                     }
                 }
-                for ( j = 0; j < cline->npts; j++ )
+                for ( j = 0; j < npts; j++ )
                     zzloc[j] = plsc->ranmi;
-                if ( cline->npts > 0 )
-                {
-                    plcol1( ( clev->level - fc_minz ) / ( fc_maxz - fc_minz ) );
-                    plline3( cline->npts, cline->x, cline->y, zzloc );
-                }
-                cline = cline->next;
+                plcol1( ( cont.level[k] - fc_minz ) / ( fc_maxz - fc_minz ) );
+                plline3( npts, cont.x + first, cont.y + first, zzloc );
             }
-            while ( cline != NULL );
-            clev = clev->next;
         }
-        while ( clev != NULL );
 
-        cont_clean_store( cont ); // now release the memory
+        cont_clean_store( &cont ); // now release the memory
         free( zzloc );
     }
 
+    if ( plsc->zbuffer && plsc->dev_fastimg && !( clevel != NULL && ( opt & SURF_CONT ) ) )
+        zbuffer_begin();
+
     // Now we can iterate over the grid drawing the quads
     for ( iSlow = 0; iSlow < nSlow - 1; iSlow++ )
     {
@@ -776,6 +812,9 @@ plfsurf3dl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx
         }
     }
 
+    if ( zbuffer != NULL )
+        zbuffer_end();
+
     if ( opt & FACETED )
     {
         plcol0( 0 );
@@ -979,6 +1018,9 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
     PLINT ixmin   = 0, ixmax = nx - 1, iymin = 0, iymax = ny - 1;
     PLINT clipped = 0, base_cont = 0, side = 0;
     PLFLT ( *getz )( PLPointer, PLINT, PLINT ) = zops->get;
+    PLF2EVAL_callback evalz = zops->f2eval;
+    const PLFLT       *zrow = NULL;
+    PLINT             zstride;
     PLFLT *_x = NULL, *_y = NULL, **_z = NULL;
     PLFLT_VECTOR x_modified, y_modified;
     int i;
@@ -1144,9 +1186,10 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
             }
         }
         // replace the input with our clipped versions
-        zp   = (PLPointer) _z;
-        getz = plf2ops_c()->get;
-        nx   = _nx;
+        zp    = (PLPointer) _z;
+        getz  = plf2ops_c()->get;
+        evalz = plf2ops_c()->f2eval;
+        nx    = _nx;
         ny   = _ny;
         // Do not want to modify input x and y (const modifier)
         x_modified = (PLFLT_VECTOR) _x;
@@ -1211,6 +1254,29 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
     if ( !utmp || !vtmp )
         myexit( "plot3dcl: Out of memory." );
 
+    // Every grid point is on two of the lines, so project them all once
+    gridu = (PLINT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLINT ) );
+    gridv = (PLINT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLINT ) );
+    if ( !gridu || !gridv )
+        myexit( "plot3dcl: Out of memory." );
+    if ( ctmp != NULL &&
+         ( gridc = (PLFLT *) malloc( (size_t) nx * (size_t) ny * sizeof ( PLFLT ) ) ) == NULL )
+        myexit( "plot3dcl: Out of memory." );
+    for ( ix = 0; ix < nx; ix++ )
+    {
+        if ( evalz != NULL )
+            zrow = plP_f2eval_row( evalz, zp, ix, &zstride );
+        for ( iy = 0; iy < ny; iy++ )
+        {
+            PLFLT zv = zrow != NULL ? zrow[iy * zstride] : getz( zp, ix, iy );
+
+            gridu[ix * ny + iy] = plP_wcpcx( plP_w3wcx( x_modified[ix], y_modified[iy], zv ) );
+            gridv[ix * ny + iy] = plP_wcpcy( plP_w3wcy( x_modified[ix], y_modified[iy], zv ) );
+            if ( gridc != NULL )
+                gridc[ix * ny + iy] = ( zv - fc_minz ) / ( fc_maxz - fc_minz );
+        }
+    }
+
     plP_gw3wc( &cxx, &cxy, &cyx, &cyy, &cyz );
     init = 1;
 // Call 3d line plotter.  Each viewing quadrant
@@ -1218,72 +1284,72 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
     if ( cxx >= 0.0 && cxy <= 0.0 )
     {
         if ( opt == DRAW_LINEY )
-            plt3zz( 1, ny, 1, -1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( 1, ny, 1, -1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( iy = 2; iy <= ny; iy++ )
-                plt3zz( 1, iy, 1, -1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( 1, iy, 1, -1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
         if ( opt == DRAW_LINEX )
-            plt3zz( 1, ny, 1, -1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( 1, ny, 1, -1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( ix = 1; ix <= nx - 1; ix++ )
-                plt3zz( ix, ny, 1, -1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( ix, ny, 1, -1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
     }
 
     else if ( cxx <= 0.0 && cxy <= 0.0 )
     {
         if ( opt == DRAW_LINEX )
-            plt3zz( nx, ny, -1, -1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( nx, ny, -1, -1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( ix = 2; ix <= nx; ix++ )
-                plt3zz( ix, ny, -1, -1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( ix, ny, -1, -1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
         if ( opt == DRAW_LINEY )
-            plt3zz( nx, ny, -1, -1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( nx, ny, -1, -1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( iy = ny; iy >= 2; iy-- )
-                plt3zz( nx, iy, -1, -1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( nx, iy, -1, -1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
     }
 
     else if ( cxx <= 0.0 && cxy >= 0.0 )
     {
         if ( opt == DRAW_LINEY )
-            plt3zz( nx, 1, -1, 1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( nx, 1, -1, 1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( iy = ny - 1; iy >= 1; iy-- )
-                plt3zz( nx, iy, -1, 1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( nx, iy, -1, 1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
         if ( opt == DRAW_LINEX )
-            plt3zz( nx, 1, -1, 1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( nx, 1, -1, 1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( ix = nx; ix >= 2; ix-- )
-                plt3zz( ix, 1, -1, 1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( ix, 1, -1, 1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
     }
 
     else if ( cxx >= 0.0 && cxy >= 0.0 )
     {
         if ( opt == DRAW_LINEX )
-            plt3zz( 1, 1, 1, 1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( 1, 1, 1, 1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( ix = nx - 1; ix >= 1; ix-- )
-                plt3zz( ix, 1, 1, 1, opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( ix, 1, 1, 1, opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
         if ( opt == DRAW_LINEY )
-            plt3zz( 1, 1, 1, 1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+            plt3zz( 1, 1, 1, 1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         else
         {
             for ( iy = 1; iy <= ny - 1; iy++ )
-                plt3zz( 1, iy, 1, 1, -opt, &init, x_modified, y_modified, zops, zp, nx, ny, utmp, vtmp, ctmp );
+                plt3zz( 1, iy, 1, 1, -opt, &init, nx, ny, utmp, vtmp, ctmp );
         }
     }
 
@@ -1291,9 +1357,8 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
 
     if ( base_cont )
     {
-        int np = NPTS, j;
-        CONT_LEVEL *cont, *clev;
-        CONT_LINE *cline;
+        int np = NPTS, j, n, line;
+        CONT_STORE cont;
 
         PLINT *uu = (PLINT *) malloc( (size_t) NPTS * sizeof ( PLINT ) );
         PLINT *vv = (PLINT *) malloc( (size_t) NPTS * sizeof ( PLINT ) );
@@ -1334,17 +1399,19 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
         plFree2dGrid( cgrid2.yg, nx, ny );
 
         // follow the contour levels and lines
-        clev = cont;
-        do  // for each contour level
+        for ( n = 0; n < cont.nlevel; n++ ) // for each contour level
         {
-            cline = clev->line;
-            do  // there are several lines that make up each contour
+            // there are several lines that make up each contour
+            for ( line = cont.level_line[n]; line < cont.level_line[n + 1]; line++ )
             {
                 int cx, k, l, m, start, end;
                 PLFLT tx, ty;
-                if ( cline->npts > np )
+                PLFLT *xl  = cont.x + cont.line_pt[line];
+                PLFLT *yl  = cont.y + cont.line_pt[line];
+                PLINT npts = cont.line_pt[line + 1] - cont.line_pt[line];
+                if ( npts > np )
                 {
-                    np = cline->npts;
+                    np = npts;
                     if ( ( ( uu = (PLINT *) realloc( uu, (size_t) np * sizeof ( PLINT ) ) ) == NULL ) ||
                          ( ( vv = (PLINT *) realloc( vv, (size_t) np * sizeof ( PLINT ) ) ) == NULL ) )
                     {
@@ -1356,16 +1423,16 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
                 // As this does not always happens, the situation must be detected and the line segment
                 // must be reversed before being plotted
                 i = 0;
-                if ( cline->npts > 0 )
+                if ( npts > 0 )
                 {
                     do
                     {
-                        plcol1( ( clev->level - fc_minz ) / ( fc_maxz - fc_minz ) );
-                        cx = plP_wcpcx( plP_w3wcx( cline->x[i], cline->y[i], plsc->ranmi ) );
-                        for ( j = i; j < cline->npts; j++ ) // convert to 2D coordinates
+                        plcol1( ( cont.level[n] - fc_minz ) / ( fc_maxz - fc_minz ) );
+                        cx = plP_wcpcx( plP_w3wcx( xl[i], yl[i], plsc->ranmi ) );
+                        for ( j = i; j < npts; j++ ) // convert to 2D coordinates
                         {
-                            uu[j] = plP_wcpcx( plP_w3wcx( cline->x[j], cline->y[j], plsc->ranmi ) );
-                            vv[j] = plP_wcpcy( plP_w3wcy( cline->x[j], cline->y[j], plsc->ranmi ) );
+                            uu[j] = plP_wcpcx( plP_w3wcx( xl[j], yl[j], plsc->ranmi ) );
+                            vv[j] = plP_wcpcy( plP_w3wcy( xl[j], yl[j], plsc->ranmi ) );
                             if ( uu[j] < cx ) // find turn back point
                                 break;
                             else
@@ -1373,12 +1440,12 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
                         }
                         plnxtv( &uu[i], &vv[i], NULL, j - i, 0 ); // plot line with increasing x
 
-                        if ( j < cline->npts )                    // line not yet finished,
+                        if ( j < npts )                           // line not yet finished,
                         {
                             start = j - 1;
-                            for ( i = start; i < cline->npts; i++ ) // search turn forward point
+                            for ( i = start; i < npts; i++ ) // search turn forward point
                             {
-                                uu[i] = plP_wcpcx( plP_w3wcx( cline->x[i], cline->y[i], plsc->ranmi ) );
+                                uu[i] = plP_wcpcx( plP_w3wcx( xl[i], yl[i], plsc->ranmi ) );
                                 if ( uu[i] > cx )
                                     break;
                                 else
@@ -1390,36 +1457,32 @@ plfplot3dcl( PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp,
                             {
                                 l           = start + k;
                                 m           = end - k;
-                                tx          = cline->x[l];
-                                ty          = cline->y[l];
-                                cline->x[l] = cline->x[m];
-                                cline->y[l] = cline->y[m];
-                                cline->x[m] = tx;
-                                cline->y[m] = ty;
+                                tx    = xl[l];
+                                ty    = yl[l];
+                                xl[l] = xl[m];
+                                yl[l] = yl[m];
+                                xl[m] = tx;
+                                yl[m] = ty;
                             }
 
                             // convert to 2D coordinates
                             for ( j = start; j <= end; j++ )
                             {
-                                uu[j] = plP_wcpcx( plP_w3wcx( cline->x[j], cline->y[j], plsc->ranmi ) );
-                                vv[j] = plP_wcpcy( plP_w3wcy( cline->x[j], cline->y[j], plsc->ranmi ) );
+                                uu[j] = plP_wcpcx( plP_w3wcx( xl[j], yl[j], plsc->ranmi ) );
+                                vv[j] = plP_wcpcy( plP_w3wcy( xl[j], yl[j], plsc->ranmi ) );
                             }
                             plnxtv( &uu[start], &vv[start], NULL, end - start + 1, 0 ); // and plot it
 
-                            cline->x[end] = cline->x[start];
-                            cline->y[end] = cline->y[start];
-                            i             = end; // restart where it was left
+                            xl[end] = xl[start];
+                            yl[end] = yl[start];
+                            i       = end; // restart where it was left
                         }
-                    } while ( j < cline->npts && i < cline->npts );
+                    } while ( j < npts && i < npts );
                 }
-                cline = cline->next;
             }
-            while ( cline != NULL );
-            clev = clev->next;
         }
-        while ( clev != NULL );
 
-        cont_clean_store( cont ); // now release the contour memory
+        cont_clean_store( &cont ); // now release the contour memory
         pl3upv = 1;
         free( uu );
         free( vv );
@@ -1606,12 +1669,188 @@ plGetAngleToLight( PLFLT* x, PLFLT* y, PLFLT* z )
     return cosangle;
 }
 
+//--------------------------------------------------------------------------
+// void zbuffer_begin()
+//
+// Starts rendering the triangles of shade_triangle() into a z-buffer
+// covering the clip window.  The pixels of the z-buffer are those of the
+// device, as far as the physical coordinates tell: devices that set
+// xlength to their size in pixels may use several physical units per
+// pixel.  For the others the z-buffer has 4 pixels per mm (about 100
+// dpi), the resolution the mem driver assumes.
+//--------------------------------------------------------------------------
+
+static void
+zbuffer_begin( void )
+{
+    PLINT i, npix;
+    PLFLT step;
+
+    if ( plsc->xlength > 0 )
+        step = floor( (PLFLT) ( plsc->phyxma - plsc->phyxmi ) / (PLFLT) plsc->xlength );
+    else
+        step = floor( plsc->xpmm / 4. );
+    step = MAX( step, 1. );
+
+    if ( ( zbuffer = (SURF_ZBUFFER *) malloc( sizeof ( SURF_ZBUFFER ) ) ) == NULL )
+        plexit( "plsurf3dl: Insufficient memory" );
+    zbuffer->x0   = plsc->clpxmi;
+    zbuffer->y0   = plsc->clpymi;
+    zbuffer->step = step;
+    zbuffer->nx   = MAX( (PLINT) ceil( ( plsc->clpxma - plsc->clpxmi ) / step ), 1 );
+    zbuffer->ny   = MAX( (PLINT) ceil( ( plsc->clpyma - plsc->clpymi ) / step ), 1 );
+    npix          = zbuffer->nx * zbuffer->ny;
+    if ( ( zbuffer->depth = (PLFLT *) malloc( (size_t) npix * sizeof ( PLFLT ) ) ) == NULL ||
+         ( zbuffer->icol1 = (unsigned short *) malloc( (size_t) npix * sizeof ( unsigned short ) ) ) == NULL )
+        plexit( "plsurf3dl: Insufficient memory" );
+
+    // An index of ncol1 leaves the pixel undrawn
+    for ( i = 0; i < npix; i++ )
+    {
+        zbuffer->depth[i] = -PLFLT_MAX;
+        zbuffer->icol1[i] = (unsigned short) plsc->ncol1;
+    }
+}
+
+//--------------------------------------------------------------------------
+// void zbuffer_end()
+//
+// Draws the z-buffer as one image of cmap1 colors and frees it.
+//--------------------------------------------------------------------------
+
+static void
+zbuffer_end( void )
+{
+    PLINT nx = zbuffer->nx + 1, ny = zbuffer->ny + 1;
+    PLINT ix, iy;
+    short *x, *y;
+
+    if ( ( x = (short *) malloc( (size_t) ( nx * ny ) * sizeof ( short ) ) ) == NULL ||
+         ( y = (short *) malloc( (size_t) ( nx * ny ) * sizeof ( short ) ) ) == NULL )
+        plexit( "plsurf3dl: Insufficient memory" );
+    for ( ix = 0; ix < nx; ix++ )
+    {
+        for ( iy = 0; iy < ny; iy++ )
+        {
+            x[ix * ny + iy] = (short) ( zbuffer->x0 + ix * zbuffer->step );
+            y[ix * ny + iy] = (short) ( zbuffer->y0 + iy * zbuffer->step );
+        }
+    }
+    plP_drawimage( x, y, zbuffer->icol1, NULL, nx, ny );
+
+    free( x );
+    free( y );
+    free( zbuffer->depth );
+    free( zbuffer->icol1 );
+    free( zbuffer );
+    zbuffer = NULL;
+}
+
+//--------------------------------------------------------------------------
+// void zbuffer_polygon()
+//
+// Renders the plane convex polygon of n points x, y, z (3-d coordinates)
+// with cmap1 color col1 into the z-buffer.  Pixels are covered if their
+// centre is within the polygon, and the polygon is drawn over pixels with
+// a depth at most as close to the viewer as its own, so that like the
+// fills of the painter's algorithm the later of two coinciding triangles
+// wins.
+//--------------------------------------------------------------------------
+
+static void
+zbuffer_polygon( PLFLT *x, PLFLT *y, PLFLT *z, PLINT n, PLFLT col1 )
+{
+    PLFLT          u[PL_MAXPOLY], v[PL_MAXPOLY], d[PL_MAXPOLY];
+    PLFLT          nu, nv, nd, umin, umax, vlo, vhi, cu, t, dcol, ddv;
+    PLFLT          *depth;
+    unsigned short *icol1, icol;
+    PLINT          i, j, a, b, ix, ix1, iy, iy1;
+
+    // Pixel coordinates and depth (larger is closer) of the points
+    for ( i = 0; i < n; i++ )
+    {
+        u[i] = ( plsc->wpxoff + plsc->wpxscl * plP_w3wcx( x[i], y[i], z[i] ) - zbuffer->x0 ) / zbuffer->step;
+        v[i] = ( plsc->wpyoff + plsc->wpyscl * plP_w3wcy( x[i], y[i], z[i] ) - zbuffer->y0 ) / zbuffer->step;
+        d[i] = plP_w3wcz( x[i], y[i], z[i] );
+    }
+
+    // Normal of the plane of the polygon by Newell's method, which gives
+    // the depth as a linear function of the pixel coordinates
+    nu = nv = nd = 0.;
+    for ( i = 0; i < n; i++ )
+    {
+        j   = ( i + 1 ) % n;
+        nu += ( v[i] - v[j] ) * ( d[i] + d[j] );
+        nv += ( d[i] - d[j] ) * ( u[i] + u[j] );
+        nd += ( u[i] - u[j] ) * ( v[i] + v[j] );
+    }
+    if ( fabs( nd ) < 1e-12 ) // seen edge on
+        return;
+
+    i    = (PLINT) ( col1 * plsc->ncol1 );
+    icol = (unsigned short) MAX( MIN( i, plsc->ncol1 - 1 ), 0 );
+
+    umin = umax = u[0];
+    for ( i = 1; i < n; i++ )
+    {
+        umin = MIN( umin, u[i] );
+        umax = MAX( umax, u[i] );
+    }
+    ix  = MAX( (PLINT) ceil( umin - 0.5 ), 0 );
+    ix1 = MIN( (PLINT) ceil( umax - 0.5 ), zbuffer->nx );
+    ddv = -nv / nd;
+    for (; ix < ix1; ix++ )
+    {
+        // Where the column of pixel centres enters and leaves the polygon.
+        // The ends of the edges are ordered the same way for both of the
+        // polygons sharing an edge, so that they leave no gap.
+        cu  = ix + 0.5;
+        vlo = PLFLT_MAX;
+        vhi = -PLFLT_MAX;
+        for ( i = 0; i < n; i++ )
+        {
+            j = ( i + 1 ) % n;
+            if ( u[i] < u[j] || ( u[i] == u[j] && v[i] < v[j] ) )
+            {
+                a = i;
+                b = j;
+            }
+            else
+            {
+                a = j;
+                b = i;
+            }
+            if ( u[a] == u[b] || cu < u[a] || cu >= u[b] )
+                continue;
+            t   = v[a] + ( cu - u[a] ) * ( v[b] - v[a] ) / ( u[b] - u[a] );
+            vlo = MIN( vlo, t );
+            vhi = MAX( vhi, t );
+        }
+        if ( vlo >= vhi )
+            continue;
+
+        iy    = MAX( (PLINT) ceil( vlo - 0.5 ), 0 );
+        iy1   = MIN( (PLINT) ceil( vhi - 0.5 ), zbuffer->ny );
+        depth = zbuffer->depth + (size_t) ix * (size_t) zbuffer->ny;
+        icol1 = zbuffer->icol1 + (size_t) ix * (size_t) zbuffer->ny;
+        dcol  = d[0] - ( nu * ( cu - u[0] ) + nv * ( iy + 0.5 - v[0] ) ) / nd;
+        for (; iy < iy1; iy++, dcol += ddv )
+        {
+            if ( dcol >= depth[iy] )
+            {
+                depth[iy] = dcol;
+                icol1[iy] = icol;
+            }
+        }
+    }
+}
+
 //--------------------------------------------------------------------------
 // void plt3zz()
 //
-// Draws the next zig-zag line for a 3-d plot.  The data is stored in array
-// z[][] as a function of x[] and y[], and is plotted out starting at index
-// (x0,y0).
+// Draws the next zig-zag line for a 3-d plot.  The physical coordinates
+// of the grid points are taken from gridu[] and gridv[] (and the colors
+// from gridc[]), and the line is plotted out starting at index (x0,y0).
 //
 // Depending on the state of "flag", the sequence of data points sent to
 // plnxtv is altered so as to allow cross-hatch plotting, or plotting
@@ -1620,21 +1859,17 @@ plGetAngleToLight( PLFLT* x, PLFLT* y, PLFLT* z )
 
 static void
 plt3zz( PLINT x0, PLINT y0, PLINT dx, PLINT dy, PLINT flag, PLINT *init,
-        PLFLT_VECTOR x, PLFLT_VECTOR y, PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
-        PLINT *u, PLINT *v, PLFLT* c )
+        PLINT nx, PLINT ny, PLINT *u, PLINT *v, PLFLT* c )
 {
-    PLINT n = 0;
-    PLFLT x2d, y2d;
-    PLFLT ( *getz )( PLPointer, PLINT, PLINT ) = zops->get;
+    PLINT n = 0, k;
 
     while ( 1 <= x0 && x0 <= nx && 1 <= y0 && y0 <= ny )
     {
-        x2d  = plP_w3wcx( x[x0 - 1], y[y0 - 1], getz( zp, x0 - 1, y0 - 1 ) );
-        y2d  = plP_w3wcy( x[x0 - 1], y[y0 - 1], getz( zp, x0 - 1, y0 - 1 ) );
-        u[n] = plP_wcpcx( x2d );
-        v[n] = plP_wcpcy( y2d );
+        k    = ( x0 - 1 ) * ny + y0 - 1;
+        u[n] = gridu[k];
+        v[n] = gridv[k];
         if ( c != NULL )
-            c[n] = ( getz( zp, x0 - 1, y0 - 1 ) - fc_minz ) / ( fc_maxz - fc_minz );
+            c[n] = gridc[k];
 
         switch ( flag )
         {
@@ -1678,12 +1913,11 @@ plt3zz( PLINT x0, PLINT y0, PLINT dx, PLINT dy, PLINT flag, PLINT *init,
         }
         if ( 1 <= x0 && x0 <= nx && 1 <= y0 && y0 <= ny )
         {
-            x2d  = plP_w3wcx( x[x0 - 1], y[y0 - 1], getz( zp, x0 - 1, y0 - 1 ) );
-            y2d  = plP_w3wcy( x[x0 - 1], y[y0 - 1], getz( zp, x0 - 1, y0 - 1 ) );
-            u[n] = plP_wcpcx( x2d );
-            v[n] = plP_wcpcy( y2d );
+            k    = ( x0 - 1 ) * ny + y0 - 1;
+            u[n] = gridu[k];
+            v[n] = gridv[k];
             if ( c != NULL )
-                c[n] = ( getz( zp, x0 - 1, y0 - 1 ) - fc_minz ) / ( fc_maxz - fc_minz );
+                c[n] = gridc[k];
             n++;
         }
     }
@@ -1936,10 +2170,9 @@ plgrid3( PLFLT tick )
 // points.
 //
 // These routines dynamically allocate memory for hidden line removal.
-// Memory is allocated in blocks of 2*BINC*sizeof(PLINT) bytes.  Large
-// values of BINC give better performance but also allocate more memory
-// than is needed. If your 3D plots are very "spiky" or you are working
-// with very large matrices then you will probably want to increase BINC.
+// The old and new views are swapped after every line rather than copied,
+// and are only reallocated when they need to grow, doubling in size (see
+// growview()), so they soon stop changing for the rest of the plot.
 //--------------------------------------------------------------------------
 
 static void
@@ -1967,9 +2200,7 @@ plnxtvhi( PLINT *u, PLINT *v, PLFLT* c, PLINT n, PLINT init )
     if ( init == 1 )
     {
         int i;
-        oldhiview = (PLINT *) malloc( (size_t) ( 2 * n ) * sizeof ( PLINT ) );
-        if ( !oldhiview )
-            myexit( "plnxtvhi: Out of memory." );
+        growview( &oldhiview, &oldhisize, 2 * n );
 
         oldhiview[0] = u[0];
         oldhiview[1] = v[0];
@@ -1999,22 +2230,7 @@ plnxtvhi( PLINT *u, PLINT *v, PLFLT* c, PLINT n, PLINT init )
     //
     xxhi = 0;
     if ( pl3upv != 0 )
-    {
-        newhisize = 2 * ( mhi + BINC );
-        if ( newhiview != NULL )
-        {
-            newhiview =
-                (PLINT *) realloc( (void *) newhiview,
-                    (size_t) newhisize * sizeof ( PLINT ) );
-        }
-        else
-        {
-            newhiview =
-                (PLINT *) malloc( (size_t) newhisize * sizeof ( PLINT ) );
-        }
-        if ( !newhiview )
-            myexit( "plnxtvhi: Out of memory." );
-    }
+        growview( &newhiview, &newhisize, 2 * ( mhi + n ) );
 
     // Do the draw or shading with hidden line removal
 
@@ -2286,9 +2502,7 @@ plnxtvlo( PLINT *u, PLINT *v, PLFLT*c, PLINT n, PLINT init )
     //
     if ( init == 1 )
     {
-        oldloview = (PLINT *) malloc( (size_t) ( 2 * n ) * sizeof ( PLINT ) );
-        if ( !oldloview )
-            myexit( "\nplnxtvlo: Out of memory." );
+        growview( &oldloview, &oldlosize, 2 * n );
 
         plP_draw3d( u[0], v[0], c, 0, 1 );
         oldloview[0] = u[0];
@@ -2320,22 +2534,7 @@ plnxtvlo( PLINT *u, PLINT *v, PLFLT*c, PLINT n, PLINT init )
     i    = 0;
     j    = 0;
     if ( pl3upv != 0 )
-    {
-        newlosize = 2 * ( mlo + BINC );
-        if ( newloview != NULL )
-        {
-            newloview =
-                (PLINT *) realloc( (void *) newloview,
-                    (size_t) newlosize * sizeof ( PLINT ) );
-        }
-        else
-        {
-            newloview =
-                (PLINT *) malloc( (size_t) newlosize * sizeof ( PLINT ) );
-        }
-        if ( !newloview )
-            myexit( "plnxtvlo: Out of memory." );
-    }
+        growview( &newloview, &newlosize, 2 * ( mlo + n ) );
 
     //
     // (oldloview[2*i], oldloview[2*i]) is the i'th point in the old array
@@ -2534,6 +2733,25 @@ plnxtvlo( PLINT *u, PLINT *v, PLFLT*c, PLINT n, PLINT init )
     swaploview();
 }
 
+//--------------------------------------------------------------------------
+// growview
+//
+// Makes sure that the view array *view, of *size PLINTs, has room for at
+// least need PLINTs.  The array at least doubles when it grows, so that
+// adding points one by one takes constant amortized time.
+//--------------------------------------------------------------------------
+
+static void
+growview( PLINT **view, PLINT *size, PLINT need )
+{
+    if ( need <= *size && *view != NULL )
+        return;
+
+    *size = MAX( need, MAX( 2 * *size, 2 * BINC ) );
+    if ( ( *view = (PLINT *) realloc( (void *) *view, (size_t) *size * sizeof ( PLINT ) ) ) == NULL )
+        myexit( "plot3d: Out of memory." );
+}
+
 //--------------------------------------------------------------------------
 // savehipoint
 // savelopoint
@@ -2548,14 +2766,8 @@ savehipoint( PLINT px, PLINT py )
     if ( pl3upv == 0 )
         return;
 
-    if ( xxhi >= newhisize )      // allocate additional space
-    {
-        newhisize += 2 * BINC;
-        newhiview  = (PLINT *) realloc( (void *) newhiview,
-            (size_t) newhisize * sizeof ( PLINT ) );
-        if ( !newhiview )
-            myexit( "savehipoint: Out of memory." );
-    }
+    if ( xxhi + 2 > newhisize )
+        growview( &newhiview, &newhisize, xxhi + 2 );
 
     newhiview[xxhi] = px;
     xxhi++;
@@ -2569,14 +2781,8 @@ savelopoint( PLINT px, PLINT py )
     if ( pl3upv == 0 )
         return;
 
-    if ( xxlo >= newlosize )      // allocate additional space
-    {
-        newlosize += 2 * BINC;
-        newloview  = (PLINT *) realloc( (void *) newloview,
-            (size_t) newlosize * sizeof ( PLINT ) );
-        if ( !newloview )
-            myexit( "savelopoint: Out of memory." );
-    }
+    if ( xxlo + 2 > newlosize )
+        growview( &newloview, &newlosize, xxlo + 2 );
 
     newloview[xxlo] = px;
     xxlo++;
@@ -2595,7 +2801,7 @@ savelopoint( PLINT px, PLINT py )
 static void
 swaphiview( void )
 {
-    PLINT *tmp;
+    PLINT *tmp, size;
 
     if ( pl3upv != 0 )
     {
@@ -2603,13 +2809,16 @@ swaphiview( void )
         tmp       = oldhiview;
         oldhiview = newhiview;
         newhiview = tmp;
+        size      = oldhisize;
+        oldhisize = newhisize;
+        newhisize = size;
     }
 }
 
 static void
 swaploview( void )
 {
-    PLINT *tmp;
+    PLINT *tmp, size;
 
     if ( pl3upv != 0 )
     {
@@ -2617,6 +2826,9 @@ swaploview( void )
         tmp       = oldloview;
         oldloview = newloview;
         newloview = tmp;
+        size      = oldlosize;
+        oldlosize = newlosize;
+        newlosize = size;
     }
 }
 
@@ -2636,6 +2848,11 @@ freework( void )
     free_mem( vtmp );
     free_mem( utmp );
     free_mem( ctmp );
+    free_mem( gridu );
+    free_mem( gridv );
+    free_mem( gridc );
+    oldhisize = newhisize = 0;
+    oldlosize = newlosize = 0;
 }
 
 //--------------------------------------------------------------------------
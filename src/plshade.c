@@ -127,25 +127,69 @@
 #define OK                   0
 #define UNDEF                64
 #define NUMBER_BISECTIONS    10
+#define SWEEP_TILE           64   // columns of cells per tile of plshades_sweep
 
 #define linear( val1, val2, level )    ( ( level - val1 ) / ( val2 - val1 ) )
 
+// Shade region and where its boundaries cross the edges of a cell
+
+typedef struct
+{
+    PLFLT sh_min, sh_max;
+    int   min_points, max_points, n_point;
+    int   min_pts[4], max_pts[4];
+} SHADE_CELL;
+
+// Polygons to fill for one shade, in grid coordinates: polygon i is made
+// of the points first[i] to first[i + 1] - 1
+
+typedef struct
+{
+    PLINT npoly, poly_size;
+    PLINT *first;
+    PLINT npts, pts_size, maxpts;
+    PLFLT *x, *y;
+} SHADE_BAND;
+
+// Grid shared by all shades in plshades_sweep(): the values, where they
+// are among the levels, which cells lie entirely within one shade, and
+// the polygons of every shade found in each tile of columns
+
+typedef struct
+{
+    PLINT                nx, ny, nband, rectangular, ntile;
+    PLFLT_VECTOR         clevel;
+    PLFLT                *a;
+    PLINT                *rlt, *rle;
+    PLINT                *full;
+    SHADE_BAND           *band;     // nband shades of tile 0, then of tile 1, ...
+    PLINT                transform; // transform the polygons in the tiles
+    PLFLT                xmin, ymin, dx, dy;
+    PLTRANSFORM_callback pltr;
+    PLPointer            pltr_data;
+} SHADE_SWEEP;
+
 // Global variables
 
-static PLFLT sh_max, sh_min;
-static int   min_points, max_points, n_point;
-static int   min_pts[4], max_pts[4];
 static PLINT pen_col_min, pen_col_max;
 static PLFLT pen_wd_min, pen_wd_max;
-static PLFLT int_val;
 
 // Function prototypes
 
 static void
-set_cond( register int *cond, register PLFLT *a, register PLINT n );
+set_cond( int *cond, const PLFLT *a, PLINT n, PLFLT sh_min, PLFLT sh_max );
 
 static int
-find_interval( PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x );
+find_interval( SHADE_CELL *sc, PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x );
+
+static int
+shade_cell( SHADE_CELL *sc, PLFLT *a, PLINT nx, PLINT ny, PLINT ix, PLINT iy,
+            PLFLT *v, int *c, PLFLT *x, PLFLT *y, PLINT *n, PLINT *slope,
+            PLINT poly[2][4] );
+
+static int
+split_cell( PLINT poly[2][4], PLINT v1, PLINT v2, PLINT v3, PLINT v4,
+            PLINT w1, PLINT w2, PLINT w3, PLINT w4 );
 
 static void
 selected_polygon( PLFILL_callback fill, PLDEFINED_callback defined,
@@ -160,14 +204,53 @@ big_recl( int *cond_code, register int ny, int dx, int dy,
           int *ix, int *iy );
 
 static void
-draw_boundary( PLINT slope, PLFLT *x, PLFLT *y );
+draw_boundary( SHADE_CELL *sc, PLINT slope, PLFLT *x, PLFLT *y );
 
 static PLINT
-plctest( PLFLT *x, PLFLT level );
+plctest( PLFLT *x, PLFLT int_val );
 
 static PLINT
 plctestez( PLFLT *a, PLINT nx, PLINT ny, PLINT ix,
-           PLINT iy, PLFLT level );
+           PLINT iy, PLFLT int_val );
+
+static void
+plshades_sweep( PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
+                PLDEFINED_callback defined,
+                PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax,
+                PLFLT_VECTOR clevel, PLINT nlevel, PLFLT fill_width,
+                PLFILL_callback fill, PLINT rectangular,
+                PLTRANSFORM_callback pltr, PLPointer pltr_data );
+
+static void
+sweep_rank( PLINT ix, PLINT thread, PLPointer data );
+
+static void
+sweep_full_column( PLINT ix, PLINT thread, PLPointer data );
+
+static void
+sweep_tile( PLINT tile, PLINT thread, PLPointer data );
+
+static PLINT
+sweep_full( SHADE_SWEEP *sw, PLINT ix, PLINT iy );
+
+static void
+sweep_columns( SHADE_SWEEP *sw, PLINT ix0, PLINT ix1, SHADE_BAND *band );
+
+static int
+sweep_cond( SHADE_SWEEP *sw, PLINT k, PLINT i );
+
+static void
+band_add_polygon( SHADE_BAND *band, PLINT n, PLFLT *x, PLFLT *y );
+
+static void
+band_add_point( SHADE_BAND *band, PLFLT x, PLFLT y );
+
+static void
+band_add_rect( SHADE_BAND *band, PLINT ix, PLINT iy, PLINT nx, PLINT ny,
+               PLINT rectangular );
+
+static void
+big_rect_cells( PLINT *full, PLINT ny, PLINT dx, PLINT dy, PLINT *ix, PLINT *iy );
 
 static void
 plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
@@ -251,7 +334,7 @@ plfshades( PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
            PLTRANSFORM_callback pltr, PLPointer pltr_data )
 {
     PLFLT shade_min, shade_max, shade_color;
-    PLINT i, init_color;
+    PLINT i, init_color, sweep;
     PLFLT init_width, color_min, color_max, color_range;
 
     // Color range to use
@@ -259,7 +342,17 @@ plfshades( PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
     color_max   = plsc->cmap1_max;
     color_range = color_max - color_min;
 
-    for ( i = 0; i < nlevel - 1; i++ )
+    // With the -shade_sweep option all shades are done in one pass over
+    // the grid, which needs increasing levels
+    sweep = plsc->shade_sweep && plsc->level >= 3 && fill != NULL &&
+            nx > 1 && ny > 1 && nlevel > 1;
+    for ( i = 0; sweep && i < nlevel - 1; i++ )
+        sweep = clevel[i] < clevel[i + 1];
+    if ( sweep )
+        plshades_sweep( zops, zp, nx, ny, defined, xmin, xmax, ymin, ymax,
+            clevel, nlevel, fill_width, fill, rectangular, pltr, pltr_data );
+
+    for ( i = 0; !sweep && i < nlevel - 1; i++ )
     {
         shade_min   = clevel[i];
         shade_max   = clevel[i + 1];
@@ -319,6 +412,467 @@ plfshades( PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
     }
 }
 
+//--------------------------------------------------------------------------
+// plshades_sweep()
+//
+// Does the shading of plfshades for all shades at once: the grid is
+// evaluated once, each grid value is classified against all levels (which
+// must be increasing) and every cell is visited once, adding its parts
+// within each of the shades it meets to the polygons of that shade.  Cells
+// which lie entirely within one shade are merged into rectangles when
+// rectangles map to rectangles.  The polygons are then filled shade by
+// shade.  The parts of the cells are the same as the ones plshade_int
+// finds, so only the number of polygons and the order in which they are
+// filled differ from shading the levels one by one.
+//
+// The classification and the polygons of the tiles of SWEEP_TILE columns
+// are computed on up to plP_nthreads() threads.  The tiles do not depend
+// on the number of threads, and the polygons are filled in the order of
+// the tiles, so the plot is the same whatever the number of threads.
+// zops, fill and any pltr other than pltr0, pltr1, pltr2 and pltr2p are
+// only called from the calling thread.
+//--------------------------------------------------------------------------
+
+static void
+plshades_sweep( PLF2OPS zops, PLPointer zp, PLINT nx, PLINT ny,
+                PLDEFINED_callback defined,
+                PLFLT xmin, PLFLT xmax, PLFLT ymin, PLFLT ymax,
+                PLFLT_VECTOR clevel, PLINT nlevel, PLFLT fill_width,
+                PLFILL_callback fill, PLINT rectangular,
+                PLTRANSFORM_callback pltr, PLPointer pltr_data )
+{
+    SHADE_SWEEP sw;
+    SHADE_BAND  *band;
+    PLINT       i, j, k, n, t, maxpts, nthreads;
+    PLFLT       *x, *y, init_width, color_min, color_range;
+
+    sw.nx          = nx;
+    sw.ny          = ny;
+    sw.nband       = nlevel - 1;
+    sw.clevel      = clevel;
+    sw.rectangular = rectangular || ( pltr == NULL && plsc->coordinate_transform == NULL );
+    sw.ntile       = ( nx - 1 + SWEEP_TILE - 1 ) / SWEEP_TILE;
+    sw.xmin        = xmin;
+    sw.ymin        = ymin;
+    sw.dx          = ( xmax - xmin ) / ( nx - 1 );
+    sw.dy          = ( ymax - ymin ) / ( ny - 1 );
+    sw.pltr        = pltr;
+    sw.pltr_data   = pltr_data;
+
+    // Only the transformations of the library are known to be thread safe
+    sw.transform = pltr == NULL || pltr == pltr0 || pltr == pltr1 ||
+                   pltr == pltr2 || pltr == pltr2p;
+
+    if ( ( ( sw.a = (PLFLT *) malloc( (size_t) ( nx * ny ) * sizeof ( PLFLT ) ) ) == NULL ) ||
+         ( ( sw.rlt = (PLINT *) malloc( (size_t) ( nx * ny ) * sizeof ( PLINT ) ) ) == NULL ) ||
+         ( ( sw.rle = (PLINT *) malloc( (size_t) ( nx * ny ) * sizeof ( PLINT ) ) ) == NULL ) ||
+         ( ( sw.full = (PLINT *) malloc( (size_t) ( ( nx - 1 ) * ( ny - 1 ) ) * sizeof ( PLINT ) ) ) == NULL ) ||
+         ( ( sw.band = (SHADE_BAND *) calloc( (size_t) ( sw.ntile * sw.nband ), sizeof ( SHADE_BAND ) ) ) == NULL ) )
+    {
+        plexit( "plfshades: Insufficient memory" );
+    }
+
+    // zops need not be thread safe, so the grid is evaluated here
+    plP_f2eval_copy( zops->f2eval, zp, 0, nx, 0, ny, sw.a );
+
+    nthreads = plP_nthreads();
+    plP_parallel( nx, nthreads, sweep_rank, &sw );
+    plP_parallel( nx - 1, nthreads, sweep_full_column, &sw );
+    plP_parallel( sw.ntile, nthreads, sweep_tile, &sw );
+
+    for ( k = 0, maxpts = 1; k < sw.ntile * sw.nband; k++ )
+        maxpts = MAX( maxpts, sw.band[k].maxpts );
+    if ( ( ( x = (PLFLT *) malloc( (size_t) maxpts * sizeof ( PLFLT ) ) ) == NULL ) ||
+         ( ( y = (PLFLT *) malloc( (size_t) maxpts * sizeof ( PLFLT ) ) ) == NULL ) )
+        plexit( "plfshades: Insufficient memory" );
+
+    // Fill the shades in order, as plfshade1 would have
+    init_width  = plsc->width;
+    color_min   = plsc->cmap1_min;
+    color_range = plsc->cmap1_max - color_min;
+    for ( i = 0; i < sw.nband; i++ )
+    {
+        plstyl( (PLINT) 0, NULL, NULL );
+        plwidth( fill_width );
+        plcol1( color_min + i / (PLFLT) ( nlevel - 2 ) * color_range );
+
+        for ( t = 0; t < sw.ntile; t++ )
+        {
+            band = &sw.band[t * sw.nband + i];
+            for ( j = 0; j < band->npoly; j++ )
+            {
+                n = band->first[j + 1] - band->first[j];
+                if ( sw.transform )
+                {
+                    exfill( fill, defined, n, band->x + band->first[j], band->y + band->first[j] );
+                    continue;
+                }
+                for ( k = 0; k < n; k++ )
+                {
+                    x[k] = band->x[band->first[j] + k];
+                    y[k] = band->y[band->first[j] + k];
+                    ( *pltr )( x[k], y[k], &x[k], &y[k], pltr_data );
+                }
+                exfill( fill, defined, n, x, y );
+            }
+            free( (void *) band->first );
+            free( (void *) band->x );
+            free( (void *) band->y );
+        }
+    }
+    plwidth( init_width );
+
+    free( (void *) x );
+    free( (void *) y );
+    free( (void *) sw.band );
+    free( (void *) sw.a );
+    free( (void *) sw.rlt );
+    free( (void *) sw.rle );
+    free( (void *) sw.full );
+}
+
+//--------------------------------------------------------------------------
+// sweep_rank()
+//
+// Locates the values of column ix among the levels: rlt levels are below
+// a value and rle levels below or equal to it, so that it is within shade
+// i when rle > i and rlt < i + 2.  Both are -1 for undefined (NaN) values.
+//--------------------------------------------------------------------------
+
+static void
+sweep_rank( PLINT ix, PLINT PL_UNUSED( thread ), PLPointer data )
+{
+    SHADE_SWEEP  *sw    = (SHADE_SWEEP *) data;
+    PLFLT_VECTOR clevel = sw->clevel;
+    PLINT        nlevel = sw->nband + 1;
+    PLINT        i, j, k, n, iy;
+    PLFLT        v;
+
+    for ( iy = 0; iy < sw->ny; iy++ )
+    {
+        k          = ix * sw->ny + iy;
+        v          = sw->a[k];
+        sw->rlt[k] = sw->rle[k] = -1;
+        if ( isnan( v ) )
+            continue;
+        for ( i = 0, j = nlevel; i < j; )
+        {
+            n = ( i + j ) / 2;
+            if ( clevel[n] < v )
+                i = n + 1;
+            else
+                j = n;
+        }
+        sw->rlt[k] = i;
+        for ( j = nlevel; i < j; )
+        {
+            n = ( i + j ) / 2;
+            if ( clevel[n] <= v )
+                i = n + 1;
+            else
+                j = n;
+        }
+        sw->rle[k] = i;
+    }
+}
+
+//--------------------------------------------------------------------------
+// sweep_full_column()
+//
+// Finds the shade each cell of column ix lies entirely within, if any.
+//--------------------------------------------------------------------------
+
+static void
+sweep_full_column( PLINT ix, PLINT PL_UNUSED( thread ), PLPointer data )
+{
+    SHADE_SWEEP *sw = (SHADE_SWEEP *) data;
+    PLINT       iy;
+
+    for ( iy = 0; iy < sw->ny - 1; iy++ )
+        sw->full[ix * ( sw->ny - 1 ) + iy] = sweep_full( sw, ix, iy );
+}
+
+//--------------------------------------------------------------------------
+// sweep_tile()
+//
+// Finds the polygons of all shades within the columns of tile, and maps
+// them to world coordinates if sw->transform is set.  Rectangles of cells
+// are not merged across tiles, so the tiles are independent.
+//--------------------------------------------------------------------------
+
+static void
+sweep_tile( PLINT tile, PLINT PL_UNUSED( thread ), PLPointer data )
+{
+    SHADE_SWEEP *sw = (SHADE_SWEEP *) data;
+    SHADE_BAND  *band;
+    PLINT       ix0 = tile * SWEEP_TILE;
+    PLINT       i, k;
+
+    sweep_columns( sw, ix0, MIN( ix0 + SWEEP_TILE, sw->nx - 1 ), sw->band + tile * sw->nband );
+    if ( !sw->transform )
+        return;
+
+    for ( i = 0; i < sw->nband; i++ )
+    {
+        band = &sw->band[tile * sw->nband + i];
+        for ( k = 0; k < band->npts; k++ )
+        {
+            if ( sw->pltr )
+                ( *sw->pltr )( band->x[k], band->y[k], &band->x[k], &band->y[k], sw->pltr_data );
+            else
+            {
+                band->x[k] = sw->xmin + band->x[k] * sw->dx;
+                band->y[k] = sw->ymin + band->y[k] * sw->dy;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+// sweep_full()
+//
+// Returns 1 + the first shade cell (ix, iy) lies entirely within (all of
+// its corners are within the shade), or 0 if there is none.
+//--------------------------------------------------------------------------
+
+static PLINT
+sweep_full( SHADE_SWEEP *sw, PLINT ix, PLINT iy )
+{
+    PLINT k = ix * sw->ny + iy;
+    PLINT lo, hi;
+
+    if ( sw->rlt[k] < 0 || sw->rlt[k + 1] < 0 ||
+         sw->rlt[k + sw->ny] < 0 || sw->rlt[k + sw->ny + 1] < 0 )
+        return 0;
+
+    // shades containing all corners: rle > i and rlt < i + 2 for each
+    lo = MAX( MAX( sw->rlt[k], sw->rlt[k + 1] ), MAX( sw->rlt[k + sw->ny], sw->rlt[k + sw->ny + 1] ) ) - 1;
+    hi = MIN( MIN( sw->rle[k], sw->rle[k + 1] ), MIN( sw->rle[k + sw->ny], sw->rle[k + sw->ny + 1] ) ) - 1;
+    lo = MAX( lo, 0 );
+    hi = MIN( hi, sw->nband - 1 );
+    return lo <= hi ? lo + 1 : 0;
+}
+
+//--------------------------------------------------------------------------
+// sweep_columns()
+//
+// Adds the parts of the cells of columns ix0 to ix1 - 1 within each shade
+// to the polygons of the shade in band[], in the order plshade_int visits
+// them.
+//--------------------------------------------------------------------------
+
+static void
+sweep_columns( SHADE_SWEEP *sw, PLINT ix0, PLINT ix1, SHADE_BAND *band )
+{
+    SHADE_CELL sc;
+    PLINT      nx = sw->nx, ny = sw->ny;
+    PLINT      ix, iy, i, j, k, m, n, lo, hi, full, npoly, slope = 0, poly[2][4];
+    PLINT      *cell;
+    PLFLT      v[4], x[8], y[8], xx[4], yy[4];
+    int        c[4];
+
+    for ( ix = ix0; ix < ix1; ix++ )
+    {
+        for ( iy = 0; iy < ny - 1; iy++ )
+        {
+            k    = ix * ny + iy;
+            cell = sw->full + ix * ( ny - 1 ) + iy;
+
+            // skip cells with undefined (NaN) corners
+            if ( sw->rlt[k] < 0 || sw->rlt[k + 1] < 0 || sw->rlt[k + ny] < 0 || sw->rlt[k + ny + 1] < 0 )
+                continue;
+
+            // A cell entirely within one shade is merged with its
+            // neighbours within the same shade into a rectangle if
+            // possible, or else into a strip of cells along the column,
+            // whose outline follows the transformed grid points.  The
+            // merged cells are negated, so that they are not filled again.
+            full = *cell;
+            if ( full > 0 )
+            {
+                big_rect_cells( cell, ny - 1, sw->rectangular ? ix1 - ix : 1, ny - 1 - iy, &i, &j );
+                band_add_rect( &band[full - 1], ix, iy, i, j, sw->rectangular );
+            }
+            full = ABS( full );
+
+            // The shades the cell meets: not all corners below the shade
+            // (rle <= i) nor all above it (rlt >= i + 2)
+            lo = MIN( MIN( sw->rlt[k], sw->rlt[k + 1] ), MIN( sw->rlt[k + ny], sw->rlt[k + ny + 1] ) ) - 1;
+            hi = MAX( MAX( sw->rle[k], sw->rle[k + 1] ), MAX( sw->rle[k + ny], sw->rle[k + ny + 1] ) ) - 1;
+            lo = MAX( lo, 0 );
+            hi = MIN( hi, sw->nband - 1 );
+
+            v[0] = sw->a[k];
+            v[1] = sw->a[k + 1];
+            v[2] = sw->a[k + ny + 1];
+            v[3] = sw->a[k + ny];
+            for ( i = lo; i <= hi; i++ )
+            {
+                if ( full > 0 && i == full - 1 )
+                    continue;
+                c[0] = sweep_cond( sw, k, i );
+                c[1] = sweep_cond( sw, k + 1, i );
+                c[2] = sweep_cond( sw, k + ny + 1, i );
+                c[3] = sweep_cond( sw, k + ny, i );
+
+                // also entirely within this shade, which happens only
+                // when all corners are on the boundary of two shades
+                if ( c[0] == OK && c[1] == OK && c[2] == OK && c[3] == OK )
+                {
+                    band_add_rect( &band[i], ix, iy, 1, 1, 1 );
+                    continue;
+                }
+
+                sc.sh_min = sw->clevel[i];
+                sc.sh_max = sw->clevel[i + 1];
+                npoly     = shade_cell( &sc, sw->a, nx, ny, ix, iy, v, c, x, y, &n, &slope, poly );
+                if ( npoly == 1 )
+                    band_add_polygon( &band[i], n, x, y );
+                for ( j = 0; npoly == 2 && j < 2; j++ )
+                {
+                    for ( m = 0, n = 0; m < 4; m++ )
+                    {
+                        if ( poly[j][m] >= 0 )
+                        {
+                            xx[n]   = x[poly[j][m]];
+                            yy[n++] = y[poly[j][m]];
+                        }
+                    }
+                    band_add_polygon( &band[i], n, xx, yy );
+                }
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+// sweep_cond()
+//
+// Condition code of grid point k for shade i.
+//--------------------------------------------------------------------------
+
+static int
+sweep_cond( SHADE_SWEEP *sw, PLINT k, PLINT i )
+{
+    if ( sw->rle[k] <= i )
+        return NEG;
+    if ( sw->rlt[k] >= i + 2 )
+        return POS;
+    return OK;
+}
+
+//--------------------------------------------------------------------------
+// band_add_polygon()
+//
+// Starts a new polygon in band, with the n points x[], y[].
+//--------------------------------------------------------------------------
+
+static void
+band_add_polygon( SHADE_BAND *band, PLINT n, PLFLT *x, PLFLT *y )
+{
+    PLINT i;
+
+    // room for the closing entry of first too
+    if ( band->npoly + 1 >= band->poly_size )
+    {
+        band->poly_size = MAX( 2 * band->poly_size, 64 );
+        if ( ( band->first = (PLINT *) realloc( band->first, (size_t) band->poly_size * sizeof ( PLINT ) ) ) == NULL )
+            plexit( "plfshades: Insufficient memory" );
+    }
+    band->first[band->npoly++] = band->npts;
+    band->first[band->npoly]   = band->npts;
+    for ( i = 0; i < n; i++ )
+        band_add_point( band, x[i], y[i] );
+}
+
+//--------------------------------------------------------------------------
+// band_add_point()
+//
+// Adds point (x, y) to the last polygon of band.
+//--------------------------------------------------------------------------
+
+static void
+band_add_point( SHADE_BAND *band, PLFLT x, PLFLT y )
+{
+    if ( band->npts == band->pts_size )
+    {
+        band->pts_size = MAX( 2 * band->pts_size, 256 );
+        if ( ( ( band->x = (PLFLT *) realloc( band->x, (size_t) band->pts_size * sizeof ( PLFLT ) ) ) == NULL ) ||
+             ( ( band->y = (PLFLT *) realloc( band->y, (size_t) band->pts_size * sizeof ( PLFLT ) ) ) == NULL ) )
+            plexit( "plfshades: Insufficient memory" );
+    }
+    band->x[band->npts] = x;
+    band->y[band->npts] = y;
+    band->npts++;
+    band->first[band->npoly] = band->npts;
+    band->maxpts = MAX( band->maxpts, band->npts - band->first[band->npoly - 1] );
+}
+
+//--------------------------------------------------------------------------
+// band_add_rect()
+//
+// Adds the rectangle of nx by ny cells from cell (ix, iy) to band.  Unless
+// rectangular is set, nx must be 1 and the outline of the cells goes
+// through all grid points on both sides of the column.
+//--------------------------------------------------------------------------
+
+static void
+band_add_rect( SHADE_BAND *band, PLINT ix, PLINT iy, PLINT nx, PLINT ny,
+               PLINT rectangular )
+{
+    PLFLT x[4], y[4];
+    PLINT i;
+
+    if ( rectangular || ny == 1 )
+    {
+        x[0] = x[1] = ix;
+        x[2] = x[3] = ix + nx;
+        y[0] = y[3] = iy;
+        y[1] = y[2] = iy + ny;
+        band_add_polygon( band, 4, x, y );
+        return;
+    }
+
+    band_add_polygon( band, 0, NULL, NULL );
+    for ( i = 0; i <= ny; i++ )
+        band_add_point( band, ix, iy + i );
+    for ( i = ny; i >= 0; i-- )
+        band_add_point( band, ix + 1, iy + i );
+}
+
+//--------------------------------------------------------------------------
+// big_rect_cells()
+//
+// Like big_recl(), but for the cells in full[] (with ny cells per column)
+// which lie entirely within one shade: finds a big rectangle of cells
+// within the same shade as full[0], at most dx by dy cells, extending
+// first along the column and then across columns.  Its size is returned
+// in ix, iy, and its cells are negated.
+//--------------------------------------------------------------------------
+
+static void
+big_rect_cells( PLINT *full, PLINT ny, PLINT dx, PLINT dy, PLINT *ix, PLINT *iy )
+{
+    PLINT shade = full[0];
+    PLINT i, j, x, y;
+
+    for ( y = 1; y < dy && full[y] == shade; y++ )
+        ;
+    for ( x = 1; x < dx; x++ )
+    {
+        for ( j = 0; j < y && full[x * ny + j] == shade; j++ )
+            ;
+        if ( j < y )
+            break;
+    }
+
+    for ( i = 0; i < x; i++ )
+        for ( j = 0; j < y; j++ )
+            full[i * ny + j] = -shade;
+    *ix = x;
+    *iy = y;
+}
+
 // N.B. This routine only needed by the Fortran interface to distinguish
 // the case where pltr and pltr_data are NULL.  So don't put declaration in
 // header which might encourage others to use this in some other context.
@@ -503,11 +1057,12 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
              PLFILL_callback fill, PLINT rectangular,
              PLTRANSFORM_callback pltr, PLPointer pltr_data )
 {
-    PLINT n, slope = 0, ix, iy;
-    int   count, i, j, nxny;
-    PLFLT *a, *a0, *a1, dx, dy;
-    PLFLT x[8], y[8], xp[2], tx, ty, init_width;
-    int   *c, *c0, *c1;
+    PLINT      n, slope = 0, ix, iy, npoly, poly[2][4];
+    int        count, i, j, nxny, cc[4];
+    PLFLT      *a, *a0, *a1, dx, dy;
+    PLFLT      x[8], y[8], v[4], tx, ty, init_width;
+    int        *c, *c0, *c1;
+    SHADE_CELL sc;
 
     (void) c2eval;   // Cast to void to silence compiler warning about unused parameter
 
@@ -532,7 +1087,6 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
     if ( pltr == NULL && plsc->coordinate_transform == NULL )
         rectangular = 1;
 
-    int_val    = shade_max - shade_min;
     init_width = plsc->width;
 
     pen_col_min = min_color;
@@ -567,9 +1121,7 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
         return;
     }
 
-    for ( ix = 0; ix < nx; ix++ )
-        for ( iy = 0; iy < ny; iy++ )
-            a[iy + ix * ny] = f2eval( ix, iy, f2eval_data );
+    plP_f2eval_copy( f2eval, f2eval_data, 0, nx, 0, ny, a );
 
     // alloc space for condition codes
 
@@ -580,10 +1132,10 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
         return;
     }
 
-    sh_min = shade_min;
-    sh_max = shade_max;
+    sc.sh_min = shade_min;
+    sc.sh_max = shade_max;
 
-    set_cond( c, a, nxny );
+    set_cond( c, a, nxny, shade_min, shade_max );
     dx = ( xmax - xmin ) / ( nx - 1 );
     dy = ( ymax - ymin ) / ( ny - 1 );
     a0 = a;
@@ -649,39 +1201,15 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
 
             // Only part of rectangle can be filled
 
-            n_point = min_points = max_points = 0;
-            n       = find_interval( a0[iy], a0[iy + 1], c0[iy], c0[iy + 1], xp );
-            for ( j = 0; j < n; j++ )
-            {
-                x[j] = ix;
-                y[j] = iy + xp[j];
-            }
-
-            i = find_interval( a0[iy + 1], a1[iy + 1],
-                c0[iy + 1], c1[iy + 1], xp );
-
-            for ( j = 0; j < i; j++ )
-            {
-                x[j + n] = ix + xp[j];
-                y[j + n] = iy + 1;
-            }
-            n += i;
-
-            i = find_interval( a1[iy + 1], a1[iy], c1[iy + 1], c1[iy], xp );
-            for ( j = 0; j < i; j++ )
-            {
-                x[n + j] = ix + 1;
-                y[n + j] = iy + 1 - xp[j];
-            }
-            n += i;
-
-            i = find_interval( a1[iy], a0[iy], c1[iy], c0[iy], xp );
-            for ( j = 0; j < i; j++ )
-            {
-                x[n + j] = ix + 1 - xp[j];
-                y[n + j] = iy;
-            }
-            n += i;
+            v[0]  = a0[iy];
+            v[1]  = a0[iy + 1];
+            v[2]  = a1[iy + 1];
+            v[3]  = a1[iy];
+            cc[0] = c0[iy];
+            cc[1] = c0[iy + 1];
+            cc[2] = c1[iy + 1];
+            cc[3] = c1[iy];
+            npoly = shade_cell( &sc, a, nx, ny, ix, iy, v, cc, x, y, &n, &slope, poly );
 
             if ( pltr )
             {
@@ -701,112 +1229,12 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
                 }
             }
 
-            if ( min_points == 4 )
-                slope = plctestez( a, nx, ny, ix, iy, shade_min );
-            if ( max_points == 4 )
-                slope = plctestez( a, nx, ny, ix, iy, shade_max );
-
-            // n = number of end of line segments
-            // min_points = number times shade_min meets edge
-            // max_points = number times shade_max meets edge
-
-            // special cases: check number of times a contour is in a box
-
-            switch ( ( min_points << 3 ) + max_points )
-            {
-            case 000:
-            case 020:
-            case 002:
-            case 022:
-                if ( fill != NULL && n > 0 )
-                    exfill( fill, defined, n, x, y );
-                break;
-            case 040:   // 2 contour lines in box
-            case 004:
-                if ( n != 6 )
-                    fprintf( stderr, "plfshade err n=%d !6", (int) n );
-                if ( slope == 1 && c0[iy] == OK )
-                {
-                    if ( fill != NULL )
-                        exfill( fill, defined, n, x, y );
-                }
-                else if ( slope == 1 )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 2, -1 );
-                    selected_polygon( fill, defined, x, y, 3, 4, 5, -1 );
-                }
-                else if ( c0[iy + 1] == OK )
-                {
-                    if ( fill != NULL )
-                        exfill( fill, defined, n, x, y );
-                }
-                else
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 5, -1 );
-                    selected_polygon( fill, defined, x, y, 2, 3, 4, -1 );
-                }
-                break;
-            case 044:
-                if ( n != 8 )
-                    fprintf( stderr, "plfshade err n=%d !8", (int) n );
-                if ( slope == 1 )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 2, 3 );
-                    selected_polygon( fill, defined, x, y, 4, 5, 6, 7 );
-                }
-                else
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 6, 7 );
-                    selected_polygon( fill, defined, x, y, 2, 3, 4, 5 );
-                }
-                break;
-            case 024:
-            case 042:
-                // 3 contours
-                if ( n != 7 )
-                    fprintf( stderr, "plfshade err n=%d !7", (int) n );
-
-                if ( ( c0[iy] == OK || c1[iy + 1] == OK ) && slope == 1 )
-                {
-                    if ( fill != NULL )
-                        exfill( fill, defined, n, x, y );
-                }
-                else if ( ( c0[iy + 1] == OK || c1[iy] == OK ) && slope == 0 )
-                {
-                    if ( fill != NULL )
-                        exfill( fill, defined, n, x, y );
-                }
-
-                else if ( c0[iy] == OK )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 6, -1 );
-                    selected_polygon( fill, defined, x, y, 2, 3, 4, 5 );
-                }
-                else if ( c0[iy + 1] == OK )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 2, -1 );
-                    selected_polygon( fill, defined, x, y, 3, 4, 5, 6 );
-                }
-                else if ( c1[iy + 1] == OK )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 5, 6 );
-                    selected_polygon( fill, defined, x, y, 2, 3, 4, -1 );
-                }
-                else if ( c1[iy] == OK )
-                {
-                    selected_polygon( fill, defined, x, y, 0, 1, 2, 3 );
-                    selected_polygon( fill, defined, x, y, 4, 5, 6, -1 );
-                }
-                else
-                {
-                    fprintf( stderr, "plfshade err logic case 024:042\n" );
-                }
-                break;
-            default:
-                fprintf( stderr, "prog err switch\n" );
-                break;
-            }
-            draw_boundary( slope, x, y );
+            if ( npoly == 1 && fill != NULL )
+                exfill( fill, defined, n, x, y );
+            for ( i = 0; npoly == 2 && i < 2; i++ )
+                selected_polygon( fill, defined, x, y,
+                    poly[i][0], poly[i][1], poly[i][2], poly[i][3] );
+            draw_boundary( &sc, slope, x, y );
 
             if ( fill != NULL )
             {
@@ -832,23 +1260,21 @@ plshade_int( PLF2EVAL_callback f2eval, PLPointer f2eval_data,
 //--------------------------------------------------------------------------
 // set_cond()
 //
-// Fills out condition code array.
+// Fills out condition code array.  The comparisons are combined rather
+// than branched on; a NaN fails both of the first two and is undefined.
 //--------------------------------------------------------------------------
 
 static void
-set_cond( register int *cond, register PLFLT *a, register PLINT n )
+set_cond( int *cond, const PLFLT *a, PLINT n, PLFLT sh_min, PLFLT sh_max )
 {
-    while ( n-- )
+    PLINT i;
+    PLFLT v;
+
+    for ( i = 0; i < n; i++ )
     {
-        if ( *a < sh_min )
-            *cond++ = NEG;
-        else if ( *a > sh_max )
-            *cond++ = POS;
-        else if ( isnan( *a ) ) //check for nans and set cond to undefined
-            *cond++ = UNDEF;
-        else
-            *cond++ = OK;
-        a++;
+        v       = a[i];
+        cond[i] = NEG * ( v < sh_min ) + POS * ( ( v > sh_max ) & ( v >= sh_min ) ) +
+                  ( isnan( v ) ? UNDEF : OK );
     }
 }
 
@@ -860,11 +1286,11 @@ set_cond( register int *cond, register PLFLT *a, register PLINT n )
 //
 // returns 0 : no points to be shaded 1 : x[0] <= x < 1 is the interval 2 :
 // x[0] <= x <= x[1] < 1 interval to be shaded n_point, max_points,
-// min_points are incremented location of min/max_points are stored
+// min_points of sc are incremented location of min/max_points are stored
 //--------------------------------------------------------------------------
 
 static int
-find_interval( PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x )
+find_interval( SHADE_CELL *sc, PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x )
 {
     register int n;
 
@@ -872,7 +1298,7 @@ find_interval( PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x )
     if ( c0 == OK )
     {
         x[n++] = 0.0;
-        n_point++;
+        sc->n_point++;
     }
     if ( c0 == c1 )
         return n;
@@ -881,31 +1307,184 @@ find_interval( PLFLT a0, PLFLT a1, PLINT c0, PLINT c1, PLFLT *x )
     {
         if ( c0 == NEG )
         {
-            x[n++] = linear( a0, a1, sh_min );
-            min_pts[min_points++] = n_point++;
+            x[n++] = linear( a0, a1, sc->sh_min );
+            sc->min_pts[sc->min_points++] = sc->n_point++;
         }
         if ( c1 == POS )
         {
-            x[n++] = linear( a0, a1, sh_max );
-            max_pts[max_points++] = n_point++;
+            x[n++] = linear( a0, a1, sc->sh_max );
+            sc->max_pts[sc->max_points++] = sc->n_point++;
         }
     }
     if ( c0 == POS || c1 == NEG )
     {
         if ( c0 == POS )
         {
-            x[n++] = linear( a0, a1, sh_max );
-            max_pts[max_points++] = n_point++;
+            x[n++] = linear( a0, a1, sc->sh_max );
+            sc->max_pts[sc->max_points++] = sc->n_point++;
         }
         if ( c1 == NEG )
         {
-            x[n++] = linear( a0, a1, sh_min );
-            min_pts[min_points++] = n_point++;
+            x[n++] = linear( a0, a1, sc->sh_min );
+            sc->min_pts[sc->min_points++] = sc->n_point++;
         }
     }
     return n;
 }
 
+//--------------------------------------------------------------------------
+// shade_cell()
+//
+// Finds the part of cell (ix, iy) of a[nx][ny] which lies in the shade
+// region of sc when the cell is only partly inside it.  v[] and c[] are
+// the values and condition codes of the corners (ix, iy), (ix, iy + 1),
+// (ix + 1, iy + 1) and (ix + 1, iy).  The n points where the region meets
+// the edges of the cell are returned in x[] and y[] in grid coordinates,
+// and the crossings of the region boundaries are recorded in sc.
+//
+// returns 0 if nothing is to be filled, 1 if the polygon through all n
+// points is to be filled, and 2 if the two polygons whose vertices are
+// listed in poly[0] and poly[1] (indices into x[] and y[], -1 for unused
+// entries) are to be filled.
+//--------------------------------------------------------------------------
+
+static int
+shade_cell( SHADE_CELL *sc, PLFLT *a, PLINT nx, PLINT ny, PLINT ix, PLINT iy,
+            PLFLT *v, int *c, PLFLT *x, PLFLT *y, PLINT *n, PLINT *slope,
+            PLINT poly[2][4] )
+{
+    PLFLT xp[2];
+    PLINT i, j, k, npoly = 1;
+
+    sc->n_point = sc->min_points = sc->max_points = 0;
+    k           = find_interval( sc, v[0], v[1], c[0], c[1], xp );
+    for ( j = 0; j < k; j++ )
+    {
+        x[j] = ix;
+        y[j] = iy + xp[j];
+    }
+
+    i = find_interval( sc, v[1], v[2], c[1], c[2], xp );
+
+    for ( j = 0; j < i; j++ )
+    {
+        x[j + k] = ix + xp[j];
+        y[j + k] = iy + 1;
+    }
+    k += i;
+
+    i = find_interval( sc, v[2], v[3], c[2], c[3], xp );
+    for ( j = 0; j < i; j++ )
+    {
+        x[k + j] = ix + 1;
+        y[k + j] = iy + 1 - xp[j];
+    }
+    k += i;
+
+    i = find_interval( sc, v[3], v[0], c[3], c[0], xp );
+    for ( j = 0; j < i; j++ )
+    {
+        x[k + j] = ix + 1 - xp[j];
+        y[k + j] = iy;
+    }
+    k += i;
+    *n = k;
+
+    if ( sc->min_points == 4 )
+        *slope = plctestez( a, nx, ny, ix, iy, sc->sh_max - sc->sh_min );
+    if ( sc->max_points == 4 )
+        *slope = plctestez( a, nx, ny, ix, iy, sc->sh_max - sc->sh_min );
+
+    // n = number of end of line segments
+    // min_points = number times shade_min meets edge
+    // max_points = number times shade_max meets edge
+
+    // special cases: check number of times a contour is in a box
+
+    switch ( ( sc->min_points << 3 ) + sc->max_points )
+    {
+    case 000:
+    case 020:
+    case 002:
+    case 022:
+        if ( k == 0 )
+            npoly = 0;
+        break;
+    case 040:   // 2 contour lines in box
+    case 004:
+        if ( k != 6 )
+            fprintf( stderr, "plfshade err n=%d !6", (int) k );
+        if ( *slope == 1 && c[0] == OK )
+            ;
+        else if ( *slope == 1 )
+            npoly = split_cell( poly, 0, 1, 2, -1, 3, 4, 5, -1 );
+        else if ( c[1] == OK )
+            ;
+        else
+            npoly = split_cell( poly, 0, 1, 5, -1, 2, 3, 4, -1 );
+        break;
+    case 044:
+        if ( k != 8 )
+            fprintf( stderr, "plfshade err n=%d !8", (int) k );
+        if ( *slope == 1 )
+            npoly = split_cell( poly, 0, 1, 2, 3, 4, 5, 6, 7 );
+        else
+            npoly = split_cell( poly, 0, 1, 6, 7, 2, 3, 4, 5 );
+        break;
+    case 024:
+    case 042:
+        // 3 contours
+        if ( k != 7 )
+            fprintf( stderr, "plfshade err n=%d !7", (int) k );
+
+        if ( ( c[0] == OK || c[2] == OK ) && *slope == 1 )
+            ;
+        else if ( ( c[1] == OK || c[3] == OK ) && *slope == 0 )
+            ;
+        else if ( c[0] == OK )
+            npoly = split_cell( poly, 0, 1, 6, -1, 2, 3, 4, 5 );
+        else if ( c[1] == OK )
+            npoly = split_cell( poly, 0, 1, 2, -1, 3, 4, 5, 6 );
+        else if ( c[2] == OK )
+            npoly = split_cell( poly, 0, 1, 5, 6, 2, 3, 4, -1 );
+        else if ( c[3] == OK )
+            npoly = split_cell( poly, 0, 1, 2, 3, 4, 5, 6, -1 );
+        else
+        {
+            fprintf( stderr, "plfshade err logic case 024:042\n" );
+            npoly = 0;
+        }
+        break;
+    default:
+        fprintf( stderr, "prog err switch\n" );
+        npoly = 0;
+        break;
+    }
+    return npoly;
+}
+
+//--------------------------------------------------------------------------
+// split_cell()
+//
+// Sets the vertices v1..v4 and w1..w4 of the two polygons a cell is split
+// into by shade_cell(), and returns 2.
+//--------------------------------------------------------------------------
+
+static int
+split_cell( PLINT poly[2][4], PLINT v1, PLINT v2, PLINT v3, PLINT v4,
+            PLINT w1, PLINT w2, PLINT w3, PLINT w4 )
+{
+    poly[0][0] = v1;
+    poly[0][1] = v2;
+    poly[0][2] = v3;
+    poly[0][3] = v4;
+    poly[1][0] = w1;
+    poly[1][1] = w2;
+    poly[1][2] = w3;
+    poly[1][3] = w4;
+    return 2;
+}
+
 //--------------------------------------------------------------------------
 // selected_polygon()
 //
@@ -1175,58 +1754,59 @@ big_recl( int *cond_code, register int ny, int dx, int dy,
 //--------------------------------------------------------------------------
 // draw_boundary()
 //
-// Draw boundaries of contour regions based on min_pts[], and max_pts[].
+// Draw boundaries of contour regions based on the min_pts[] and max_pts[]
+// of sc.
 //--------------------------------------------------------------------------
 
 static void
-draw_boundary( PLINT slope, PLFLT *x, PLFLT *y )
+draw_boundary( SHADE_CELL *sc, PLINT slope, PLFLT *x, PLFLT *y )
 {
     int i;
 
-    if ( pen_col_min != 0 && pen_wd_min != 0 && min_points != 0 )
+    if ( pen_col_min != 0 && pen_wd_min != 0 && sc->min_points != 0 )
     {
         plcol0( pen_col_min );
         plwidth( pen_wd_min );
-        if ( min_points == 4 && slope == 0 )
+        if ( sc->min_points == 4 && slope == 0 )
         {
             // swap points 1 and 3
-            i          = min_pts[1];
-            min_pts[1] = min_pts[3];
-            min_pts[3] = i;
+            i          = sc->min_pts[1];
+            sc->min_pts[1] = sc->min_pts[3];
+            sc->min_pts[3] = i;
         }
-        pljoin( x[min_pts[0]], y[min_pts[0]], x[min_pts[1]], y[min_pts[1]] );
-        if ( min_points == 4 )
+        pljoin( x[sc->min_pts[0]], y[sc->min_pts[0]], x[sc->min_pts[1]], y[sc->min_pts[1]] );
+        if ( sc->min_points == 4 )
         {
-            pljoin( x[min_pts[2]], y[min_pts[2]], x[min_pts[3]],
-                y[min_pts[3]] );
+            pljoin( x[sc->min_pts[2]], y[sc->min_pts[2]], x[sc->min_pts[3]],
+                y[sc->min_pts[3]] );
         }
     }
-    if ( pen_col_max != 0 && pen_wd_max != 0 && max_points != 0 )
+    if ( pen_col_max != 0 && pen_wd_max != 0 && sc->max_points != 0 )
     {
         plcol0( pen_col_max );
         plwidth( pen_wd_max );
-        if ( max_points == 4 && slope == 0 )
+        if ( sc->max_points == 4 && slope == 0 )
         {
             // swap points 1 and 3
-            i          = max_pts[1];
-            max_pts[1] = max_pts[3];
-            max_pts[3] = i;
+            i          = sc->max_pts[1];
+            sc->max_pts[1] = sc->max_pts[3];
+            sc->max_pts[3] = i;
         }
-        pljoin( x[max_pts[0]], y[max_pts[0]], x[max_pts[1]], y[max_pts[1]] );
-        if ( max_points == 4 )
+        pljoin( x[sc->max_pts[0]], y[sc->max_pts[0]], x[sc->max_pts[1]], y[sc->max_pts[1]] );
+        if ( sc->max_points == 4 )
         {
-            pljoin( x[max_pts[2]], y[max_pts[2]], x[max_pts[3]],
-                y[max_pts[3]] );
+            pljoin( x[sc->max_pts[2]], y[sc->max_pts[2]], x[sc->max_pts[3]],
+                y[sc->max_pts[3]] );
         }
     }
 }
 
 //--------------------------------------------------------------------------
 //
-// plctest( &(x[0][0]), PLFLT level)
+// plctest( &(x[0][0]), PLFLT int_val)
 // where x was defined as PLFLT x[4][4];
 //
-// determines if the contours associated with level have
+// determines if the contours of the shade boundaries, int_val apart, have
 // positive slope or negative slope in the box:
 //
 //  (2,3)   (3,3)
@@ -1260,7 +1840,7 @@ draw_boundary( PLINT slope, PLFLT *x, PLFLT *y )
 #define RATIO_SQ          6.0
 
 static PLINT
-plctest( PLFLT *x, PLFLT PL_UNUSED( level ) )
+plctest( PLFLT *x, PLFLT int_val )
 {
     int    i, j;
     double t[4], sorted[4], temp;
@@ -1321,7 +1901,7 @@ plctest( PLFLT *x, PLFLT PL_UNUSED( level ) )
 
 static PLINT
 plctestez( PLFLT *a, PLINT nx, PLINT ny, PLINT ix,
-           PLINT iy, PLFLT level )
+           PLINT iy, PLFLT int_val )
 {
     PLFLT x[4][4];
     int   i, j, ii, jj;
@@ -1339,5 +1919,5 @@ plctestez( PLFLT *a, PLINT nx, PLINT ny, PLINT ix,
             x[i][j] = a[ii * ny + jj];
         }
     }
-    return plctest( &( x[0][0] ), level );
+    return plctest( &( x[0][0] ), int_val );
 }
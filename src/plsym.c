@@ -77,6 +77,9 @@ plcvec( PLINT ch, signed char **xygr );
 static void
 plhrsh2( PLINT ch, PLINT x, PLINT y );
 
+static void
+plhrsh_points( PLINT ch, PLINT n, PLINT *x, PLINT *y );
+
 //--------------------------------------------------------------------------
 //! Plot a glyph at the specified points.  (This function largely
 //! supersedes plpoin and plsym because many[!] more glyphs are
@@ -131,11 +134,14 @@ c_plsym( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLINT code )
         return;
     }
 
+    plP_growxy( &plsc->linexbuf, &plsc->lineybuf, &plsc->linebufsize, n );
     for ( i = 0; i < n; i++ )
     {
         TRANSFORM( x[i], y[i], &xt, &yt );
-        plhrsh( code, plP_wcpcx( xt ), plP_wcpcy( yt ) );
+        plsc->linexbuf[i] = plP_wcpcx( xt );
+        plsc->lineybuf[i] = plP_wcpcy( yt );
     }
+    plhrsh_points( code, n, plsc->linexbuf, plsc->lineybuf );
 }
 
 //--------------------------------------------------------------------------
@@ -191,11 +197,14 @@ c_plpoin( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLINT code )
         // One-time diagnostic output.
         // fprintf(stdout, "plploin code, sym = %d, %d\n", code, sym);
 
+        plP_growxy( &plsc->linexbuf, &plsc->lineybuf, &plsc->linebufsize, n );
         for ( i = 0; i < n; i++ )
         {
             TRANSFORM( x[i], y[i], &xt, &yt );
-            plhrsh( sym, plP_wcpcx( xt ), plP_wcpcy( yt ) );
+            plsc->linexbuf[i] = plP_wcpcx( xt );
+            plsc->lineybuf[i] = plP_wcpcy( yt );
         }
+        plhrsh_points( sym, n, plsc->linexbuf, plsc->lineybuf );
     }
 }
 
@@ -224,7 +233,7 @@ c_plpoin( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLINT code )
 void
 c_plpoin3( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, PLINT code )
 {
-    PLINT i, sym, ifont = plsc->cfont;
+    PLINT i, sym, ifont = plsc->cfont, npts = 0;
     PLFLT u, v;
     PLFLT xmin, xmax, ymin, ymax, zmin, zmax, zscale;
 
@@ -263,6 +272,7 @@ c_plpoin3( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, PLINT code )
             ifont = 1;
         sym = *( fntlkup + ( ifont - 1 ) * numberchars + code );
 
+        plP_growxy( &plsc->linexbuf, &plsc->lineybuf, &plsc->linebufsize, n );
         for ( i = 0; i < n; i++ )
         {
             if ( x[i] >= xmin && x[i] <= xmax &&
@@ -271,9 +281,11 @@ c_plpoin3( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, PLINT code )
             {
                 u = plP_wcpcx( plP_w3wcx( x[i], y[i], z[i] ) );
                 v = plP_wcpcy( plP_w3wcy( x[i], y[i], z[i] ) );
-                plhrsh( sym, (PLINT) u, (PLINT) v );
+                plsc->linexbuf[npts]   = (PLINT) u;
+                plsc->lineybuf[npts++] = (PLINT) v;
             }
         }
+        plhrsh_points( sym, npts, plsc->linexbuf, plsc->lineybuf );
     }
 }
 
@@ -348,9 +360,27 @@ c_plstring3( PLINT n, PLFLT_VECTOR x, PLFLT_VECTOR y, PLFLT_VECTOR z, PLCHAR_VEC
 void
 plhrsh( PLINT ch, PLINT x, PLINT y )
 {
-    EscText   args;
-    int       idx;
-    PLUNICODE unicode_char;
+    plhrsh_points( ch, 1, &x, &y );
+}
+
+//--------------------------------------------------------------------------
+// void plhrsh_points()
+//
+// Writes the Hershey symbol "ch" centred at each of the n physical
+// coordinates (x[i], y[i]), as plhrsh() does for one point.  The unicode
+// lookup and the setup of the text are done once for all the points, and
+// drivers that set dev_markers get all of them in a single PLESC_MARKERS
+// escape.
+//--------------------------------------------------------------------------
+
+static void
+plhrsh_points( PLINT ch, PLINT n, PLINT *x, PLINT *y )
+{
+    EscText    args;
+    EscMarkers markers;
+    int        idx;
+    PLINT      i;
+    PLUNICODE  unicode_char;
 
     // Check to see if the device understands unicode and wants to draw
     // symbols.
@@ -359,7 +389,7 @@ plhrsh( PLINT ch, PLINT x, PLINT y )
     {
         // Get the index in the lookup table and the unicode character
         idx          = plhershey2unicode( ch );
-        unicode_char = hershey_to_unicode_lookup_table[idx].Unicode;
+        unicode_char = idx == -1 ? 0 : hershey_to_unicode_lookup_table[idx].Unicode;
 
         //
         //  Test to see if there is a defined unicode glyph for this hershey
@@ -371,7 +401,8 @@ plhrsh( PLINT ch, PLINT x, PLINT y )
         if ( ( unicode_char == 0 ) || ( idx == -1 ) )
         {
 #ifndef PL_TEST_FOR_MISSING_GLYPHS
-            plhrsh2( ch, x, y );
+            for ( i = 0; i < n; i++ )
+                plhrsh2( ch, x[i], y[i] );
 #endif
         }
         else
@@ -392,8 +423,6 @@ plhrsh( PLINT ch, PLINT x, PLINT y )
             args.base   = 0;
             args.just   = 0.5;
             args.xform  = xform;
-            args.x      = x;
-            args.y      = y;
             args.string = NULL;
             args.symbol = ch;
 
@@ -427,14 +456,35 @@ plhrsh( PLINT ch, PLINT x, PLINT y )
                 args.n_fci  = fci;
                 args.n_char = unicode_char;
 
-                plP_esc( PLESC_BEGIN_TEXT, &args );
-                plP_esc( PLESC_TEXT_CHAR, &args );
-                plP_esc( PLESC_END_TEXT, &args );
+                for ( i = 0; i < n; i++ )
+                {
+                    args.x = x[i];
+                    args.y = y[i];
+                    plP_esc( PLESC_BEGIN_TEXT, &args );
+                    plP_esc( PLESC_TEXT_CHAR, &args );
+                    plP_esc( PLESC_END_TEXT, &args );
+                }
+            }
+            else if ( plsc->dev_markers && n > 1 )
+            {
+                // All the markers at once
+                args.x       = x[0];
+                args.y       = y[0];
+                markers.text = &args;
+                markers.n    = n;
+                markers.x    = x;
+                markers.y    = y;
+                plP_markers( &markers );
             }
             else
             {
                 // "array method"
-                plP_esc( PLESC_HAS_TEXT, &args );
+                for ( i = 0; i < n; i++ )
+                {
+                    args.x = x[i];
+                    args.y = y[i];
+                    plP_esc( PLESC_HAS_TEXT, &args );
+                }
             }
 
             plsc->chrht  = plsc->original_chrht;
@@ -443,7 +493,8 @@ plhrsh( PLINT ch, PLINT x, PLINT y )
     }
     else
     {
-        plhrsh2( ch, x, y );
+        for ( i = 0; i < n; i++ )
+            plhrsh2( ch, x[i], y[i] );
     }
 }
 
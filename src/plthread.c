@@ -0,0 +1,153 @@
+//      Support for running independent parts of a computation on several
+//      threads.
+//
+// This file is part of PLplot.
+//
+// PLplot is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Library General Public License as published
+// by the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// PLplot is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Library General Public License for more details.
+//
+// You should have received a copy of the GNU Library General Public License
+// along with PLplot; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+//
+//
+
+#include "plplotP.h"
+
+#ifdef PL_HAVE_THREADS
+#include <pthread.h>
+
+typedef struct
+{
+    PLINT n;    // number of work items
+    PLINT next; // next work item to hand out
+    void ( *body )( PLINT, PLINT, PLPointer );
+    PLPointer       data;
+    pthread_mutex_t mutex;
+} PLParallel;
+
+typedef struct
+{
+    PLParallel *par;
+    PLINT      thread;
+} PLParallelThread;
+
+//--------------------------------------------------------------------------
+// parallel_worker()
+//
+// Hands out the work items one at a time to the calling thread until all
+// of them have been processed.
+//--------------------------------------------------------------------------
+
+static void *
+parallel_worker( void *arg )
+{
+    PLParallelThread *pt  = (PLParallelThread *) arg;
+    PLParallel       *par = pt->par;
+    PLINT            i;
+
+    for (;; )
+    {
+        pthread_mutex_lock( &par->mutex );
+        i = par->next++;
+        pthread_mutex_unlock( &par->mutex );
+
+        if ( i >= par->n )
+            break;
+        ( *par->body )( i, pt->thread, par->data );
+    }
+
+    return NULL;
+}
+#endif // PL_HAVE_THREADS
+
+//--------------------------------------------------------------------------
+// plP_nthreads()
+//
+// Number of threads the current stream allows for parallel computations,
+// as set with the -nthreads option.  Always 1 if PLplot was built without
+// thread support.
+//--------------------------------------------------------------------------
+
+PLINT
+plP_nthreads( void )
+{
+#ifdef PL_HAVE_THREADS
+    return MAX( plsc->nthreads, 1 );
+#else
+    return 1;
+#endif
+}
+
+//--------------------------------------------------------------------------
+// plP_parallel()
+//
+// Calls body( i, thread, data ) once for every i = 0, ..., n - 1, using
+// up to nthreads threads.  thread (0 <= thread < nthreads) identifies the
+// calling thread so that body can use per-thread scratch storage.  The
+// calling thread takes part in the work as thread 0, and plP_parallel
+// returns when all calls have completed.  body must not call any
+// function that changes the state of the stream.
+//--------------------------------------------------------------------------
+
+void
+plP_parallel( PLINT n, PLINT nthreads, void ( *body )( PLINT, PLINT, PLPointer ), PLPointer data )
+{
+    PLINT            i;
+#ifdef PL_HAVE_THREADS
+    PLParallel       par;
+    PLParallelThread *pt;
+    pthread_t        *tid;
+    PLINT            nstarted;
+
+    nthreads = MIN( nthreads, n );
+    if ( nthreads > 1 )
+    {
+        if ( ( pt = (PLParallelThread *) malloc( (size_t) nthreads * sizeof ( PLParallelThread ) ) ) == NULL ||
+             ( tid = (pthread_t *) malloc( (size_t) nthreads * sizeof ( pthread_t ) ) ) == NULL )
+        {
+            plexit( "plP_parallel: Insufficient memory" );
+        }
+
+        par.n    = n;
+        par.next = 0;
+        par.body = body;
+        par.data = data;
+        pthread_mutex_init( &par.mutex, NULL );
+
+        // If a thread cannot be created the others simply get more work.
+        nstarted = 1;
+        for ( i = 1; i < nthreads; i++ )
+        {
+            pt[nstarted].par    = &par;
+            pt[nstarted].thread = nstarted;
+            if ( pthread_create( &tid[nstarted], NULL, parallel_worker, &pt[nstarted] ) == 0 )
+                nstarted++;
+        }
+
+        pt[0].par    = &par;
+        pt[0].thread = 0;
+        parallel_worker( &pt[0] );
+
+        for ( i = 1; i < nstarted; i++ )
+            pthread_join( tid[i], NULL );
+
+        pthread_mutex_destroy( &par.mutex );
+        free( pt );
+        free( tid );
+        return;
+    }
+#else
+    (void) nthreads;
+#endif
+
+    for ( i = 0; i < n; i++ )
+        ( *body )( i, 0, data );
+}
@@ -65,6 +65,7 @@ static void     PrevFamilyFile( void );
 static void     ReadPageHeader( void );
 static void     plr_KeyEH( PLGraphicsIn *, void *, int * );
 static void     SeekToDisp( long );
+static int      SeekToIndexedPage( void );
 static void     SeekOnePage( void );
 static void     SeekToNextPage( void );
 static void     SeekToCurPage( void );
@@ -80,6 +81,7 @@ static void     Init( int, char ** );
 static int      ProcessFile( int, char ** );
 static int      OpenMetaFile( char ** );
 static int      ReadFileHeader( void );
+static void     ReadPageIndex( void );
 
 // Option handlers
 
@@ -121,6 +123,9 @@ static FPOS_T prevpage_loc;     // Byte position of previous page header
 static FPOS_T curpage_loc;      // Byte position of current page header
 static FPOS_T nextpage_loc;     // Byte position of next page header
 
+static U_LONG *page_index;      // Byte positions of all page headers
+static PLINT  index_pages;      // Number of pages in page_index
+
 // File info
 
 static int     input_type;       // 0 for file, 1 for stream
@@ -398,6 +403,7 @@ ProcessFile( int argc, char **argv )
 
     if ( ReadFileHeader() )
         exit( EX_BADFILE );
+    ReadPageIndex();
 
 // Read & process any state info before the INITIALIZE
 
@@ -1566,6 +1572,11 @@ SeekToDisp( long target_disp )
         "Before seek: target_page = %d, curpage = %d, curdisp = %d\n",
         target_page, curpage, curdisp );
 
+// With a page index, go straight to the target page
+
+    if ( page_index != NULL && SeekToIndexedPage() == 0 )
+        goto done;
+
 // <Return> while drawing any page but the last
 
     if ( delta == 0 )
@@ -1598,6 +1609,54 @@ done:
     return;
 }
 
+//--------------------------------------------------------------------------
+// SeekToIndexedPage()
+//
+// Seeks to the end of 'target_page' through the page index, in a single
+// step.  The page counters end up as if SeekOnePage() had been used to get
+// there, and out of bounds seeks likewise stop at the first or last page.
+// Returns 1 if the current page is not in the index, in which case
+// nothing is done.
+//--------------------------------------------------------------------------
+
+static int
+SeekToIndexedPage( void )
+{
+    FPOS_T loc;
+    PLINT  lo = 0, hi = index_pages - 1, mid, base, page;
+
+// Find the current page in the index
+
+    while ( lo < hi )
+    {
+        mid = ( lo + hi ) / 2;
+        if ( (FPOS_T) page_index[mid] < curpage_loc )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if ( (FPOS_T) page_index[lo] != curpage_loc )
+        return 1;
+
+// Page counter before the first page of the file.  The current page has
+// been counted unless we are right before its header.
+
+    if ( pl_fgetpos( MetaFile, &loc ) )
+        plr_exit( "plrender: fgetpos call failed" );
+
+    base = curpage - lo - ( loc != curpage_loc );
+    page = MAX( 0, MIN( target_page - base, index_pages - 1 ) );
+
+    SeekTo( (FPOS_T) page_index[page] );
+    while ( curpage < base + page )
+        PageIncr();
+    while ( curpage > base + page )
+        PageDecr();
+
+    delta = 0;
+    return 0;
+}
+
 //--------------------------------------------------------------------------
 // SeekOnePage()
 //
@@ -1834,6 +1893,74 @@ file: %s, position: %d", c, FileName, (int) curpage_loc );
     DEBUG_PRINT_LOCATION( "end of ReadPageHeader" );
 }
 
+//--------------------------------------------------------------------------
+// ReadPageIndex()
+//
+// Reads the page index that the plmeta driver writes after the CLOSE
+// command, so that seeks need not follow the links between the page
+// headers.  page_index is left NULL for files without a valid index and
+// for file families, whose offsets are per member.  The position in the
+// file is not changed.
+//--------------------------------------------------------------------------
+
+static void
+ReadPageIndex( void )
+{
+    FPOS_T loc, size;
+    size_t bp;
+    U_LONG ix_offset, npages, i;
+    U_CHAR cmd, tag[4];
+
+    free( (void *) page_index );
+    page_index  = NULL;
+    index_pages = 0;
+
+    if ( !isfile || is_family || no_pagelinks )
+        return;
+
+    if ( pl_fgetpos( MetaFile, &loc ) )
+        plr_exit( "plrender: fgetpos call failed" );
+    bp = pdfs->bp;
+
+// The index ends with its offset and a tag.  The smallest index is the
+// command, the page count, one page, the index offset and the tag.
+
+    if ( fseek( MetaFile, 0L, SEEK_END ) || pl_fgetpos( MetaFile, &size )
+         || size < 17 )
+        goto done;
+
+    doseek( size - 8 );
+    if ( pdf_rd_4bytes( pdfs, &ix_offset ) || pdf_rdx( tag, 4, pdfs ) != 4
+         || memcmp( tag, PLMETA_INDEX_TAG, 4 ) || ix_offset > (U_LONG) size - 17 )
+        goto done;
+
+    doseek( (FPOS_T) ix_offset );
+    if ( pdf_rd_1byte( pdfs, &cmd ) || cmd != PAGE_INDEX
+         || pdf_rd_4bytes( pdfs, &npages ) || npages == 0
+         || npages != ( (U_LONG) size - ix_offset - 13 ) / 4 )
+        goto done;
+
+    if ( ( page_index = (U_LONG *) malloc( npages * sizeof ( U_LONG ) ) ) == NULL )
+        plr_exit( "plrender: Insufficient memory for the page index" );
+
+    for ( i = 0; i < npages; i++ )
+    {
+        if ( pdf_rd_4bytes( pdfs, &page_index[i] ) || page_index[i] >= ix_offset
+             || ( i > 0 && page_index[i] <= page_index[i - 1] ) )
+        {
+            free( (void *) page_index );
+            page_index = NULL;
+            goto done;
+        }
+    }
+    index_pages = (PLINT) npages;
+    pldebug( "ReadPageIndex", "%d pages in the page index\n", index_pages );
+
+done:
+    doseek( loc );
+    pdfs->bp = bp;
+}
+
 //--------------------------------------------------------------------------
 // ReadFileHeader()
 //